@@ -0,0 +1,33 @@
+#include <iostream>
+#include <string>
+#include "brightchain/disk_block_store.hpp"
+#include "brightchain/block_size.hpp"
+
+// Converts the per-block .m.json metadata sidecars of a store into the
+// binary metadata index, one size class at a time.
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <store-path>\n";
+        return 1;
+    }
+
+    const std::string storePath = argv[1];
+    size_t total = 0;
+    try {
+        for (brightchain::BlockSize size : brightchain::VALID_BLOCK_SIZES) {
+            brightchain::DiskBlockStore store(storePath, size);
+            size_t migrated = store.migrateJsonMetadata();
+            if (migrated > 0) {
+                std::cout << brightchain::blockSizeToString(size) << ": migrated " << migrated
+                          << " metadata files\n";
+            }
+            total += migrated;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Migration failed: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "Migrated " << total << " metadata files\n";
+    return 0;
+}
@@ -3,6 +3,8 @@
 #include <vector>
 #include <cstdint>
 #include <array>
+#include <memory>
+#include <span>
 
 namespace brightchain {
 
@@ -66,4 +68,96 @@ public:
     );
 };
 
+/**
+ * Incremental AES-256-GCM over spans, for payloads that should not be held
+ * in memory twice. Output is produced as input arrives, so peak memory is
+ * bounded by the caller's chunk size, and update() may run in place.
+ *
+ * The cipher context is kept between messages: init() with a new IV starts
+ * the next message, reusing the key schedule when the key is unchanged.
+ * The one-shot AesGcm::encrypt()/decrypt() wipe the key after every call and
+ * never reuse it; keep a stream to encrypt many messages under one key.
+ * Never reuse an IV with the same key.
+ *
+ * Usage: init() -> update()* -> finish(), then init() again. clearKey()
+ * wipes the key schedule once the key is no longer needed. A moved-from
+ * stream may only be destroyed or assigned to.
+ */
+class AesGcmStream {
+public:
+    enum class Mode { Encrypt, Decrypt };
+
+    /**
+     * Constructor.
+     * @throws std::runtime_error if the cipher context cannot be created
+     */
+    explicit AesGcmStream(Mode mode);
+
+    ~AesGcmStream();
+    AesGcmStream(AesGcmStream&& other) noexcept;
+    AesGcmStream& operator=(AesGcmStream&& other) noexcept;
+    AesGcmStream(const AesGcmStream&) = delete;
+    AesGcmStream& operator=(const AesGcmStream&) = delete;
+
+    /**
+     * Start a message with a new key.
+     * @param aad Additional authenticated data for the whole message
+     * @throws std::logic_error if the stream has been moved from
+     */
+    void init(const AesGcm::Key& key, const AesGcm::IV& iv, std::span<const uint8_t> aad = {});
+
+    /**
+     * Start a message with the key of the previous message.
+     * @throws std::logic_error if no key has been set
+     */
+    void init(const AesGcm::IV& iv, std::span<const uint8_t> aad = {});
+
+    /**
+     * Process the next piece of the message.
+     * @param in Input bytes
+     * @param out Output, at least in.size() bytes; may be the same memory as in
+     * @throws std::logic_error if no message is in progress
+     * @throws std::invalid_argument if out is too small or partially overlaps in
+     */
+    void update(std::span<const uint8_t> in, std::span<uint8_t> out);
+
+    /**
+     * Process the next piece of the message in place.
+     */
+    void update(std::span<uint8_t> data) { update(data, data); }
+
+    /**
+     * Finish an encrypted message.
+     * @return Authentication tag
+     * @throws std::logic_error if not encrypting or no message is in progress
+     */
+    AesGcm::Tag finish();
+
+    /**
+     * Finish a decrypted message and check its tag. On failure the output
+     * already produced must be discarded.
+     * @throws std::runtime_error if authentication fails
+     * @throws std::logic_error if not decrypting or no message is in progress
+     */
+    void finish(const AesGcm::Tag& tag);
+
+    /**
+     * Erase the key schedule from the cipher context. init() with a key is
+     * required before the next message.
+     */
+    void clearKey();
+
+    Mode mode() const { return mode_; }
+
+private:
+    void requireActive() const;
+    void setup();
+
+    struct Context;
+    std::unique_ptr<Context> context_;
+    Mode mode_;
+    bool keyed_ = false;
+    bool active_ = false;
+};
+
 } // namespace brightchain
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "brightchain/checksum.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include "brightchain/thread_pool.hpp"
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * How AsyncBlockIO executes block reads.
+ */
+enum class AsyncIOBackend {
+    IoUring,   // Linux io_uring: open, stat, read and close in the kernel's queue
+    ThreadPool // Blocking store calls on the worker pool
+};
+
+/**
+ * AsyncBlockIO issues DiskBlockStore operations concurrently so a single
+ * caller can keep many block reads and writes in flight.
+ *
+ * On Linux, reads from a FilePerBlock store go through io_uring when the
+ * kernel supports it: each read is an OPENAT and a STATX, then a READ and a
+ * CLOSE, with up to queueDepth reads in the ring. Writes, existence checks,
+ * packed stores and kernels without io_uring run on a dedicated pool whose
+ * size is the queue depth. Results are delivered through futures or
+ * per-request callbacks (invoked on a worker or the ring's completion thread).
+ *
+ * The store must outlive the engine. The destructor waits for all
+ * outstanding requests to complete.
+ */
+class AsyncBlockIO {
+public:
+    static constexpr size_t DEFAULT_QUEUE_DEPTH = 64;
+
+    /**
+     * Completion callback for batched reads.
+     * @param index Position of the request in the batch
+     * @param data Block data (empty on error)
+     * @param error Exception raised by the request, or nullptr
+     */
+    using GetCallback =
+        std::function<void(size_t index, std::vector<uint8_t> data, std::exception_ptr error)>;
+
+    /**
+     * Completion callback for batched writes.
+     */
+    using PutCallback =
+        std::function<void(size_t index, const Checksum& checksum, std::exception_ptr error)>;
+
+    /**
+     * Constructor.
+     * @param store Store to operate on
+     * @param queueDepth Maximum number of requests executing at once
+     * @param backend Preferred read backend; IoUring falls back to ThreadPool
+     *                where io_uring is unavailable
+     * @throws std::invalid_argument if queueDepth is 0
+     */
+    explicit AsyncBlockIO(DiskBlockStore& store, size_t queueDepth = DEFAULT_QUEUE_DEPTH,
+                          AsyncIOBackend backend = AsyncIOBackend::IoUring);
+
+    ~AsyncBlockIO();
+    AsyncBlockIO(const AsyncBlockIO&) = delete;
+    AsyncBlockIO& operator=(const AsyncBlockIO&) = delete;
+
+    std::future<std::vector<uint8_t>> get(const Checksum& checksum);
+    std::future<Checksum> put(std::vector<uint8_t> data);
+    std::future<Checksum> put(std::vector<uint8_t> data, const BlockMetadata& metadata);
+    std::future<bool> has(const Checksum& checksum);
+
+    /**
+     * Submit a batch of reads.
+     * @return One future per checksum, in the same order
+     */
+    std::vector<std::future<std::vector<uint8_t>>> getBatch(const std::vector<Checksum>& checksums);
+
+    /**
+     * Submit a batch of reads completing through a callback.
+     */
+    void getBatch(const std::vector<Checksum>& checksums, GetCallback callback);
+
+    /**
+     * Submit a batch of writes.
+     * @return One future per block, in the same order
+     */
+    std::vector<std::future<Checksum>> putBatch(std::vector<std::vector<uint8_t>> blocks);
+
+    /**
+     * Submit a batch of writes completing through a callback.
+     */
+    void putBatch(std::vector<std::vector<uint8_t>> blocks, PutCallback callback);
+
+    /**
+     * Submit a batch of existence checks.
+     */
+    std::vector<std::future<bool>> hasBatch(const std::vector<Checksum>& checksums);
+
+    /**
+     * Block until every submitted request has completed.
+     */
+    void drain();
+
+    /**
+     * Number of requests submitted but not yet completed.
+     */
+    size_t inFlight() const { return inFlight_.load(std::memory_order_relaxed); }
+
+    size_t queueDepth() const { return pool_.size(); }
+
+    /**
+     * Backend actually used for reads.
+     */
+    AsyncIOBackend backend() const {
+        return ring_ ? AsyncIOBackend::IoUring : AsyncIOBackend::ThreadPool;
+    }
+
+    DiskBlockStore& store() { return store_; }
+
+private:
+    class Ring;
+
+    template <typename F>
+    auto enqueue(F&& task);
+
+    /**
+     * Read a block through the ring, or on the pool without one.
+     */
+    void read(const Checksum& checksum,
+              std::function<void(std::vector<uint8_t>, std::exception_ptr)> done);
+
+    DiskBlockStore& store_;
+    std::atomic<size_t> inFlight_{0};
+    ThreadPool pool_;
+    std::unique_ptr<Ring> ring_;
+};
+
+} // namespace brightchain
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "brightchain/block_size.hpp"
+#include "brightchain/checksum.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * Counters reported by a BlockCache.
+ */
+struct BlockCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t insertions = 0;
+    uint64_t evictions = 0;
+    uint64_t bytes = 0;
+    uint64_t entries = 0;
+};
+
+/**
+ * In-memory cache of block contents keyed by Checksum.
+ *
+ * Each BlockSize has its own byte budget (0 disables caching for that size).
+ * Entries are spread over lock-striped shards that each own an equal slice of
+ * every budget, so budget / shardCount should hold several blocks of that
+ * size. Each shard evicts with the 2Q policy: first-time blocks enter a small
+ * FIFO (A1in), and only blocks that are requested again after leaving it
+ * (tracked by the A1out ghost list) are promoted to the main LRU (Am). A large
+ * one-pass scan therefore cycles through A1in without displacing the hot
+ * working set.
+ *
+ * Cached blocks are shared immutable buffers, so concurrent readers of the
+ * same block never copy it.
+ */
+class BlockCache {
+public:
+    using Entry = std::shared_ptr<const std::vector<uint8_t>>;
+
+    static constexpr size_t DEFAULT_SHARD_COUNT = 16;
+
+    /**
+     * Constructor.
+     * @param shardCount Number of independently locked shards
+     */
+    explicit BlockCache(size_t shardCount = DEFAULT_SHARD_COUNT);
+
+    /**
+     * Set the byte budget for blocks of a given size. Shrinking a budget
+     * evicts immediately.
+     */
+    void setBudget(BlockSize blockSize, uint64_t bytes);
+
+    uint64_t budget(BlockSize blockSize) const;
+
+    /**
+     * Look up a block.
+     * @param checksum Block checksum
+     * @param blockSize Size class the lookup is counted against
+     * @return Cached data, or nullptr on a miss
+     */
+    Entry get(const Checksum& checksum, BlockSize blockSize);
+
+    /**
+     * Insert a block after a miss.
+     * @param checksum Block checksum
+     * @param blockSize Size class whose budget the block is charged to
+     * @param data Block data
+     * @param generation generation() read before the block was loaded; if
+     *                   the checksum's shard has erased anything since, the
+     *                   load may predate a removal and is not inserted
+     */
+    void put(const Checksum& checksum, BlockSize blockSize, Entry data,
+             std::optional<uint64_t> generation = std::nullopt);
+
+    /**
+     * Drop a block (e.g. after it is removed from the store).
+     */
+    void erase(const Checksum& checksum);
+
+    /**
+     * Erase count of the shard holding a checksum, for put().
+     */
+    uint64_t generation(const Checksum& checksum) const;
+
+    void clear();
+
+    /**
+     * Counters summed over all size classes.
+     */
+    BlockCacheStats stats() const;
+
+    /**
+     * Counters for one size class.
+     */
+    BlockCacheStats stats(BlockSize blockSize) const;
+
+private:
+    enum class Queue : uint8_t { A1in, Am };
+
+    struct Node {
+        Checksum checksum;
+        Entry data;
+        Queue queue;
+    };
+
+    struct SizeClass {
+        uint64_t budget = 0; // this shard's slice of the size class budget
+        uint64_t a1inBytes = 0;
+        uint64_t amBytes = 0;
+        uint64_t ghostBytes = 0;
+        std::list<Node> a1in;                                   // FIFO, newest at front
+        std::list<Node> am;                                     // LRU, most recent at front
+        std::list<std::pair<Checksum, uint64_t>> a1out;         // ghost keys, newest at front
+        std::unordered_map<Checksum, std::list<std::pair<Checksum, uint64_t>>::iterator> ghosts;
+        BlockCacheStats stats;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<Checksum, std::pair<size_t, std::list<Node>::iterator>> index;
+        std::array<SizeClass, VALID_BLOCK_SIZES.size()> classes;
+        uint64_t generation = 0; // bumped by every erase()
+    };
+
+    static size_t classIndex(BlockSize blockSize);
+    Shard& shardFor(const Checksum& checksum) const;
+    void evict(Shard& shard, size_t cls);
+    void removeNode(Shard& shard, size_t cls, std::list<Node>::iterator node);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::array<std::atomic<uint64_t>, VALID_BLOCK_SIZES.size()> budgets_{};
+};
+
+/**
+ * Read-through caching decorator for a DiskBlockStore. Reads are served from
+ * the cache when possible; writes go straight to the store and removals
+ * invalidate the cached copy. A miss that loaded a block before a concurrent
+ * remove() does not put it back into the cache.
+ */
+class CachingBlockStore {
+public:
+    /**
+     * Constructor.
+     * @param store Backing store (must outlive this object)
+     * @param cache Cache (may be shared between several stores)
+     */
+    CachingBlockStore(DiskBlockStore& store, BlockCache& cache);
+
+    Checksum put(const std::vector<uint8_t>& data);
+    Checksum put(const std::vector<uint8_t>& data, const BlockMetadata& metadata);
+
+    /**
+     * Retrieve a block, copying it out of the cache.
+     * @throws std::runtime_error if block not found
+     */
+    std::vector<uint8_t> get(const Checksum& checksum) const;
+
+    /**
+     * Retrieve a block as a shared buffer without copying.
+     * @throws std::runtime_error if block not found
+     */
+    BlockCache::Entry getShared(const Checksum& checksum) const;
+
+    bool has(const Checksum& checksum) const;
+    bool remove(const Checksum& checksum);
+
+    DiskBlockStore& store() const { return store_; }
+    BlockCache& cache() const { return cache_; }
+
+private:
+    DiskBlockStore& store_;
+    BlockCache& cache_;
+};
+
+} // namespace brightchain
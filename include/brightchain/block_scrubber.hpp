@@ -0,0 +1,166 @@
+#pragma once
+
+#include "brightchain/disk_block_store.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * Construction options for a BlockScrubber.
+ */
+struct ScrubberOptions {
+    /**
+     * Read budget in bytes per second; 0 disables throttling.
+     */
+    uint64_t bytesPerSecond = 16 * 1024 * 1024;
+
+    /**
+     * Nice value of the background thread (Linux: per thread). Best effort.
+     */
+    int niceLevel = 19;
+
+    /**
+     * Put the background thread in the idle I/O scheduling class so its
+     * reads are only served when no foreground I/O is waiting. Best effort.
+     */
+    bool idleIoPriority = true;
+
+    /**
+     * Pause between two passes of the background thread.
+     */
+    std::chrono::seconds passInterval{std::chrono::hours(24)};
+
+    /**
+     * Blocks verified between cursor saves; a restart repeats at most this many.
+     */
+    size_t cursorInterval = 256;
+
+    /**
+     * Called after a block failed verification and was quarantined.
+     */
+    std::function<void(const Checksum&)> onCorrupt;
+};
+
+/**
+ * Progress counters of a BlockScrubber.
+ */
+struct ScrubStats {
+    uint64_t passesCompleted = 0; // Persisted across restarts
+    uint64_t blocksVerified = 0;  // Since construction
+    uint64_t bytesVerified = 0;   // Since construction
+    uint64_t corruptBlocks = 0;   // Quarantined since construction
+    uint64_t skippedBlocks = 0;   // Unreadable for a transient reason since construction
+    uint64_t passBlocks = 0;      // Verified so far in the current pass
+    uint64_t passTotal = 0;       // Blocks scheduled for the current pass
+};
+
+/**
+ * BlockScrubber re-hashes stored blocks to detect bit rot. A block whose
+ * content no longer matches its checksum (or fails with a read error) is
+ * moved out of the store with DiskBlockStore::quarantine(). A block that
+ * cannot be opened or mapped for a transient reason, such as EMFILE or
+ * ENOMEM, is counted as skipped and verified again on the next pass.
+ *
+ * Each pass visits the blocks listed by forEachChecksum() in checksum
+ * order. The last verified checksum is saved to
+ * storePath/blockSize/scrub.cursor, so a restarted scrubber resumes the
+ * pass where it stopped. Blocks are read through sequential memory
+ * mappings and throttled to bytesPerSecond; the background thread also
+ * lowers its CPU and I/O priority so scrubbing yields to foreground work.
+ */
+class BlockScrubber {
+public:
+    /**
+     * Constructor. Loads the persisted cursor, if any.
+     * @param store Store to verify; must outlive the scrubber
+     * @param options Budget and scheduling options
+     * @throws std::runtime_error if the cursor file is corrupt
+     */
+    explicit BlockScrubber(DiskBlockStore& store, ScrubberOptions options = {});
+
+    /**
+     * Destructor. Stops the background thread and saves the cursor.
+     */
+    ~BlockScrubber();
+
+    BlockScrubber(const BlockScrubber&) = delete;
+    BlockScrubber& operator=(const BlockScrubber&) = delete;
+
+    /**
+     * Start scrubbing on a background thread. No-op if already running.
+     */
+    void start();
+
+    /**
+     * Stop the background thread after the block in progress.
+     */
+    void stop();
+
+    bool running() const;
+
+    /**
+     * Verify blocks on the calling thread, continuing the current pass.
+     * Stops at the end of a pass; the next call begins a new one.
+     * @param maxBlocks Upper bound on blocks verified by this call
+     * @return Number of blocks verified
+     */
+    size_t scrub(size_t maxBlocks = std::numeric_limits<size_t>::max());
+
+    ScrubStats stats() const;
+
+    /**
+     * Path of the persisted cursor.
+     */
+    const std::filesystem::path& cursorPath() const { return cursorPath_; }
+
+private:
+    void run();
+    void beginPass();
+    void verify(const Checksum& checksum);
+    void throttle(uint64_t bytes);
+    void loadCursor();
+    void saveCursor() const;
+
+    /**
+     * Sleep until the deadline or stop().
+     * @return False if stopped
+     */
+    bool sleepUntil(std::chrono::steady_clock::time_point deadline);
+
+    DiskBlockStore& store_;
+    const ScrubberOptions options_;
+    const std::filesystem::path cursorPath_;
+
+    std::mutex scrubMutex_; // Serializes scrub() calls
+    std::vector<Checksum> pass_;
+    size_t next_ = 0;
+    bool passLoaded_ = false;
+    std::optional<Checksum> cursor_;
+    std::chrono::steady_clock::time_point windowStart_;
+    uint64_t windowBytes_ = 0;
+
+    std::atomic<uint64_t> passes_{0};
+    std::atomic<uint64_t> blocksVerified_{0};
+    std::atomic<uint64_t> bytesVerified_{0};
+    std::atomic<uint64_t> corruptBlocks_{0};
+    std::atomic<uint64_t> skippedBlocks_{0};
+    std::atomic<uint64_t> passBlocks_{0};
+    std::atomic<uint64_t> passTotal_{0};
+
+    mutable std::mutex threadMutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> stopRequested_{false};
+    std::thread worker_;
+};
+
+} // namespace brightchain
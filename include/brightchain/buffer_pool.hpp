@@ -0,0 +1,145 @@
+#pragma once
+
+#include "brightchain/block_size.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace brightchain {
+
+class BufferPool;
+
+/**
+ * Shared state of a BufferPool, kept alive by its buffers (buffer_pool.cpp).
+ */
+struct BufferDepot;
+
+/**
+ * BlockBuffer is a move-only handle to a pooled, aligned buffer of one block
+ * size. Destroying the handle returns the buffer to its pool. The contents
+ * of a freshly acquired buffer are unspecified.
+ */
+class BlockBuffer {
+public:
+    BlockBuffer() = default;
+    ~BlockBuffer();
+
+    BlockBuffer(BlockBuffer&& other) noexcept;
+    BlockBuffer& operator=(BlockBuffer&& other) noexcept;
+    BlockBuffer(const BlockBuffer&) = delete;
+    BlockBuffer& operator=(const BlockBuffer&) = delete;
+
+    uint8_t* data() { return data_; }
+    const uint8_t* data() const { return data_; }
+
+    /**
+     * Number of valid bytes; equals capacity() unless resize() shrank it.
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * Length of the block size class.
+     */
+    size_t capacity() const { return blockSizeToLength(blockSize_); }
+
+    BlockSize blockSize() const { return blockSize_; }
+
+    bool empty() const { return data_ == nullptr; }
+
+    /**
+     * Set the number of valid bytes.
+     * @throws std::length_error if size exceeds capacity()
+     */
+    void resize(size_t size);
+
+    std::span<uint8_t> span() { return {data_, size_}; }
+    std::span<const uint8_t> span() const { return {data_, size_}; }
+    operator std::span<const uint8_t>() const { return span(); }
+
+    /**
+     * Return the buffer to its pool now, leaving the handle empty.
+     */
+    void reset();
+
+private:
+    friend class BufferPool;
+
+    BlockBuffer(std::shared_ptr<BufferDepot> depot, uint8_t* data, BlockSize blockSize)
+        : depot_(std::move(depot)), data_(data), size_(blockSizeToLength(blockSize)),
+          blockSize_(blockSize) {}
+
+    std::shared_ptr<BufferDepot> depot_;
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    BlockSize blockSize_ = BlockSize::Unknown;
+};
+
+/**
+ * Allocation counters of one size class.
+ */
+struct BufferPoolStats {
+    uint64_t allocations = 0; // Buffers obtained from the system
+    uint64_t reuses = 0;      // Acquisitions served from a cache
+    uint64_t retained = 0;    // Idle buffers held by the shared depot
+};
+
+/**
+ * BufferPool recycles block-sized buffers so that steady-state block I/O
+ * does not allocate. Released buffers go to a small per-thread cache first
+ * (Large and Huge buffers skip it) and then to a shared depot with a bounded
+ * number of buffers per size class; anything beyond that is returned to the
+ * system.
+ *
+ * Buffers up to Medium are aligned to their own size (Message, Tiny) or the
+ * page size, so they can be used for O_DIRECT. Large and Huge buffers are
+ * anonymous mappings backed by explicit huge pages when the system has
+ * them reserved and by transparent huge pages otherwise, where the platform
+ * offers either.
+ *
+ * Destroying the pool frees its idle buffers, and buffers still in use are
+ * freed when released. Buffers another thread has cached for it are freed
+ * when that thread next uses any pool, or when it exits.
+ */
+class BufferPool {
+public:
+    BufferPool();
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * Get a buffer of one block size.
+     * @throws std::invalid_argument for BlockSize::Unknown
+     * @throws std::bad_alloc if the system is out of memory
+     */
+    BlockBuffer acquire(BlockSize blockSize);
+
+    /**
+     * Limit the idle buffers kept in the shared depot for a size class,
+     * freeing any excess now.
+     */
+    void setRetention(BlockSize blockSize, size_t buffers);
+
+    size_t retention(BlockSize blockSize) const;
+
+    /**
+     * Free every idle buffer in the shared depot and the calling thread's cache.
+     */
+    void trim();
+
+    BufferPoolStats stats(BlockSize blockSize) const;
+
+    /**
+     * Process-wide pool.
+     */
+    static BufferPool& shared();
+
+private:
+    std::shared_ptr<BufferDepot> depot_;
+};
+
+} // namespace brightchain
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "brightchain/cbl.hpp"
+#include "brightchain/checksum.hpp"
+#include "brightchain/constants.hpp"
+#include "brightchain/super_cbl.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * Non-owning view of a 64-byte hash stored inside a block.
+ * Valid only while the underlying bytes are.
+ */
+class ChecksumView {
+public:
+    ChecksumView() = default;
+    explicit ChecksumView(const uint8_t* bytes) : bytes_(bytes) {}
+
+    const uint8_t* data() const { return bytes_; }
+    std::span<const uint8_t, Checksum::HASH_SIZE> bytes() const {
+        return std::span<const uint8_t, Checksum::HASH_SIZE>(bytes_, Checksum::HASH_SIZE);
+    }
+
+    /**
+     * Copy the hash into an owning Checksum.
+     */
+    Checksum toChecksum() const;
+    std::string toHex() const { return toChecksum().toHex(); }
+
+    friend bool operator==(ChecksumView a, ChecksumView b) {
+        return std::memcmp(a.bytes_, b.bytes_, Checksum::HASH_SIZE) == 0;
+    }
+    friend bool operator==(ChecksumView a, const Checksum& b) {
+        return std::memcmp(a.bytes_, b.hash().data(), Checksum::HASH_SIZE) == 0;
+    }
+    friend bool operator<(ChecksumView a, ChecksumView b) {
+        return std::memcmp(a.bytes_, b.bytes_, Checksum::HASH_SIZE) < 0;
+    }
+    friend bool operator<(ChecksumView a, const Checksum& b) {
+        return std::memcmp(a.bytes_, b.hash().data(), Checksum::HASH_SIZE) < 0;
+    }
+    friend bool operator<(const Checksum& a, ChecksumView b) {
+        return std::memcmp(a.hash().data(), b.bytes_, Checksum::HASH_SIZE) < 0;
+    }
+
+private:
+    const uint8_t* bytes_ = nullptr;
+};
+
+/**
+ * Random-access range over consecutive 64-byte hashes (the address list of
+ * a CBL or the child list of a SuperCBL). Elements are ChecksumViews, so
+ * iterating, indexing and standard algorithms (std::find, std::lower_bound
+ * on sorted lists) never allocate.
+ */
+class ChecksumRange {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using iterator_concept = std::random_access_iterator_tag;
+        using value_type = ChecksumView;
+        using difference_type = std::ptrdiff_t;
+        using reference = ChecksumView;
+        using pointer = void;
+
+        iterator() = default;
+        explicit iterator(const uint8_t* position) : position_(position) {}
+
+        ChecksumView operator*() const { return ChecksumView(position_); }
+        ChecksumView operator[](difference_type n) const { return *(*this + n); }
+
+        iterator& operator++() { position_ += Checksum::HASH_SIZE; return *this; }
+        iterator operator++(int) { iterator old = *this; ++*this; return old; }
+        iterator& operator--() { position_ -= Checksum::HASH_SIZE; return *this; }
+        iterator operator--(int) { iterator old = *this; --*this; return old; }
+        iterator& operator+=(difference_type n) {
+            position_ += n * static_cast<difference_type>(Checksum::HASH_SIZE);
+            return *this;
+        }
+        iterator& operator-=(difference_type n) { return *this += -n; }
+
+        friend iterator operator+(iterator it, difference_type n) { return it += n; }
+        friend iterator operator+(difference_type n, iterator it) { return it += n; }
+        friend iterator operator-(iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(iterator a, iterator b) {
+            return (a.position_ - b.position_) / static_cast<difference_type>(Checksum::HASH_SIZE);
+        }
+        friend bool operator==(iterator a, iterator b) { return a.position_ == b.position_; }
+        friend auto operator<=>(iterator a, iterator b) { return a.position_ <=> b.position_; }
+
+    private:
+        const uint8_t* position_ = nullptr;
+    };
+
+    ChecksumRange() = default;
+    ChecksumRange(const uint8_t* first, size_t count) : first_(first), count_(count) {}
+
+    iterator begin() const { return iterator(first_); }
+    iterator end() const { return iterator(first_ + count_ * Checksum::HASH_SIZE); }
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    ChecksumView operator[](size_t index) const {
+        return ChecksumView(first_ + index * Checksum::HASH_SIZE);
+    }
+    ChecksumView front() const { return (*this)[0]; }
+    ChecksumView back() const { return (*this)[count_ - 1]; }
+
+    /**
+     * Sub-range [offset, offset + count); the caller keeps it in bounds.
+     */
+    ChecksumRange subrange(size_t offset, size_t count) const {
+        return ChecksumRange(first_ + offset * Checksum::HASH_SIZE, count);
+    }
+
+    /**
+     * Copy out owning Checksums, for callers that outlive the block.
+     */
+    std::vector<Checksum> toVector() const;
+
+private:
+    const uint8_t* first_ = nullptr;
+    size_t count_ = 0;
+};
+
+/**
+ * CBLView parses a CBL or ExtendedCBL in place over borrowed bytes (a
+ * MappedBlock, a vector, a packed segment) without copying the block or
+ * materializing its addresses. Header fields are decoded on access.
+ *
+ * The view holds pointers into the span; keep the bytes alive and
+ * unmodified for as long as the view or any ChecksumView taken from it.
+ */
+class CBLView {
+public:
+    /**
+     * Constructor.
+     * @param data Whole block bytes
+     * @throws std::invalid_argument if the bytes are not a CBL or ExtendedCBL,
+     *         or the address list does not fit in the block
+     */
+    explicit CBLView(std::span<const uint8_t> data);
+
+    StructuredBlockType type() const { return static_cast<StructuredBlockType>(data_[1]); }
+    bool isExtended() const { return type() == StructuredBlockType::ExtendedCBL; }
+
+    std::span<const uint8_t, 16> creatorId() const {
+        return std::span<const uint8_t, 16>(data_.data() + 4, 16);
+    }
+    uint64_t dateCreated() const;
+    uint32_t addressCount() const { return static_cast<uint32_t>(addresses_.size()); }
+    uint32_t tupleSize() const { return data_[32]; }
+    uint64_t originalDataLength() const;
+    ChecksumView originalDataChecksum() const { return ChecksumView(data_.data() + 41); }
+    std::span<const uint8_t, 64> signature() const;
+
+    /**
+     * ExtendedCBL file name and MIME type; empty for a plain CBL.
+     */
+    std::string_view fileName() const { return fileName_; }
+    std::string_view mimeType() const { return mimeType_; }
+
+    /**
+     * Bytes ahead of the address list (header plus ExtendedCBL metadata).
+     */
+    size_t layerOverheadSize() const { return overhead_; }
+
+    ChecksumRange addresses() const { return addresses_; }
+
+    /**
+     * Everything after the layer header, as ConstituentBlockListBlock::layerPayload().
+     */
+    std::span<const uint8_t> layerPayload() const { return data_.subspan(overhead_); }
+
+    std::span<const uint8_t> data() const { return data_; }
+
+private:
+    std::span<const uint8_t> data_;
+    size_t overhead_ = CBLHeader::SIZE;
+    std::string_view fileName_;
+    std::string_view mimeType_;
+    ChecksumRange addresses_;
+};
+
+/**
+ * SuperCBLView parses a SuperCBL in place over borrowed bytes; the same
+ * lifetime rules as CBLView apply.
+ */
+class SuperCBLView {
+public:
+    /**
+     * Constructor.
+     * @param data Whole block bytes
+     * @throws std::invalid_argument if the bytes are not a SuperCBL or the
+     *         child list does not fit in the block
+     */
+    explicit SuperCBLView(std::span<const uint8_t> data);
+
+    std::span<const uint8_t, 16> creatorId() const {
+        return std::span<const uint8_t, 16>(data_.data() + 4, 16);
+    }
+    uint64_t dateCreated() const;
+    uint32_t subCblCount() const { return static_cast<uint32_t>(children_.size()); }
+    uint32_t totalBlockCount() const;
+    uint16_t depth() const;
+    uint64_t originalDataLength() const;
+    ChecksumView originalDataChecksum() const { return ChecksumView(data_.data() + 46); }
+    std::span<const uint8_t, 64> signature() const {
+        return std::span<const uint8_t, 64>(data_.data() + 110, 64);
+    }
+
+    ChecksumRange subCblChecksums() const { return children_; }
+    std::span<const uint8_t> layerPayload() const { return data_.subspan(SuperCBLHeader::SIZE); }
+    std::span<const uint8_t> data() const { return data_; }
+
+private:
+    std::span<const uint8_t> data_;
+    ChecksumRange children_;
+};
+
+} // namespace brightchain
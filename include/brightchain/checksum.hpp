@@ -5,6 +5,7 @@
 #include <vector>
 #include <array>
 #include <memory>
+#include <span>
 
 namespace brightchain {
 
@@ -24,6 +25,24 @@ public:
      */
     static Checksum fromData(const std::vector<uint8_t>& data);
 
+    /**
+     * Create checksum from a buffer without copying it (e.g. a MappedBlock).
+     * @param data Pointer to the data to hash
+     * @param length Length of the data
+     * @return Checksum object
+     */
+    static Checksum fromData(const uint8_t* data, size_t length);
+
+    /**
+     * Hash many equal-length blocks at once, using the widest multi-lane
+     * SHA3 kernel the CPU supports (see sha3_batch.hpp).
+     * @param blocks Pointers to the blocks
+     * @param length Length of every block
+     * @return One checksum per block, in order
+     */
+    static std::vector<Checksum> fromBlocks(std::span<const uint8_t* const> blocks,
+                                            size_t length);
+
     /**
      * Create checksum from hex string.
      * @param hex Hex string representation
@@ -67,6 +86,40 @@ private:
     HashArray hash_;
 };
 
+/**
+ * Incremental SHA3-512 for data that arrives in pieces (e.g. whole files
+ * that are hashed while being split into blocks). One-shot hashing through
+ * Checksum::fromData reuses a per-thread context instead.
+ */
+class ChecksumStream {
+public:
+    ChecksumStream();
+    ~ChecksumStream();
+    ChecksumStream(const ChecksumStream&) = delete;
+    ChecksumStream& operator=(const ChecksumStream&) = delete;
+
+    /**
+     * Append data to the hashed stream.
+     */
+    void update(const uint8_t* data, size_t length);
+    void update(std::span<const uint8_t> data) { update(data.data(), data.size()); }
+
+    /**
+     * Finish hashing. The stream must not be updated again until reset().
+     * @return Checksum of everything passed to update()
+     */
+    Checksum finish();
+
+    /**
+     * Start a new stream, reusing the context.
+     */
+    void reset();
+
+private:
+    struct Context;
+    std::unique_ptr<Context> context_;
+};
+
 } // namespace brightchain
 
 // Hash function for std::unordered_map
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "brightchain/checksum.hpp"
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * Cuckoo filter over block checksums (Fan et al., 2014).
+ * Answers "definitely absent" or "possibly present" and, unlike a Bloom
+ * filter, supports deletion. Each bucket holds four 16-bit fingerprints,
+ * giving a false positive rate of roughly 0.01% at 95% occupancy.
+ *
+ * Checksums are already uniformly distributed SHA3-512 digests, so bucket
+ * indices and fingerprints are taken directly from the hash bytes.
+ *
+ * Not thread-safe; callers synchronize access.
+ */
+class CuckooFilter {
+public:
+    static constexpr size_t SLOTS_PER_BUCKET = 4;
+    static constexpr size_t MAX_KICKS = 500;
+
+    /**
+     * Constructor.
+     * @param expectedItems Number of items the filter should hold comfortably
+     */
+    explicit CuckooFilter(size_t expectedItems = 0);
+
+    /**
+     * Add a checksum. Adding the same checksum twice stores it twice.
+     * @return False if the filter is too full to place it (the filter is left
+     *         unchanged; rebuild it with a larger capacity)
+     */
+    bool insert(const Checksum& checksum);
+
+    /**
+     * Test membership.
+     * @return False if the checksum was definitely never inserted
+     */
+    bool contains(const Checksum& checksum) const;
+
+    /**
+     * Remove one copy of a checksum. Only remove checksums that were inserted,
+     * otherwise another item's fingerprint may be dropped.
+     * @return True if a matching fingerprint was removed
+     */
+    bool remove(const Checksum& checksum);
+
+    size_t size() const { return count_; }
+    size_t capacity() const { return buckets_.size() * SLOTS_PER_BUCKET; }
+
+    /**
+     * Write the filter to disk.
+     * @throws std::runtime_error on I/O failure
+     */
+    void save(const std::filesystem::path& path) const;
+
+    /**
+     * Read a filter written by save().
+     * @return The filter, or nullopt if the file is missing or invalid
+     */
+    static std::optional<CuckooFilter> load(const std::filesystem::path& path);
+
+private:
+    using Bucket = std::array<uint16_t, SLOTS_PER_BUCKET>;
+
+    static uint16_t fingerprint(const Checksum& checksum);
+    size_t primaryIndex(const Checksum& checksum) const;
+    size_t alternateIndex(size_t index, uint16_t fp) const;
+    bool insertInto(size_t index, uint16_t fp);
+
+    std::vector<Bucket> buckets_;
+    size_t count_ = 0;
+    uint64_t victimSeed_ = 0;
+};
+
+} // namespace brightchain
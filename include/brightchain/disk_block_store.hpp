@@ -2,18 +2,110 @@
 
 #include "brightchain/block_size.hpp"
 #include "brightchain/block_metadata.hpp"
+#include "brightchain/buffer_pool.hpp"
 #include "brightchain/checksum.hpp"
+#include "brightchain/cuckoo_filter.hpp"
+#include "brightchain/group_commit.hpp"
+#include "brightchain/mapped_block.hpp"
+#include "brightchain/metadata_index.hpp"
+#include "brightchain/packed_segment_store.hpp"
+#include "brightchain/ref_count_table.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace brightchain {
 
+/**
+ * On-disk layout used by a DiskBlockStore.
+ */
+enum class StorageLayout {
+    FilePerBlock, // One file per block, metadata in a per-size index
+    Packed        // Blocks appended to segment files (Message/Tiny/Small only)
+};
+
+/**
+ * When a put() is considered durable.
+ */
+enum class Durability {
+    None,       // Rely on the OS to write back; a power loss may drop recent blocks
+    PerWrite,   // fsync every block before put() returns
+    GroupCommit // put() waits for a background committer that batches fsyncs
+};
+
+/**
+ * Construction options for a DiskBlockStore.
+ */
+struct DiskBlockStoreOptions {
+    StorageLayout layout = StorageLayout::FilePerBlock;
+
+    /**
+     * Keep an in-memory cuckoo filter of stored checksums so that has()/get()
+     * for absent blocks never touch the filesystem. The filter is saved on
+     * clean shutdown and rebuilt by scanning the store otherwise; opening the
+     * store without the filter discards a saved one. Only enable it when this
+     * process is the sole writer of the store directory.
+     */
+    bool existenceFilter = false;
+
+    /**
+     * Durability of put(). In every mode FilePerBlock blocks are written to a
+     * temporary file and renamed into place, so a crash never leaves a
+     * partial block under a checksum name.
+     */
+    Durability durability = Durability::None;
+
+    /**
+     * GroupCommit only: longest time a put() waits for its batch.
+     */
+    std::chrono::milliseconds groupCommitInterval{5};
+
+    /**
+     * GroupCommit only: pending bytes that trigger an immediate batch.
+     */
+    size_t groupCommitBytes = 4 * 1024 * 1024;
+
+    /**
+     * FilePerBlock only: when a block's bytes past length_without_padding are
+     * all one value, write only the unpadded prefix and leave the rest of the
+     * file as a sparse hole. Non-zero fill values are recorded in the
+     * metadata index and re-materialized on read. Checksums are unaffected.
+     */
+    bool virtualPadding = false;
+
+    /**
+     * Count references to each block in storePath/blockSize/refcounts.idx
+     * (see RefCountTable). put() of a block that is already stored only
+     * adds a reference, without writing data or replacing its metadata, and
+     * concurrent puts of one checksum wait for a single writer. remove()
+     * drops one reference and deletes the block with the last one; addRef()
+     * and forceRemove() adjust references without data. Blocks stored
+     * before counting was enabled hold one reference.
+     */
+    bool referenceCounting = false;
+};
+
 /**
  * DiskBlockStore provides base functionality for storing blocks on disk.
- * Directory structure: storePath/blockSize/char1/char2/checksum
- * Metadata files: storePath/blockSize/char1/char2/checksum.m.json
+ * FilePerBlock layout:
+ *   Directory structure: storePath/blockSize/char1/char2/checksum
+ *   Metadata index: storePath/blockSize/metadata.idx (see MetadataIndex)
+ *   Legacy metadata files: storePath/blockSize/char1/char2/checksum.m.json
+ *   (still read if present; see migrateJsonMetadata())
+ * Packed layout:
+ *   Segment files: storePath/blockSize/segments/NNNNNNNN.seg (see PackedSegmentStore)
  */
 class DiskBlockStore {
 public:
@@ -21,8 +113,28 @@ public:
      * Constructor.
      * @param storePath Root directory for block storage
      * @param blockSize Block size for this store
+     * @param layout On-disk layout
+     * @throws std::invalid_argument if Packed is requested for blocks larger than Small
      */
-    DiskBlockStore(const std::string& storePath, BlockSize blockSize);
+    DiskBlockStore(const std::string& storePath, BlockSize blockSize,
+                   StorageLayout layout = StorageLayout::FilePerBlock);
+
+    /**
+     * Constructor.
+     * @param storePath Root directory for block storage
+     * @param blockSize Block size for this store
+     * @param options Layout and acceleration options
+     */
+    DiskBlockStore(const std::string& storePath, BlockSize blockSize,
+                   const DiskBlockStoreOptions& options);
+
+    /**
+     * Destructor. Persists the existence filter if one is enabled.
+     */
+    ~DiskBlockStore();
+
+    DiskBlockStore(const DiskBlockStore&) = delete;
+    DiskBlockStore& operator=(const DiskBlockStore&) = delete;
 
     /**
      * Store a block.
@@ -32,13 +144,35 @@ public:
     Checksum put(const std::vector<uint8_t>& data);
 
     /**
-     * Store a block with metadata.
+     * Store a block with metadata. Returns once the block is as durable as the
+     * store's Durability mode promises. With reference counting, storing a
+     * block that already exists only adds a reference.
      * @param data Block data
      * @param metadata Block metadata
      * @return Checksum of the stored block
+     * @throws std::overflow_error if an added reference would exceed UINT32_MAX
      */
     Checksum put(const std::vector<uint8_t>& data, const BlockMetadata& metadata);
 
+    /**
+     * Store a block whose checksum the caller has already computed (e.g.
+     * with Checksum::fromBlocks), skipping the hash pass.
+     * @param checksum Checksum::fromData(data); not verified
+     * @param data Block data
+     * @param metadata Block metadata
+     * @return The given checksum
+     */
+    Checksum put(const Checksum& checksum, std::span<const uint8_t> data,
+                 const BlockMetadata& metadata);
+
+    /**
+     * Store a block held in a pooled buffer.
+     * @param data Block data (data.size() bytes)
+     * @param metadata Block metadata
+     * @return Checksum of the stored block
+     */
+    Checksum put(const BlockBuffer& data, const BlockMetadata& metadata);
+
     /**
      * Retrieve a block.
      * @param checksum Block checksum
@@ -47,6 +181,27 @@ public:
      */
     std::vector<uint8_t> get(const Checksum& checksum) const;
 
+    /**
+     * Retrieve a block into a buffer from a pool, so that repeated reads do
+     * not allocate.
+     * @param checksum Block checksum
+     * @param pool Pool to take the buffer from
+     * @return Block data, sized to the stored block
+     * @throws std::runtime_error if block not found
+     */
+    BlockBuffer getBuffer(const Checksum& checksum,
+                          BufferPool& pool = BufferPool::shared()) const;
+
+    /**
+     * Retrieve a block as a read-only memory-mapped view, avoiding the heap
+     * copy made by get(). The view remains valid after the block is removed.
+     * @param checksum Block checksum
+     * @param hint Expected access pattern
+     * @return Mapped block data
+     * @throws std::runtime_error if block not found
+     */
+    MappedBlock getMapped(const Checksum& checksum, AccessHint hint = AccessHint::Normal) const;
+
     /**
      * Check if a block exists.
      * @param checksum Block checksum
@@ -55,12 +210,59 @@ public:
     bool has(const Checksum& checksum) const;
 
     /**
-     * Delete a block.
+     * Delete a block. With reference counting, drop one reference and only
+     * delete the block once none remain.
      * @param checksum Block checksum
      * @return True if block was deleted
      */
     bool remove(const Checksum& checksum);
 
+    /**
+     * Add references to a stored block without writing it, e.g. when another
+     * structure starts sharing it. Without reference counting the block
+     * keeps its single reference.
+     * @param checksum Block checksum
+     * @param count References to add
+     * @return False if the block is not stored
+     * @throws std::overflow_error if the count would exceed UINT32_MAX
+     */
+    bool addRef(const Checksum& checksum, uint32_t count = 1);
+
+    /**
+     * Delete a block regardless of its reference count.
+     * @param checksum Block checksum
+     * @return True if block was deleted
+     */
+    bool forceRemove(const Checksum& checksum);
+
+    /**
+     * Take a damaged block out of service: its stored bytes are moved to
+     * quarantineDir()/checksum for inspection and the block is removed
+     * regardless of its reference count. Its reference count is kept, so a
+     * put() of the repaired block carries the references over.
+     * @param checksum Block checksum
+     * @return True if the block was stored
+     */
+    bool quarantine(const Checksum& checksum);
+
+    /**
+     * Directory holding quarantined blocks: storePath/blockSize/quarantine.
+     */
+    std::filesystem::path quarantineDir() const;
+
+    /**
+     * Number of references to a block.
+     * @param checksum Block checksum
+     * @return 0 if the block is not stored; always 1 without reference counting
+     */
+    uint32_t refCount(const Checksum& checksum) const;
+
+    /**
+     * Invoke a callback for every stored block.
+     * @param callback Called with each block checksum
+     */
+    void forEachChecksum(const std::function<void(const Checksum&)>& callback) const;
+
     /**
      * Store metadata for a block.
      * @param checksum Block checksum
@@ -82,11 +284,35 @@ public:
      */
     bool hasMetadata(const Checksum& checksum) const;
 
+    /**
+     * One-time migration of legacy .m.json metadata sidecars into the binary
+     * metadata index. Each sidecar is deleted once its record is indexed.
+     * No-op for the Packed layout.
+     * @return Number of sidecars migrated
+     * @throws std::runtime_error if a sidecar cannot be parsed
+     */
+    size_t migrateJsonMetadata();
+
     /**
      * Get block size.
      */
     BlockSize blockSize() const { return blockSize_; }
 
+    /**
+     * Get storage layout.
+     */
+    StorageLayout layout() const { return layout_; }
+
+    /**
+     * Get durability mode.
+     */
+    Durability durability() const { return durability_; }
+
+    /**
+     * Check if reference counting is enabled.
+     */
+    bool referenceCounting() const { return refCounts_ != nullptr; }
+
     /**
      * Get store path.
      */
@@ -104,7 +330,7 @@ protected:
     std::filesystem::path blockPath(const Checksum& checksum) const;
 
     /**
-     * Get metadata file path for a block.
+     * Get legacy JSON metadata file path for a block.
      */
     std::filesystem::path metadataPath(const Checksum& checksum) const;
 
@@ -113,9 +339,83 @@ protected:
      */
     void ensureBlockPath(const Checksum& checksum) const;
 
+    /**
+     * Root directory for blocks of this store's size.
+     */
+    std::filesystem::path sizeDir() const;
+
+    /**
+     * Check the existence filter.
+     * @return False only if the block is definitely absent
+     */
+    bool mayContain(const Checksum& checksum) const;
+
 private:
+    friend class AsyncBlockIO; // Reads block files through io_uring
+
     std::string storePath_;
     BlockSize blockSize_;
+    StorageLayout layout_;
+    Durability durability_;
+    bool virtualPadding_;
+    std::unique_ptr<PackedSegmentStore> packed_;
+    std::unique_ptr<MetadataIndex> metadataIndex_;
+    std::unique_ptr<RefCountTable> refCounts_;
+    std::unique_ptr<GroupCommitter> committer_; // destroyed before the stores it flushes
+    std::atomic<uint64_t> tempSequence_{0};
+
+    /**
+     * Orders puts and removes of one checksum, striped by checksum, so that
+     * the existence filter and reference counts follow the block files.
+     * With reference counting, puts in progress are tracked instead of
+     * holding the lock while writing; later writers wait on the future.
+     */
+    struct WriteStripe {
+        std::mutex mutex;
+        std::unordered_map<Checksum, std::shared_future<void>> inflight;
+    };
+    static constexpr size_t WRITE_STRIPES = 64;
+    std::unique_ptr<std::array<WriteStripe, WRITE_STRIPES>> writeStripes_;
+
+    WriteStripe& stripeFor(const Checksum& checksum) const;
+
+    /**
+     * Wait until no put of checksum is in progress.
+     * @param lock Holds stripe.mutex; released while waiting
+     */
+    void waitForInflight(WriteStripe& stripe, std::unique_lock<std::mutex>& lock,
+                         const Checksum& checksum) const;
+
+    /**
+     * Add count references to a stored block; the caller holds its stripe.
+     * @throws std::overflow_error if the count would exceed UINT32_MAX
+     */
+    void bumpRefCount(const Checksum& checksum, uint32_t count);
+
+    /**
+     * Make a reference count change as durable as the Durability mode promises.
+     */
+    void commitRefCount();
+
+    void storeBlock(const Checksum& checksum, std::span<const uint8_t> data,
+                    const BlockMetadata& metadata);
+    bool removeBlock(const Checksum& checksum);
+
+    void writeBlockFile(const Checksum& checksum, std::span<const uint8_t> data,
+                        size_t storedLength);
+
+    void rebuildExistenceFilter();
+    void dropFromFilter(const Checksum& checksum);
+    std::filesystem::path filterPath() const;
+
+    mutable std::shared_mutex filterMutex_;
+    std::unique_ptr<CuckooFilter> filter_;
+    // Stored blocks the full filter could not take, until the next rebuild
+    // (guarded by filterMutex_)
+    std::unordered_set<Checksum> filterOverflow_;
+    // Held shared by block file changes and exclusively by a rebuild's scan,
+    // so the scan sees a stable directory while readers keep the old filter
+    std::shared_mutex filterWriters_;
 };
 
 } // namespace brightchain
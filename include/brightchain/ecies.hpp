@@ -2,8 +2,12 @@
 
 #include "brightchain/ec_key_pair.hpp"
 #include "brightchain/aes_gcm.hpp"
+#include "brightchain/secp256k1.hpp"
+#include "brightchain/thread_pool.hpp"
 #include <vector>
 #include <cstdint>
+#include <optional>
+#include <span>
 
 namespace brightchain {
 
@@ -13,7 +17,42 @@ namespace brightchain {
 enum class EciesEncryptionType : uint8_t {
     Basic = 33,       // No length prefix
     WithLength = 66,  // Includes 8-byte length prefix
-    Multiple = 99     // Multiple recipients (not implemented yet)
+    /**
+     * Multiple recipients: ephemeral key, IV and a 4-byte recipient count,
+     * then one entry per recipient (4-byte index, 2-byte length, wrapped
+     * symmetric key and tag), then the data tag and ciphertext. With
+     * EciesMultipleOptions::recipientKeyIds each wrapped key is preceded by
+     * an 8-byte key id and the entries are sorted by it.
+     */
+    Multiple = 99
+};
+
+/**
+ * Options for multiple recipient encryption.
+ */
+struct EciesMultipleOptions {
+    /**
+     * Prefix each recipient entry with an 8-byte id derived from that
+     * recipient's ECDH secret, and sort the entries by id. Recipients then
+     * find their entry by binary search instead of trial decryption; only
+     * sender and recipient can compute an id. Decoders that predate key ids
+     * cannot read such messages.
+     */
+    bool recipientKeyIds = false;
+
+    /**
+     * Workers that wrap the symmetric key for large recipient lists
+     * (nullptr selects ThreadPool::shared()). Called from one of the pool's
+     * own workers, the keys are wrapped inline instead.
+     */
+    ThreadPool* pool = nullptr;
+
+    /**
+     * Cache of parsed recipient keys, so a stable membership is not
+     * re-decompressed for every message (nullptr selects
+     * PublicKeyCache::shared(); a zero-capacity cache disables caching).
+     */
+    PublicKeyCache* keyCache = nullptr;
 };
 
 /**
@@ -23,8 +62,10 @@ enum class EciesEncryptionType : uint8_t {
  *   Basic: version(1) + cipherSuite(1) + type(1) + ephemeralPubKey(33) + IV(12) + ciphertext + authTag(16)
  *   WithLength: Basic format + length(8) before ciphertext
  * Multiple recipient format (type 99):
- *   version(1) + cipherSuite(1) + type(1) + ephemeralPubKey(33) + IV(12) + 
- *   recipientCount(4) + [pubKeyIndex(4) + encryptedSymmetricKey(65)]... + ciphertext + authTag(16)
+ *   version(1) + cipherSuite(1) + type(1) + ephemeralPubKey(33) + IV(12) +
+ *   recipientCount(4) + [pubKeyIndex(4) + keyLength(2) + [keyId(8)] + encryptedSymmetricKey(48)]... +
+ *   authTag(16) + ciphertext
+ *   keyId is present when keyLength is 56 (see EciesMultipleOptions::recipientKeyIds).
  */
 class Ecies {
 public:
@@ -55,11 +96,13 @@ public:
      * Each recipient can decrypt with their own private key.
      * @param plaintext Data to encrypt
      * @param recipientPublicKeys Vector of recipient public keys (each 33 bytes compressed)
+     * @param options Entry layout options
      * @return Encrypted data with all recipient key material
      */
     static std::vector<uint8_t> encryptMultiple(
         const std::vector<uint8_t>& plaintext,
-        const std::vector<std::vector<uint8_t>>& recipientPublicKeys
+        const std::vector<std::vector<uint8_t>>& recipientPublicKeys,
+        const EciesMultipleOptions& options = {}
     );
 
     /**
@@ -73,6 +116,21 @@ public:
         const EcKeyPair& keyPair
     );
 
+    /**
+     * Decrypt a multiple recipient ciphertext as the recipient at a known
+     * position in the encryptMultiple() key list. Only that entry is
+     * unwrapped; it is located directly when entries have a uniform length,
+     * by key id when the message carries recipient key ids.
+     * @param recipientIndex Position of keyPair's public key at encryption
+     * @throws std::invalid_argument if ciphertext is not of type Multiple
+     * @throws std::runtime_error if the entry does not decrypt with keyPair
+     */
+    static std::vector<uint8_t> decrypt(
+        const std::vector<uint8_t>& ciphertext,
+        const EcKeyPair& keyPair,
+        uint32_t recipientIndex
+    );
+
 private:
     static std::vector<uint8_t> encryptInternal(
         const std::vector<uint8_t>& plaintext,
@@ -80,35 +138,58 @@ private:
         EciesEncryptionType type
     );
 
+    static std::vector<uint8_t> decryptInternal(
+        const std::vector<uint8_t>& ciphertext,
+        const EcKeyPair& keyPair,
+        std::optional<uint32_t> recipientIndex
+    );
+
+    /**
+     * Find this recipient's entry in a type 99 ciphertext and decrypt the payload.
+     * @param offset Start of the recipient count
+     */
+    static std::vector<uint8_t> decryptMultiple(
+        const std::vector<uint8_t>& ciphertext,
+        size_t offset,
+        const std::vector<uint8_t>& ephemeralPublicKey,
+        const AesGcm::IV& iv,
+        const EcKeyPair& keyPair,
+        std::optional<uint32_t> recipientIndex
+    );
+
     /**
      * Encrypt the symmetric key for a specific recipient using ECIES.
      * @param symmetricKey The symmetric key to encrypt (32 bytes)
-     * @param recipientPublicKey The recipient's public key (33 bytes)
+     * @param recipientPublicKey The recipient's parsed public key
      * @param ephemeralPrivateKey The ephemeral private key to use (32 bytes)
      * @param ephemeralPublicKey The ephemeral public key (33 bytes)
      * @param iv The IV to use (12 bytes)
-     * @return Encrypted symmetric key (~65 bytes with secp256k1)
+     * @param withKeyId Prefix the recipient key id (8 bytes)
+     * @return Encrypted symmetric key (48 bytes, 56 with key id)
      */
     static std::vector<uint8_t> encryptSymmetricKey(
         const AesGcm::Key& symmetricKey,
-        const std::vector<uint8_t>& recipientPublicKey,
+        const Secp256k1::PublicKey& recipientPublicKey,
         const std::vector<uint8_t>& ephemeralPrivateKey,
         const std::vector<uint8_t>& ephemeralPublicKey,
-        const AesGcm::IV& iv
+        const AesGcm::IV& iv,
+        bool withKeyId
     );
 
     /**
-     * Decrypt the symmetric key using ECDH and derive from ephemeral key.
-     * @param encryptedSymmetricKey The encrypted key material
+     * Decrypt the symmetric key with the key encryption key the recipient
+     * derived from its ECDH secret.
+     * @param encryptedSymmetricKey The encrypted key material, without key id
+     * @param keyEncryptionKey HKDF output for the recipient's shared secret
      * @param ephemeralPublicKey The ephemeral public key
-     * @param privateKey The recipient's private key
      * @param iv The IV used
      * @return Decrypted symmetric key (32 bytes)
+     * @throws std::runtime_error if the key does not authenticate
      */
     static AesGcm::Key decryptSymmetricKey(
-        const std::vector<uint8_t>& encryptedSymmetricKey,
+        std::span<const uint8_t> encryptedSymmetricKey,
+        const AesGcm::Key& keyEncryptionKey,
         const std::vector<uint8_t>& ephemeralPublicKey,
-        const std::vector<uint8_t>& privateKey,
         const AesGcm::IV& iv
     );
 };
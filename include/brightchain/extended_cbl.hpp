@@ -31,6 +31,18 @@ public:
     std::vector<uint8_t> layerHeaderData() const override;
     size_t layerOverheadSize() const override;
 
+    /**
+     * Serialize the layer header of an ExtendedCBL: the base header fields,
+     * the file metadata, then the signature. The CRC8 covers the fields and
+     * metadata.
+     * @param header Base header (type and isExtended are forced to ExtendedCBL)
+     * @param metadata File name and MIME type
+     * @return Header bytes; addresses follow directly
+     * @throws std::invalid_argument if the metadata is too long
+     */
+    static std::vector<uint8_t> serializeHeader(const CBLHeader& header,
+                                                const ExtendedCBLMetadata& metadata);
+
     const std::string& fileName() const { return metadata_.fileName; }
     const std::string& mimeType() const { return metadata_.mimeType; }
 
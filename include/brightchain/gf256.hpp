@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace brightchain {
+
+/**
+ * Arithmetic in GF(2^8) with the reduction polynomial x^8 + x^4 + x^3 + x + 1
+ * (0x11B). This is the polynomial of the GFNI instructions, so bulk
+ * multiplication can use GF2P8MULB directly.
+ */
+namespace gf256 {
+
+uint8_t mul(uint8_t a, uint8_t b);
+
+/**
+ * Multiplicative inverse.
+ * @throws std::domain_error for zero
+ */
+uint8_t inv(uint8_t a);
+
+/**
+ * Bulk kernel selected at runtime.
+ */
+enum class Kernel {
+    Scalar,    // 256-entry product row per coefficient
+    Avx2,      // Split-nibble PSHUFB on 32-byte vectors
+    Avx512Gfni // GF2P8MULB on 64-byte vectors
+};
+
+Kernel bestKernel();
+
+/**
+ * target[i] ^= coefficient * source[i] for i < length.
+ * @param kernel Must be supported by the CPU (see bestKernel())
+ */
+void mulAdd(uint8_t* target, const uint8_t* source, uint8_t coefficient, size_t length,
+            Kernel kernel = bestKernel());
+
+/**
+ * target[i] = coefficient * source[i] for i < length.
+ */
+void mul(uint8_t* target, const uint8_t* source, uint8_t coefficient, size_t length,
+         Kernel kernel = bestKernel());
+
+} // namespace gf256
+
+} // namespace brightchain
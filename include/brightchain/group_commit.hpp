@@ -0,0 +1,108 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * Background committer that amortizes fsync cost across concurrent writers.
+ *
+ * Writers hand over a fully written temporary file and block until the
+ * committer has made it durable. A batch is committed when the oldest pending
+ * write is `interval` old or `maxBytes` are pending, whichever comes first:
+ * writeback is started for every file (Linux only), each file is
+ * fdatasync'ed (F_FULLFSYNC on Apple; the journal commits coalesce), the
+ * batch hook runs, the files are renamed into place, and every touched
+ * directory is fsync'ed once.
+ *
+ * A crash therefore leaves either the complete block under its final name or
+ * an orphaned temporary file, never a partial block.
+ */
+class GroupCommitter {
+public:
+    /**
+     * Constructor.
+     * @param interval Longest time a write waits for its batch
+     * @param maxBytes Pending bytes that trigger an immediate commit
+     * @param batchHook Called once per batch after file data is durable and
+     *        before the renames (e.g. to flush an index); may be empty
+     * @throws std::invalid_argument if maxBytes is zero
+     */
+    GroupCommitter(std::chrono::milliseconds interval, size_t maxBytes,
+                   std::function<void()> batchHook = {});
+
+    /**
+     * Destructor. Commits everything still pending.
+     */
+    ~GroupCommitter();
+
+    GroupCommitter(const GroupCommitter&) = delete;
+    GroupCommitter& operator=(const GroupCommitter&) = delete;
+
+    /**
+     * Durably commit a temporary file under its final name. Blocks until the
+     * batch containing it has been committed.
+     * @param fd Open descriptor of the written temporary file (ownership is taken)
+     * @param tempPath Temporary file path, in the same directory as finalPath
+     * @param finalPath Destination path
+     * @param bytes Size of the file, counted towards the batch threshold
+     * @throws std::runtime_error if this write failed; its temporary file is
+     *         removed. Other writes in the batch succeed or fail on their own.
+     */
+    void commit(int fd, const std::filesystem::path& tempPath,
+                const std::filesystem::path& finalPath, size_t bytes);
+
+    /**
+     * Wait for the next batch without contributing a file, so that writes made
+     * durable by the batch hook (e.g. segment appends) share its fsync.
+     * @param bytes Bytes written, counted towards the batch threshold
+     * @throws std::runtime_error if the batch failed
+     */
+    void await(size_t bytes);
+
+    /**
+     * Commit everything pending now and wait for it.
+     */
+    void flush();
+
+    /**
+     * Number of batches committed so far.
+     */
+    size_t batchCount() const;
+
+private:
+    struct Pending {
+        int fd;
+        std::filesystem::path tempPath;
+        std::filesystem::path finalPath;
+        std::promise<void> done;
+    };
+
+    void enqueue(Pending pending, size_t bytes, bool urgent);
+    void committerLoop();
+    void commitBatch(std::vector<Pending>& batch);
+
+    const std::chrono::milliseconds interval_;
+    const size_t maxBytes_;
+    const std::function<void()> batchHook_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<Pending> pending_;
+    std::chrono::steady_clock::time_point batchStart_;
+    size_t pendingBytes_ = 0;
+    size_t batches_ = 0;
+    bool urgent_ = false;
+    bool stopping_ = false;
+    std::thread committer_;
+};
+
+} // namespace brightchain
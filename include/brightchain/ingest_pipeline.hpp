@@ -0,0 +1,97 @@
+#pragma once
+
+#include "brightchain/checksum.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include "brightchain/thread_pool.hpp"
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace brightchain {
+
+/**
+ * Options for IngestPipeline.
+ */
+struct IngestOptions {
+    std::array<uint8_t, 16> creatorId{};
+
+    /**
+     * When non-empty, the file is described by an ExtendedCBL carrying the
+     * file name and MIME type instead of a plain CBL.
+     */
+    std::string fileName;
+    std::string mimeType = "application/octet-stream";
+
+    /**
+     * Upper bound on block data buffered between the reader and the workers,
+     * including the chunks being read. At least one block is always
+     * buffered, so the bound is never below the store's block length.
+     */
+    size_t maxBufferedBytes = 256 * 1024 * 1024;
+};
+
+/**
+ * Outcome of ingesting one file.
+ */
+struct IngestResult {
+    Checksum cblChecksum;          // Root of the stored tree (CBL, ExtendedCBL or SuperCBL)
+    Checksum originalDataChecksum; // SHA3-512 of the whole input
+    uint64_t originalDataLength = 0;
+    uint64_t blockCount = 0;       // Data blocks referenced by the tree
+    uint16_t depth = 0;            // SuperCBL levels above the CBLs; 0 for a single CBL
+};
+
+/**
+ * IngestPipeline turns a file into stored blocks plus a CBL describing them.
+ *
+ * The calling thread reads the input in block-sized chunks and feeds the
+ * whole-file checksum; chunks are then hashed in groups by the multi-lane
+ * SHA3 kernel and written through the store on a worker pool. Chunks are
+ * zero padded to the store's block size and stored with
+ * length_without_padding set, so stores with virtual padding keep only the
+ * payload of the last block. Memory use is bounded by
+ * IngestOptions::maxBufferedBytes regardless of input size.
+ *
+ * Blocks are stored as-is (tuple size 1). Their addresses stream into a
+ * SuperCBLBuilder, so the result is a single CBL when it fits in one block
+ * and a SuperCBL tree otherwise; inputs of any size are supported.
+ */
+class IngestPipeline {
+public:
+    /**
+     * Constructor.
+     * @param store Destination store; its block size sets the chunk size
+     * @param pool Workers for hashing and writing. Do not call ingest() from
+     *        one of this pool's workers.
+     */
+    explicit IngestPipeline(DiskBlockStore& store, ThreadPool& pool = ThreadPool::shared());
+
+    /**
+     * Ingest a file.
+     * @throws std::runtime_error if the file cannot be read or a block
+     *         cannot be stored
+     */
+    IngestResult ingestFile(const std::filesystem::path& path,
+                            const IngestOptions& options = {});
+
+    /**
+     * Ingest everything readable from a file descriptor.
+     * @param fd Open descriptor positioned at the start of the data
+     * @throws std::runtime_error on read or store failure
+     */
+    IngestResult ingest(int fd, const IngestOptions& options = {});
+
+    /**
+     * Number of block addresses a CBL of the store's block size can hold;
+     * larger inputs are described by a SuperCBL tree.
+     * @param options Ingest options (an ExtendedCBL header takes more room)
+     */
+    size_t cblCapacity(const IngestOptions& options = {}) const;
+
+private:
+    DiskBlockStore& store_;
+    ThreadPool& pool_;
+};
+
+} // namespace brightchain
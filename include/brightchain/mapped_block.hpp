@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace brightchain {
+
+/**
+ * Expected access pattern for a mapped block, forwarded to madvise().
+ */
+enum class AccessHint {
+    Normal,
+    Sequential, // Read front to back once (reassembly, hashing)
+    Random,     // Scattered reads (address lookups)
+    WillNeed    // Start reading ahead immediately
+};
+
+/**
+ * MappedBlock is a read-only memory-mapped view of stored block data.
+ * The view stays valid for the lifetime of the MappedBlock; blocks are
+ * immutable once stored, so the mapping can be shared freely between readers.
+ */
+class MappedBlock {
+public:
+    /**
+     * Map a whole file.
+     * @param path File to map
+     * @param hint Expected access pattern
+     * @throws std::system_error with the errno if the file cannot be opened or mapped
+     */
+    static MappedBlock map(const std::filesystem::path& path, AccessHint hint = AccessHint::Normal);
+
+    /**
+     * Map a byte range of an open file. The offset does not need to be page aligned.
+     * @param fd Open file descriptor (may be closed after mapping)
+     * @param offset Start of the range
+     * @param length Length of the range
+     * @param hint Expected access pattern
+     * @throws std::system_error with the errno if the range cannot be mapped
+     */
+    static MappedBlock map(int fd, uint64_t offset, size_t length,
+                           AccessHint hint = AccessHint::Normal);
+
+    /**
+     * Map a block stored with virtual padding: the first storedLength bytes
+     * come from the file (copy-on-write, no read), the remainder of the
+     * paddedLength bytes are materialized as `fill` in anonymous memory.
+     * @param path Block file
+     * @param storedLength Bytes of real data at the start of the file
+     * @param paddedLength Logical block length
+     * @param fill Padding byte value
+     * @param hint Expected access pattern
+     * @throws std::system_error with the errno if the file cannot be opened or mapped
+     */
+    static MappedBlock mapPadded(const std::filesystem::path& path, size_t storedLength,
+                                 size_t paddedLength, uint8_t fill,
+                                 AccessHint hint = AccessHint::Normal);
+
+    MappedBlock() = default;
+    ~MappedBlock();
+    MappedBlock(const MappedBlock&) = delete;
+    MappedBlock& operator=(const MappedBlock&) = delete;
+    MappedBlock(MappedBlock&& other) noexcept;
+    MappedBlock& operator=(MappedBlock&& other) noexcept;
+
+    /**
+     * Get the mapped bytes.
+     */
+    std::span<const uint8_t> span() const { return {data_, size_}; }
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /**
+     * Change the access pattern hint for the mapping.
+     */
+    void advise(AccessHint hint) const;
+
+private:
+    MappedBlock(void* base, size_t mappedLength, const uint8_t* data, size_t size);
+    void release();
+
+    void* base_ = nullptr;
+    size_t mappedLength_ = 0;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace brightchain
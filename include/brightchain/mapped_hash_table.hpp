@@ -0,0 +1,158 @@
+#pragma once
+
+#include "brightchain/checksum.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <shared_mutex>
+
+namespace brightchain {
+
+/**
+ * Memory-mapped open-addressing hash table of fixed-width records keyed by
+ * checksum (linear probing, doubled when 70% full), shared by MetadataIndex
+ * and RefCountTable.
+ *
+ * File layout (little-endian):
+ *   Header (64 bytes): [Magic(4)][Version(4)][SlotCount(8)][LiveCount(8)]
+ *                      [TombstoneCount(8)][Reserved(32)]
+ *   Slots (recordSize bytes each): [Checksum(64)] followed by the owner's
+ *   fields, including a 4-byte flags word at flagsOffset.
+ *
+ * The table owns the occupied and tombstone flag bits; owners may use the
+ * others. All access goes through the table's lock, so sync() is safe while
+ * other threads insert and grow the table.
+ */
+class MappedHashTable {
+public:
+    static constexpr size_t HEADER_SIZE = 64;
+    static constexpr uint64_t INITIAL_SLOTS = 1024;
+    static constexpr uint32_t FLAG_OCCUPIED = 1u << 0;
+    static constexpr uint32_t FLAG_TOMBSTONE = 1u << 1;
+
+    /**
+     * Record format of one table file.
+     */
+    struct Layout {
+        uint32_t magic;
+        uint32_t version;
+        size_t recordSize;
+        size_t flagsOffset;
+        const char* name; // used in error messages
+    };
+
+    /**
+     * Open (or create) a table file.
+     * @throws std::runtime_error if the file is invalid or cannot be mapped
+     */
+    MappedHashTable(const std::filesystem::path& path, const Layout& layout);
+
+    ~MappedHashTable();
+    MappedHashTable(const MappedHashTable&) = delete;
+    MappedHashTable& operator=(const MappedHashTable&) = delete;
+
+    /**
+     * Call fn(const uint8_t* record) under the shared lock, with nullptr if
+     * the checksum has no record.
+     */
+    template <typename Fn>
+    decltype(auto) read(const Checksum& checksum, Fn&& fn) const {
+        std::shared_lock lock(mutex_);
+        const uint64_t index = find(checksum);
+        return fn(index == slots_ ? static_cast<const uint8_t*>(nullptr) : slot(index));
+    }
+
+    /**
+     * Call fn(uint8_t* record, bool existed) under the exclusive lock with the
+     * record of checksum, inserting a zeroed record (key already set) if
+     * there is none.
+     */
+    template <typename Fn>
+    void write(const Checksum& checksum, Fn&& fn) {
+        std::unique_lock lock(mutex_);
+        bool existed = false;
+        uint8_t* record = findOrInsert(checksum, existed);
+        fn(record, existed);
+        markOccupied(record);
+    }
+
+    /**
+     * Remove the record for a checksum.
+     * @return True if a record was removed
+     */
+    bool erase(const Checksum& checksum);
+
+    /**
+     * Call fn(const uint8_t* record) for every live record in file order,
+     * under the shared lock. fn must not modify the table.
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        std::shared_lock lock(mutex_);
+        for (uint64_t index = 0; index < slots_; ++index) {
+            if (isLive(slot(index))) {
+                fn(static_cast<const uint8_t*>(slot(index)));
+            }
+        }
+    }
+
+    /**
+     * Number of live records.
+     */
+    size_t size() const;
+
+    uint64_t slotCount() const;
+
+    /**
+     * Flush dirty pages of the mapping to disk.
+     */
+    void sync() const;
+
+    const std::filesystem::path& path() const { return path_; }
+
+    /**
+     * The key of a record.
+     */
+    static Checksum key(const uint8_t* record);
+
+private:
+    struct Fresh {};
+    MappedHashTable(const std::filesystem::path& path, const Layout& layout, uint64_t slots,
+                    Fresh);
+
+    void open();
+    void map(uint64_t slots);
+    void unmap();
+    void grow();
+    void writeCounts();
+    uint8_t* slot(uint64_t index) const;
+    uint64_t homeSlot(const Checksum& checksum) const;
+    uint32_t flags(const uint8_t* record) const;
+    bool isLive(const uint8_t* record) const;
+    void markOccupied(uint8_t* record) const;
+
+    /**
+     * Find the slot holding a checksum.
+     * @return Slot index, or slots_ if absent
+     */
+    uint64_t find(const Checksum& checksum) const;
+
+    uint8_t* findOrInsert(const Checksum& checksum, bool& existed);
+
+    /**
+     * Place a copy of a live record from another table (no duplicate check).
+     */
+    void place(const uint8_t* record);
+
+    std::filesystem::path path_;
+    Layout layout_;
+    int fd_ = -1;
+    uint8_t* base_ = nullptr;
+    size_t mappedLength_ = 0;
+    uint64_t slots_ = 0;
+    uint64_t live_ = 0;
+    uint64_t tombstones_ = 0;
+    mutable std::shared_mutex mutex_;
+};
+
+} // namespace brightchain
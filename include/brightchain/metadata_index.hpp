@@ -0,0 +1,114 @@
+#pragma once
+
+#include "brightchain/block_metadata.hpp"
+#include "brightchain/checksum.hpp"
+#include "brightchain/mapped_hash_table.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+
+namespace brightchain {
+
+/**
+ * Padding elided from a stored block: only the first storedLength bytes are
+ * on disk and the rest of the block consists of `fill` bytes.
+ */
+struct VirtualPadding {
+    uint32_t storedLength;
+    uint8_t fill;
+};
+
+/**
+ * MetadataIndex stores BlockMetadata for one size class as fixed-width binary
+ * records in a single MappedHashTable file.
+ *
+ * Record layout (little-endian):
+ *   Slots (96 bytes each): [Checksum(64)][CreatedAt(8)][LengthWithoutPadding(8)]
+ *                          [BlockSize(4)][Flags(4)][PaddingFill(1)][Reserved(3)]
+ *                          [StoredLength(4)]
+ * PaddingFill and StoredLength are only meaningful when the virtual padding
+ * flag is set (see VirtualPadding). CreatedAt is in milliseconds since the
+ * epoch when the millisecond flag is set, in seconds in older records.
+ *
+ * Lookups touch one or two slots; forEach() walks the file sequentially.
+ */
+class MetadataIndex {
+public:
+    static constexpr size_t HEADER_SIZE = MappedHashTable::HEADER_SIZE;
+    static constexpr size_t RECORD_SIZE = 96;
+    static constexpr uint64_t INITIAL_SLOTS = MappedHashTable::INITIAL_SLOTS;
+
+    /**
+     * Open (or create) an index file.
+     * @param path Index file path
+     * @throws std::runtime_error if the file is invalid or cannot be mapped
+     */
+    explicit MetadataIndex(const std::filesystem::path& path);
+
+    MetadataIndex(const MetadataIndex&) = delete;
+    MetadataIndex& operator=(const MetadataIndex&) = delete;
+
+    /**
+     * Insert or replace the record for a block. An existing virtual padding
+     * descriptor is kept.
+     */
+    void put(const Checksum& checksum, const BlockMetadata& metadata);
+
+    /**
+     * Insert or replace the record for a block together with its virtual
+     * padding descriptor (nullopt clears it).
+     */
+    void put(const Checksum& checksum, const BlockMetadata& metadata,
+             const std::optional<VirtualPadding>& padding);
+
+    std::optional<BlockMetadata> get(const Checksum& checksum) const;
+
+    bool has(const Checksum& checksum) const;
+
+    /**
+     * Get the virtual padding descriptor of a block.
+     * @return The descriptor, or nullopt if the block is stored in full or unknown
+     */
+    std::optional<VirtualPadding> padding(const Checksum& checksum) const;
+
+    /**
+     * Remove the record for a block.
+     * @return True if a record was removed
+     */
+    bool remove(const Checksum& checksum);
+
+    /**
+     * Visit every live record in file order. The callback must not modify
+     * the index.
+     */
+    void forEach(const std::function<void(const Checksum&, const BlockMetadata&)>& callback) const;
+
+    /**
+     * Number of live records.
+     */
+    size_t size() const;
+
+    uint64_t slotCount() const;
+
+    /**
+     * Flush dirty pages of the mapping to disk. Safe to call while other
+     * threads insert (and possibly grow the table).
+     */
+    void sync() const;
+
+    const std::filesystem::path& path() const { return table_.path(); }
+
+private:
+    static constexpr uint32_t FLAG_VIRTUAL_PADDING = 1u << 2;
+    static constexpr uint32_t FLAG_CREATED_AT_MILLIS = 1u << 3;
+
+    static void writeRecord(uint8_t* record, const BlockMetadata& metadata,
+                            const std::optional<VirtualPadding>& padding);
+    static std::optional<VirtualPadding> readPadding(const uint8_t* record);
+    static BlockMetadata readRecord(const uint8_t* record);
+
+    MappedHashTable table_;
+};
+
+} // namespace brightchain
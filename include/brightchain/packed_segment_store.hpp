@@ -0,0 +1,209 @@
+#pragma once
+
+#include "brightchain/block_size.hpp"
+#include "brightchain/block_metadata.hpp"
+#include "brightchain/checksum.hpp"
+#include "brightchain/mapped_block.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * PackedSegmentStore is a log-structured block store for small block sizes.
+ * Blocks are appended to large segment files instead of one file per block,
+ * and located through an in-memory checksum -> (segment, offset, length) index
+ * that is rebuilt by scanning the segment headers on open.
+ *
+ * Segment layout: directory/NNNNNNNN.seg, each a sequence of entries:
+ *   [Magic(4)][Type(1)][Flags(1)][Reserved(2)][DataLength(4)][BlockSize(4)]
+ *   [CreatedAt(8)][LengthWithoutPadding(8)][Checksum(64)][Reserved(4)]
+ *   [CRC32C(4)][Data(DataLength)]
+ * All integers are little-endian. The CRC covers the header before it and
+ * the data. CreatedAt is in milliseconds since the epoch when flag bit 0 is
+ * set, in seconds otherwise (entries written before the flag existed).
+ * Removals and metadata updates are appended as data-less entries.
+ *
+ * Space held by removed or superseded blocks is reclaimed by compaction:
+ * once such blocks make up compactionThreshold of a sealed segment, its
+ * remaining entries are copied to a new file that replaces it. Tombstones
+ * and metadata entries that may still shadow entries of older segments
+ * are kept, so a compacted segment can still hold a few small entries for
+ * blocks that are gone.
+ *
+ * On open, an entry that fails verification is skipped up to the next
+ * intact entry (see damagedBytes()). Only the last segment is truncated,
+ * and only when nothing intact follows, i.e. after a torn append.
+ */
+class PackedSegmentStore {
+public:
+    static constexpr uint64_t DEFAULT_SEGMENT_SIZE = 256ULL * 1024 * 1024;
+    static constexpr size_t ENTRY_HEADER_SIZE = 104;
+    static constexpr double DEFAULT_COMPACTION_THRESHOLD = 0.5;
+
+    /**
+     * Open (or create) a packed store.
+     * @param directory Directory holding the segment files
+     * @param blockSize Block size for this store
+     * @param maxSegmentSize Size after which a new segment is started
+     * @param compactionThreshold Fraction of a sealed segment held by removed
+     *        or superseded blocks at which it is compacted (above 1 disables
+     *        compaction)
+     * @throws std::runtime_error if a segment cannot be opened or read, or
+     *         uses an unsupported entry format
+     */
+    PackedSegmentStore(const std::filesystem::path& directory, BlockSize blockSize,
+                       uint64_t maxSegmentSize = DEFAULT_SEGMENT_SIZE,
+                       double compactionThreshold = DEFAULT_COMPACTION_THRESHOLD);
+
+    ~PackedSegmentStore();
+    PackedSegmentStore(const PackedSegmentStore&) = delete;
+    PackedSegmentStore& operator=(const PackedSegmentStore&) = delete;
+
+    /**
+     * Append a block. Storing a block that already exists only updates its metadata.
+     * @param checksum Checksum of data
+     * @param data Block data
+     * @param metadata Block metadata
+     */
+    void put(const Checksum& checksum, std::span<const uint8_t> data,
+             const BlockMetadata& metadata);
+
+    /**
+     * Read a block.
+     * @throws std::runtime_error if block not found
+     */
+    std::vector<uint8_t> get(const Checksum& checksum) const;
+
+    /**
+     * Read a block into a caller-provided buffer.
+     * @return Number of bytes read
+     * @throws std::runtime_error if block not found or larger than out
+     */
+    size_t read(const Checksum& checksum, std::span<uint8_t> out) const;
+
+    /**
+     * Map a block's bytes in its segment without copying.
+     * @throws std::runtime_error if block not found
+     */
+    MappedBlock getMapped(const Checksum& checksum, AccessHint hint = AccessHint::Normal) const;
+
+    bool has(const Checksum& checksum) const;
+
+    /**
+     * Remove a block by appending a tombstone. May compact the segment that
+     * held the block (see compactionThreshold); a compaction that fails
+     * leaves the segment as it is until the store is reopened.
+     * @return True if block was removed
+     */
+    bool remove(const Checksum& checksum);
+
+    /**
+     * Replace the metadata of a stored block.
+     * @throws std::runtime_error if block not found
+     */
+    void putMetadata(const Checksum& checksum, const BlockMetadata& metadata);
+
+    std::optional<BlockMetadata> getMetadata(const Checksum& checksum) const;
+
+    /**
+     * Invoke a callback for every live block. The callback may use the store.
+     */
+    void forEach(const std::function<void(const Checksum&)>& callback) const;
+
+    /**
+     * Number of live blocks.
+     */
+    size_t size() const;
+
+    /**
+     * Number of segment files.
+     */
+    size_t segmentCount() const;
+
+    /**
+     * Bytes occupied by removed or superseded entries, less what compaction
+     * has reclaimed.
+     */
+    uint64_t deadBytes() const;
+
+    /**
+     * Number of segment compactions since open.
+     */
+    uint64_t compactionCount() const;
+
+    /**
+     * Bytes skipped on open because they did not hold intact entries
+     * (excluding a truncated torn tail).
+     */
+    uint64_t damagedBytes() const;
+
+    /**
+     * Flush appended entries to stable storage. Concurrent appends are not
+     * blocked while the flush runs.
+     * @throws std::runtime_error on I/O failure
+     */
+    void sync();
+
+    const std::filesystem::path& directory() const { return directory_; }
+
+private:
+    enum class EntryType : uint8_t {
+        Block = 1,
+        Tombstone = 2,
+        Metadata = 3
+    };
+
+    struct SegmentStats {
+        uint64_t length = 0;           // file length once sealed
+        uint64_t reclaimableBytes = 0; // removed or superseded block entries
+        bool keep = false;             // damaged, or its compaction failed
+    };
+
+    struct Location {
+        uint32_t segment;
+        uint64_t offset; // offset of the block data within the segment
+        uint32_t length;
+        BlockSize size;
+        int64_t createdAt; // milliseconds since the epoch
+        uint64_t lengthWithoutPadding;
+    };
+
+    void loadSegments();
+    void scanSegment(uint32_t segment, int fd, bool active);
+    void openNewSegment();
+    void append(EntryType type, const Checksum& checksum, std::span<const uint8_t> data,
+                const BlockMetadata& metadata);
+    void maybeCompact(uint32_t segment);
+    void compactSegment(uint32_t segment);
+    std::filesystem::path segmentPath(uint32_t segment) const;
+    std::pair<Location, int> locate(const Checksum& checksum) const;
+
+    std::filesystem::path directory_;
+    BlockSize blockSize_;
+    uint64_t maxSegmentSize_;
+    double compactionThreshold_;
+
+    mutable std::shared_mutex indexMutex_;
+    std::unordered_map<Checksum, Location> index_;
+    uint64_t deadBytes_ = 0;
+    uint64_t damagedBytes_ = 0;
+    uint64_t compactions_ = 0;
+
+    std::mutex writeMutex_;
+    std::vector<int> segmentFds_;
+    std::vector<SegmentStats> segmentStats_; // guarded by writeMutex_
+    std::vector<int> retiredFds_; // replaced by compaction; readers may still hold them
+    uint64_t activeOffset_ = 0;
+    size_t firstUnsynced_ = 0; // segments before this one are fully synced
+};
+
+} // namespace brightchain
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "brightchain/cbl_view.hpp"
+#include "brightchain/checksum.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include "brightchain/thread_pool.hpp"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * RangeReader serves byte ranges of a file described by a CBL, ExtendedCBL
+ * or SuperCBL without reassembling it from the start.
+ *
+ * A byte offset maps to a tuple index (offset / block length). The tuple's
+ * leaf CBL is located by arithmetic on the tree shape: every CBL holds
+ * floor(addresses per block / tupleSize) tuples, every SuperCBL holds
+ * (block length - header) / 64 children, and all nodes except the last one
+ * on each level are full (the layout produced by SuperCBLBuilder). Each node
+ * on the path is checked against that layout and the data length, and a
+ * tree laid out differently is rejected. A read therefore loads one node per
+ * level plus the touched data blocks. Decoded
+ * nodes are kept in a small LRU cache, so nearby reads usually touch only
+ * data blocks.
+ *
+ * Thread-safe; concurrent reads share the node cache. A read called from one
+ * of the pool's workers fetches its tuples inline.
+ */
+class RangeReader {
+public:
+    static constexpr size_t DEFAULT_NODE_CACHE = 64;
+
+    /**
+     * Constructor. Loads the root and the leftmost leaf (for the tuple size).
+     * @param store Store holding the tree and its data blocks
+     * @param root Checksum of the root CBL, ExtendedCBL or SuperCBL
+     * @param nodeCacheSize Decoded tree nodes to keep
+     * @param pool Workers used when a read touches several tuples
+     * @throws std::runtime_error if the root is missing or not a CBL
+     */
+    RangeReader(DiskBlockStore& store, const Checksum& root,
+                size_t nodeCacheSize = DEFAULT_NODE_CACHE,
+                ThreadPool& pool = ThreadPool::shared());
+
+    /**
+     * Length of the described file (the root's originalDataLength).
+     */
+    uint64_t size() const { return size_; }
+
+    /**
+     * Read bytes [offset, offset + length), clipped to the end of the file.
+     * @param out Destination with room for length bytes
+     * @return Bytes read
+     * @throws std::runtime_error if a block is missing or the tree does not
+     *         have the expected shape
+     */
+    size_t read(uint64_t offset, uint8_t* out, size_t length);
+
+    /**
+     * Read bytes [offset, offset + length), clipped to the end of the file.
+     */
+    std::vector<uint8_t> read(uint64_t offset, size_t length);
+
+    /**
+     * Number of tree nodes loaded from the store so far (cache misses).
+     */
+    size_t nodeLoads() const;
+
+private:
+    struct Node {
+        MappedBlock block;
+        ChecksumRange children; // Points into block
+        uint64_t originalDataLength = 0;
+        uint32_t tupleSize = 0; // 0 for SuperCBL nodes
+        uint16_t depth = 0;     // SuperCBL depth (1: children are CBLs)
+        size_t overhead = 0;    // CBL layer header size
+    };
+
+    std::shared_ptr<const Node> loadNode(const Checksum& checksum);
+    std::vector<Checksum> locateTuple(uint64_t tuple);
+
+    DiskBlockStore& store_;
+    ThreadPool& pool_;
+    Checksum root_;
+    uint64_t size_ = 0;
+    size_t blockLength_;
+    uint64_t tuplesPerLeaf_ = 0;
+    uint64_t superFanout_ = 0;
+
+    mutable std::mutex cacheMutex_;
+    size_t cacheCapacity_;
+    size_t nodeLoads_ = 0;
+    std::list<Checksum> lru_;
+    std::unordered_map<Checksum,
+                       std::pair<std::shared_ptr<const Node>, std::list<Checksum>::iterator>>
+        cache_;
+};
+
+} // namespace brightchain
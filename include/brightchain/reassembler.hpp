@@ -0,0 +1,99 @@
+#pragma once
+
+#include "brightchain/async_block_io.hpp"
+#include "brightchain/checksum.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include "brightchain/thread_pool.hpp"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * Options for Reassembler.
+ */
+struct ReassemblyOptions {
+    /**
+     * Number of tuples fetched ahead of the writer.
+     */
+    size_t readAhead = 32;
+
+    /**
+     * Hash the output and compare it with the root's originalDataChecksum.
+     */
+    bool verifyChecksum = true;
+};
+
+/**
+ * Outcome of a reassembly.
+ */
+struct ReassemblyResult {
+    uint64_t bytesWritten = 0;
+    uint64_t blocksRead = 0; // Data blocks read, counting every member of each tuple
+};
+
+/**
+ * Reassembler restores the original data described by a CBL, ExtendedCBL or
+ * SuperCBL tree and writes it, in order, to a file descriptor.
+ *
+ * The tree is walked depth-first, loading interior nodes as they are
+ * reached; each node's type is taken from its structured header, so trees
+ * of any depth work. Data tuples are fetched up to `readAhead` ahead of the
+ * writer, on a worker pool or, given an AsyncBlockIO, as one engine read per
+ * member. The members of a tuple are XORed to
+ * recover the data block (a tuple size of 1 stores data as-is). Output is
+ * trimmed to the root's originalDataLength and hashed incrementally.
+ *
+ * Every block must be in the given store.
+ */
+class Reassembler {
+public:
+    /**
+     * Constructor.
+     * @param store Store holding the tree and its data blocks
+     * @param pool Workers for block reads. Do not call reassemble() from one
+     *        of this pool's workers.
+     */
+    explicit Reassembler(DiskBlockStore& store, ThreadPool& pool = ThreadPool::shared());
+
+    /**
+     * Constructor reading data blocks through an I/O engine, whose queue
+     * depth bounds the reads executing at once.
+     * @param io Engine over the store holding the tree and its data blocks
+     */
+    explicit Reassembler(AsyncBlockIO& io);
+
+    /**
+     * Reassemble into a file descriptor.
+     * @param root Checksum of the root CBL, ExtendedCBL or SuperCBL
+     * @param fd Destination, written sequentially
+     * @throws std::runtime_error if a block is missing or malformed, the tree
+     *         holds less data than declared, or the checksum does not match
+     *         (the data has been written by then)
+     */
+    ReassemblyResult reassemble(const Checksum& root, int fd,
+                                const ReassemblyOptions& options = {});
+
+    /**
+     * Reassemble into a file, replacing it.
+     * @throws std::runtime_error as for reassemble(); the file is removed on failure
+     */
+    ReassemblyResult reassembleToFile(const Checksum& root, const std::filesystem::path& path,
+                                      const ReassemblyOptions& options = {});
+
+private:
+    /**
+     * Start reading a tuple and XOR its members once all have arrived.
+     */
+    std::future<std::vector<uint8_t>> readTuple(std::vector<Checksum> tuple,
+                                                std::atomic<uint64_t>& blocksRead);
+
+    DiskBlockStore& store_;
+    ThreadPool& pool_;
+    AsyncBlockIO* io_ = nullptr;
+};
+
+} // namespace brightchain
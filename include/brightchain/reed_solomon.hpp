@@ -0,0 +1,157 @@
+#pragma once
+
+#include "brightchain/checksum.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include "brightchain/thread_pool.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * Systematic Reed-Solomon erasure code over GF(2^8).
+ *
+ * Data shards are stored unchanged; each parity shard is a linear
+ * combination of the data shards with coefficients from a Cauchy matrix,
+ * so any dataShards of the dataShards + parityShards shards recover the
+ * rest. Work is split into byte ranges on a thread pool, and every range
+ * runs the SIMD multiply-accumulate kernels of gf256.
+ */
+class ReedSolomon {
+public:
+    /**
+     * Constructor.
+     * @param dataShards Number of data shards (k)
+     * @param parityShards Number of parity shards (m)
+     * @param pool Workers for encoding and reconstruction
+     * @throws std::invalid_argument unless k >= 1, m >= 1 and k + m <= 256
+     */
+    ReedSolomon(size_t dataShards, size_t parityShards,
+                ThreadPool& pool = ThreadPool::shared());
+
+    size_t dataShards() const { return dataShards_; }
+    size_t parityShards() const { return parityShards_; }
+    size_t totalShards() const { return dataShards_ + parityShards_; }
+
+    /**
+     * Compute the parity shards.
+     * @param data k buffers of shardSize bytes
+     * @param parity m buffers of shardSize bytes, overwritten
+     * @throws std::invalid_argument if the shard counts do not match
+     */
+    void encode(std::span<const uint8_t* const> data, std::span<uint8_t* const> parity,
+                size_t shardSize) const;
+
+    /**
+     * Rebuild missing shards in place.
+     * @param shards k + m buffers of shardSize bytes, data shards first;
+     *        missing ones are overwritten
+     * @param present Which shards hold valid data
+     * @throws std::invalid_argument if the counts do not match
+     * @throws std::runtime_error if fewer than k shards are present
+     */
+    void reconstruct(std::span<uint8_t* const> shards, std::span<const bool> present,
+                     size_t shardSize) const;
+
+    /**
+     * Parity shards for a given number of data shards, derived from
+     * FECConstants: ceil(k * (REDUNDANCY_FACTOR - 1)) clamped to
+     * [MIN_REDUNDANCY, MAX_REDUNDANCY].
+     */
+    static size_t defaultParityShards(size_t dataShards);
+
+private:
+    /**
+     * outputs[r] = sum over c of rows[r][c] * inputs[c], split across the pool.
+     */
+    void multiply(const std::vector<std::vector<uint8_t>>& rows,
+                  std::span<const uint8_t* const> inputs, std::span<uint8_t* const> outputs,
+                  size_t shardSize) const;
+
+    size_t dataShards_;
+    size_t parityShards_;
+    std::vector<std::vector<uint8_t>> parityRows_; // m x k Cauchy coefficients
+    ThreadPool& pool_;
+};
+
+/**
+ * Where the shards of a protected payload live.
+ */
+struct FecManifest {
+    uint64_t originalLength = 0;
+    uint32_t shardSize = 0;
+    std::vector<Checksum> dataShards;
+    std::vector<Checksum> parityShards;
+
+    /**
+     * Binary form, big-endian: [Version(1)][OriginalLength(8)][ShardSize(4)]
+     * [DataShards(2)][ParityShards(2)][Checksums(64 each)].
+     */
+    std::vector<uint8_t> serialize() const;
+
+    /**
+     * @throws std::invalid_argument if the data is truncated or of an unknown version
+     */
+    static FecManifest deserialize(const std::vector<uint8_t>& data);
+};
+
+/**
+ * BlockFec protects large payloads (e.g. a 64 MiB block) with parity shards
+ * stored as ordinary blocks, so a lost or corrupted shard is rebuilt from
+ * the others instead of being uploaded again.
+ *
+ * Shards are blocks of the shard store's block size, which must not exceed
+ * FECConstants::MAX_SHARD_SIZE; the payload is split into as many data
+ * shards as needed (the last one zero padded).
+ */
+class BlockFec {
+public:
+    /**
+     * Constructor.
+     * @param store Store holding the shards
+     * @param pool Workers for the codec
+     * @throws std::invalid_argument if the store's blocks exceed MAX_SHARD_SIZE
+     */
+    explicit BlockFec(DiskBlockStore& store, ThreadPool& pool = ThreadPool::shared());
+
+    /**
+     * Split a payload into data shards, compute parity and store everything.
+     * Data and parity shards together are capped at 256, so at most
+     * 256 - parityShards data shards fit: 251 with the default parity of 5,
+     * i.e. 251 MiB with MAX_SHARD_SIZE shards. A Huge (256 MiB) payload
+     * does not fit and must be split by the caller first.
+     * @param parityShards Parity shard count; 0 for defaultParityShards()
+     * @throws std::invalid_argument if the payload needs more than
+     *         256 - parityShards data shards
+     */
+    FecManifest protect(std::span<const uint8_t> payload, size_t parityShards = 0);
+
+    /**
+     * Read the payload, rebuilding missing or corrupted data shards from parity.
+     * @throws std::runtime_error if fewer than dataShards shards are intact
+     */
+    std::vector<uint8_t> recover(const FecManifest& manifest) const;
+
+    /**
+     * Rebuild and store every missing or corrupted shard. Corrupted shards
+     * are quarantined first; rebuilt shards keep their reference counts.
+     * @return Number of shards written back
+     * @throws std::runtime_error if fewer than dataShards shards are intact
+     */
+    size_t repair(const FecManifest& manifest);
+
+private:
+    /**
+     * Load every shard that is present and intact, then rebuild the rest.
+     * @return All shards; `lost` lists the indices that were rebuilt
+     */
+    std::vector<std::vector<uint8_t>> loadShards(const FecManifest& manifest,
+                                                 std::vector<size_t>& lost) const;
+
+    DiskBlockStore& store_;
+    ThreadPool& pool_;
+    size_t shardSize_;
+};
+
+} // namespace brightchain
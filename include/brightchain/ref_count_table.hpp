@@ -0,0 +1,74 @@
+#pragma once
+
+#include "brightchain/checksum.hpp"
+#include "brightchain/mapped_hash_table.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+namespace brightchain {
+
+/**
+ * RefCountTable persists per-block reference counts for one size class in a
+ * MappedHashTable file, like MetadataIndex.
+ *
+ * DiskBlockStore only records blocks with more than one reference; a stored
+ * block without a record has a count of one. Unique data therefore costs no
+ * space in the table.
+ *
+ * Record layout (little-endian):
+ *   Slots (72 bytes each): [Checksum(64)][Count(4)][Flags(4)]
+ */
+class RefCountTable {
+public:
+    static constexpr size_t HEADER_SIZE = MappedHashTable::HEADER_SIZE;
+    static constexpr size_t RECORD_SIZE = 72;
+    static constexpr uint64_t INITIAL_SLOTS = MappedHashTable::INITIAL_SLOTS;
+
+    /**
+     * Open (or create) a table file.
+     * @param path Table file path
+     * @throws std::runtime_error if the file is invalid or cannot be mapped
+     */
+    explicit RefCountTable(const std::filesystem::path& path);
+
+    RefCountTable(const RefCountTable&) = delete;
+    RefCountTable& operator=(const RefCountTable&) = delete;
+
+    /**
+     * Get the recorded count of a block.
+     * @return The count, or nullopt if the block has no record
+     */
+    std::optional<uint32_t> get(const Checksum& checksum) const;
+
+    /**
+     * Insert or replace the count of a block.
+     */
+    void set(const Checksum& checksum, uint32_t count);
+
+    /**
+     * Remove the record for a block.
+     * @return True if a record was removed
+     */
+    bool remove(const Checksum& checksum);
+
+    /**
+     * Number of live records.
+     */
+    size_t size() const;
+
+    uint64_t slotCount() const;
+
+    /**
+     * Flush dirty pages of the mapping to disk. Safe to call while other
+     * threads update the table.
+     */
+    void sync() const;
+
+    const std::filesystem::path& path() const { return table_.path(); }
+
+private:
+    MappedHashTable table_;
+};
+
+} // namespace brightchain
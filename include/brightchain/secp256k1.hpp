@@ -0,0 +1,202 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * secp256k1 primitives behind ECIES, EcKeyPair signatures and the ECDH
+ * voting key derivation.
+ *
+ * Two backends produce identical shared secrets and interoperable DER
+ * signatures:
+ *  - OpenSsl: the generic EC code, with the curve group built once.
+ *  - LibSecp256k1: bitcoin-core's libsecp256k1, with precomputed generator
+ *    tables and a constant-time scalar multiply. Only present when the
+ *    library was built with BRIGHTCHAIN_WITH_SECP256K1; it is then the default.
+ *
+ * ECDSA signatures from LibSecp256k1 are deterministic (RFC 6979) and low-S.
+ * Verification accepts high-S signatures from either backend. As with
+ * OpenSSL's raw ECDSA signing, the first 32 bytes of the data are signed directly
+ * as the digest; shorter data is left-padded with zeros.
+ */
+class Secp256k1 {
+public:
+    enum class Backend { OpenSsl, LibSecp256k1 };
+
+    static constexpr size_t PRIVATE_KEY_SIZE = 32;
+    static constexpr size_t COMPRESSED_KEY_SIZE = 33;
+    static constexpr size_t UNCOMPRESSED_KEY_SIZE = 65;
+
+    using SharedSecret = std::array<uint8_t, 32>;
+    using SharedPoint = std::array<uint8_t, UNCOMPRESSED_KEY_SIZE>;
+
+    /**
+     * A public key parsed once for repeated ECDH, so a recipient addressed
+     * by many messages is decompressed (a field square root) only once.
+     * Immutable and cheap to copy; copies share the parsed point.
+     */
+    class PublicKey {
+    public:
+        PublicKey() = default;
+
+        bool empty() const { return !parsed_; }
+
+        /**
+         * Backend the key was parsed for.
+         */
+        Backend backend() const;
+
+        /**
+         * The encoding the key was parsed from.
+         */
+        std::span<const uint8_t> encoded() const;
+
+    private:
+        friend class Secp256k1;
+        struct Parsed;
+
+        std::shared_ptr<const Parsed> parsed_;
+    };
+
+    /**
+     * Whether a backend was compiled in.
+     */
+    static bool available(Backend backend);
+
+    /**
+     * Backend used by all operations in the process.
+     */
+    static Backend backend();
+
+    /**
+     * Select the backend for all threads.
+     * @throws std::invalid_argument if it was not compiled in
+     */
+    static void setBackend(Backend backend);
+
+    /**
+     * ECDH shared secret: the x coordinate of privateKey * publicKey, as
+     * produced by OpenSSL's ECDH_compute_key.
+     * @throws std::runtime_error if either key is invalid
+     */
+    static SharedSecret ecdh(std::span<const uint8_t> privateKey,
+                             std::span<const uint8_t> publicKey);
+
+    /**
+     * Full shared point privateKey * publicKey, uncompressed (0x04 || x || y).
+     * @throws std::runtime_error if either key is invalid
+     */
+    static SharedPoint ecdhPoint(std::span<const uint8_t> privateKey,
+                                 std::span<const uint8_t> publicKey);
+
+    /**
+     * Parse a compressed or uncompressed public key for the active backend.
+     * @throws std::runtime_error if it is not a point on the curve
+     */
+    static PublicKey parsePublicKey(std::span<const uint8_t> publicKey);
+
+    /**
+     * ECDH against a parsed key. A key parsed under another backend is
+     * re-parsed from its encoding.
+     * @throws std::runtime_error if the private key is invalid or publicKey is empty
+     */
+    static SharedSecret ecdh(std::span<const uint8_t> privateKey, const PublicKey& publicKey);
+
+    static SharedPoint ecdhPoint(std::span<const uint8_t> privateKey,
+                                 const PublicKey& publicKey);
+
+    /**
+     * DER-encoded ECDSA signature over data.
+     * @throws std::runtime_error if the private key is invalid
+     */
+    static std::vector<uint8_t> sign(std::span<const uint8_t> privateKey,
+                                     std::span<const uint8_t> data);
+
+    /**
+     * Verify a DER-encoded ECDSA signature. Malformed keys or signatures
+     * verify as false.
+     */
+    static bool verify(std::span<const uint8_t> data, std::span<const uint8_t> signature,
+                       std::span<const uint8_t> publicKey);
+};
+
+/**
+ * Counters reported by a PublicKeyCache.
+ */
+struct PublicKeyCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t entries = 0;
+};
+
+/**
+ * Thread-safe LRU cache of parsed public keys, keyed by their encoding.
+ *
+ * Multi-recipient encryption to a large, stable membership parses the same
+ * keys for every message; the cache keeps the most recently addressed ones.
+ * Entries are spread over lock-striped shards that each hold an equal slice
+ * of the capacity. A capacity of 0 parses on every call without storing.
+ */
+class PublicKeyCache {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 65536;
+    static constexpr size_t DEFAULT_SHARD_COUNT = 16;
+
+    /**
+     * Constructor.
+     * @param capacity Maximum number of cached keys
+     * @param shardCount Number of independently locked shards
+     * @throws std::invalid_argument if shardCount is 0
+     */
+    explicit PublicKeyCache(size_t capacity = DEFAULT_CAPACITY,
+                            size_t shardCount = DEFAULT_SHARD_COUNT);
+
+    /**
+     * Look up a key, parsing and inserting it on a miss. Keys parsed under a
+     * different backend than the active one are replaced.
+     * @throws std::runtime_error if the key is invalid (invalid keys are not cached)
+     */
+    Secp256k1::PublicKey get(std::span<const uint8_t> publicKey);
+
+    size_t capacity() const { return capacity_; }
+
+    void clear();
+
+    PublicKeyCacheStats stats() const;
+
+    /**
+     * Process-wide cache with the default capacity.
+     */
+    static PublicKeyCache& shared();
+
+private:
+    using Encoding = std::vector<uint8_t>;
+
+    struct EncodingHash {
+        size_t operator()(const Encoding& encoding) const;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        size_t capacity = 0;
+        std::list<std::pair<Encoding, Secp256k1::PublicKey>> lru; // most recent at front
+        std::unordered_map<Encoding, decltype(lru)::iterator, EncodingHash> index;
+        PublicKeyCacheStats stats;
+    };
+
+    Shard& shardFor(const Encoding& encoding);
+
+    size_t capacity_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace brightchain
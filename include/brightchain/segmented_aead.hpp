@@ -0,0 +1,104 @@
+#pragma once
+
+#include "brightchain/aes_gcm.hpp"
+#include "brightchain/thread_pool.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * Segmented AES-256-GCM for Large and Huge blocks.
+ *
+ * A single GCM message is sequential, so one 64 MiB block keeps one core
+ * busy. This format splits the payload into fixed-size segments that are
+ * sealed independently and in parallel on a thread pool:
+ *
+ *   [Header 64][Tag 16 x segments][Ciphertext = payload length]
+ *
+ * Header: "BSEG" | version | 3 reserved | segment size (u32 BE) |
+ *         payload length (u64 BE) | IV (12) | HMAC-SHA256 (32)
+ *
+ * Per-message encryption and MAC keys are derived from the caller's key
+ * and the random IV with HKDF-SHA256. Segment i is encrypted under the
+ * nonce i (big-endian, 12 bytes) with the first 32 header bytes as AAD.
+ * The header MAC covers those bytes, the caller's AAD and every segment
+ * tag, so truncated, reordered or spliced segments are rejected before
+ * any segment is decrypted.
+ *
+ * The format is independent of AesGcm::encrypt output; isSegmented()
+ * tells the two apart.
+ */
+class SegmentedAead {
+public:
+    static constexpr size_t DEFAULT_SEGMENT_SIZE = 1024 * 1024;
+    static constexpr size_t HEADER_SIZE = 64;
+
+    /**
+     * Constructor.
+     * @param segmentSize Plaintext bytes per segment for encryption
+     * @param pool Workers for sealing and opening segments
+     * @throws std::invalid_argument if segmentSize is 0 or above 2^31
+     */
+    explicit SegmentedAead(size_t segmentSize = DEFAULT_SEGMENT_SIZE,
+                           ThreadPool& pool = ThreadPool::shared());
+
+    size_t segmentSize() const { return segmentSize_; }
+
+    /**
+     * Bytes needed to seal a payload of the given size.
+     */
+    size_t sealedSize(size_t plaintextSize) const;
+
+    /**
+     * Seal a payload into a caller-provided buffer.
+     * @param sealed Output of at least sealedSize(plaintext.size()) bytes;
+     *        must not overlap plaintext
+     * @throws std::invalid_argument if sealed is too small
+     */
+    void encrypt(std::span<const uint8_t> plaintext, std::span<uint8_t> sealed,
+                 const AesGcm::Key& key, std::span<const uint8_t> aad = {}) const;
+
+    std::vector<uint8_t> encrypt(std::span<const uint8_t> plaintext, const AesGcm::Key& key,
+                                 std::span<const uint8_t> aad = {}) const;
+
+    /**
+     * Open a sealed payload into a caller-provided buffer. The segment size
+     * is taken from the header, not from this instance. The header MAC is
+     * checked first; if a segment then fails, the contents of plaintext are
+     * unspecified.
+     * @param plaintext Output of at least plaintextSize(sealed) bytes
+     * @throws std::runtime_error if the format is invalid or authentication fails
+     * @throws std::invalid_argument if plaintext is too small
+     */
+    void decrypt(std::span<const uint8_t> sealed, std::span<uint8_t> plaintext,
+                 const AesGcm::Key& key, std::span<const uint8_t> aad = {}) const;
+
+    std::vector<uint8_t> decrypt(std::span<const uint8_t> sealed, const AesGcm::Key& key,
+                                 std::span<const uint8_t> aad = {}) const;
+
+    /**
+     * Payload length recorded in a sealed header.
+     * @throws std::runtime_error if the header is invalid or does not match
+     *         the sealed length
+     */
+    static size_t plaintextSize(std::span<const uint8_t> sealed);
+
+    /**
+     * Whether data starts with a segmented AEAD header.
+     */
+    static bool isSegmented(std::span<const uint8_t> data);
+
+private:
+    /**
+     * Run fn(first, last) over segment ranges, split across the pool.
+     */
+    template <typename Fn>
+    void forSegments(size_t segments, size_t payloadSize, Fn&& fn) const;
+
+    size_t segmentSize_;
+    ThreadPool& pool_;
+};
+
+} // namespace brightchain
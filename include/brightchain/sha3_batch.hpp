@@ -0,0 +1,45 @@
+#pragma once
+
+#include "brightchain/checksum.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace brightchain {
+
+/**
+ * Implementation used for batch SHA3-512.
+ */
+enum class Sha3Kernel {
+    Scalar,   // One buffer at a time through OpenSSL
+    Avx2x4,   // Four Keccak states interleaved in 256-bit registers
+    Avx512x8  // Eight Keccak states interleaved in 512-bit registers
+};
+
+/**
+ * Fastest batch kernel supported by this CPU (checked once at runtime).
+ */
+Sha3Kernel sha3BestKernel();
+
+/**
+ * Number of buffers the kernel hashes per pass; batches that are a
+ * multiple of this use every lane.
+ */
+size_t sha3KernelLanes(Sha3Kernel kernel);
+
+/**
+ * SHA3-512 of many equal-length buffers. The multi-lane kernels run one
+ * Keccak permutation per 72-byte block for 4 or 8 buffers at once, which
+ * beats hashing them one by one when blocks are small enough to hash in
+ * bulk (e.g. a window of data blocks during ingest). A trailing partial
+ * group is hashed in the same kernel with idle lanes.
+ * @param inputs Buffers, each `length` bytes
+ * @param length Common length
+ * @param outputs Receives one digest per input
+ * @param kernel Kernel to use; must be supported by the CPU
+ * @throws std::invalid_argument if the kernel is not supported here
+ */
+void sha3_512Batch(std::span<const uint8_t* const> inputs, size_t length,
+                   Checksum::HashArray* outputs, Sha3Kernel kernel = sha3BestKernel());
+
+} // namespace brightchain
@@ -53,6 +53,7 @@ public:
      */
     bool validateSignature(const std::vector<uint8_t>& publicKey) const;
     std::vector<Checksum> subCblChecksums() const;
+    const SuperCBLHeader& header() const { return header_; }
     uint32_t subCblCount() const { return header_.subCblCount; }
     uint32_t totalBlockCount() const { return header_.totalBlockCount; }
     uint16_t depth() const { return header_.depth; }
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "brightchain/checksum.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include "brightchain/extended_cbl.hpp"
+#include "brightchain/thread_pool.hpp"
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <optional>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * Options for SuperCBLBuilder.
+ */
+struct SuperCBLBuilderOptions {
+    std::array<uint8_t, 16> creatorId{};
+
+    /**
+     * Addresses per tuple; leaves hold a whole number of tuples.
+     */
+    uint8_t tupleSize = 1;
+
+    /**
+     * When set, every leaf is an ExtendedCBL carrying this metadata, so the
+     * file name survives whichever node ends up as the root.
+     */
+    std::optional<ExtendedCBLMetadata> metadata;
+};
+
+/**
+ * Outcome of building a tree.
+ */
+struct SuperCBLBuildResult {
+    Checksum root;
+    uint16_t depth = 0;        // 0: the root is a single CBL
+    uint64_t addressCount = 0; // Data block addresses in the leaves
+    uint64_t cblCount = 0;
+    uint64_t superCblCount = 0;
+};
+
+/**
+ * SuperCBLBuilder turns an unbounded, ordered stream of block addresses
+ * into a CBL tree in the store.
+ *
+ * Addresses are packed into full leaf CBLs; every SuperCBL level rolls up
+ * as soon as it holds as many children as fit in one block, and only the
+ * last node on each level is partial. This is the layout RangeReader
+ * navigates arithmetically. Leaves and SuperCBLs are serialized and stored
+ * on a worker pool while the caller keeps adding, with a bounded number
+ * of nodes in flight, so memory use is O(depth x block size) whatever the
+ * input length.
+ *
+ * Every node records the length of data it covers (full blocks, except
+ * for the last node on each level). The whole-file checksum is only known
+ * at the end and is set on the root; other nodes carry a zero checksum.
+ *
+ * Not thread-safe; one producer adds addresses in file order.
+ */
+class SuperCBLBuilder {
+public:
+    /**
+     * Constructor.
+     * @param store Destination store; its block size sizes every node
+     * @param options Creator, tuple size and optional file metadata
+     * @param pool Workers for serializing and storing nodes. Do not use the
+     *        builder from one of this pool's workers.
+     * @throws std::invalid_argument if a node cannot hold one tuple or two children
+     */
+    explicit SuperCBLBuilder(DiskBlockStore& store, const SuperCBLBuilderOptions& options = {},
+                             ThreadPool& pool = ThreadPool::shared());
+
+    /**
+     * Waits for nodes still being stored.
+     */
+    ~SuperCBLBuilder();
+
+    SuperCBLBuilder(const SuperCBLBuilder&) = delete;
+    SuperCBLBuilder& operator=(const SuperCBLBuilder&) = delete;
+
+    /**
+     * Append the next address in file order.
+     * @throws std::runtime_error if storing an earlier node failed
+     */
+    void add(const Checksum& address);
+
+    /**
+     * Store the partial nodes and the root. The builder cannot be reused.
+     * @param originalDataLength Length of the described data
+     * @param originalDataChecksum Checksum of the described data, set on the root
+     * @throws std::runtime_error if storing a node failed, or the address
+     *         count is not a multiple of the tuple size
+     */
+    SuperCBLBuildResult finish(uint64_t originalDataLength, const Checksum& originalDataChecksum);
+
+    /**
+     * Addresses per leaf CBL (a multiple of the tuple size).
+     */
+    size_t leafCapacity() const { return leafCapacity_; }
+
+    /**
+     * Children per SuperCBL.
+     */
+    size_t fanout() const { return fanout_; }
+
+private:
+    struct Child {
+        std::shared_future<Checksum> checksum;
+        uint64_t tuples = 0;    // Data tuples beneath the child
+        uint64_t addresses = 0; // Data block addresses beneath the child
+    };
+
+    /**
+     * Store the current leaf. Final nodes get the total length so the last
+     * one on each level is clipped; the root also gets the data checksum.
+     */
+    std::shared_future<Checksum> flushLeaf(std::optional<uint64_t> totalLength,
+                                           std::optional<Checksum> rootChecksum);
+    std::shared_future<Checksum> flushLevel(size_t level, std::optional<uint64_t> totalLength,
+                                            std::optional<Checksum> rootChecksum);
+    void push(size_t level, Child child);
+    uint64_t nodeLength(uint64_t firstTuple, uint64_t tuples,
+                        std::optional<uint64_t> totalLength) const;
+    std::shared_future<Checksum> submit(std::function<Checksum()> task);
+
+    DiskBlockStore& store_;
+    ThreadPool& pool_;
+    SuperCBLBuilderOptions options_;
+    size_t blockLength_;
+    size_t leafCapacity_;
+    size_t fanout_;
+    size_t window_;
+
+    std::vector<Checksum> leaf_;
+    uint64_t leafFirstTuple_ = 0;
+    std::vector<std::vector<Child>> levels_; // levels_[i] feeds a SuperCBL of depth i + 1
+    std::vector<uint64_t> levelFirstTuple_;
+    std::deque<std::shared_future<Checksum>> inFlight_;
+    SuperCBLBuildResult result_;
+    bool finished_ = false;
+};
+
+} // namespace brightchain
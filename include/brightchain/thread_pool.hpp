@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * Fixed-size worker pool used by the storage and crypto pipelines.
+ * Tasks run in FIFO order; the destructor finishes queued tasks before joining.
+ */
+class ThreadPool {
+public:
+    /**
+     * Constructor.
+     * @param threadCount Number of workers (0 selects the hardware concurrency)
+     */
+    explicit ThreadPool(size_t threadCount = 0);
+
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Queue a task without a result. Exceptions escaping the task are discarded;
+     * use submit() to observe them.
+     */
+    void post(std::function<void()> task);
+
+    /**
+     * Queue a task and get a future for its result (or exception).
+     */
+    template <typename F>
+    auto submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        auto packaged =
+            std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        auto future = packaged->get_future();
+        post([packaged]() { (*packaged)(); });
+        return future;
+    }
+
+    /**
+     * Run fn(begin, end) over [first, last) split into contiguous ranges, one
+     * per worker, and wait for all of them. Runs inline when the range or
+     * the pool is too small to split, and when called from one of this
+     * pool's workers, where waiting on queued tasks could deadlock.
+     * @throws The first range's exception, once every range has finished
+     */
+    template <typename Fn>
+    void parallelFor(size_t first, size_t last, Fn&& fn) {
+        if (last <= first) {
+            return;
+        }
+        const size_t count = last - first;
+        if (count < 2 || size() < 2 || onWorker()) {
+            fn(first, last);
+            return;
+        }
+
+        const size_t perTask = (count + size() - 1) / size();
+        std::vector<std::future<void>> tasks;
+        tasks.reserve((count + perTask - 1) / perTask);
+        for (size_t begin = first; begin < last; begin += perTask) {
+            const size_t end = std::min(last, begin + perTask);
+            tasks.push_back(submit([&fn, begin, end]() { fn(begin, end); }));
+        }
+        for (auto& task : tasks) {
+            task.wait();
+        }
+        for (auto& task : tasks) {
+            task.get();
+        }
+    }
+
+    /**
+     * Block until the queue is empty and no task is running.
+     */
+    void waitIdle();
+
+    /**
+     * Check whether the calling thread is one of this pool's workers.
+     */
+    bool onWorker() const;
+
+    /**
+     * Number of worker threads.
+     */
+    size_t size() const { return workers_.size(); }
+
+    /**
+     * Process-wide pool sized to the hardware concurrency.
+     */
+    static ThreadPool& shared();
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable available_;
+    std::condition_variable idle_;
+    size_t running_ = 0;
+    bool stopping_ = false;
+};
+
+} // namespace brightchain
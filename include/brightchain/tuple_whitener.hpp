@@ -0,0 +1,157 @@
+#pragma once
+
+#include "brightchain/checksum.hpp"
+#include "brightchain/constants.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * RandomBlockPool remembers the checksums of random blocks already in a
+ * store so that new tuples can reuse them instead of generating and
+ * storing fresh randomness every time (the OFFS reuse model).
+ *
+ * Bounded: once full, a new block replaces a random existing entry.
+ * Thread-safe.
+ */
+class RandomBlockPool {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 4096;
+
+    explicit RandomBlockPool(size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * Offer a stored random block for reuse.
+     */
+    void add(const Checksum& checksum);
+
+    /**
+     * Forget a block (e.g. one that has been removed from the store).
+     */
+    void remove(const Checksum& checksum);
+
+    /**
+     * Pick up to `count` distinct blocks at random.
+     */
+    std::vector<Checksum> sample(size_t count);
+
+    size_t size() const;
+    size_t capacity() const { return capacity_; }
+
+private:
+    mutable std::mutex mutex_;
+    size_t capacity_;
+    std::vector<Checksum> blocks_;
+    std::mt19937_64 rng_;
+};
+
+/**
+ * Options for TupleWhitener.
+ */
+struct WhiteningOptions {
+    /**
+     * Random blocks XORed into each source block; the tuple has one more member.
+     */
+    uint32_t randomBlocks = TupleConstants::RANDOM_BLOCKS_PER_TUPLE;
+
+    /**
+     * Long-run share of random blocks drawn from the pool rather than
+     * generated fresh.
+     */
+    double reuseFraction = OFFS_CACHE_PERCENTAGE;
+};
+
+/**
+ * A whitened tuple: XORing every member restores the source block.
+ */
+struct WhitenedTuple {
+    std::vector<Checksum> members; // Whitened block first, then the random blocks
+    uint32_t reusedBlocks = 0;     // Random blocks taken from the pool
+};
+
+/**
+ * TupleWhitener implements owner-free storage of blocks: a source block is
+ * XORed with random blocks and only the result and the random blocks are
+ * stored, none of which reveals the source on its own.
+ *
+ * Random blocks are drawn from a RandomBlockPool for reuseFraction of the
+ * draws (tracked exactly over the whitener's lifetime) and generated fresh
+ * for the rest; fresh blocks are stored and offered to the pool. Pooled
+ * blocks are read through memory maps, and the source and all random
+ * blocks are combined in one vectorized pass (see xorBlocks), so
+ * whitening Medium and Large blocks is bound by memory bandwidth rather
+ * than per-byte work.
+ *
+ * Tuples use the layout of CBL tuples, so a CBL with tupleSize
+ * randomBlocks + 1 over the members is read back by Reassembler and
+ * RangeReader. Thread-safe.
+ */
+class TupleWhitener {
+public:
+    /**
+     * Constructor.
+     * @param store Store for whitened and random blocks; sets the block size
+     * @param pool Pool of reusable random blocks in that store
+     * @param options Tuple shape and reuse ratio
+     * @throws std::invalid_argument if randomBlocks is outside
+     *         TupleConstants::MIN_RANDOM_BLOCKS..MAX_RANDOM_BLOCKS or
+     *         reuseFraction is outside [0, 1]
+     */
+    TupleWhitener(DiskBlockStore& store, RandomBlockPool& pool,
+                  const WhiteningOptions& options = {});
+
+    /**
+     * Whiten and store one block.
+     * @param source Block data, at most one block long; shorter data is
+     *        zero padded
+     * @return Tuple members
+     * @throws std::invalid_argument if the source is longer than a block
+     * @throws std::runtime_error if randomness or storage fails; references
+     *         taken on pooled blocks are released first
+     */
+    WhitenedTuple whiten(std::span<const uint8_t> source);
+
+    /**
+     * Recover a source block by XORing the members of its tuple.
+     * @throws std::runtime_error if a member is missing or has the wrong size
+     */
+    std::vector<uint8_t> reconstruct(std::span<const Checksum> members) const;
+
+    /**
+     * Recover a source block into a caller-provided block-sized buffer.
+     */
+    void reconstructInto(std::span<const Checksum> members, uint8_t* out) const;
+
+    uint64_t reusedCount() const;
+    uint64_t freshCount() const;
+
+private:
+    /**
+     * Decide how many of a tuple's random blocks to reuse, keeping the
+     * running share at reuseFraction.
+     */
+    uint32_t planReuse();
+
+    /**
+     * Generate the fresh random blocks, then store the whitened block and
+     * the fresh ones, appending them to tuple.members.
+     */
+    void whitenInto(WhitenedTuple& tuple, std::span<const uint8_t> source,
+                    const std::vector<MappedBlock>& reused);
+
+    DiskBlockStore& store_;
+    RandomBlockPool& pool_;
+    WhiteningOptions options_;
+    size_t blockLength_;
+
+    mutable std::mutex statsMutex_;
+    uint64_t reused_ = 0;
+    uint64_t fresh_ = 0;
+};
+
+} // namespace brightchain
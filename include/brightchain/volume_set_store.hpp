@@ -0,0 +1,222 @@
+#pragma once
+
+#include "brightchain/disk_block_store.hpp"
+#include "brightchain/thread_pool.hpp"
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace brightchain {
+
+/**
+ * One root directory of a VolumeSetStore, typically a mount point.
+ */
+struct VolumeSpec {
+    std::string path;
+
+    /**
+     * Relative share of the blocks placed on this volume. 0 uses the
+     * capacity of the filesystem, which unlike its free space does not
+     * change as blocks are stored.
+     */
+    uint64_t weight = 0;
+};
+
+/**
+ * State of a volume as reported by VolumeSetStore::volumes().
+ */
+struct VolumeInfo {
+    std::string path;
+    double weight;
+    bool draining; // Removed: no new blocks, emptied by rebalance()
+};
+
+/**
+ * VolumeSetStore spreads the blocks of one block size across several
+ * DiskBlockStores, one per volume, so a node with many disks gets their
+ * aggregate bandwidth behind a single store.
+ *
+ * Placement is weighted rendezvous hashing on the checksum: every volume
+ * scores the block and the highest score owns it. Adding a volume therefore
+ * only claims the blocks it now wins, and removing one only releases its
+ * own; rebalance() moves those blocks in bounded steps. Until a block has
+ * been moved, reads probe the volumes in score order and still find it.
+ * A put that finds its owner out of space (ENOSPC or EDQUOT) goes to the
+ * next volume in score order instead, where reads find it the same way;
+ * rebalance() leaves such a block in place while its owner stays full.
+ *
+ * putMany() and getMany() run one task per volume on the thread pool; do
+ * not call them from a task of that pool. Puts hold the volume list's shared
+ * lock while they write, so rebalance() only detaches a drained volume once
+ * no put can still land on it.
+ */
+class VolumeSetStore {
+public:
+    /**
+     * Constructor. Volume directories are created if needed.
+     * @param volumes Volume roots; each becomes storePath of a DiskBlockStore
+     * @param blockSize Block size for every volume
+     * @param options Options applied to every volume
+     * @param pool Workers for parallel I/O and rebalancing
+     * @throws std::invalid_argument if no volumes are given or a path repeats
+     */
+    VolumeSetStore(const std::vector<VolumeSpec>& volumes, BlockSize blockSize,
+                   const DiskBlockStoreOptions& options = {},
+                   ThreadPool& pool = ThreadPool::shared());
+
+    VolumeSetStore(const VolumeSetStore&) = delete;
+    VolumeSetStore& operator=(const VolumeSetStore&) = delete;
+
+    /**
+     * Store a block on its owning volume, or the next one in score order
+     * with room if the owner is full.
+     * @return Checksum of the stored block
+     * @throws std::runtime_error if every volume is draining
+     * @throws std::system_error if every accepting volume is out of space
+     */
+    Checksum put(const std::vector<uint8_t>& data);
+    Checksum put(const std::vector<uint8_t>& data, const BlockMetadata& metadata);
+    Checksum put(const Checksum& checksum, const std::vector<uint8_t>& data,
+                 const BlockMetadata& metadata);
+
+    /**
+     * Store many blocks, writing to all volumes concurrently.
+     * @param blocks Block data
+     * @param metadata One entry per block, or empty for default metadata
+     * @return Checksums in the order of blocks
+     * @throws std::invalid_argument if metadata is non-empty and sized differently
+     */
+    std::vector<Checksum> putMany(std::span<const std::vector<uint8_t>> blocks,
+                                  std::span<const BlockMetadata> metadata = {});
+
+    /**
+     * Retrieve a block.
+     * @throws std::runtime_error if no volume holds it
+     */
+    std::vector<uint8_t> get(const Checksum& checksum) const;
+
+    /**
+     * Retrieve many blocks, reading from all volumes concurrently.
+     * @return Block data in the order of checksums
+     * @throws std::runtime_error if any block is missing
+     */
+    std::vector<std::vector<uint8_t>> getMany(std::span<const Checksum> checksums) const;
+
+    /**
+     * Retrieve a block as a read-only memory-mapped view.
+     * @throws std::runtime_error if no volume holds it
+     */
+    MappedBlock getMapped(const Checksum& checksum, AccessHint hint = AccessHint::Normal) const;
+
+    bool has(const Checksum& checksum) const;
+
+    /**
+     * Delete a block from every volume holding a copy. With reference
+     * counting, drop one reference from the copy reads find instead.
+     * @return True if any copy was deleted
+     */
+    bool remove(const Checksum& checksum);
+
+    /**
+     * Invoke a callback once for every stored block, including blocks
+     * not yet moved to their owner.
+     */
+    void forEachChecksum(const std::function<void(const Checksum&)>& callback) const;
+
+    std::optional<BlockMetadata> getMetadata(const Checksum& checksum) const;
+
+    /**
+     * Add a volume. Blocks it now owns stay where they are until rebalance().
+     * @throws std::invalid_argument if the path is already part of the set
+     */
+    void addVolume(const VolumeSpec& volume);
+
+    /**
+     * Stop placing blocks on a volume. rebalance() moves its blocks away and
+     * detaches it once it is empty.
+     * @throws std::invalid_argument if the path is unknown or it is the last
+     *         volume accepting blocks
+     */
+    void removeVolume(const std::string& path);
+
+    /**
+     * Move blocks that are not on their owning volume, sources in parallel.
+     * @param maxBlocks Upper bound on blocks moved by this call
+     * @return Number of blocks moved; 0 once placement is settled
+     */
+    size_t rebalance(size_t maxBlocks = std::numeric_limits<size_t>::max());
+
+    /**
+     * Volume a block is placed on by the current volume set.
+     * @throws std::runtime_error if every volume is draining
+     */
+    std::string ownerOf(const Checksum& checksum) const;
+
+    std::vector<VolumeInfo> volumes() const;
+
+    BlockSize blockSize() const { return blockSize_; }
+
+private:
+    struct Volume {
+        std::string path;
+        uint64_t id;
+        double weight;
+        std::atomic<bool> draining{false};
+        std::unique_ptr<DiskBlockStore> store;
+    };
+    using VolumePtr = std::shared_ptr<Volume>;
+
+    VolumePtr openVolume(const VolumeSpec& spec) const;
+
+    /**
+     * Copy of the volume list, safe to use without the lock.
+     */
+    std::vector<VolumePtr> snapshot() const;
+
+    /**
+     * Volumes in descending rendezvous score for a block.
+     */
+    static std::vector<VolumePtr> ranked(const Checksum& checksum,
+                                         std::vector<VolumePtr> volumes);
+
+    /**
+     * Highest-ranked volume that is not draining.
+     */
+    static VolumePtr owner(const std::vector<VolumePtr>& ranking);
+
+    /**
+     * First volume in ranking that holds the block, or null.
+     */
+    static VolumePtr locate(const Checksum& checksum, const std::vector<VolumePtr>& ranking);
+
+    /**
+     * Put on the owner, falling back down the ranking past volumes that are
+     * out of space.
+     */
+    static void putRanked(const std::vector<VolumePtr>& ranking, const Checksum& checksum,
+                          const std::vector<uint8_t>& data, const BlockMetadata& metadata);
+
+    BlockSize blockSize_;
+    DiskBlockStoreOptions options_;
+    ThreadPool& pool_;
+    mutable std::shared_mutex mutex_;
+    std::vector<VolumePtr> volumes_;
+
+    /**
+     * Orders rebalance() moves and removes of one checksum, striped by
+     * checksum, so a remove cannot land between the copy and the delete.
+     */
+    static constexpr size_t MOVE_STRIPES = 64;
+    std::array<std::mutex, MOVE_STRIPES> moveStripes_;
+
+    std::mutex& stripeFor(const Checksum& checksum);
+};
+
+} // namespace brightchain
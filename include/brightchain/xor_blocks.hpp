@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace brightchain {
+
+class Checksum;
+class DiskBlockStore;
+
+/**
+ * XOR `length` bytes of `source` into `target` (target ^= source).
+ * Uses AVX-512 or AVX2 when the CPU has them. Buffers need no alignment
+ * and may be memory-mapped.
+ */
+void xorInto(uint8_t* target, const uint8_t* source, size_t length);
+
+/**
+ * XOR several sources into one output in a single pass:
+ * target = sources[0] ^ sources[1] ^ ... Each byte of every source is read
+ * once and each output byte written once, so whitening a tuple costs one
+ * sweep over memory rather than one per member.
+ * @param target Output; may alias sources[0] but no other source
+ * @param sources At least one buffer of `length` bytes
+ * @param length Bytes per buffer
+ */
+void xorBlocks(uint8_t* target, std::span<const uint8_t* const> sources, size_t length);
+
+/**
+ * Recover a data block from the stored members of its tuple:
+ * out = members[0] ^ members[1] ^ ... Members are memory-mapped and combined
+ * with xorBlocks(), so nothing is copied before the single output pass.
+ * @param out Output of `length` bytes
+ * @param length Length every member must have
+ * @throws std::invalid_argument if members is empty
+ * @throws std::runtime_error if a member is missing or of another length
+ */
+void xorTupleInto(const DiskBlockStore& store, std::span<const Checksum> members, uint8_t* out,
+                  size_t length);
+
+/**
+ * As xorTupleInto(), sized by the first member.
+ */
+std::vector<uint8_t> xorTuple(const DiskBlockStore& store, std::span<const Checksum> members);
+
+} // namespace brightchain
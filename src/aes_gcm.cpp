@@ -1,8 +1,10 @@
 #include "brightchain/aes_gcm.hpp"
 #include <openssl/evp.h>
 #include <openssl/rand.h>
+#include <algorithm>
 #include <stdexcept>
 #include <cstring>
+#include <utility>
 
 namespace brightchain {
 
@@ -22,6 +24,43 @@ AesGcm::IV AesGcm::generateIV() {
     return iv;
 }
 
+namespace {
+
+// EVP lengths are ints; feed larger spans in pieces
+constexpr size_t MAX_EVP_CHUNK = size_t{1} << 30;
+
+/**
+ * Per-thread stream for the one-shot API, so each call reuses a context.
+ */
+AesGcmStream& threadStream(AesGcmStream::Mode mode) {
+    thread_local AesGcmStream encryptor(AesGcmStream::Mode::Encrypt);
+    thread_local AesGcmStream decryptor(AesGcmStream::Mode::Decrypt);
+    return mode == AesGcmStream::Mode::Encrypt ? encryptor : decryptor;
+}
+
+/**
+ * Wipes a thread stream's key when a one-shot call returns or throws, so
+ * no key schedule outlives the call in thread-local storage.
+ */
+class KeyScope {
+public:
+    explicit KeyScope(AesGcmStream& stream) : stream_(stream) {}
+    ~KeyScope() {
+        try {
+            stream_.clearKey();
+        } catch (...) {
+            // The reset itself wiped the key; only re-initialization failed
+        }
+    }
+    KeyScope(const KeyScope&) = delete;
+    KeyScope& operator=(const KeyScope&) = delete;
+
+private:
+    AesGcmStream& stream_;
+};
+
+} // namespace
+
 std::vector<uint8_t> AesGcm::encrypt(
     const std::vector<uint8_t>& plaintext,
     const Key& key,
@@ -29,120 +68,188 @@ std::vector<uint8_t> AesGcm::encrypt(
     Tag& tag,
     const std::vector<uint8_t>& aad
 ) {
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) {
+    AesGcmStream& stream = threadStream(AesGcmStream::Mode::Encrypt);
+    KeyScope scope(stream);
+    stream.init(key, iv, aad);
+
+    std::vector<uint8_t> ciphertext(plaintext.size());
+    stream.update(plaintext, ciphertext);
+    tag = stream.finish();
+    return ciphertext;
+}
+
+std::vector<uint8_t> AesGcm::decrypt(
+    const std::vector<uint8_t>& ciphertext,
+    const Key& key,
+    const IV& iv,
+    const Tag& tag,
+    const std::vector<uint8_t>& aad
+) {
+    AesGcmStream& stream = threadStream(AesGcmStream::Mode::Decrypt);
+    KeyScope scope(stream);
+    stream.init(key, iv, aad);
+
+    std::vector<uint8_t> plaintext(ciphertext.size());
+    stream.update(ciphertext, plaintext);
+    stream.finish(tag);
+    return plaintext;
+}
+
+struct AesGcmStream::Context {
+    EVP_CIPHER_CTX* ctx = nullptr;
+    ~Context() { EVP_CIPHER_CTX_free(ctx); }
+};
+
+AesGcmStream::AesGcmStream(Mode mode) : context_(std::make_unique<Context>()), mode_(mode) {
+    context_->ctx = EVP_CIPHER_CTX_new();
+    if (!context_->ctx) {
         throw std::runtime_error("Failed to create cipher context");
     }
+    setup();
+}
 
-    if (EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("Failed to initialize encryption");
+void AesGcmStream::setup() {
+    const int enc = mode_ == Mode::Encrypt ? 1 : 0;
+    if (EVP_CipherInit_ex(context_->ctx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr, enc) != 1) {
+        throw std::runtime_error(enc ? "Failed to initialize encryption"
+                                     : "Failed to initialize decryption");
     }
 
-    if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, IV_SIZE, nullptr) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
+    if (EVP_CIPHER_CTX_ctrl(context_->ctx, EVP_CTRL_GCM_SET_IVLEN, AesGcm::IV_SIZE, nullptr) != 1) {
         throw std::runtime_error("Failed to set IV length");
     }
+}
 
-    if (EVP_EncryptInit_ex(ctx, nullptr, nullptr, key.data(), iv.data()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("Failed to set key and IV");
-    }
+AesGcmStream::~AesGcmStream() = default;
 
-    // Process AAD if provided
-    if (!aad.empty()) {
-        int len;
-        if (EVP_EncryptUpdate(ctx, nullptr, &len, aad.data(), aad.size()) != 1) {
-            EVP_CIPHER_CTX_free(ctx);
-            throw std::runtime_error("Failed to process AAD");
-        }
-    }
+AesGcmStream::AesGcmStream(AesGcmStream&& other) noexcept
+    : context_(std::move(other.context_)),
+      mode_(other.mode_),
+      keyed_(std::exchange(other.keyed_, false)),
+      active_(std::exchange(other.active_, false)) {}
 
-    std::vector<uint8_t> ciphertext(plaintext.size() + EVP_CIPHER_block_size(EVP_aes_256_gcm()));
-    int len = 0;
+AesGcmStream& AesGcmStream::operator=(AesGcmStream&& other) noexcept {
+    context_ = std::move(other.context_);
+    mode_ = other.mode_;
+    keyed_ = std::exchange(other.keyed_, false);
+    active_ = std::exchange(other.active_, false);
+    return *this;
+}
 
-    if (EVP_EncryptUpdate(ctx, ciphertext.data(), &len, plaintext.data(), plaintext.size()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("Failed to encrypt data");
+void AesGcmStream::clearKey() {
+    keyed_ = false;
+    active_ = false;
+    if (!context_) {
+        return;
     }
-    int ciphertext_len = len;
+    // Reset cleanses the key schedule; the cipher and IV length are set again
+    EVP_CIPHER_CTX_reset(context_->ctx);
+    setup();
+}
 
-    if (EVP_EncryptFinal_ex(ctx, ciphertext.data() + len, &len) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("Failed to finalize encryption");
+void AesGcmStream::init(const AesGcm::Key& key, const AesGcm::IV& iv,
+                        std::span<const uint8_t> aad) {
+    if (!context_) {
+        throw std::logic_error("AES-GCM stream has been moved from");
     }
-    ciphertext_len += len;
-
-    if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, TAG_SIZE, tag.data()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("Failed to get authentication tag");
+    active_ = false;
+    if (EVP_CipherInit_ex(context_->ctx, nullptr, nullptr, key.data(), iv.data(),
+                          mode_ == Mode::Encrypt ? 1 : 0) != 1) {
+        throw std::runtime_error("Failed to set key and IV");
     }
-
-    EVP_CIPHER_CTX_free(ctx);
-    ciphertext.resize(ciphertext_len);
-    return ciphertext;
+    keyed_ = true;
+    init(iv, aad);
 }
 
-std::vector<uint8_t> AesGcm::decrypt(
-    const std::vector<uint8_t>& ciphertext,
-    const Key& key,
-    const IV& iv,
-    const Tag& tag,
-    const std::vector<uint8_t>& aad
-) {
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) {
-        throw std::runtime_error("Failed to create cipher context");
+void AesGcmStream::init(const AesGcm::IV& iv, std::span<const uint8_t> aad) {
+    if (!keyed_) {
+        throw std::logic_error("No key set for AES-GCM stream");
     }
 
-    if (EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("Failed to initialize decryption");
+    // A null key keeps the existing key schedule and only resets the IV
+    active_ = false;
+    if (EVP_CipherInit_ex(context_->ctx, nullptr, nullptr, nullptr, iv.data(),
+                          mode_ == Mode::Encrypt ? 1 : 0) != 1) {
+        throw std::runtime_error("Failed to set IV");
     }
 
-    if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, IV_SIZE, nullptr) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("Failed to set IV length");
+    for (size_t offset = 0; offset < aad.size(); offset += MAX_EVP_CHUNK) {
+        const size_t length = std::min(MAX_EVP_CHUNK, aad.size() - offset);
+        int len;
+        if (EVP_CipherUpdate(context_->ctx, nullptr, &len, aad.data() + offset,
+                             static_cast<int>(length)) != 1) {
+            throw std::runtime_error("Failed to process AAD");
+        }
     }
+    active_ = true;
+}
 
-    if (EVP_DecryptInit_ex(ctx, nullptr, nullptr, key.data(), iv.data()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("Failed to set key and IV");
+void AesGcmStream::requireActive() const {
+    if (!active_) {
+        throw std::logic_error("AES-GCM stream has no message in progress");
     }
+}
 
-    // Process AAD if provided
-    if (!aad.empty()) {
+void AesGcmStream::update(std::span<const uint8_t> in, std::span<uint8_t> out) {
+    requireActive();
+    if (out.size() < in.size()) {
+        throw std::invalid_argument("Output buffer too small");
+    }
+    if (in.data() != out.data() && in.data() < out.data() + in.size() &&
+        out.data() < in.data() + in.size()) {
+        throw std::invalid_argument("Input and output partially overlap");
+    }
+
+    // GCM is a stream mode: every input byte yields one output byte immediately
+    for (size_t offset = 0; offset < in.size(); offset += MAX_EVP_CHUNK) {
+        const size_t length = std::min(MAX_EVP_CHUNK, in.size() - offset);
         int len;
-        if (EVP_DecryptUpdate(ctx, nullptr, &len, aad.data(), aad.size()) != 1) {
-            EVP_CIPHER_CTX_free(ctx);
-            throw std::runtime_error("Failed to process AAD");
+        if (EVP_CipherUpdate(context_->ctx, out.data() + offset, &len, in.data() + offset,
+                             static_cast<int>(length)) != 1) {
+            throw std::runtime_error(mode_ == Mode::Encrypt ? "Failed to encrypt data"
+                                                            : "Failed to decrypt data");
         }
     }
+}
 
-    std::vector<uint8_t> plaintext(ciphertext.size());
+AesGcm::Tag AesGcmStream::finish() {
+    if (mode_ != Mode::Encrypt) {
+        throw std::logic_error("finish() without a tag is only valid when encrypting");
+    }
+    requireActive();
+    active_ = false;
+
+    uint8_t trailing[16];
     int len = 0;
+    if (EVP_CipherFinal_ex(context_->ctx, trailing, &len) != 1) {
+        throw std::runtime_error("Failed to finalize encryption");
+    }
 
-    if (EVP_DecryptUpdate(ctx, plaintext.data(), &len, ciphertext.data(), ciphertext.size()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("Failed to decrypt data");
+    AesGcm::Tag tag;
+    if (EVP_CIPHER_CTX_ctrl(context_->ctx, EVP_CTRL_GCM_GET_TAG, AesGcm::TAG_SIZE,
+                            tag.data()) != 1) {
+        throw std::runtime_error("Failed to get authentication tag");
     }
-    int plaintext_len = len;
+    return tag;
+}
 
-    if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, TAG_SIZE, const_cast<uint8_t*>(tag.data())) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw std::runtime_error("Failed to set authentication tag");
+void AesGcmStream::finish(const AesGcm::Tag& tag) {
+    if (mode_ != Mode::Decrypt) {
+        throw std::logic_error("finish(tag) is only valid when decrypting");
     }
+    requireActive();
+    active_ = false;
 
-    int ret = EVP_DecryptFinal_ex(ctx, plaintext.data() + len, &len);
-    EVP_CIPHER_CTX_free(ctx);
+    if (EVP_CIPHER_CTX_ctrl(context_->ctx, EVP_CTRL_GCM_SET_TAG, AesGcm::TAG_SIZE,
+                            const_cast<uint8_t*>(tag.data())) != 1) {
+        throw std::runtime_error("Failed to set authentication tag");
+    }
 
-    if (ret != 1) {
+    uint8_t trailing[16];
+    int len = 0;
+    if (EVP_CipherFinal_ex(context_->ctx, trailing, &len) != 1) {
         throw std::runtime_error("Authentication failed - data may be corrupted");
     }
-    plaintext_len += len;
-
-    plaintext.resize(plaintext_len);
-    return plaintext;
 }
 
 } // namespace brightchain
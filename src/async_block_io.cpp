@@ -0,0 +1,620 @@
+#include "brightchain/async_block_io.hpp"
+#include "brightchain/metadata_index.hpp"
+#include <stdexcept>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define BRIGHTCHAIN_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace brightchain {
+
+namespace {
+
+/**
+ * Validate the depth before the worker pool is sized from it.
+ */
+size_t checkedDepth(size_t queueDepth) {
+    if (queueDepth == 0) {
+        throw std::invalid_argument("Queue depth must be positive");
+    }
+    return queueDepth;
+}
+
+} // namespace
+
+#ifdef BRIGHTCHAIN_HAVE_IO_URING
+
+/**
+ * Block reads driven through io_uring with the raw syscalls, so there is no
+ * liburing dependency. A read submits OPENAT and STATX together, then READs
+ * the reported size and CLOSEs the file. One completion thread reaps the
+ * ring and submits each read's next step. At most `depth` reads hold a slot
+ * in the ring; the rest wait in a backlog.
+ */
+class AsyncBlockIO::Ring {
+public:
+    using Done = std::function<void(std::vector<uint8_t>, std::exception_ptr)>;
+
+    /**
+     * Set up a ring, or return nullptr if the kernel lacks io_uring or one
+     * of the opcodes used here.
+     */
+    static std::unique_ptr<Ring> create(size_t depth);
+
+    ~Ring();
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    void read(const Checksum& checksum, std::string path,
+              std::optional<VirtualPadding> padding, Done done);
+
+    /**
+     * Block until no read holds a slot or waits in the backlog.
+     */
+    void waitIdle();
+
+private:
+    // Largest ring the kernel accepts is 32768 entries; each read needs two
+    static constexpr size_t MAX_DEPTH = 4096;
+
+    enum Step : uint64_t { Open = 0, Stat = 1, Read = 2, Close = 3 };
+    static constexpr uint64_t STEP_MASK = 3;
+    static constexpr uint64_t WAKE = 0; // user_data of the shutdown NOP
+
+    struct alignas(8) Request {
+        Request(const Checksum& checksum, std::string path, Done done,
+                std::optional<VirtualPadding> padding)
+            : checksum(checksum), path(std::move(path)), done(std::move(done)),
+              padding(padding) {}
+
+        Checksum checksum;
+        std::string path;
+        Done done;
+        std::optional<VirtualPadding> padding;
+        struct statx status {};
+        std::vector<uint8_t> data;
+        size_t readLength = 0; // Stored prefix of data to read from the file
+        size_t offset = 0;
+        int fd = -1;
+        int openError = 0;
+        int statError = 0;
+        int pending = 0; // Completions outstanding for the open/stat step
+        std::exception_ptr failure;
+    };
+
+    Ring(int fd, const io_uring_params& params, size_t depth);
+
+    void unmap();
+
+    io_uring_sqe& nextSqe(Request* request, Step step, uint8_t opcode);
+    void flush();
+    void start(Request* request);
+    void opened(Request* request);
+    void submitRead(Request* request);
+    void finish(Request* request);
+    void release(Request* request);
+    void complete(uint64_t userData, int result);
+    void reap();
+
+    int fd_;
+    size_t depth_;
+
+    void* sqRing_ = MAP_FAILED;
+    size_t sqRingSize_ = 0;
+    void* cqRing_ = MAP_FAILED;
+    size_t cqRingSize_ = 0;
+    io_uring_sqe* sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize_ = 0;
+
+    unsigned* sqTail_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned* sqArray_ = nullptr;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    std::mutex mutex_; // Guards the submission queue and the slot accounting
+    std::condition_variable idle_;
+    unsigned unsubmitted_ = 0;
+    size_t active_ = 0;
+    std::deque<Request*> backlog_;
+    std::thread reaper_;
+};
+
+std::unique_ptr<AsyncBlockIO::Ring> AsyncBlockIO::Ring::create(size_t depth) {
+    depth = std::min(depth, MAX_DEPTH);
+    io_uring_params params{};
+    const int fd = static_cast<int>(
+        ::syscall(__NR_io_uring_setup, static_cast<unsigned>(depth * 2), &params));
+    if (fd < 0) {
+        return nullptr; // ENOSYS, or blocked by a seccomp policy
+    }
+
+    // Probe for the file opcodes, which arrived after io_uring itself
+    constexpr unsigned PROBE_OPS = 256;
+    std::vector<uint8_t> probeBuffer(sizeof(io_uring_probe) +
+                                     PROBE_OPS * sizeof(io_uring_probe_op));
+    auto* probe = reinterpret_cast<io_uring_probe*>(probeBuffer.data());
+    bool supported =
+        ::syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, PROBE_OPS) == 0;
+    for (uint8_t op : {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE}) {
+        supported = supported && op <= probe->last_op &&
+                    (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+    }
+    if (!supported) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    try {
+        return std::unique_ptr<Ring>(new Ring(fd, params, depth));
+    } catch (const std::runtime_error&) {
+        return nullptr; // The constructor released the ring
+    }
+}
+
+AsyncBlockIO::Ring::Ring(int fd, const io_uring_params& params, size_t depth)
+    : fd_(fd), depth_(depth) {
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+
+    sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     fd_, IORING_OFF_SQ_RING);
+    if (sqRing_ != MAP_FAILED) {
+        cqRing_ = singleMmap ? sqRing_
+                             : ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+    }
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    if (cqRing_ != MAP_FAILED) {
+        sqes_ = static_cast<io_uring_sqe*>(::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+                                                 MAP_SHARED | MAP_POPULATE, fd_,
+                                                 IORING_OFF_SQES));
+    }
+    if (sqes_ == MAP_FAILED) {
+        unmap();
+        throw std::runtime_error("Failed to map io_uring queues");
+    }
+
+    auto* sq = static_cast<uint8_t*>(sqRing_);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    auto* cq = static_cast<uint8_t*>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    try {
+        reaper_ = std::thread([this]() { reap(); });
+    } catch (...) {
+        unmap();
+        throw;
+    }
+}
+
+void AsyncBlockIO::Ring::unmap() {
+    if (sqes_ != MAP_FAILED) {
+        ::munmap(sqes_, sqesSize_);
+    }
+    if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_) {
+        ::munmap(cqRing_, cqRingSize_);
+    }
+    if (sqRing_ != MAP_FAILED) {
+        ::munmap(sqRing_, sqRingSize_);
+    }
+    ::close(fd_);
+}
+
+AsyncBlockIO::Ring::~Ring() {
+    waitIdle();
+    {
+        std::lock_guard lock(mutex_);
+        io_uring_sqe& sqe = nextSqe(nullptr, Open, IORING_OP_NOP);
+        sqe.user_data = WAKE;
+        flush();
+    }
+    reaper_.join();
+    unmap();
+}
+
+io_uring_sqe& AsyncBlockIO::Ring::nextSqe(Request* request, Step step, uint8_t opcode) {
+    // Every read holds at most two entries and the ring has room for two per
+    // slot, so the queue cannot be full here.
+    const unsigned tail = *sqTail_;
+    const unsigned index = tail & sqMask_;
+    io_uring_sqe& sqe = sqes_[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = opcode;
+    sqe.user_data = reinterpret_cast<uint64_t>(request) | step;
+    sqArray_[index] = index;
+    std::atomic_ref<unsigned>(*sqTail_).store(tail + 1, std::memory_order_release);
+    ++unsubmitted_;
+    return sqe;
+}
+
+void AsyncBlockIO::Ring::flush() {
+    while (unsubmitted_ > 0) {
+        const long submitted = ::syscall(__NR_io_uring_enter, fd_, unsubmitted_, 0, 0, nullptr, 0);
+        if (submitted < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // EAGAIN/EBUSY: the entries stay queued and the next flush or
+            // the reaper submits them
+            return;
+        }
+        unsubmitted_ -= static_cast<unsigned>(submitted);
+    }
+}
+
+void AsyncBlockIO::Ring::read(const Checksum& checksum, std::string path,
+                              std::optional<VirtualPadding> padding, Done done) {
+    auto* request = new Request(checksum, std::move(path), std::move(done), padding);
+    std::lock_guard lock(mutex_);
+    if (active_ < depth_) {
+        ++active_;
+        start(request);
+    } else {
+        backlog_.push_back(request);
+    }
+}
+
+void AsyncBlockIO::Ring::start(Request* request) {
+    request->pending = 2;
+    io_uring_sqe& open = nextSqe(request, Open, IORING_OP_OPENAT);
+    open.fd = AT_FDCWD;
+    open.addr = reinterpret_cast<uint64_t>(request->path.c_str());
+    open.open_flags = O_RDONLY | O_CLOEXEC;
+
+    io_uring_sqe& stat = nextSqe(request, Stat, IORING_OP_STATX);
+    stat.fd = AT_FDCWD;
+    stat.addr = reinterpret_cast<uint64_t>(request->path.c_str());
+    stat.len = STATX_SIZE;
+    stat.off = reinterpret_cast<uint64_t>(&request->status);
+    flush();
+}
+
+void AsyncBlockIO::Ring::submitRead(Request* request) {
+    std::lock_guard lock(mutex_);
+    io_uring_sqe& sqe = nextSqe(request, Read, IORING_OP_READ);
+    sqe.fd = request->fd;
+    sqe.addr = reinterpret_cast<uint64_t>(request->data.data() + request->offset);
+    sqe.len = static_cast<uint32_t>(request->readLength - request->offset);
+    sqe.off = request->offset;
+    flush();
+}
+
+void AsyncBlockIO::Ring::finish(Request* request) {
+    // Hand the result over before the close so it does not wait on it
+    Done done = std::move(request->done);
+    try {
+        done(std::move(request->data), request->failure);
+    } catch (...) {
+        // Exceptions from completions are discarded, as on the pool
+    }
+
+    if (request->fd < 0) {
+        release(request);
+        return;
+    }
+    std::lock_guard lock(mutex_);
+    io_uring_sqe& sqe = nextSqe(request, Close, IORING_OP_CLOSE);
+    sqe.fd = request->fd;
+    flush();
+}
+
+void AsyncBlockIO::Ring::release(Request* request) {
+    delete request;
+    std::lock_guard lock(mutex_);
+    if (!backlog_.empty()) {
+        Request* next = backlog_.front();
+        backlog_.pop_front();
+        start(next);
+        return;
+    }
+    if (--active_ == 0) {
+        idle_.notify_all();
+    }
+}
+
+void AsyncBlockIO::Ring::opened(Request* request) {
+    // OPENAT and STATX complete in either order
+    if (--request->pending > 0) {
+        return;
+    }
+    if (request->openError == ENOENT) {
+        request->failure = std::make_exception_ptr(
+            std::runtime_error("Block not found: " + request->checksum.toHex()));
+    } else if (request->openError != 0) {
+        request->failure = std::make_exception_ptr(
+            std::runtime_error("Failed to open block file: " + request->path));
+    } else if (request->statError != 0) {
+        request->failure = std::make_exception_ptr(
+            std::runtime_error("Failed to read block data: " + request->path));
+    }
+    if (request->failure) {
+        finish(request);
+        return;
+    }
+
+    // Virtually padded blocks: read only the stored prefix, synthesize the rest
+    const auto size = static_cast<size_t>(request->status.stx_size);
+    const auto& padding = request->padding;
+    request->data.assign(size, padding ? padding->fill : 0);
+    request->readLength = padding ? std::min<size_t>(padding->storedLength, size) : size;
+    if (request->readLength == 0) {
+        finish(request);
+        return;
+    }
+    submitRead(request);
+}
+
+void AsyncBlockIO::Ring::complete(uint64_t userData, int result) {
+    auto* request = reinterpret_cast<Request*>(userData & ~STEP_MASK);
+    switch (static_cast<Step>(userData & STEP_MASK)) {
+        case Open:
+            request->fd = result >= 0 ? result : -1;
+            request->openError = result < 0 ? -result : 0;
+            opened(request);
+            return;
+
+        case Stat:
+            request->statError = result < 0 ? -result : 0;
+            opened(request);
+            return;
+
+        case Read:
+            if (result <= 0) {
+                // An error, or the file shrank under the read
+                request->failure = std::make_exception_ptr(
+                    std::runtime_error("Failed to read block data: " + request->path));
+                request->data.clear();
+                finish(request);
+                return;
+            }
+            request->offset += static_cast<size_t>(result);
+            if (request->offset < request->readLength) {
+                submitRead(request);
+            } else {
+                finish(request);
+            }
+            return;
+
+        case Close:
+            release(request);
+            return;
+    }
+}
+
+void AsyncBlockIO::Ring::reap() {
+    std::atomic_ref<unsigned> head(*cqHead_);
+    std::atomic_ref<unsigned> tail(*cqTail_);
+    for (;;) {
+        unsigned current = head.load(std::memory_order_relaxed);
+        if (current == tail.load(std::memory_order_acquire)) {
+            bool queued;
+            {
+                std::lock_guard lock(mutex_);
+                flush();
+                queued = unsubmitted_ > 0;
+            }
+            if (queued) {
+                // The kernel refused the submission (EAGAIN/EBUSY). Waiting
+                // for a completion could block forever with nothing in
+                // flight, so back off and retry the submit instead.
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            ::syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            continue;
+        }
+
+        const io_uring_cqe& cqe = cqes_[current & cqMask_];
+        const uint64_t userData = cqe.user_data;
+        const int result = cqe.res;
+        head.store(current + 1, std::memory_order_release);
+        if (userData == WAKE) {
+            return;
+        }
+        complete(userData, result);
+    }
+}
+
+void AsyncBlockIO::Ring::waitIdle() {
+    std::unique_lock lock(mutex_);
+    idle_.wait(lock, [this]() { return active_ == 0; });
+}
+
+#else
+
+/**
+ * Without io_uring headers every read runs on the pool.
+ */
+class AsyncBlockIO::Ring {
+public:
+    static std::unique_ptr<Ring> create(size_t) { return nullptr; }
+
+    void read(const Checksum&, std::string, std::optional<VirtualPadding>,
+              std::function<void(std::vector<uint8_t>, std::exception_ptr)>) {}
+    void waitIdle() {}
+};
+
+#endif
+
+AsyncBlockIO::AsyncBlockIO(DiskBlockStore& store, size_t queueDepth, AsyncIOBackend backend)
+    : store_(store), pool_(checkedDepth(queueDepth)) {
+    // Packed segments are shared files read under the store's own locks
+    if (backend == AsyncIOBackend::IoUring && !store_.packed_) {
+        ring_ = Ring::create(queueDepth);
+    }
+}
+
+AsyncBlockIO::~AsyncBlockIO() {
+    drain();
+}
+
+template <typename F>
+auto AsyncBlockIO::enqueue(F&& task) {
+    inFlight_.fetch_add(1, std::memory_order_relaxed);
+    return pool_.submit([this, task = std::forward<F>(task)]() mutable {
+        struct Completion {
+            std::atomic<size_t>& counter;
+            ~Completion() { counter.fetch_sub(1, std::memory_order_relaxed); }
+        } completion{inFlight_};
+        return task();
+    });
+}
+
+void AsyncBlockIO::read(const Checksum& checksum,
+                        std::function<void(std::vector<uint8_t>, std::exception_ptr)> done) {
+    if (!ring_) {
+        enqueue([this, checksum, done = std::move(done)]() {
+            std::vector<uint8_t> data;
+            std::exception_ptr error;
+            try {
+                data = store_.get(checksum);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            done(std::move(data), error);
+        });
+        return;
+    }
+
+    // Absent blocks fail without a submission, as in DiskBlockStore::get()
+    if (!store_.mayContain(checksum)) {
+        done({}, std::make_exception_ptr(
+                     std::runtime_error("Block not found: " + checksum.toHex())));
+        return;
+    }
+
+    // The ring holds the read's slot until after the completion returns,
+    // so drain() still waits for it once the count drops
+    inFlight_.fetch_add(1, std::memory_order_relaxed);
+    ring_->read(checksum, store_.blockPath(checksum).string(),
+                store_.metadataIndex_->padding(checksum),
+                [this, done = std::move(done)](std::vector<uint8_t> data,
+                                               std::exception_ptr error) {
+                    inFlight_.fetch_sub(1, std::memory_order_relaxed);
+                    done(std::move(data), error);
+                });
+}
+
+std::future<std::vector<uint8_t>> AsyncBlockIO::get(const Checksum& checksum) {
+    if (!ring_) {
+        return enqueue([this, checksum]() { return store_.get(checksum); });
+    }
+
+    auto promise = std::make_shared<std::promise<std::vector<uint8_t>>>();
+    auto future = promise->get_future();
+    read(checksum, [promise](std::vector<uint8_t> data, std::exception_ptr error) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(std::move(data));
+        }
+    });
+    return future;
+}
+
+std::future<Checksum> AsyncBlockIO::put(std::vector<uint8_t> data) {
+    return enqueue([this, data = std::move(data)]() { return store_.put(data); });
+}
+
+std::future<Checksum> AsyncBlockIO::put(std::vector<uint8_t> data,
+                                        const BlockMetadata& metadata) {
+    return enqueue([this, data = std::move(data), metadata]() {
+        return store_.put(data, metadata);
+    });
+}
+
+std::future<bool> AsyncBlockIO::has(const Checksum& checksum) {
+    return enqueue([this, checksum]() { return store_.has(checksum); });
+}
+
+std::vector<std::future<std::vector<uint8_t>>> AsyncBlockIO::getBatch(
+    const std::vector<Checksum>& checksums) {
+    std::vector<std::future<std::vector<uint8_t>>> futures;
+    futures.reserve(checksums.size());
+    for (const auto& checksum : checksums) {
+        futures.push_back(get(checksum));
+    }
+    return futures;
+}
+
+void AsyncBlockIO::getBatch(const std::vector<Checksum>& checksums, GetCallback callback) {
+    auto shared = std::make_shared<GetCallback>(std::move(callback));
+    for (size_t i = 0; i < checksums.size(); ++i) {
+        read(checksums[i], [shared, i](std::vector<uint8_t> data, std::exception_ptr error) {
+            (*shared)(i, std::move(data), error);
+        });
+    }
+}
+
+std::vector<std::future<Checksum>> AsyncBlockIO::putBatch(
+    std::vector<std::vector<uint8_t>> blocks) {
+    std::vector<std::future<Checksum>> futures;
+    futures.reserve(blocks.size());
+    for (auto& block : blocks) {
+        futures.push_back(put(std::move(block)));
+    }
+    return futures;
+}
+
+void AsyncBlockIO::putBatch(std::vector<std::vector<uint8_t>> blocks, PutCallback callback) {
+    auto shared = std::make_shared<PutCallback>(std::move(callback));
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        enqueue([this, shared, i, data = std::move(blocks[i])]() {
+            Checksum checksum;
+            std::exception_ptr error;
+            try {
+                checksum = store_.put(data);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            (*shared)(i, checksum, error);
+        });
+    }
+}
+
+std::vector<std::future<bool>> AsyncBlockIO::hasBatch(const std::vector<Checksum>& checksums) {
+    std::vector<std::future<bool>> futures;
+    futures.reserve(checksums.size());
+    for (const auto& checksum : checksums) {
+        futures.push_back(has(checksum));
+    }
+    return futures;
+}
+
+void AsyncBlockIO::drain() {
+    // Completions may submit more work to either backend
+    do {
+        pool_.waitIdle();
+        if (ring_) {
+            ring_->waitIdle();
+        }
+    } while (inFlight() > 0);
+}
+
+} // namespace brightchain
@@ -0,0 +1,272 @@
+#include "brightchain/block_cache.hpp"
+#include <cstring>
+#include <stdexcept>
+
+namespace brightchain {
+
+namespace {
+
+// 2Q tuning from Johnson & Shasha: A1in holds ~25% of the budget and the
+// A1out ghost list remembers ~50% of the budget worth of evicted keys.
+constexpr uint64_t A1IN_DIVISOR = 4;
+constexpr uint64_t A1OUT_DIVISOR = 2;
+
+} // namespace
+
+BlockCache::BlockCache(size_t shardCount) {
+    if (shardCount == 0) {
+        throw std::invalid_argument("Shard count must be positive");
+    }
+
+    shards_.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+size_t BlockCache::classIndex(BlockSize blockSize) {
+    for (size_t i = 0; i < VALID_BLOCK_SIZES.size(); ++i) {
+        if (VALID_BLOCK_SIZES[i] == blockSize) {
+            return i;
+        }
+    }
+    throw std::invalid_argument("Invalid block size for cache");
+}
+
+BlockCache::Shard& BlockCache::shardFor(const Checksum& checksum) const {
+    // std::hash<Checksum> uses the leading bytes; stripe on different ones so
+    // the per-shard hash tables stay evenly loaded.
+    uint64_t value;
+    std::memcpy(&value, checksum.hash().data() + 8, sizeof(value));
+    return *shards_[value % shards_.size()];
+}
+
+void BlockCache::setBudget(BlockSize blockSize, uint64_t bytes) {
+    size_t cls = classIndex(blockSize);
+    budgets_[cls].store(bytes, std::memory_order_relaxed);
+
+    for (auto& shard : shards_) {
+        std::lock_guard lock(shard->mutex);
+        shard->classes[cls].budget = bytes / shards_.size();
+        evict(*shard, cls);
+    }
+}
+
+uint64_t BlockCache::budget(BlockSize blockSize) const {
+    return budgets_[classIndex(blockSize)].load(std::memory_order_relaxed);
+}
+
+BlockCache::Entry BlockCache::get(const Checksum& checksum, BlockSize blockSize) {
+    size_t cls = classIndex(blockSize);
+    Shard& shard = shardFor(checksum);
+    std::lock_guard lock(shard.mutex);
+
+    auto it = shard.index.find(checksum);
+    if (it == shard.index.end()) {
+        ++shard.classes[cls].stats.misses;
+        return nullptr;
+    }
+
+    auto [nodeClass, node] = it->second;
+    SizeClass& sc = shard.classes[nodeClass];
+    ++sc.stats.hits;
+    if (node->queue == Queue::Am) {
+        sc.am.splice(sc.am.begin(), sc.am, node);
+    }
+    // A1in hits are deliberately not promoted: correlated re-reads shortly
+    // after the first access should not make a block look hot.
+    return node->data;
+}
+
+void BlockCache::put(const Checksum& checksum, BlockSize blockSize, Entry data,
+                     std::optional<uint64_t> generation) {
+    if (!data) {
+        throw std::invalid_argument("Cannot cache null block data");
+    }
+
+    size_t cls = classIndex(blockSize);
+    Shard& shard = shardFor(checksum);
+    std::lock_guard lock(shard.mutex);
+
+    SizeClass& sc = shard.classes[cls];
+    const uint64_t size = data->size();
+    if (sc.budget == 0 || size > sc.budget || shard.index.count(checksum) > 0 ||
+        (generation && *generation != shard.generation)) {
+        return;
+    }
+
+    auto ghost = sc.ghosts.find(checksum);
+    if (ghost != sc.ghosts.end()) {
+        sc.ghostBytes -= ghost->second->second;
+        sc.a1out.erase(ghost->second);
+        sc.ghosts.erase(ghost);
+
+        sc.am.push_front(Node{checksum, std::move(data), Queue::Am});
+        sc.amBytes += size;
+        shard.index[checksum] = {cls, sc.am.begin()};
+    } else {
+        sc.a1in.push_front(Node{checksum, std::move(data), Queue::A1in});
+        sc.a1inBytes += size;
+        shard.index[checksum] = {cls, sc.a1in.begin()};
+    }
+    ++sc.stats.insertions;
+
+    evict(shard, cls);
+}
+
+void BlockCache::evict(Shard& shard, size_t cls) {
+    SizeClass& sc = shard.classes[cls];
+
+    while (sc.a1inBytes + sc.amBytes > sc.budget) {
+        if (!sc.a1in.empty() && (sc.a1inBytes > sc.budget / A1IN_DIVISOR || sc.am.empty())) {
+            Node& victim = sc.a1in.back();
+            const uint64_t size = victim.data->size();
+
+            sc.a1out.emplace_front(victim.checksum, size);
+            sc.ghosts[victim.checksum] = sc.a1out.begin();
+            sc.ghostBytes += size;
+
+            shard.index.erase(victim.checksum);
+            sc.a1inBytes -= size;
+            sc.a1in.pop_back();
+        } else {
+            Node& victim = sc.am.back();
+            shard.index.erase(victim.checksum);
+            sc.amBytes -= victim.data->size();
+            sc.am.pop_back();
+        }
+        ++sc.stats.evictions;
+    }
+
+    while (sc.ghostBytes > sc.budget / A1OUT_DIVISOR && !sc.a1out.empty()) {
+        auto& oldest = sc.a1out.back();
+        sc.ghostBytes -= oldest.second;
+        sc.ghosts.erase(oldest.first);
+        sc.a1out.pop_back();
+    }
+}
+
+void BlockCache::removeNode(Shard& shard, size_t cls, std::list<Node>::iterator node) {
+    SizeClass& sc = shard.classes[cls];
+    const uint64_t size = node->data->size();
+    if (node->queue == Queue::Am) {
+        sc.amBytes -= size;
+        sc.am.erase(node);
+    } else {
+        sc.a1inBytes -= size;
+        sc.a1in.erase(node);
+    }
+}
+
+void BlockCache::erase(const Checksum& checksum) {
+    Shard& shard = shardFor(checksum);
+    std::lock_guard lock(shard.mutex);
+    ++shard.generation;
+
+    auto it = shard.index.find(checksum);
+    if (it != shard.index.end()) {
+        removeNode(shard, it->second.first, it->second.second);
+        shard.index.erase(it);
+    }
+
+    for (auto& sc : shard.classes) {
+        auto ghost = sc.ghosts.find(checksum);
+        if (ghost != sc.ghosts.end()) {
+            sc.ghostBytes -= ghost->second->second;
+            sc.a1out.erase(ghost->second);
+            sc.ghosts.erase(ghost);
+        }
+    }
+}
+
+uint64_t BlockCache::generation(const Checksum& checksum) const {
+    Shard& shard = shardFor(checksum);
+    std::lock_guard lock(shard.mutex);
+    return shard.generation;
+}
+
+void BlockCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard lock(shard->mutex);
+        shard->index.clear();
+        for (auto& sc : shard->classes) {
+            sc.a1in.clear();
+            sc.am.clear();
+            sc.a1out.clear();
+            sc.ghosts.clear();
+            sc.a1inBytes = 0;
+            sc.amBytes = 0;
+            sc.ghostBytes = 0;
+        }
+    }
+}
+
+BlockCacheStats BlockCache::stats(BlockSize blockSize) const {
+    size_t cls = classIndex(blockSize);
+    BlockCacheStats total;
+    for (const auto& shard : shards_) {
+        std::lock_guard lock(shard->mutex);
+        const SizeClass& sc = shard->classes[cls];
+        total.hits += sc.stats.hits;
+        total.misses += sc.stats.misses;
+        total.insertions += sc.stats.insertions;
+        total.evictions += sc.stats.evictions;
+        total.bytes += sc.a1inBytes + sc.amBytes;
+        total.entries += sc.a1in.size() + sc.am.size();
+    }
+    return total;
+}
+
+BlockCacheStats BlockCache::stats() const {
+    BlockCacheStats total;
+    for (BlockSize blockSize : VALID_BLOCK_SIZES) {
+        BlockCacheStats cls = stats(blockSize);
+        total.hits += cls.hits;
+        total.misses += cls.misses;
+        total.insertions += cls.insertions;
+        total.evictions += cls.evictions;
+        total.bytes += cls.bytes;
+        total.entries += cls.entries;
+    }
+    return total;
+}
+
+CachingBlockStore::CachingBlockStore(DiskBlockStore& store, BlockCache& cache)
+    : store_(store), cache_(cache) {}
+
+Checksum CachingBlockStore::put(const std::vector<uint8_t>& data) {
+    return store_.put(data);
+}
+
+Checksum CachingBlockStore::put(const std::vector<uint8_t>& data, const BlockMetadata& metadata) {
+    return store_.put(data, metadata);
+}
+
+BlockCache::Entry CachingBlockStore::getShared(const Checksum& checksum) const {
+    if (auto cached = cache_.get(checksum, store_.blockSize())) {
+        return cached;
+    }
+
+    const uint64_t generation = cache_.generation(checksum);
+    auto data = std::make_shared<const std::vector<uint8_t>>(store_.get(checksum));
+    cache_.put(checksum, store_.blockSize(), data, generation);
+    return data;
+}
+
+std::vector<uint8_t> CachingBlockStore::get(const Checksum& checksum) const {
+    return *getShared(checksum);
+}
+
+bool CachingBlockStore::has(const Checksum& checksum) const {
+    return store_.has(checksum);
+}
+
+bool CachingBlockStore::remove(const Checksum& checksum) {
+    // Erasing after the store means a miss that reloaded the block in
+    // between is dropped here, and any later one sees the erase
+    const bool removed = store_.remove(checksum);
+    cache_.erase(checksum);
+    return removed;
+}
+
+} // namespace brightchain
@@ -0,0 +1,255 @@
+#include "brightchain/block_scrubber.hpp"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace brightchain {
+
+namespace {
+
+constexpr const char* CURSOR_MAGIC = "BSCR1";
+
+// ioprio_set(2) constants; glibc provides no wrapper
+constexpr int IOPRIO_WHO_PROCESS = 1;
+constexpr int IOPRIO_CLASS_IDLE = 3;
+constexpr int IOPRIO_CLASS_SHIFT = 13;
+
+/**
+ * Lower the priority of the calling thread. Failures are ignored: scrubbing
+ * at normal priority is still correct, only less polite.
+ */
+void lowerThreadPriority(int niceLevel, bool idleIo) {
+#ifdef __linux__
+    const auto tid = static_cast<id_t>(::syscall(SYS_gettid));
+    (void)::setpriority(PRIO_PROCESS, tid, niceLevel);
+    if (idleIo) {
+        (void)::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0,
+                        IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+    }
+#else
+    (void)niceLevel;
+    (void)idleIo;
+#endif
+}
+
+} // namespace
+
+BlockScrubber::BlockScrubber(DiskBlockStore& store, ScrubberOptions options)
+    : store_(store), options_(std::move(options)),
+      cursorPath_(std::filesystem::path(store.storePath()) /
+                  blockSizeToString(store.blockSize()) / "scrub.cursor") {
+    loadCursor();
+}
+
+BlockScrubber::~BlockScrubber() {
+    stop();
+    try {
+        std::lock_guard lock(scrubMutex_);
+        saveCursor();
+    } catch (...) {
+        // Losing the cursor only repeats part of a pass
+    }
+}
+
+void BlockScrubber::start() {
+    std::lock_guard lock(threadMutex_);
+    if (worker_.joinable()) {
+        return;
+    }
+    worker_ = std::thread([this]() { run(); });
+}
+
+void BlockScrubber::stop() {
+    std::thread worker;
+    {
+        std::lock_guard lock(threadMutex_);
+        stopRequested_ = true;
+        worker = std::move(worker_);
+    }
+    wake_.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    stopRequested_ = false;
+}
+
+bool BlockScrubber::running() const {
+    std::lock_guard lock(threadMutex_);
+    return worker_.joinable();
+}
+
+void BlockScrubber::run() {
+    lowerThreadPriority(options_.niceLevel, options_.idleIoPriority);
+
+    while (!stopRequested_) {
+        const uint64_t before = passes_.load();
+        bool failed = false;
+        try {
+            scrub();
+        } catch (...) {
+            failed = true; // Store errors: retry after the pass interval
+        }
+        if ((failed || passes_.load() != before) &&
+            !sleepUntil(std::chrono::steady_clock::now() + options_.passInterval)) {
+            break;
+        }
+    }
+}
+
+bool BlockScrubber::sleepUntil(std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock lock(threadMutex_);
+    return !wake_.wait_until(lock, deadline, [this]() { return stopRequested_.load(); });
+}
+
+size_t BlockScrubber::scrub(size_t maxBlocks) {
+    std::lock_guard lock(scrubMutex_);
+    if (!passLoaded_) {
+        beginPass();
+    }
+
+    windowStart_ = std::chrono::steady_clock::now();
+    windowBytes_ = 0;
+
+    size_t verified = 0;
+    while (verified < maxBlocks && next_ < pass_.size() && !stopRequested_) {
+        verify(pass_[next_]);
+        cursor_ = pass_[next_];
+        ++next_;
+        ++verified;
+        ++passBlocks_;
+        if (options_.cursorInterval > 0 && next_ % options_.cursorInterval == 0) {
+            saveCursor();
+        }
+    }
+
+    if (next_ == pass_.size()) {
+        ++passes_;
+        cursor_.reset();
+        pass_.clear();
+        next_ = 0;
+        passLoaded_ = false;
+    }
+    saveCursor();
+    return verified;
+}
+
+void BlockScrubber::beginPass() {
+    // Sorting makes the order independent of directory iteration, so the
+    // cursor identifies a position that survives restarts and new blocks.
+    pass_.clear();
+    store_.forEachChecksum([this](const Checksum& checksum) {
+        if (!cursor_ || *cursor_ < checksum) {
+            pass_.push_back(checksum);
+        }
+    });
+    std::sort(pass_.begin(), pass_.end());
+    next_ = 0;
+    passLoaded_ = true;
+    passBlocks_ = 0;
+    passTotal_ = pass_.size();
+}
+
+void BlockScrubber::verify(const Checksum& checksum) {
+    bool intact = false;
+    uint64_t bytes = 0;
+    try {
+        MappedBlock block = store_.getMapped(checksum, AccessHint::Sequential);
+        bytes = block.size();
+        intact = Checksum::fromData(block.data(), block.size()) == checksum;
+    } catch (const std::system_error& error) {
+        if (!store_.has(checksum)) {
+            return; // Removed since the pass was listed
+        }
+        // Only a media error condemns the block. Running out of descriptors
+        // or memory says nothing about its content; the next pass retries it.
+        if (error.code() != std::errc::io_error) {
+            ++skippedBlocks_;
+            return;
+        }
+    } catch (const std::runtime_error&) {
+        if (!store_.has(checksum)) {
+            return; // Removed since the pass was listed
+        }
+    }
+
+    ++blocksVerified_;
+    bytesVerified_ += bytes;
+    if (!intact && store_.quarantine(checksum)) {
+        ++corruptBlocks_;
+        if (options_.onCorrupt) {
+            options_.onCorrupt(checksum);
+        }
+    }
+    throttle(bytes);
+}
+
+void BlockScrubber::throttle(uint64_t bytes) {
+    if (options_.bytesPerSecond == 0) {
+        return;
+    }
+
+    windowBytes_ += bytes;
+    const auto due = windowStart_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                        std::chrono::duration<double>(
+                                            static_cast<double>(windowBytes_) /
+                                            static_cast<double>(options_.bytesPerSecond)));
+    if (due > std::chrono::steady_clock::now()) {
+        sleepUntil(due);
+    }
+}
+
+void BlockScrubber::loadCursor() {
+    std::ifstream file(cursorPath_);
+    if (!file) {
+        return;
+    }
+
+    std::string magic;
+    uint64_t passes = 0;
+    std::string hex;
+    if (!(file >> magic >> passes >> hex) || magic != CURSOR_MAGIC) {
+        throw std::runtime_error("Corrupt scrub cursor: " + cursorPath_.string());
+    }
+    passes_ = passes;
+    if (hex != "-") {
+        try {
+            cursor_ = Checksum::fromHex(hex);
+        } catch (const std::exception&) {
+            throw std::runtime_error("Corrupt scrub cursor: " + cursorPath_.string());
+        }
+    }
+}
+
+void BlockScrubber::saveCursor() const {
+    auto tmpPath = cursorPath_;
+    tmpPath += ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        file << CURSOR_MAGIC << '\n'
+             << passes_.load() << '\n'
+             << (cursor_ ? cursor_->toHex() : std::string("-")) << '\n';
+        if (!file) {
+            throw std::runtime_error("Failed to write scrub cursor: " + tmpPath.string());
+        }
+    }
+    std::filesystem::rename(tmpPath, cursorPath_);
+}
+
+ScrubStats BlockScrubber::stats() const {
+    ScrubStats stats;
+    stats.passesCompleted = passes_.load();
+    stats.blocksVerified = blocksVerified_.load();
+    stats.bytesVerified = bytesVerified_.load();
+    stats.corruptBlocks = corruptBlocks_.load();
+    stats.skippedBlocks = skippedBlocks_.load();
+    stats.passBlocks = passBlocks_.load();
+    stats.passTotal = passTotal_.load();
+    return stats;
+}
+
+} // namespace brightchain
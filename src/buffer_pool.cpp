@@ -0,0 +1,399 @@
+#include "brightchain/buffer_pool.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+namespace brightchain {
+
+namespace {
+
+constexpr size_t CLASS_COUNT = VALID_BLOCK_SIZES.size();
+
+size_t classIndex(BlockSize blockSize) {
+    for (size_t i = 0; i < CLASS_COUNT; ++i) {
+        if (VALID_BLOCK_SIZES[i] == blockSize) {
+            return i;
+        }
+    }
+    throw std::invalid_argument("Invalid block size for buffer pool");
+}
+
+bool isMapped(BlockSize blockSize) {
+    return blockSizeToLength(blockSize) >= blockSizeToLength(BlockSize::Large);
+}
+
+/**
+ * Buffers a thread keeps per size class before handing them to the depot.
+ * Mapped classes go straight to the depot: one idle buffer per thread would
+ * hold up to 256 MiB outside the depot's retention bound.
+ */
+size_t threadLimit(BlockSize blockSize) {
+    switch (blockSize) {
+        case BlockSize::Message:
+        case BlockSize::Tiny:
+        case BlockSize::Small:
+            return 16;
+        case BlockSize::Medium:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+size_t defaultRetention(BlockSize blockSize) {
+    switch (blockSize) {
+        case BlockSize::Message:
+        case BlockSize::Tiny:
+        case BlockSize::Small:
+            return 1024;
+        case BlockSize::Medium:
+            return 16;
+        case BlockSize::Large:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+uint8_t* allocateBuffer(BlockSize blockSize) {
+    const size_t length = blockSizeToLength(blockSize);
+    if (isMapped(blockSize)) {
+#ifdef MAP_HUGETLB
+        // Explicit huge pages only exist if the administrator reserved them
+        void* huge = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (huge != MAP_FAILED) {
+            return static_cast<uint8_t*>(huge);
+        }
+#endif
+        void* data = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                            -1, 0);
+        if (data == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+#ifdef MADV_HUGEPAGE
+        (void)::madvise(data, length, MADV_HUGEPAGE);
+#endif
+        return static_cast<uint8_t*>(data);
+    }
+
+    static const size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    void* data = std::aligned_alloc(std::min(length, pageSize), length);
+    if (!data) {
+        throw std::bad_alloc();
+    }
+    return static_cast<uint8_t*>(data);
+}
+
+void freeBuffer(uint8_t* data, BlockSize blockSize) {
+    if (isMapped(blockSize)) {
+        ::munmap(data, blockSizeToLength(blockSize));
+    } else {
+        std::free(data);
+    }
+}
+
+} // namespace
+
+struct BufferDepot {
+    struct SizeClass {
+        std::mutex mutex;
+        std::vector<uint8_t*> idle;
+        size_t retention = 0;
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> reuses{0};
+    };
+
+    BufferDepot() {
+        for (size_t i = 0; i < CLASS_COUNT; ++i) {
+            classes[i].retention = defaultRetention(VALID_BLOCK_SIZES[i]);
+        }
+    }
+
+    ~BufferDepot() {
+        for (size_t i = 0; i < CLASS_COUNT; ++i) {
+            for (uint8_t* data : classes[i].idle) {
+                freeBuffer(data, VALID_BLOCK_SIZES[i]);
+            }
+        }
+    }
+
+    uint8_t* take(size_t cls) {
+        std::lock_guard lock(classes[cls].mutex);
+        auto& idle = classes[cls].idle;
+        if (idle.empty()) {
+            return nullptr;
+        }
+        uint8_t* data = idle.back();
+        idle.pop_back();
+        return data;
+    }
+
+    void give(size_t cls, uint8_t* data) {
+        {
+            std::lock_guard lock(classes[cls].mutex);
+            auto& idle = classes[cls].idle;
+            if (idle.size() < classes[cls].retention) {
+                idle.push_back(data);
+                return;
+            }
+        }
+        freeBuffer(data, VALID_BLOCK_SIZES[cls]);
+    }
+
+    std::array<SizeClass, CLASS_COUNT> classes;
+
+    // Set by ~BufferPool; buffers released afterwards are freed, not kept
+    std::atomic<bool> retired{false};
+};
+
+namespace {
+
+/**
+ * Per-thread free lists, one set per pool the thread has released buffers to.
+ * Entries only observe their depot, so a destroyed pool is not kept alive by
+ * every thread that once used it; its entry is pruned, and its buffers
+ * freed, the next time the thread touches any pool.
+ */
+struct ThreadCache {
+    struct Entry {
+        std::weak_ptr<BufferDepot> depot;
+        const BufferDepot* key;
+        std::array<std::vector<uint8_t*>, CLASS_COUNT> buffers;
+    };
+
+    ~ThreadCache();
+
+    /**
+     * Free the buffers of entries whose pool is gone and drop the entries.
+     */
+    void prune() {
+        for (auto it = entries.begin(); it != entries.end();) {
+            auto depot = it->depot.lock();
+            if (depot && !depot->retired.load(std::memory_order_acquire)) {
+                ++it;
+                continue;
+            }
+            for (size_t i = 0; i < CLASS_COUNT; ++i) {
+                for (uint8_t* data : it->buffers[i]) {
+                    freeBuffer(data, VALID_BLOCK_SIZES[i]);
+                }
+            }
+            it = entries.erase(it);
+        }
+    }
+
+    /**
+     * Entry of a live depot the caller holds a reference to. Every entry
+     * left after prune() observes a live depot, so addresses are unique.
+     */
+    Entry* find(const BufferDepot* depot) {
+        prune();
+        for (auto& entry : entries) {
+            if (entry.key == depot) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    Entry& entryFor(const std::shared_ptr<BufferDepot>& depot) {
+        if (Entry* entry = find(depot.get())) {
+            return *entry;
+        }
+        Entry& entry = entries.emplace_back();
+        entry.depot = depot;
+        entry.key = depot.get();
+        for (size_t i = 0; i < CLASS_COUNT; ++i) {
+            entry.buffers[i].reserve(threadLimit(VALID_BLOCK_SIZES[i]));
+        }
+        return entry;
+    }
+
+    std::vector<Entry> entries;
+};
+
+// Buffers released by other thread_local destructors after the cache is
+// gone must bypass it.
+thread_local bool threadCacheAlive = true;
+thread_local ThreadCache threadCache;
+
+ThreadCache::~ThreadCache() {
+    threadCacheAlive = false;
+    for (auto& entry : entries) {
+        auto depot = entry.depot.lock();
+        for (size_t i = 0; i < CLASS_COUNT; ++i) {
+            for (uint8_t* data : entry.buffers[i]) {
+                if (depot) {
+                    depot->give(i, data);
+                } else {
+                    freeBuffer(data, VALID_BLOCK_SIZES[i]);
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+BlockBuffer::~BlockBuffer() {
+    reset();
+}
+
+BlockBuffer::BlockBuffer(BlockBuffer&& other) noexcept
+    : depot_(std::move(other.depot_)), data_(other.data_), size_(other.size_),
+      blockSize_(other.blockSize_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+BlockBuffer& BlockBuffer::operator=(BlockBuffer&& other) noexcept {
+    if (this != &other) {
+        reset();
+        depot_ = std::move(other.depot_);
+        data_ = other.data_;
+        size_ = other.size_;
+        blockSize_ = other.blockSize_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+void BlockBuffer::resize(size_t size) {
+    if (size > capacity()) {
+        throw std::length_error("Buffer size exceeds block size");
+    }
+    size_ = size;
+}
+
+void BlockBuffer::reset() {
+    if (!data_) {
+        return;
+    }
+
+    const size_t cls = classIndex(blockSize_);
+    if (threadCacheAlive && !depot_->retired.load(std::memory_order_acquire)) {
+        auto& cached = threadCache.entryFor(depot_).buffers[cls];
+        if (cached.size() < threadLimit(blockSize_)) {
+            cached.push_back(data_);
+        } else {
+            depot_->give(cls, data_);
+        }
+    } else {
+        depot_->give(cls, data_);
+    }
+
+    depot_.reset();
+    data_ = nullptr;
+    size_ = 0;
+}
+
+BufferPool::BufferPool() : depot_(std::make_shared<BufferDepot>()) {}
+
+BufferPool::~BufferPool() {
+    // Buffers still in use go back to a depot that keeps none of them
+    depot_->retired.store(true, std::memory_order_release);
+    for (auto& sizeClass : depot_->classes) {
+        std::lock_guard lock(sizeClass.mutex);
+        sizeClass.retention = 0;
+    }
+    trim();
+}
+
+BlockBuffer BufferPool::acquire(BlockSize blockSize) {
+    const size_t cls = classIndex(blockSize);
+    auto& sizeClass = depot_->classes[cls];
+
+    if (threadCacheAlive) {
+        if (auto* entry = threadCache.find(depot_.get())) {
+            auto& cached = entry->buffers[cls];
+            if (!cached.empty()) {
+                uint8_t* data = cached.back();
+                cached.pop_back();
+                sizeClass.reuses.fetch_add(1, std::memory_order_relaxed);
+                return BlockBuffer(depot_, data, blockSize);
+            }
+        }
+    }
+
+    if (uint8_t* data = depot_->take(cls)) {
+        sizeClass.reuses.fetch_add(1, std::memory_order_relaxed);
+        return BlockBuffer(depot_, data, blockSize);
+    }
+
+    uint8_t* data = allocateBuffer(blockSize);
+    sizeClass.allocations.fetch_add(1, std::memory_order_relaxed);
+    return BlockBuffer(depot_, data, blockSize);
+}
+
+void BufferPool::setRetention(BlockSize blockSize, size_t buffers) {
+    const size_t cls = classIndex(blockSize);
+    auto& sizeClass = depot_->classes[cls];
+
+    std::vector<uint8_t*> excess;
+    {
+        std::lock_guard lock(sizeClass.mutex);
+        sizeClass.retention = buffers;
+        while (sizeClass.idle.size() > buffers) {
+            excess.push_back(sizeClass.idle.back());
+            sizeClass.idle.pop_back();
+        }
+    }
+    for (uint8_t* data : excess) {
+        freeBuffer(data, blockSize);
+    }
+}
+
+size_t BufferPool::retention(BlockSize blockSize) const {
+    auto& sizeClass = depot_->classes[classIndex(blockSize)];
+    std::lock_guard lock(sizeClass.mutex);
+    return sizeClass.retention;
+}
+
+void BufferPool::trim() {
+    if (threadCacheAlive) {
+        if (auto* entry = threadCache.find(depot_.get())) {
+            for (size_t i = 0; i < CLASS_COUNT; ++i) {
+                for (uint8_t* data : entry->buffers[i]) {
+                    freeBuffer(data, VALID_BLOCK_SIZES[i]);
+                }
+                entry->buffers[i].clear();
+            }
+        }
+    }
+
+    for (size_t i = 0; i < CLASS_COUNT; ++i) {
+        auto& sizeClass = depot_->classes[i];
+        std::vector<uint8_t*> idle;
+        {
+            std::lock_guard lock(sizeClass.mutex);
+            idle.swap(sizeClass.idle);
+        }
+        for (uint8_t* data : idle) {
+            freeBuffer(data, VALID_BLOCK_SIZES[i]);
+        }
+    }
+}
+
+BufferPoolStats BufferPool::stats(BlockSize blockSize) const {
+    auto& sizeClass = depot_->classes[classIndex(blockSize)];
+    BufferPoolStats stats;
+    stats.allocations = sizeClass.allocations.load(std::memory_order_relaxed);
+    stats.reuses = sizeClass.reuses.load(std::memory_order_relaxed);
+    std::lock_guard lock(sizeClass.mutex);
+    stats.retained = sizeClass.idle.size();
+    return stats;
+}
+
+BufferPool& BufferPool::shared() {
+    static BufferPool pool;
+    return pool;
+}
+
+} // namespace brightchain
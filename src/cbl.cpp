@@ -144,16 +144,18 @@ std::vector<uint8_t> ConstituentBlockListBlock::layerHeaderData() const {
 }
 
 std::vector<uint8_t> ConstituentBlockListBlock::layerPayload() const {
-    if (data_.size() <= CBLHeader::SIZE) {
+    const size_t dataStart = layerOverheadSize();
+    if (data_.size() <= dataStart) {
         return {};
     }
-    return std::vector<uint8_t>(data_.begin() + CBLHeader::SIZE, data_.end());
+    return std::vector<uint8_t>(data_.begin() + dataStart, data_.end());
 }
 
 std::vector<Checksum> ConstituentBlockListBlock::addresses() const {
     std::vector<Checksum> result;
     const size_t addressSize = Checksum::HASH_SIZE;
-    const size_t dataStart = CBLHeader::SIZE;
+    // ExtendedCBL file metadata sits inside the header, ahead of the addresses
+    const size_t dataStart = layerOverheadSize();
     
     for (uint32_t i = 0; i < header_.addressCount; ++i) {
         size_t offset = dataStart + (i * addressSize);
@@ -0,0 +1,122 @@
+#include "brightchain/cbl_view.hpp"
+#include <stdexcept>
+
+namespace brightchain {
+
+namespace {
+
+template <typename T>
+T readBigEndian(const uint8_t* data) {
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        value = static_cast<T>((value << 8) | data[i]);
+    }
+    return value;
+}
+
+// The ExtendedCBL file metadata sits where the base header has its signature
+constexpr size_t METADATA_OFFSET = CBLHeader::SIZE - 64;
+
+} // namespace
+
+Checksum ChecksumView::toChecksum() const {
+    Checksum::HashArray hash;
+    std::memcpy(hash.data(), bytes_, Checksum::HASH_SIZE);
+    return Checksum::fromHash(hash);
+}
+
+std::vector<Checksum> ChecksumRange::toVector() const {
+    std::vector<Checksum> result;
+    result.reserve(count_);
+    for (ChecksumView view : *this) {
+        result.push_back(view.toChecksum());
+    }
+    return result;
+}
+
+CBLView::CBLView(std::span<const uint8_t> data) : data_(data) {
+    if (data_.size() < CBLHeader::SIZE) {
+        throw std::invalid_argument("Insufficient data for CBL header");
+    }
+    if (data_[0] != BlockHeaderConstants::MAGIC_PREFIX) {
+        throw std::invalid_argument("Invalid magic prefix");
+    }
+
+    if (type() == StructuredBlockType::ExtendedCBL) {
+        size_t offset = METADATA_OFFSET;
+        const size_t fileNameLength = readBigEndian<uint16_t>(&data_[offset]);
+        offset += 2;
+        if (offset + fileNameLength + 1 > data_.size()) {
+            throw std::invalid_argument("Invalid file name length");
+        }
+        fileName_ = std::string_view(reinterpret_cast<const char*>(&data_[offset]),
+                                     fileNameLength);
+        offset += fileNameLength;
+
+        const size_t mimeTypeLength = data_[offset++];
+        if (offset + mimeTypeLength > data_.size()) {
+            throw std::invalid_argument("Invalid MIME type length");
+        }
+        mimeType_ = std::string_view(reinterpret_cast<const char*>(&data_[offset]),
+                                     mimeTypeLength);
+        overhead_ = CBLHeader::SIZE + 3 + fileNameLength + mimeTypeLength;
+    } else if (type() != StructuredBlockType::CBL) {
+        throw std::invalid_argument("Not a CBL block");
+    }
+
+    const uint32_t count = readBigEndian<uint32_t>(&data_[28]);
+    if (overhead_ > data_.size() ||
+        count > (data_.size() - overhead_) / Checksum::HASH_SIZE) {
+        throw std::invalid_argument("CBL address list exceeds the block");
+    }
+    addresses_ = ChecksumRange(data_.data() + overhead_, count);
+}
+
+uint64_t CBLView::dateCreated() const {
+    return readBigEndian<uint64_t>(&data_[20]);
+}
+
+uint64_t CBLView::originalDataLength() const {
+    return readBigEndian<uint64_t>(&data_[33]);
+}
+
+std::span<const uint8_t, 64> CBLView::signature() const {
+    // Follows the ExtendedCBL metadata, so it always ends the layer header
+    return std::span<const uint8_t, 64>(data_.data() + overhead_ - 64, 64);
+}
+
+SuperCBLView::SuperCBLView(std::span<const uint8_t> data) : data_(data) {
+    if (data_.size() < SuperCBLHeader::SIZE) {
+        throw std::invalid_argument("Insufficient data for SuperCBL header");
+    }
+    if (data_[0] != BlockHeaderConstants::MAGIC_PREFIX) {
+        throw std::invalid_argument("Invalid magic prefix");
+    }
+    if (data_[1] != static_cast<uint8_t>(StructuredBlockType::SuperCBL)) {
+        throw std::invalid_argument("Not a SuperCBL block");
+    }
+
+    const uint32_t count = readBigEndian<uint32_t>(&data_[28]);
+    if (count > (data_.size() - SuperCBLHeader::SIZE) / Checksum::HASH_SIZE) {
+        throw std::invalid_argument("SuperCBL child list exceeds the block");
+    }
+    children_ = ChecksumRange(data_.data() + SuperCBLHeader::SIZE, count);
+}
+
+uint64_t SuperCBLView::dateCreated() const {
+    return readBigEndian<uint64_t>(&data_[20]);
+}
+
+uint32_t SuperCBLView::totalBlockCount() const {
+    return readBigEndian<uint32_t>(&data_[32]);
+}
+
+uint16_t SuperCBLView::depth() const {
+    return readBigEndian<uint16_t>(&data_[36]);
+}
+
+uint64_t SuperCBLView::originalDataLength() const {
+    return readBigEndian<uint64_t>(&data_[38]);
+}
+
+} // namespace brightchain
@@ -1,4 +1,5 @@
 #include "brightchain/checksum.hpp"
+#include "brightchain/sha3_batch.hpp"
 #include <openssl/evp.h>
 #include <stdexcept>
 #include <sstream>
@@ -12,33 +13,72 @@ Checksum::Checksum() : hash_{} {}
 Checksum::Checksum(const HashArray& hash) : hash_(hash) {}
 
 Checksum Checksum::fromData(const std::vector<uint8_t>& data) {
-    HashArray hash;
-    
-    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    return fromData(data.data(), data.size());
+}
+
+namespace {
+
+/**
+ * SHA3-512 implementation, fetched once; EVP_sha3_512() would be looked up
+ * again on every EVP_DigestInit_ex.
+ */
+const EVP_MD* sha3Digest() {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    static EVP_MD* md = EVP_MD_fetch(nullptr, "SHA3-512", nullptr);
+    if (md) {
+        return md;
+    }
+#endif
+    return EVP_sha3_512();
+}
+
+/**
+ * Per-thread digest context reused by one-shot hashing.
+ */
+EVP_MD_CTX* threadContext() {
+    thread_local std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(
+        EVP_MD_CTX_new(), &EVP_MD_CTX_free);
     if (!ctx) {
         throw std::runtime_error("Failed to create EVP_MD_CTX");
     }
+    return ctx.get();
+}
 
-    if (EVP_DigestInit_ex(ctx, EVP_sha3_512(), nullptr) != 1) {
-        EVP_MD_CTX_free(ctx);
+} // namespace
+
+Checksum Checksum::fromData(const uint8_t* data, size_t length) {
+    HashArray hash;
+    EVP_MD_CTX* ctx = threadContext();
+
+    if (EVP_DigestInit_ex(ctx, sha3Digest(), nullptr) != 1) {
         throw std::runtime_error("Failed to initialize SHA3-512");
     }
 
-    if (EVP_DigestUpdate(ctx, data.data(), data.size()) != 1) {
-        EVP_MD_CTX_free(ctx);
+    if (EVP_DigestUpdate(ctx, data, length) != 1) {
         throw std::runtime_error("Failed to update SHA3-512");
     }
 
     unsigned int hashLen = 0;
     if (EVP_DigestFinal_ex(ctx, hash.data(), &hashLen) != 1 || hashLen != HASH_SIZE) {
-        EVP_MD_CTX_free(ctx);
         throw std::runtime_error("Failed to finalize SHA3-512");
     }
 
-    EVP_MD_CTX_free(ctx);
     return Checksum(hash);
 }
 
+std::vector<Checksum> Checksum::fromBlocks(std::span<const uint8_t* const> blocks,
+                                           size_t length) {
+    std::vector<HashArray> hashes(blocks.size());
+    sha3_512Batch(blocks, length, hashes.data());
+
+    std::vector<Checksum> result;
+    result.reserve(hashes.size());
+    for (const auto& hash : hashes) {
+        result.push_back(Checksum(hash));
+    }
+    return result;
+}
+
 Checksum Checksum::fromHex(const std::string& hex) {
     if (hex.length() != HASH_SIZE * 2) {
         throw std::invalid_argument("Invalid hex string length");
@@ -78,6 +118,43 @@ bool Checksum::operator<(const Checksum& other) const {
     return hash_ < other.hash_;
 }
 
+struct ChecksumStream::Context {
+    EVP_MD_CTX* ctx = nullptr;
+    ~Context() { EVP_MD_CTX_free(ctx); }
+};
+
+ChecksumStream::ChecksumStream() : context_(std::make_unique<Context>()) {
+    context_->ctx = EVP_MD_CTX_new();
+    if (!context_->ctx) {
+        throw std::runtime_error("Failed to create EVP_MD_CTX");
+    }
+    reset();
+}
+
+ChecksumStream::~ChecksumStream() = default;
+
+void ChecksumStream::reset() {
+    if (EVP_DigestInit_ex(context_->ctx, sha3Digest(), nullptr) != 1) {
+        throw std::runtime_error("Failed to initialize SHA3-512");
+    }
+}
+
+void ChecksumStream::update(const uint8_t* data, size_t length) {
+    if (EVP_DigestUpdate(context_->ctx, data, length) != 1) {
+        throw std::runtime_error("Failed to update SHA3-512");
+    }
+}
+
+Checksum ChecksumStream::finish() {
+    Checksum::HashArray hash;
+    unsigned int hashLen = 0;
+    if (EVP_DigestFinal_ex(context_->ctx, hash.data(), &hashLen) != 1 ||
+        hashLen != Checksum::HASH_SIZE) {
+        throw std::runtime_error("Failed to finalize SHA3-512");
+    }
+    return Checksum::fromHash(hash);
+}
+
 } // namespace brightchain
 
 namespace std {
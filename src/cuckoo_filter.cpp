@@ -0,0 +1,184 @@
+#include "brightchain/cuckoo_filter.hpp"
+#include "file_io.hpp"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace brightchain {
+
+namespace {
+
+constexpr uint32_t FILTER_MAGIC = 0x46434342; // "BCCF" little-endian
+constexpr uint32_t FILTER_VERSION = 1;
+constexpr size_t MIN_BUCKETS = 1024;
+constexpr double TARGET_LOAD = 0.85;
+
+} // namespace
+
+CuckooFilter::CuckooFilter(size_t expectedItems) {
+    size_t wanted = static_cast<size_t>(expectedItems / (SLOTS_PER_BUCKET * TARGET_LOAD)) + 1;
+    size_t buckets = MIN_BUCKETS;
+    while (buckets < wanted) {
+        buckets <<= 1;
+    }
+    buckets_.assign(buckets, Bucket{});
+}
+
+uint16_t CuckooFilter::fingerprint(const Checksum& checksum) {
+    const auto& hash = checksum.hash();
+    uint16_t fp = static_cast<uint16_t>(hash[8] | (hash[9] << 8));
+    return fp == 0 ? 1 : fp; // 0 marks an empty slot
+}
+
+size_t CuckooFilter::primaryIndex(const Checksum& checksum) const {
+    return static_cast<size_t>(readLE(checksum.hash().data(), 8)) & (buckets_.size() - 1);
+}
+
+size_t CuckooFilter::alternateIndex(size_t index, uint16_t fp) const {
+    // Partial-key cuckoo hashing: the alternate bucket depends only on the
+    // current bucket and the fingerprint, so entries can be relocated
+    // without the original key.
+    uint64_t mixed = static_cast<uint64_t>(fp) * 0x9E3779B97F4A7C15ULL;
+    return (index ^ static_cast<size_t>(mixed >> 32)) & (buckets_.size() - 1);
+}
+
+bool CuckooFilter::insertInto(size_t index, uint16_t fp) {
+    for (auto& slot : buckets_[index]) {
+        if (slot == 0) {
+            slot = fp;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CuckooFilter::insert(const Checksum& checksum) {
+    uint16_t fp = fingerprint(checksum);
+    size_t i1 = primaryIndex(checksum);
+    size_t i2 = alternateIndex(i1, fp);
+    if (insertInto(i1, fp) || insertInto(i2, fp)) {
+        ++count_;
+        return true;
+    }
+
+    // Relocate existing fingerprints, remembering each swap so a failed
+    // insertion can be rolled back and the filter stays exact for its members.
+    std::vector<std::pair<size_t, size_t>> path;
+    size_t index = (checksum.hash()[10] & 1) ? i1 : i2;
+    uint16_t carried = fp;
+    for (size_t kick = 0; kick < MAX_KICKS; ++kick) {
+        victimSeed_ = victimSeed_ * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t slot = static_cast<size_t>(victimSeed_ >> 62);
+        std::swap(carried, buckets_[index][slot]);
+        path.emplace_back(index, slot);
+
+        index = alternateIndex(index, carried);
+        if (insertInto(index, carried)) {
+            ++count_;
+            return true;
+        }
+    }
+
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        std::swap(carried, buckets_[it->first][it->second]);
+    }
+    return false;
+}
+
+bool CuckooFilter::contains(const Checksum& checksum) const {
+    uint16_t fp = fingerprint(checksum);
+    size_t i1 = primaryIndex(checksum);
+    size_t i2 = alternateIndex(i1, fp);
+    for (uint16_t slot : buckets_[i1]) {
+        if (slot == fp) {
+            return true;
+        }
+    }
+    for (uint16_t slot : buckets_[i2]) {
+        if (slot == fp) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CuckooFilter::remove(const Checksum& checksum) {
+    uint16_t fp = fingerprint(checksum);
+    size_t i1 = primaryIndex(checksum);
+    for (size_t index : {i1, alternateIndex(i1, fp)}) {
+        for (auto& slot : buckets_[index]) {
+            if (slot == fp) {
+                slot = 0;
+                --count_;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void CuckooFilter::save(const std::filesystem::path& path) const {
+    auto tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Failed to create filter file: " + tmp.string());
+        }
+
+        uint8_t header[24];
+        writeLE(header, (static_cast<uint64_t>(FILTER_VERSION) << 32) | FILTER_MAGIC, 8);
+        writeLE(header + 8, buckets_.size(), 8);
+        writeLE(header + 16, count_, 8);
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        for (const auto& bucket : buckets_) {
+            for (uint16_t slot : bucket) {
+                file.put(static_cast<char>(slot & 0xFF));
+                file.put(static_cast<char>(slot >> 8));
+            }
+        }
+        if (!file) {
+            throw std::runtime_error("Failed to write filter file: " + tmp.string());
+        }
+    }
+    std::filesystem::rename(tmp, path);
+}
+
+std::optional<CuckooFilter> CuckooFilter::load(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return std::nullopt;
+    }
+
+    uint8_t header[24];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) {
+        return std::nullopt;
+    }
+
+    uint64_t tag = readLE(header, 8);
+    uint64_t bucketCount = readLE(header + 8, 8);
+    uint64_t count = readLE(header + 16, 8);
+    if (tag != ((static_cast<uint64_t>(FILTER_VERSION) << 32) | FILTER_MAGIC) ||
+        bucketCount < MIN_BUCKETS || (bucketCount & (bucketCount - 1)) != 0 ||
+        count > bucketCount * SLOTS_PER_BUCKET) {
+        return std::nullopt;
+    }
+
+    std::vector<uint8_t> raw(bucketCount * SLOTS_PER_BUCKET * 2);
+    if (!file.read(reinterpret_cast<char*>(raw.data()), raw.size())) {
+        return std::nullopt;
+    }
+
+    CuckooFilter filter;
+    filter.buckets_.assign(bucketCount, Bucket{});
+    for (size_t b = 0; b < bucketCount; ++b) {
+        for (size_t s = 0; s < SLOTS_PER_BUCKET; ++s) {
+            size_t offset = (b * SLOTS_PER_BUCKET + s) * 2;
+            filter.buckets_[b][s] = static_cast<uint16_t>(raw[offset] | (raw[offset + 1] << 8));
+        }
+    }
+    filter.count_ = count;
+    return filter;
+}
+
+} // namespace brightchain
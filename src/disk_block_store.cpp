@@ -1,13 +1,72 @@
 #include "brightchain/disk_block_store.hpp"
+#include "file_io.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
+#include <mutex>
 #include <stdexcept>
+#include <system_error>
 #include <nlohmann/json.hpp>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace brightchain {
 
-DiskBlockStore::DiskBlockStore(const std::string& storePath, BlockSize blockSize)
-    : storePath_(storePath), blockSize_(blockSize) {
-    
+namespace {
+
+bool isChecksumFileName(const std::string& name) {
+    return name.size() == Checksum::HASH_SIZE * 2 &&
+           std::all_of(name.begin(), name.end(),
+                       [](unsigned char c) { return std::isxdigit(c) && !std::isupper(c); });
+}
+
+/**
+ * Detect padding that can be stored virtually.
+ * @return The fill byte if every byte from `offset` on has the same value
+ */
+std::optional<uint8_t> uniformTail(std::span<const uint8_t> data, size_t offset) {
+    if (offset >= data.size()) {
+        return std::nullopt;
+    }
+    const uint8_t* tail = data.data() + offset;
+    const size_t length = data.size() - offset;
+    // Each byte equals its successor iff the whole range is one value
+    if (length > 1 && std::memcmp(tail, tail + 1, length - 1) != 0) {
+        return std::nullopt;
+    }
+    return tail[0];
+}
+
+/**
+ * Rename a written temporary block file into place, removing it if the
+ * rename fails.
+ */
+void renameIntoPlace(const std::filesystem::path& tempPath, const std::filesystem::path& path) {
+    try {
+        std::filesystem::rename(tempPath, path);
+    } catch (...) {
+        std::error_code ignored;
+        std::filesystem::remove(tempPath, ignored);
+        throw;
+    }
+}
+
+} // namespace
+
+DiskBlockStore::DiskBlockStore(const std::string& storePath, BlockSize blockSize,
+                               StorageLayout layout)
+    : DiskBlockStore(storePath, blockSize, DiskBlockStoreOptions{layout}) {}
+
+DiskBlockStore::DiskBlockStore(const std::string& storePath, BlockSize blockSize,
+                               const DiskBlockStoreOptions& options)
+    : storePath_(storePath), blockSize_(blockSize), layout_(options.layout),
+      durability_(options.durability), virtualPadding_(options.virtualPadding) {
+    const StorageLayout layout = options.layout;
+
     if (storePath.empty()) {
         throw std::invalid_argument("Store path is required");
     }
@@ -16,8 +75,152 @@ DiskBlockStore::DiskBlockStore(const std::string& storePath, BlockSize blockSize
         throw std::invalid_argument("Block size is required");
     }
 
+    if (layout == StorageLayout::Packed &&
+        blockSizeToLength(blockSize) > blockSizeToLength(BlockSize::Small)) {
+        throw std::invalid_argument("Packed layout only supports Message, Tiny and Small blocks");
+    }
+
     // Ensure store path exists
     std::filesystem::create_directories(storePath_);
+
+    if (layout == StorageLayout::Packed) {
+        packed_ = std::make_unique<PackedSegmentStore>(
+            std::filesystem::path(storePath_) / blockSizeToString(blockSize_) / "segments",
+            blockSize_);
+    } else {
+        std::filesystem::create_directories(sizeDir());
+        metadataIndex_ = std::make_unique<MetadataIndex>(sizeDir() / "metadata.idx");
+    }
+
+    if (options.referenceCounting) {
+        std::filesystem::create_directories(sizeDir());
+        refCounts_ = std::make_unique<RefCountTable>(sizeDir() / "refcounts.idx");
+    }
+
+    if (durability_ == Durability::GroupCommit) {
+        std::function<void()> batchHook = [this]() {
+            if (packed_) {
+                packed_->sync();
+            } else {
+                metadataIndex_->sync();
+            }
+            if (refCounts_) {
+                refCounts_->sync();
+            }
+        };
+        committer_ = std::make_unique<GroupCommitter>(
+            options.groupCommitInterval, options.groupCommitBytes, std::move(batchHook));
+    }
+
+    if (options.existenceFilter && !packed_) {
+        // The saved filter is only trusted after a clean shutdown: it is
+        // deleted once loaded, so a crash forces a rescan on the next open.
+        if (auto saved = CuckooFilter::load(filterPath())) {
+            filter_ = std::make_unique<CuckooFilter>(std::move(*saved));
+            std::filesystem::remove(filterPath());
+        } else {
+            rebuildExistenceFilter();
+        }
+    } else {
+        // Blocks written by this open would be missing from a saved filter,
+        // so the next filter-enabled open must rescan instead
+        std::filesystem::remove(filterPath());
+    }
+
+    if (filter_ || refCounts_) {
+        writeStripes_ = std::make_unique<std::array<WriteStripe, WRITE_STRIPES>>();
+    }
+}
+
+DiskBlockStore::~DiskBlockStore() {
+    // Overflowed blocks are missing from the filter, so leave it to a rescan
+    if (filter_ && filterOverflow_.empty()) {
+        try {
+            filter_->save(filterPath());
+        } catch (...) {
+            // A missing filter only costs a rescan on the next open
+        }
+    }
+}
+
+std::filesystem::path DiskBlockStore::sizeDir() const {
+    return std::filesystem::path(storePath_) / blockSizeToString(blockSize_);
+}
+
+std::filesystem::path DiskBlockStore::filterPath() const {
+    return sizeDir() / ".existence-filter";
+}
+
+void DiskBlockStore::rebuildExistenceFilter() {
+    std::unique_lock writers(filterWriters_);
+    if (filter_) {
+        // Another put may have rebuilt the filter while this one waited
+        std::shared_lock lock(filterMutex_);
+        if (filterOverflow_.empty()) {
+            return;
+        }
+    }
+
+    // Size from what is actually stored, with room to double before the
+    // next rebuild. Readers keep using the old filter during the scan.
+    size_t count = 0;
+    forEachChecksum([&count](const Checksum&) { ++count; });
+
+    auto filter = std::make_unique<CuckooFilter>(count * 2);
+    forEachChecksum([&filter](const Checksum& checksum) {
+        if (!filter->insert(checksum)) {
+            throw std::runtime_error("Existence filter capacity exceeded during rebuild");
+        }
+    });
+
+    std::unique_lock lock(filterMutex_);
+    filter_ = std::move(filter);
+    filterOverflow_.clear();
+}
+
+void DiskBlockStore::dropFromFilter(const Checksum& checksum) {
+    std::unique_lock lock(filterMutex_);
+    if (filterOverflow_.erase(checksum) == 0) {
+        filter_->remove(checksum);
+    }
+}
+
+bool DiskBlockStore::mayContain(const Checksum& checksum) const {
+    if (!filter_) {
+        return true;
+    }
+    std::shared_lock lock(filterMutex_);
+    return filter_->contains(checksum) ||
+           (!filterOverflow_.empty() && filterOverflow_.contains(checksum));
+}
+
+void DiskBlockStore::forEachChecksum(const std::function<void(const Checksum&)>& callback) const {
+    if (packed_) {
+        packed_->forEach(callback);
+        return;
+    }
+
+    const auto root = sizeDir();
+    if (!std::filesystem::exists(root)) {
+        return;
+    }
+
+    for (const auto& first : std::filesystem::directory_iterator(root)) {
+        if (!first.is_directory()) {
+            continue;
+        }
+        for (const auto& second : std::filesystem::directory_iterator(first.path())) {
+            if (!second.is_directory()) {
+                continue;
+            }
+            for (const auto& entry : std::filesystem::directory_iterator(second.path())) {
+                std::string name = entry.path().filename().string();
+                if (entry.is_regular_file() && isChecksumFileName(name)) {
+                    callback(Checksum::fromHex(name));
+                }
+            }
+        }
+    }
 }
 
 std::filesystem::path DiskBlockStore::blockDir(const Checksum& checksum) const {
@@ -44,31 +247,221 @@ void DiskBlockStore::ensureBlockPath(const Checksum& checksum) const {
 }
 
 Checksum DiskBlockStore::put(const std::vector<uint8_t>& data) {
-    Checksum checksum = Checksum::fromData(data);
     BlockMetadata metadata(blockSize_, data.size());
     return put(data, metadata);
 }
 
 Checksum DiskBlockStore::put(const std::vector<uint8_t>& data, const BlockMetadata& metadata) {
-    Checksum checksum = Checksum::fromData(data);
+    return put(Checksum::fromData(data), data, metadata);
+}
+
+Checksum DiskBlockStore::put(const BlockBuffer& data, const BlockMetadata& metadata) {
+    return put(Checksum::fromData(data.data(), data.size()), data.span(), metadata);
+}
+
+Checksum DiskBlockStore::put(const Checksum& checksum, std::span<const uint8_t> data,
+                             const BlockMetadata& metadata) {
+    if (!refCounts_) {
+        std::unique_lock<std::mutex> lock;
+        if (writeStripes_) {
+            lock = std::unique_lock(stripeFor(checksum).mutex);
+        }
+        storeBlock(checksum, data, metadata);
+        return checksum;
+    }
+
+    WriteStripe& stripe = stripeFor(checksum);
+    std::unique_lock lock(stripe.mutex);
+    // Another put of this block may have failed or been removed since, so
+    // re-check once it finishes instead of trusting it
+    waitForInflight(stripe, lock, checksum);
+    if (has(checksum)) {
+        bumpRefCount(checksum, 1);
+        lock.unlock();
+        commitRefCount();
+        return checksum;
+    }
+
+    std::promise<void> written;
+    stripe.inflight.emplace(checksum, written.get_future().share());
+    lock.unlock();
+
+    auto finish = [&]() {
+        lock.lock();
+        stripe.inflight.erase(checksum);
+        written.set_value();
+    };
+    try {
+        storeBlock(checksum, data, metadata);
+    } catch (...) {
+        finish();
+        throw;
+    }
+    finish();
+    return checksum;
+}
+
+DiskBlockStore::WriteStripe& DiskBlockStore::stripeFor(const Checksum& checksum) const {
+    return (*writeStripes_)[std::hash<Checksum>{}(checksum) % WRITE_STRIPES];
+}
+
+void DiskBlockStore::waitForInflight(WriteStripe& stripe, std::unique_lock<std::mutex>& lock,
+                                     const Checksum& checksum) const {
+    for (auto pending = stripe.inflight.find(checksum); pending != stripe.inflight.end();
+         pending = stripe.inflight.find(checksum)) {
+        auto done = pending->second;
+        lock.unlock();
+        done.wait();
+        lock.lock();
+    }
+}
+
+void DiskBlockStore::bumpRefCount(const Checksum& checksum, uint32_t count) {
+    const uint32_t current = refCounts_->get(checksum).value_or(1);
+    if (current > UINT32_MAX - count) {
+        throw std::overflow_error("Reference count overflow: " + checksum.toHex());
+    }
+    refCounts_->set(checksum, current + count);
+}
+
+void DiskBlockStore::commitRefCount() {
+    if (durability_ == Durability::PerWrite) {
+        refCounts_->sync();
+    } else if (durability_ == Durability::GroupCommit) {
+        committer_->await(RefCountTable::RECORD_SIZE);
+    }
+}
+
+void DiskBlockStore::storeBlock(const Checksum& checksum, std::span<const uint8_t> data,
+                                const BlockMetadata& metadata) {
+    if (packed_) {
+        packed_->put(checksum, data, metadata);
+        if (durability_ == Durability::PerWrite) {
+            packed_->sync();
+        } else if (durability_ == Durability::GroupCommit) {
+            committer_->await(PackedSegmentStore::ENTRY_HEADER_SIZE + data.size());
+        }
+        return;
+    }
+
+    std::optional<VirtualPadding> padding;
+    if (virtualPadding_ && data.size() <= UINT32_MAX) {
+        if (auto fill = uniformTail(data, metadata.length_without_padding)) {
+            padding = VirtualPadding{static_cast<uint32_t>(metadata.length_without_padding),
+                                     *fill};
+        }
+    }
+
+    bool filterFull = false;
+    {
+        std::shared_lock<std::shared_mutex> writers;
+        if (filter_) {
+            writers = std::shared_lock(filterWriters_);
+        }
+
+        // A re-put of a stored block must not add another copy of its
+        // fingerprint; a handful of duplicates would fill both of its buckets.
+        // The caller keeps removes of this checksum out until the insert below.
+        const bool existed = filter_ && has(checksum);
+
+        // Index the metadata first so the block's commit also makes it durable;
+        // a record without a block file is ignored by has() and get().
+        metadataIndex_->put(checksum, metadata, padding);
+        writeBlockFile(checksum, data, padding ? padding->storedLength : data.size());
+
+        if (filter_ && !existed) {
+            std::unique_lock lock(filterMutex_);
+            if (!filter_->insert(checksum)) {
+                filterOverflow_.insert(checksum);
+                filterFull = true;
+            }
+        }
+    }
+
+    // The rebuild scans the directory, so it runs outside the filter lock
+    if (filterFull) {
+        rebuildExistenceFilter();
+    }
+}
+
+void DiskBlockStore::writeBlockFile(const Checksum& checksum, std::span<const uint8_t> data,
+                                    size_t storedLength) {
     ensureBlockPath(checksum);
 
     std::filesystem::path path = blockPath(checksum);
-    std::ofstream file(path, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("Failed to create block file: " + path.string());
+    std::filesystem::path tempPath =
+        path.string() + ".tmp" + std::to_string(tempSequence_.fetch_add(1));
+
+    int fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed to create block file: " + tempPath.string());
     }
 
-    file.write(reinterpret_cast<const char*>(data.data()), data.size());
-    if (!file) {
-        throw std::runtime_error("Failed to write block data: " + path.string());
+    const uint8_t* cursor = data.data();
+    size_t remaining = storedLength;
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, cursor, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            const int error = errno;
+            ::close(fd);
+            std::filesystem::remove(tempPath);
+            throw std::system_error(error, std::generic_category(),
+                                    "Failed to write block data: " + path.string());
+        }
+        cursor += written;
+        remaining -= static_cast<size_t>(written);
     }
 
-    putMetadata(checksum, metadata);
-    return checksum;
+    // Extending the file leaves the elided padding as a hole
+    if (storedLength < data.size() && ::ftruncate(fd, static_cast<off_t>(data.size())) != 0) {
+        const int error = errno;
+        ::close(fd);
+        std::filesystem::remove(tempPath);
+        throw std::system_error(error, std::generic_category(),
+                                "Failed to extend block file: " + path.string());
+    }
+
+    switch (durability_) {
+        case Durability::None:
+            ::close(fd);
+            renameIntoPlace(tempPath, path);
+            break;
+        case Durability::PerWrite:
+            if (syncData(fd) != 0) {
+                ::close(fd);
+                std::filesystem::remove(tempPath);
+                throw std::runtime_error("Failed to sync block file: " + path.string());
+            }
+            ::close(fd);
+            try {
+                metadataIndex_->sync();
+            } catch (...) {
+                std::error_code ignored;
+                std::filesystem::remove(tempPath, ignored);
+                throw;
+            }
+            renameIntoPlace(tempPath, path);
+            syncDirectory(path.parent_path());
+            break;
+        case Durability::GroupCommit:
+            committer_->commit(fd, tempPath, path, data.size());
+            break;
+    }
 }
 
 std::vector<uint8_t> DiskBlockStore::get(const Checksum& checksum) const {
+    if (packed_) {
+        return packed_->get(checksum);
+    }
+
+    if (!mayContain(checksum)) {
+        throw std::runtime_error("Block not found: " + checksum.toHex());
+    }
+
     std::filesystem::path path = blockPath(checksum);
     
     if (!std::filesystem::exists(path)) {
@@ -83,27 +476,249 @@ std::vector<uint8_t> DiskBlockStore::get(const Checksum& checksum) const {
     std::streamsize size = file.tellg();
     file.seekg(0, std::ios::beg);
 
-    std::vector<uint8_t> data(size);
-    if (!file.read(reinterpret_cast<char*>(data.data()), size)) {
+    // Virtually padded blocks: read only the stored prefix, synthesize the rest
+    auto padding = metadataIndex_->padding(checksum);
+    std::streamsize stored =
+        padding ? std::min<std::streamsize>(padding->storedLength, size) : size;
+
+    std::vector<uint8_t> data(size, padding ? padding->fill : 0);
+    if (!file.read(reinterpret_cast<char*>(data.data()), stored)) {
         throw std::runtime_error("Failed to read block data: " + path.string());
     }
 
     return data;
 }
 
+BlockBuffer DiskBlockStore::getBuffer(const Checksum& checksum, BufferPool& pool) const {
+    BlockBuffer buffer = pool.acquire(blockSize_);
+    if (packed_) {
+        buffer.resize(packed_->read(checksum, buffer.span()));
+        return buffer;
+    }
+
+    if (!mayContain(checksum)) {
+        throw std::runtime_error("Block not found: " + checksum.toHex());
+    }
+
+    std::filesystem::path path = blockPath(checksum);
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            throw std::runtime_error("Block not found: " + checksum.toHex());
+        }
+        throw std::runtime_error("Failed to open block file: " + path.string());
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) > buffer.capacity()) {
+        ::close(fd);
+        throw std::runtime_error("Invalid block file: " + path.string());
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+
+    // Virtually padded blocks: read only the stored prefix, synthesize the rest
+    auto padding = metadataIndex_->padding(checksum);
+    const size_t stored = padding ? std::min<size_t>(padding->storedLength, size) : size;
+
+    size_t done = 0;
+    while (done < stored) {
+        ssize_t got = ::pread(fd, buffer.data() + done, stored - done, static_cast<off_t>(done));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to read block data: " + path.string());
+        }
+        done += static_cast<size_t>(got);
+    }
+    ::close(fd);
+
+    if (stored < size) {
+        std::memset(buffer.data() + stored, padding->fill, size - stored);
+    }
+    buffer.resize(size);
+    return buffer;
+}
+
+MappedBlock DiskBlockStore::getMapped(const Checksum& checksum, AccessHint hint) const {
+    if (packed_) {
+        return packed_->getMapped(checksum, hint);
+    }
+
+    if (!mayContain(checksum)) {
+        throw std::runtime_error("Block not found: " + checksum.toHex());
+    }
+
+    std::filesystem::path path = blockPath(checksum);
+    if (!std::filesystem::exists(path)) {
+        throw std::runtime_error("Block not found: " + checksum.toHex());
+    }
+
+    // A zero fill is already what the sparse hole reads back as
+    auto padding = metadataIndex_->padding(checksum);
+    if (padding && padding->fill != 0) {
+        size_t size = static_cast<size_t>(std::filesystem::file_size(path));
+        return MappedBlock::mapPadded(path, std::min<size_t>(padding->storedLength, size), size,
+                                      padding->fill, hint);
+    }
+    return MappedBlock::map(path, hint);
+}
+
 bool DiskBlockStore::has(const Checksum& checksum) const {
-    return std::filesystem::exists(blockPath(checksum));
+    if (packed_) {
+        return packed_->has(checksum);
+    }
+    return mayContain(checksum) && std::filesystem::exists(blockPath(checksum));
 }
 
 bool DiskBlockStore::remove(const Checksum& checksum) {
+    if (!refCounts_) {
+        std::unique_lock<std::mutex> lock;
+        if (writeStripes_) {
+            lock = std::unique_lock(stripeFor(checksum).mutex);
+        }
+        return removeBlock(checksum);
+    }
+
+    WriteStripe& stripe = stripeFor(checksum);
+    std::unique_lock lock(stripe.mutex);
+    waitForInflight(stripe, lock, checksum);
+
+    // Only blocks with more than one reference have a record
+    if (auto count = refCounts_->get(checksum)) {
+        if (*count > 2) {
+            refCounts_->set(checksum, *count - 1);
+        } else {
+            refCounts_->remove(checksum);
+        }
+        lock.unlock();
+        commitRefCount();
+        return false;
+    }
+    return removeBlock(checksum);
+}
+
+bool DiskBlockStore::addRef(const Checksum& checksum, uint32_t count) {
+    if (!refCounts_) {
+        return has(checksum);
+    }
+
+    WriteStripe& stripe = stripeFor(checksum);
+    std::unique_lock lock(stripe.mutex);
+    waitForInflight(stripe, lock, checksum);
+
+    if (!has(checksum)) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+    bumpRefCount(checksum, count);
+    lock.unlock();
+    commitRefCount();
+    return true;
+}
+
+bool DiskBlockStore::forceRemove(const Checksum& checksum) {
+    if (!refCounts_) {
+        std::unique_lock<std::mutex> lock;
+        if (writeStripes_) {
+            lock = std::unique_lock(stripeFor(checksum).mutex);
+        }
+        return removeBlock(checksum);
+    }
+
+    WriteStripe& stripe = stripeFor(checksum);
+    std::unique_lock lock(stripe.mutex);
+    waitForInflight(stripe, lock, checksum);
+
+    refCounts_->remove(checksum);
+    return removeBlock(checksum);
+}
+
+bool DiskBlockStore::quarantine(const Checksum& checksum) {
+    std::unique_lock<std::mutex> lock;
+    if (writeStripes_) {
+        WriteStripe& stripe = stripeFor(checksum);
+        lock = std::unique_lock(stripe.mutex);
+        waitForInflight(stripe, lock, checksum);
+    }
+
+    const auto target = quarantineDir() / checksum.toHex();
+    if (packed_) {
+        if (!packed_->has(checksum)) {
+            return false;
+        }
+        std::filesystem::create_directories(quarantineDir());
+        auto data = packed_->get(checksum);
+        std::ofstream file(target, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(data.data()),
+                   static_cast<std::streamsize>(data.size()));
+        if (!file) {
+            throw std::runtime_error("Failed to write quarantined block: " + target.string());
+        }
+        file.close();
+        packed_->remove(checksum);
+    } else {
+        std::filesystem::path path = blockPath(checksum);
+        if (!std::filesystem::exists(path)) {
+            return false;
+        }
+        std::filesystem::create_directories(quarantineDir());
+        std::shared_lock<std::shared_mutex> writers;
+        if (filter_) {
+            writers = std::shared_lock(filterWriters_);
+        }
+        std::filesystem::rename(path, target);
+
+        if (filter_) {
+            dropFromFilter(checksum);
+        }
+        metadataIndex_->remove(checksum);
+        std::filesystem::remove(metadataPath(checksum));
+    }
+    // The reference record stays: the block's owners still hold their
+    // references, and a put() of the repaired block resumes them
+    return true;
+}
+
+std::filesystem::path DiskBlockStore::quarantineDir() const {
+    return sizeDir() / "quarantine";
+}
+
+uint32_t DiskBlockStore::refCount(const Checksum& checksum) const {
+    if (!has(checksum)) {
+        return 0;
+    }
+    if (!refCounts_) {
+        return 1;
+    }
+    return refCounts_->get(checksum).value_or(1);
+}
+
+bool DiskBlockStore::removeBlock(const Checksum& checksum) {
+    if (packed_) {
+        return packed_->remove(checksum);
+    }
+
     std::filesystem::path path = blockPath(checksum);
     std::filesystem::path metaPath = metadataPath(checksum);
 
     bool removed = false;
     if (std::filesystem::exists(path)) {
+        std::shared_lock<std::shared_mutex> writers;
+        if (filter_) {
+            writers = std::shared_lock(filterWriters_);
+        }
         std::filesystem::remove(path);
         removed = true;
+
+        if (filter_) {
+            dropFromFilter(checksum);
+        }
     }
+    metadataIndex_->remove(checksum);
     if (std::filesystem::exists(metaPath)) {
         std::filesystem::remove(metaPath);
     }
@@ -112,21 +727,34 @@ bool DiskBlockStore::remove(const Checksum& checksum) {
 }
 
 void DiskBlockStore::putMetadata(const Checksum& checksum, const BlockMetadata& metadata) {
-    ensureBlockPath(checksum);
-    std::filesystem::path path = metadataPath(checksum);
-    
-    std::ofstream file(path);
-    if (!file) {
-        throw std::runtime_error("Failed to create metadata file: " + path.string());
+    if (packed_) {
+        packed_->putMetadata(checksum, metadata);
+        if (durability_ == Durability::PerWrite) {
+            packed_->sync();
+        }
+    } else {
+        metadataIndex_->put(checksum, metadata);
+        if (durability_ == Durability::PerWrite) {
+            metadataIndex_->sync();
+        }
+    }
+
+    if (durability_ == Durability::GroupCommit) {
+        committer_->await(MetadataIndex::RECORD_SIZE);
     }
-    
-    nlohmann::json j = metadata.to_json();
-    file << j.dump(2);
 }
 
 std::optional<BlockMetadata> DiskBlockStore::getMetadata(const Checksum& checksum) const {
+    if (packed_) {
+        return packed_->getMetadata(checksum);
+    }
+
+    if (auto metadata = metadataIndex_->get(checksum)) {
+        return metadata;
+    }
+
+    // Fall back to a legacy sidecar that has not been migrated yet
     std::filesystem::path path = metadataPath(checksum);
-    
     if (!std::filesystem::exists(path)) {
         return std::nullopt;
     }
@@ -142,7 +770,40 @@ std::optional<BlockMetadata> DiskBlockStore::getMetadata(const Checksum& checksu
 }
 
 bool DiskBlockStore::hasMetadata(const Checksum& checksum) const {
-    return std::filesystem::exists(metadataPath(checksum));
+    if (packed_) {
+        return packed_->has(checksum);
+    }
+    return metadataIndex_->has(checksum) || std::filesystem::exists(metadataPath(checksum));
+}
+
+size_t DiskBlockStore::migrateJsonMetadata() {
+    if (packed_) {
+        return 0;
+    }
+
+    size_t migrated = 0;
+    forEachChecksum([this, &migrated](const Checksum& checksum) {
+        std::filesystem::path path = metadataPath(checksum);
+        if (!std::filesystem::exists(path)) {
+            return;
+        }
+
+        std::ifstream file(path);
+        nlohmann::json j;
+        try {
+            file >> j;
+        } catch (const nlohmann::json::exception& e) {
+            throw std::runtime_error("Failed to parse metadata file " + path.string() + ": " +
+                                     e.what());
+        }
+        metadataIndex_->put(checksum, BlockMetadata::from_json(j));
+        file.close();
+        std::filesystem::remove(path);
+        ++migrated;
+    });
+
+    metadataIndex_->sync();
+    return migrated;
 }
 
 } // namespace brightchain
@@ -1,8 +1,10 @@
 #include "brightchain/ec_key_pair.hpp"
+#include "brightchain/secp256k1.hpp"
 #include <openssl/ec.h>
 #include <openssl/ecdsa.h>
 #include <openssl/obj_mac.h>
 #include <openssl/bn.h>
+#include <openssl/crypto.h>
 #include <openssl/rand.h>
 #include <stdexcept>
 #include <sstream>
@@ -132,6 +134,18 @@ std::string EcKeyPair::privateKeyHex() const {
 }
 
 std::vector<uint8_t> EcKeyPair::sign(const std::vector<uint8_t>& data) const {
+    if (Secp256k1::backend() == Secp256k1::Backend::LibSecp256k1) {
+        auto priv = privateKey();
+        try {
+            auto signature = Secp256k1::sign(priv, data);
+            OPENSSL_cleanse(priv.data(), priv.size());
+            return signature;
+        } catch (...) {
+            OPENSSL_cleanse(priv.data(), priv.size());
+            throw;
+        }
+    }
+
     unsigned int sig_len = ECDSA_size(key_);
     std::vector<uint8_t> signature(sig_len);
 
@@ -148,26 +162,7 @@ bool EcKeyPair::verify(
     const std::vector<uint8_t>& signature,
     const std::vector<uint8_t>& publicKey
 ) {
-    EC_KEY* key = EC_KEY_new_by_curve_name(NID_secp256k1);
-    if (!key) {
-        return false;
-    }
-
-    const EC_GROUP* group = EC_KEY_get0_group(key);
-    EC_POINT* pub = EC_POINT_new(group);
-    if (!pub || EC_POINT_oct2point(group, pub, publicKey.data(), publicKey.size(), nullptr) != 1) {
-        EC_POINT_free(pub);
-        EC_KEY_free(key);
-        return false;
-    }
-
-    EC_KEY_set_public_key(key, pub);
-    int result = ECDSA_verify(0, data.data(), data.size(), signature.data(), signature.size(), key);
-
-    EC_POINT_free(pub);
-    EC_KEY_free(key);
-
-    return result == 1;
+    return Secp256k1::verify(data, signature, publicKey);
 }
 
 } // namespace brightchain
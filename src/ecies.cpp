@@ -1,12 +1,14 @@
 #include "brightchain/ecies.hpp"
 #include "brightchain/aes_gcm.hpp"
-#include <openssl/ec.h>
-#include <openssl/ecdh.h>
+#include "brightchain/secp256k1.hpp"
 #include <openssl/kdf.h>
 #include <openssl/evp.h>
+#include <algorithm>
+#include <array>
 #include <stdexcept>
 #include <cstring>
 #include <string>
+#include <string_view>
 
 namespace brightchain {
 
@@ -15,6 +17,60 @@ static constexpr uint8_t VERSION = 0x01;
 static constexpr uint8_t CIPHER_SUITE = 0x01;  // Secp256k1_Aes256Gcm_Sha256
 static constexpr size_t EPHEMERAL_KEY_SIZE = 33;
 static constexpr size_t HEADER_SIZE = 3;  // version + cipherSuite + type
+static constexpr size_t ENTRY_HEADER_SIZE = 6;  // pubKeyIndex + keyLength
+static constexpr size_t WRAPPED_KEY_SIZE = AesGcm::KEY_SIZE + AesGcm::TAG_SIZE;
+static constexpr size_t KEY_ID_SIZE = 8;
+// Below this many recipients the wrapping is cheaper than a pool round trip
+static constexpr size_t PARALLEL_RECIPIENTS = 32;
+
+namespace {
+
+using RecipientKeyId = std::array<uint8_t, KEY_ID_SIZE>;
+
+/**
+ * HKDF-SHA256 without salt, as used throughout ECIES v2.
+ */
+void hkdfSha256(std::span<const uint8_t> secret, std::string_view info, std::span<uint8_t> out) {
+    EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
+    if (!pctx ||
+        EVP_PKEY_derive_init(pctx) <= 0 ||
+        EVP_PKEY_CTX_set_hkdf_md(pctx, EVP_sha256()) <= 0 ||
+        EVP_PKEY_CTX_set1_hkdf_key(pctx, secret.data(), secret.size()) <= 0 ||
+        EVP_PKEY_CTX_add1_hkdf_info(pctx, reinterpret_cast<const unsigned char*>(info.data()),
+                                    static_cast<int>(info.size())) <= 0) {
+        EVP_PKEY_CTX_free(pctx);
+        throw std::runtime_error("Failed to setup HKDF");
+    }
+
+    size_t length = out.size();
+    if (EVP_PKEY_derive(pctx, out.data(), &length) <= 0 || length != out.size()) {
+        EVP_PKEY_CTX_free(pctx);
+        throw std::runtime_error("Failed to derive key");
+    }
+    EVP_PKEY_CTX_free(pctx);
+}
+
+AesGcm::Key keyEncryptionKey(const Secp256k1::SharedSecret& sharedSecret) {
+    AesGcm::Key key;
+    hkdfSha256(sharedSecret, "ecies-v2-key-encryption", key);
+    return key;
+}
+
+RecipientKeyId recipientKeyId(const Secp256k1::SharedSecret& sharedSecret) {
+    RecipientKeyId id;
+    hkdfSha256(sharedSecret, "ecies-v2-recipient-key-id", id);
+    return id;
+}
+
+uint32_t readUint32(const uint8_t* in) {
+    return (uint32_t{in[0]} << 24) | (uint32_t{in[1]} << 16) | (uint32_t{in[2]} << 8) | in[3];
+}
+
+uint16_t readUint16(const uint8_t* in) {
+    return static_cast<uint16_t>((in[0] << 8) | in[1]);
+}
+
+} // namespace
 
 std::vector<uint8_t> Ecies::encryptBasic(
     const std::vector<uint8_t>& plaintext,
@@ -32,7 +88,8 @@ std::vector<uint8_t> Ecies::encryptWithLength(
 
 std::vector<uint8_t> Ecies::encryptMultiple(
     const std::vector<uint8_t>& plaintext,
-    const std::vector<std::vector<uint8_t>>& recipientPublicKeys
+    const std::vector<std::vector<uint8_t>>& recipientPublicKeys,
+    const EciesMultipleOptions& options
 ) {
     if (recipientPublicKeys.empty()) {
         throw std::runtime_error("Must have at least one recipient");
@@ -63,21 +120,44 @@ std::vector<uint8_t> Ecies::encryptMultiple(
     AesGcm::Tag tag;
     auto ciphertext = AesGcm::encrypt(plaintext, symmetricKey, iv, tag, aad);
 
-    // Encrypt symmetric key for each recipient
-    std::vector<std::pair<uint32_t, std::vector<uint8_t>>> encryptedKeys;
-    for (uint32_t i = 0; i < recipientPublicKeys.size(); ++i) {
-        auto encryptedKey = encryptSymmetricKey(
-            symmetricKey,
-            recipientPublicKeys[i],
-            ephemeralPrivateKey,
-            ephemeralPublicKey,
-            iv
-        );
-        encryptedKeys.push_back({i, encryptedKey});
+    // Encrypt symmetric key for each recipient. Entries are independent, so
+    // large lists are wrapped on the pool in contiguous ranges.
+    PublicKeyCache& keyCache = options.keyCache ? *options.keyCache : PublicKeyCache::shared();
+    std::vector<std::pair<uint32_t, std::vector<uint8_t>>> encryptedKeys(recipientPublicKeys.size());
+    auto wrapRange = [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            encryptedKeys[i] = {static_cast<uint32_t>(i), encryptSymmetricKey(
+                symmetricKey,
+                keyCache.get(recipientPublicKeys[i]),
+                ephemeralPrivateKey,
+                ephemeralPublicKey,
+                iv,
+                options.recipientKeyIds
+            )};
+        }
+    };
+
+    ThreadPool& pool = options.pool ? *options.pool : ThreadPool::shared();
+    const size_t recipients = recipientPublicKeys.size();
+    if (recipients < PARALLEL_RECIPIENTS) {
+        wrapRange(0, recipients);
+    } else {
+        pool.parallelFor(0, recipients, wrapRange);
+    }
+
+    // Key ids lead each entry; sorting by them lets recipients binary search
+    if (options.recipientKeyIds) {
+        std::sort(encryptedKeys.begin(), encryptedKeys.end(),
+                  [](const auto& a, const auto& b) {
+                      return std::memcmp(a.second.data(), b.second.data(), KEY_ID_SIZE) < 0;
+                  });
     }
 
     // Assemble result: header + ephemeralPubKey + IV + recipientCount + encrypted keys + tag + ciphertext
     std::vector<uint8_t> result;
+    result.reserve(HEADER_SIZE + EPHEMERAL_KEY_SIZE + iv.size() + 4 +
+                   encryptedKeys.size() * (ENTRY_HEADER_SIZE + encryptedKeys[0].second.size()) +
+                   tag.size() + ciphertext.size());
     
     // Header
     result.push_back(VERSION);
@@ -125,64 +205,17 @@ std::vector<uint8_t> Ecies::encryptMultiple(
 
 std::vector<uint8_t> Ecies::encryptSymmetricKey(
     const AesGcm::Key& symmetricKey,
-    const std::vector<uint8_t>& recipientPublicKey,
+    const Secp256k1::PublicKey& recipientPublicKey,
     const std::vector<uint8_t>& ephemeralPrivateKey,
     const std::vector<uint8_t>& ephemeralPublicKey,
-    const AesGcm::IV& iv
+    const AesGcm::IV& iv,
+    bool withKeyId
 ) {
     // Compute ECDH shared secret with recipient's public key
-    EC_KEY* recipientKey = EC_KEY_new_by_curve_name(NID_secp256k1);
-    if (!recipientKey) {
-        throw std::runtime_error("Failed to create recipient EC key");
-    }
-
-    const EC_GROUP* group = EC_KEY_get0_group(recipientKey);
-    EC_POINT* recipientPoint = EC_POINT_new(group);
-    if (!recipientPoint ||
-        EC_POINT_oct2point(group, recipientPoint, recipientPublicKey.data(),
-                          recipientPublicKey.size(), nullptr) != 1) {
-        EC_POINT_free(recipientPoint);
-        EC_KEY_free(recipientKey);
-        throw std::runtime_error("Invalid recipient public key");
-    }
-
-    size_t secretLen = 32;
-    std::vector<uint8_t> sharedSecret(secretLen);
-
-    BIGNUM* priv_bn = BN_bin2bn(ephemeralPrivateKey.data(), ephemeralPrivateKey.size(), nullptr);
-    EC_KEY_set_private_key(recipientKey, priv_bn);
-
-    if (ECDH_compute_key(sharedSecret.data(), secretLen, recipientPoint,
-                         recipientKey, nullptr) != static_cast<int>(secretLen)) {
-        BN_free(priv_bn);
-        EC_POINT_free(recipientPoint);
-        EC_KEY_free(recipientKey);
-        throw std::runtime_error("Failed to compute shared secret");
-    }
-
-    BN_free(priv_bn);
-    EC_POINT_free(recipientPoint);
-    EC_KEY_free(recipientKey);
+    const auto sharedSecret = Secp256k1::ecdh(ephemeralPrivateKey, recipientPublicKey);
 
     // Derive encryption key using HKDF-SHA256
-    AesGcm::Key encKey;
-    EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
-    if (!pctx ||
-        EVP_PKEY_derive_init(pctx) <= 0 ||
-        EVP_PKEY_CTX_set_hkdf_md(pctx, EVP_sha256()) <= 0 ||
-        EVP_PKEY_CTX_set1_hkdf_key(pctx, sharedSecret.data(), sharedSecret.size()) <= 0 ||
-        EVP_PKEY_CTX_add1_hkdf_info(pctx,
-            reinterpret_cast<const unsigned char*>("ecies-v2-key-encryption"), 23) <= 0) {
-        EVP_PKEY_CTX_free(pctx);
-        throw std::runtime_error("Failed to setup HKDF for key encryption");
-    }
-
-    size_t keyLen = AesGcm::KEY_SIZE;
-    if (EVP_PKEY_derive(pctx, encKey.data(), &keyLen) <= 0 || keyLen != AesGcm::KEY_SIZE) {
-        EVP_PKEY_CTX_free(pctx);
-        throw std::runtime_error("Failed to derive key encryption key");
-    }
-    EVP_PKEY_CTX_free(pctx);
+    const AesGcm::Key encKey = keyEncryptionKey(sharedSecret);
 
     // Encrypt symmetric key with derived key
     AesGcm::Tag keyTag;
@@ -192,93 +225,46 @@ std::vector<uint8_t> Ecies::encryptSymmetricKey(
 
     // Convert the symmetric key (array) to vector for encryption
     std::vector<uint8_t> keyToEncrypt(symmetricKey.begin(), symmetricKey.end());
-    auto encryptedKey = AesGcm::encrypt(keyToEncrypt, encKey, iv, keyTag, aad);
-    
-    // Append the authentication tag to the encrypted data
+    auto wrappedKey = AesGcm::encrypt(keyToEncrypt, encKey, iv, keyTag, aad);
+
+    // [keyId] + encrypted key + authentication tag
+    std::vector<uint8_t> encryptedKey;
+    encryptedKey.reserve((withKeyId ? KEY_ID_SIZE : 0) + WRAPPED_KEY_SIZE);
+    if (withKeyId) {
+        const auto id = recipientKeyId(sharedSecret);
+        encryptedKey.insert(encryptedKey.end(), id.begin(), id.end());
+    }
+    encryptedKey.insert(encryptedKey.end(), wrappedKey.begin(), wrappedKey.end());
     encryptedKey.insert(encryptedKey.end(), keyTag.begin(), keyTag.end());
     return encryptedKey;
 }
 
 AesGcm::Key Ecies::decryptSymmetricKey(
-    const std::vector<uint8_t>& encryptedSymmetricKey,
+    std::span<const uint8_t> encryptedSymmetricKey,
+    const AesGcm::Key& keyEncryptionKey,
     const std::vector<uint8_t>& ephemeralPublicKey,
-    const std::vector<uint8_t>& privateKey,
     const AesGcm::IV& iv
 ) {
-    // Compute ECDH shared secret with ephemeral public key
-    EC_KEY* ephemeralKey = EC_KEY_new_by_curve_name(NID_secp256k1);
-    if (!ephemeralKey) {
-        throw std::runtime_error("Failed to create ephemeral EC key");
-    }
-
-    const EC_GROUP* group = EC_KEY_get0_group(ephemeralKey);
-    EC_POINT* ephemeralPoint = EC_POINT_new(group);
-    if (!ephemeralPoint ||
-        EC_POINT_oct2point(group, ephemeralPoint, ephemeralPublicKey.data(),
-                          ephemeralPublicKey.size(), nullptr) != 1) {
-        EC_POINT_free(ephemeralPoint);
-        EC_KEY_free(ephemeralKey);
-        throw std::runtime_error("Invalid ephemeral public key");
-    }
-
-    size_t secretLen = 32;
-    std::vector<uint8_t> sharedSecret(secretLen);
-
-    BIGNUM* priv_bn = BN_bin2bn(privateKey.data(), privateKey.size(), nullptr);
-    EC_KEY_set_private_key(ephemeralKey, priv_bn);
-
-    if (ECDH_compute_key(sharedSecret.data(), secretLen, ephemeralPoint,
-                         ephemeralKey, nullptr) != static_cast<int>(secretLen)) {
-        BN_free(priv_bn);
-        EC_POINT_free(ephemeralPoint);
-        EC_KEY_free(ephemeralKey);
-        throw std::runtime_error("Failed to compute shared secret");
-    }
-
-    BN_free(priv_bn);
-    EC_POINT_free(ephemeralPoint);
-    EC_KEY_free(ephemeralKey);
-
-    // Derive decryption key using HKDF-SHA256
-    AesGcm::Key decKey;
-    EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
-    if (!pctx ||
-        EVP_PKEY_derive_init(pctx) <= 0 ||
-        EVP_PKEY_CTX_set_hkdf_md(pctx, EVP_sha256()) <= 0 ||
-        EVP_PKEY_CTX_set1_hkdf_key(pctx, sharedSecret.data(), sharedSecret.size()) <= 0 ||
-        EVP_PKEY_CTX_add1_hkdf_info(pctx,
-            reinterpret_cast<const unsigned char*>("ecies-v2-key-encryption"), 23) <= 0) {
-        EVP_PKEY_CTX_free(pctx);
-        throw std::runtime_error("Failed to setup HKDF for key decryption");
-    }
-
-    size_t keyLen = AesGcm::KEY_SIZE;
-    if (EVP_PKEY_derive(pctx, decKey.data(), &keyLen) <= 0 || keyLen != AesGcm::KEY_SIZE) {
-        EVP_PKEY_CTX_free(pctx);
-        throw std::runtime_error("Failed to derive key decryption key");
-    }
-    EVP_PKEY_CTX_free(pctx);
-
-    // Decrypt symmetric key - note we can't verify tag without it, so we'll assume it's valid
-    AesGcm::Tag keyTag;
     std::vector<uint8_t> aad;
     aad.insert(aad.end(), ephemeralPublicKey.begin(), ephemeralPublicKey.end());
     aad.insert(aad.end(), iv.begin(), iv.end());
 
-    // For decryption, we need the tag which is appended to encrypted data
+    // The tag is appended to the encrypted key
     if (encryptedSymmetricKey.size() < AesGcm::TAG_SIZE) {
         throw std::runtime_error("Encrypted key too short");
     }
 
+    const size_t encryptedSize = encryptedSymmetricKey.size() - AesGcm::TAG_SIZE;
     std::vector<uint8_t> encrypted(encryptedSymmetricKey.begin(),
-                                   encryptedSymmetricKey.end() - AesGcm::TAG_SIZE);
-    std::memcpy(keyTag.data(), encryptedSymmetricKey.data() + encrypted.size(), AesGcm::TAG_SIZE);
+                                   encryptedSymmetricKey.begin() + encryptedSize);
+    AesGcm::Tag keyTag;
+    std::memcpy(keyTag.data(), encryptedSymmetricKey.data() + encryptedSize, AesGcm::TAG_SIZE);
 
-    auto decryptedKey = AesGcm::decrypt(encrypted, decKey, iv, keyTag, aad);
+    auto decryptedKey = AesGcm::decrypt(encrypted, keyEncryptionKey, iv, keyTag, aad);
     if (decryptedKey.size() != AesGcm::KEY_SIZE) {
         throw std::runtime_error("Decrypted key has incorrect size");
     }
-    
+
     AesGcm::Key result;
     std::memcpy(result.data(), decryptedKey.data(), AesGcm::KEY_SIZE);
     return result;
@@ -295,58 +281,11 @@ std::vector<uint8_t> Ecies::encryptInternal(
     auto ephemeralPrivateKey = ephemeralKeyPair.privateKey();
 
     // Compute ECDH shared secret
-    EC_KEY* recipientKey = EC_KEY_new_by_curve_name(NID_secp256k1);
-    if (!recipientKey) {
-        throw std::runtime_error("Failed to create recipient EC key");
-    }
-
-    const EC_GROUP* group = EC_KEY_get0_group(recipientKey);
-    EC_POINT* recipientPoint = EC_POINT_new(group);
-    if (!recipientPoint || 
-        EC_POINT_oct2point(group, recipientPoint, recipientPublicKey.data(), 
-                          recipientPublicKey.size(), nullptr) != 1) {
-        EC_POINT_free(recipientPoint);
-        EC_KEY_free(recipientKey);
-        throw std::runtime_error("Invalid recipient public key");
-    }
-
-    size_t secretLen = 32;
-    std::vector<uint8_t> sharedSecret(secretLen);
-    
-    BIGNUM* priv_bn = BN_bin2bn(ephemeralPrivateKey.data(), ephemeralPrivateKey.size(), nullptr);
-    EC_KEY_set_private_key(recipientKey, priv_bn);
-    
-    if (ECDH_compute_key(sharedSecret.data(), secretLen, recipientPoint, 
-                         recipientKey, nullptr) != static_cast<int>(secretLen)) {
-        BN_free(priv_bn);
-        EC_POINT_free(recipientPoint);
-        EC_KEY_free(recipientKey);
-        throw std::runtime_error("Failed to compute shared secret");
-    }
-
-    BN_free(priv_bn);
-    EC_POINT_free(recipientPoint);
-    EC_KEY_free(recipientKey);
+    const auto sharedSecret = Secp256k1::ecdh(ephemeralPrivateKey, recipientPublicKey);
 
     // Derive AES key using HKDF-SHA256
     AesGcm::Key aesKey;
-    EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
-    if (!pctx ||
-        EVP_PKEY_derive_init(pctx) <= 0 ||
-        EVP_PKEY_CTX_set_hkdf_md(pctx, EVP_sha256()) <= 0 ||
-        EVP_PKEY_CTX_set1_hkdf_key(pctx, sharedSecret.data(), sharedSecret.size()) <= 0 ||
-        EVP_PKEY_CTX_add1_hkdf_info(pctx, 
-            reinterpret_cast<const unsigned char*>("ecies-v2-key-derivation"), 23) <= 0) {
-        EVP_PKEY_CTX_free(pctx);
-        throw std::runtime_error("Failed to setup HKDF");
-    }
-
-    size_t keyLen = AesGcm::KEY_SIZE;
-    if (EVP_PKEY_derive(pctx, aesKey.data(), &keyLen) <= 0 || keyLen != AesGcm::KEY_SIZE) {
-        EVP_PKEY_CTX_free(pctx);
-        throw std::runtime_error("Failed to derive AES key");
-    }
-    EVP_PKEY_CTX_free(pctx);
+    hkdfSha256(sharedSecret, "ecies-v2-key-derivation", aesKey);
 
     // Generate random IV
     auto iv = AesGcm::generateIV();
@@ -401,6 +340,22 @@ std::vector<uint8_t> Ecies::encryptInternal(
 std::vector<uint8_t> Ecies::decrypt(
     const std::vector<uint8_t>& ciphertext,
     const EcKeyPair& keyPair
+) {
+    return decryptInternal(ciphertext, keyPair, std::nullopt);
+}
+
+std::vector<uint8_t> Ecies::decrypt(
+    const std::vector<uint8_t>& ciphertext,
+    const EcKeyPair& keyPair,
+    uint32_t recipientIndex
+) {
+    return decryptInternal(ciphertext, keyPair, recipientIndex);
+}
+
+std::vector<uint8_t> Ecies::decryptInternal(
+    const std::vector<uint8_t>& ciphertext,
+    const EcKeyPair& keyPair,
+    std::optional<uint32_t> recipientIndex
 ) {
     size_t minSize = HEADER_SIZE + EPHEMERAL_KEY_SIZE + AesGcm::IV_SIZE + AesGcm::TAG_SIZE;
     if (ciphertext.size() < minSize) {
@@ -436,84 +391,11 @@ std::vector<uint8_t> Ecies::decrypt(
 
     // Handle multiple recipient mode
     if (type == EciesEncryptionType::Multiple) {
-        if (ciphertext.size() < offset + 4 + AesGcm::TAG_SIZE) {
-            throw std::runtime_error("Multiple recipient ciphertext too short");
-        }
-
-        // Parse recipient count
-        uint32_t recipientCount = 0;
-        for (int i = 0; i < 4; ++i) {
-            recipientCount = (recipientCount << 8) | ciphertext[offset++];
-        }
-
-        // Find our key in the recipient list
-        AesGcm::Key symmetricKey;
-        bool foundKey = false;
-
-        for (uint32_t i = 0; i < recipientCount; ++i) {
-            if (offset + 6 > ciphertext.size()) {
-                throw std::runtime_error("Truncated recipient entry");
-            }
-
-            // Parse index
-            uint32_t recipientIndex = 0;
-            for (int j = 0; j < 4; ++j) {
-                recipientIndex = (recipientIndex << 8) | ciphertext[offset++];
-            }
-
-            // Parse encrypted key length
-            uint16_t encryptedKeyLen = 0;
-            for (int j = 0; j < 2; ++j) {
-                encryptedKeyLen = (encryptedKeyLen << 8) | ciphertext[offset++];
-            }
-
-            if (offset + encryptedKeyLen > ciphertext.size()) {
-                throw std::runtime_error("Truncated encrypted key");
-            }
-
-            std::vector<uint8_t> encryptedKey(
-                ciphertext.begin() + offset,
-                ciphertext.begin() + offset + encryptedKeyLen
-            );
-            offset += encryptedKeyLen;
-
-            // Try to decrypt with our key pair (only if we haven't found it yet)
-            if (!foundKey) {
-                try {
-                    symmetricKey = decryptSymmetricKey(encryptedKey, ephemeralPublicKey, 
-                                                      keyPair.privateKey(), iv);
-                    foundKey = true;
-                } catch (...) {
-                    // Not for us, continue to next recipient
-                    continue;
-                }
-            }
-        }
-
-        if (!foundKey) {
-            throw std::runtime_error("Could not decrypt symmetric key with provided key pair");
-        }
-
-        // Extract auth tag
-        AesGcm::Tag tag;
-        if (offset + AesGcm::TAG_SIZE > ciphertext.size()) {
-            throw std::runtime_error("Missing auth tag");
-        }
-        std::memcpy(tag.data(), ciphertext.data() + offset, AesGcm::TAG_SIZE);
-        offset += AesGcm::TAG_SIZE;
-
-        // Extract ciphertext
-        std::vector<uint8_t> encrypted(ciphertext.begin() + offset, ciphertext.end());
-
-        // Construct AAD
-        std::vector<uint8_t> aad;
-        aad.push_back(version);
-        aad.push_back(cipherSuite);
-        aad.push_back(static_cast<uint8_t>(type));
-        aad.insert(aad.end(), ephemeralPublicKey.begin(), ephemeralPublicKey.end());
-
-        // Decrypt
-        return AesGcm::decrypt(encrypted, symmetricKey, iv, tag, aad);
+        return decryptMultiple(ciphertext, offset, ephemeralPublicKey, iv, keyPair,
+                               recipientIndex);
+    }
+    if (recipientIndex) {
+        throw std::invalid_argument("Recipient index requires a multiple recipient ciphertext");
     }
 
     // Handle single recipient modes (Basic, WithLength)
@@ -548,59 +430,11 @@ std::vector<uint8_t> Ecies::decrypt(
     );
 
     // Compute ECDH shared secret
-    EC_KEY* ephemeralKey = EC_KEY_new_by_curve_name(NID_secp256k1);
-    if (!ephemeralKey) {
-        throw std::runtime_error("Failed to create ephemeral EC key");
-    }
-
-    const EC_GROUP* group = EC_KEY_get0_group(ephemeralKey);
-    EC_POINT* ephemeralPoint = EC_POINT_new(group);
-    if (!ephemeralPoint ||
-        EC_POINT_oct2point(group, ephemeralPoint, ephemeralPublicKey.data(),
-                          ephemeralPublicKey.size(), nullptr) != 1) {
-        EC_POINT_free(ephemeralPoint);
-        EC_KEY_free(ephemeralKey);
-        throw std::runtime_error("Invalid ephemeral public key");
-    }
-
-    auto privateKey = keyPair.privateKey();
-    size_t secretLen = 32;
-    std::vector<uint8_t> sharedSecret(secretLen);
-
-    BIGNUM* priv_bn = BN_bin2bn(privateKey.data(), privateKey.size(), nullptr);
-    EC_KEY_set_private_key(ephemeralKey, priv_bn);
-
-    if (ECDH_compute_key(sharedSecret.data(), secretLen, ephemeralPoint,
-                         ephemeralKey, nullptr) != static_cast<int>(secretLen)) {
-        BN_free(priv_bn);
-        EC_POINT_free(ephemeralPoint);
-        EC_KEY_free(ephemeralKey);
-        throw std::runtime_error("Failed to compute shared secret");
-    }
-
-    BN_free(priv_bn);
-    EC_POINT_free(ephemeralPoint);
-    EC_KEY_free(ephemeralKey);
+    const auto sharedSecret = Secp256k1::ecdh(keyPair.privateKey(), ephemeralPublicKey);
 
     // Derive AES key using HKDF-SHA256
     AesGcm::Key aesKey;
-    EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
-    if (!pctx ||
-        EVP_PKEY_derive_init(pctx) <= 0 ||
-        EVP_PKEY_CTX_set_hkdf_md(pctx, EVP_sha256()) <= 0 ||
-        EVP_PKEY_CTX_set1_hkdf_key(pctx, sharedSecret.data(), sharedSecret.size()) <= 0 ||
-        EVP_PKEY_CTX_add1_hkdf_info(pctx,
-            reinterpret_cast<const unsigned char*>("ecies-v2-key-derivation"), 23) <= 0) {
-        EVP_PKEY_CTX_free(pctx);
-        throw std::runtime_error("Failed to setup HKDF");
-    }
-
-    size_t keyLen = AesGcm::KEY_SIZE;
-    if (EVP_PKEY_derive(pctx, aesKey.data(), &keyLen) <= 0 || keyLen != AesGcm::KEY_SIZE) {
-        EVP_PKEY_CTX_free(pctx);
-        throw std::runtime_error("Failed to derive AES key");
-    }
-    EVP_PKEY_CTX_free(pctx);
+    hkdfSha256(sharedSecret, "ecies-v2-key-derivation", aesKey);
 
     // Construct AAD: version + cipherSuite + type + ephemeralPublicKey
     std::vector<uint8_t> aad;
@@ -613,4 +447,160 @@ std::vector<uint8_t> Ecies::decrypt(
     return AesGcm::decrypt(encrypted, aesKey, iv, tag, aad);
 }
 
+std::vector<uint8_t> Ecies::decryptMultiple(
+    const std::vector<uint8_t>& ciphertext,
+    size_t offset,
+    const std::vector<uint8_t>& ephemeralPublicKey,
+    const AesGcm::IV& iv,
+    const EcKeyPair& keyPair,
+    std::optional<uint32_t> recipientIndex
+) {
+    if (ciphertext.size() < offset + 4 + AesGcm::TAG_SIZE) {
+        throw std::runtime_error("Multiple recipient ciphertext too short");
+    }
+
+    // Parse recipient count
+    const uint32_t recipientCount = readUint32(ciphertext.data() + offset);
+    offset += 4;
+    const size_t tableStart = offset;
+
+    // Every entry is wrapped under the same ephemeral key, so one ECDH and
+    // one HKDF serve the whole table
+    const auto sharedSecret = Secp256k1::ecdh(keyPair.privateKey(), ephemeralPublicKey);
+    const AesGcm::Key kek = keyEncryptionKey(sharedSecret);
+    std::optional<RecipientKeyId> ownKeyId;
+    auto keyId = [&]() -> const RecipientKeyId& {
+        if (!ownKeyId) {
+            ownKeyId = recipientKeyId(sharedSecret);
+        }
+        return *ownKeyId;
+    };
+
+    auto decryptPayload = [&](size_t tableEnd, const AesGcm::Key& symmetricKey) {
+        if (tableEnd + AesGcm::TAG_SIZE > ciphertext.size()) {
+            throw std::runtime_error("Missing auth tag");
+        }
+        AesGcm::Tag tag;
+        std::memcpy(tag.data(), ciphertext.data() + tableEnd, AesGcm::TAG_SIZE);
+        std::vector<uint8_t> encrypted(ciphertext.begin() + tableEnd + AesGcm::TAG_SIZE,
+                                       ciphertext.end());
+
+        std::vector<uint8_t> aad;
+        aad.push_back(VERSION);
+        aad.push_back(CIPHER_SUITE);
+        aad.push_back(static_cast<uint8_t>(EciesEncryptionType::Multiple));
+        aad.insert(aad.end(), ephemeralPublicKey.begin(), ephemeralPublicKey.end());
+        return AesGcm::decrypt(encrypted, symmetricKey, iv, tag, aad);
+    };
+
+    // Direct lookup. encryptMultiple writes entries of one length, so entry
+    // k starts at a fixed stride. Keyed tables are sorted by key id rather
+    // than index, so binary search them and check the index afterwards;
+    // otherwise jump to the given index. Anything unexpected falls through
+    // to the scan.
+    if (recipientCount > 0 && tableStart + ENTRY_HEADER_SIZE <= ciphertext.size()) {
+        const size_t keyLen = readUint16(ciphertext.data() + tableStart + 4);
+        const size_t stride = ENTRY_HEADER_SIZE + keyLen;
+        const bool keyed = keyLen == KEY_ID_SIZE + WRAPPED_KEY_SIZE;
+        const size_t available = ciphertext.size() - tableStart - AesGcm::TAG_SIZE;
+
+        auto entryAt = [&](size_t position) -> const uint8_t* {
+            const uint8_t* entry = ciphertext.data() + tableStart + position * stride;
+            return readUint16(entry + 4) == keyLen ? entry : nullptr;
+        };
+
+        const uint8_t* entry = nullptr;
+        if (available / stride >= recipientCount) {
+            if (!keyed && recipientIndex) {
+                if (*recipientIndex < recipientCount) {
+                    const uint8_t* candidate = entryAt(*recipientIndex);
+                    if (candidate && readUint32(candidate) == *recipientIndex) {
+                        entry = candidate;
+                    }
+                }
+            } else if (keyed) {
+                size_t low = 0;
+                size_t high = recipientCount;
+                while (low < high) {
+                    const size_t mid = low + (high - low) / 2;
+                    const uint8_t* candidate = entryAt(mid);
+                    if (!candidate) {
+                        break;
+                    }
+                    const int order = std::memcmp(candidate + ENTRY_HEADER_SIZE,
+                                                  keyId().data(), KEY_ID_SIZE);
+                    if (order == 0) {
+                        if (!recipientIndex || readUint32(candidate) == *recipientIndex) {
+                            entry = candidate;
+                        }
+                        break;
+                    }
+                    if (order < 0) {
+                        low = mid + 1;
+                    } else {
+                        high = mid;
+                    }
+                }
+            }
+        }
+
+        if (entry) {
+            const size_t skip = keyed ? KEY_ID_SIZE : 0;
+            std::optional<AesGcm::Key> symmetricKey;
+            try {
+                symmetricKey = decryptSymmetricKey(
+                    std::span<const uint8_t>(entry + ENTRY_HEADER_SIZE + skip, keyLen - skip),
+                    kek, ephemeralPublicKey, iv);
+            } catch (const std::runtime_error&) {
+                // Not a uniform table after all; scan it
+            }
+            // Payload authentication failures are final, not a reason to scan
+            if (symmetricKey) {
+                return decryptPayload(tableStart + recipientCount * stride, *symmetricKey);
+            }
+        }
+    }
+
+    // Scan the table: match the index or key id when known, else try each entry
+    AesGcm::Key symmetricKey;
+    bool foundKey = false;
+    offset = tableStart;
+    for (uint32_t i = 0; i < recipientCount; ++i) {
+        if (offset + ENTRY_HEADER_SIZE > ciphertext.size()) {
+            throw std::runtime_error("Truncated recipient entry");
+        }
+        const uint32_t entryIndex = readUint32(ciphertext.data() + offset);
+        const uint16_t encryptedKeyLen = readUint16(ciphertext.data() + offset + 4);
+        offset += ENTRY_HEADER_SIZE;
+
+        if (offset + encryptedKeyLen > ciphertext.size()) {
+            throw std::runtime_error("Truncated encrypted key");
+        }
+        std::span<const uint8_t> encryptedKey(ciphertext.data() + offset, encryptedKeyLen);
+        offset += encryptedKeyLen;
+
+        if (foundKey || (recipientIndex && entryIndex != *recipientIndex)) {
+            continue;
+        }
+        if (encryptedKeyLen == KEY_ID_SIZE + WRAPPED_KEY_SIZE) {
+            if (std::memcmp(encryptedKey.data(), keyId().data(), KEY_ID_SIZE) != 0) {
+                continue;
+            }
+            encryptedKey = encryptedKey.subspan(KEY_ID_SIZE);
+        }
+
+        try {
+            symmetricKey = decryptSymmetricKey(encryptedKey, kek, ephemeralPublicKey, iv);
+            foundKey = true;
+        } catch (const std::runtime_error&) {
+            // Not for us, continue to next recipient
+        }
+    }
+
+    if (!foundKey) {
+        throw std::runtime_error("Could not decrypt symmetric key with provided key pair");
+    }
+    return decryptPayload(offset, symmetricKey);
+}
+
 } // namespace brightchain
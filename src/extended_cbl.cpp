@@ -5,6 +5,20 @@
 
 namespace brightchain {
 
+static uint8_t calculateCRC8(const uint8_t* data, size_t length) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < length; ++i) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; ++j) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// Offset of the file metadata: the base header fields end after isExtended
+static constexpr size_t METADATA_OFFSET = CBLHeader::SIZE - 64;
+
 std::vector<uint8_t> ExtendedCBLMetadata::serialize() const {
     if (fileName.length() > CBLConstants::MAX_FILE_NAME_LENGTH) {
         throw std::invalid_argument("File name too long");
@@ -72,7 +86,23 @@ ExtendedCBL::ExtendedCBL(BlockSize blockSize, const std::vector<uint8_t>& data,
     
     // In ExtendedCBL, metadata comes at offset 106 (after isExtended flag)
     // BEFORE the signature, not after the full header
-    metadata_ = ExtendedCBLMetadata::deserialize(data, 106);
+    metadata_ = ExtendedCBLMetadata::deserialize(data, METADATA_OFFSET);
+}
+
+std::vector<uint8_t> ExtendedCBL::serializeHeader(const CBLHeader& header,
+                                                  const ExtendedCBLMetadata& metadata) {
+    CBLHeader extended = header;
+    extended.type = static_cast<uint8_t>(StructuredBlockType::ExtendedCBL);
+    extended.isExtended = 1;
+
+    auto base = extended.serialize();
+    auto metadataBytes = metadata.serialize();
+
+    std::vector<uint8_t> result(base.begin(), base.begin() + METADATA_OFFSET);
+    result.insert(result.end(), metadataBytes.begin(), metadataBytes.end());
+    result[3] = calculateCRC8(&result[4], result.size() - 4);
+    result.insert(result.end(), extended.signature.begin(), extended.signature.end());
+    return result;
 }
 
 void ExtendedCBL::validateSync() const {
@@ -0,0 +1,119 @@
+#include "file_io.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+
+namespace brightchain {
+
+void writeLE(uint8_t* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+}
+
+uint64_t readLE(const uint8_t* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(in[i]) << (i * 8);
+    }
+    return value;
+}
+
+int64_t toUnixMillis(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+std::chrono::system_clock::time_point fromUnixMillis(int64_t millis) {
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::milliseconds(millis)));
+}
+
+void writeFully(int fd, const uint8_t* data, size_t length, uint64_t offset) {
+    while (length > 0) {
+        ssize_t written = ::pwrite(fd, data, length, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "Failed to write file");
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+}
+
+void writeFully(int fd, const uint8_t* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = ::write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "Failed to write output");
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+}
+
+bool readFully(int fd, uint8_t* data, size_t length, uint64_t offset) {
+    while (length > 0) {
+        ssize_t got = ::pread(fd, data, length, static_cast<off_t>(offset));
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to read file: " + std::string(std::strerror(errno)));
+        }
+        if (got == 0) {
+            return false;
+        }
+        data += got;
+        length -= static_cast<size_t>(got);
+        offset += static_cast<uint64_t>(got);
+    }
+    return true;
+}
+
+int syncData(int fd) {
+#if defined(__linux__)
+    return ::fdatasync(fd);
+#elif defined(__APPLE__)
+    // Not every filesystem supports F_FULLFSYNC
+    if (::fcntl(fd, F_FULLFSYNC) == 0) {
+        return 0;
+    }
+    return ::fsync(fd);
+#else
+    return ::fsync(fd);
+#endif
+}
+
+void startWriteback(int fd) {
+#ifdef __linux__
+    // A hint only: a failure leaves the writeback to syncData()
+    (void)::sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+#else
+    (void)fd;
+#endif
+}
+
+void syncDirectory(const std::filesystem::path& directory) {
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open directory for sync: " + directory.string());
+    }
+    int result = ::fsync(fd);
+    ::close(fd);
+    if (result != 0) {
+        throw std::runtime_error("Failed to sync directory: " + directory.string());
+    }
+}
+
+} // namespace brightchain
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Low-level file helpers shared by the on-disk formats. Internal to the
+// library; not installed with the public headers.
+
+namespace brightchain {
+
+/**
+ * Store the low `bytes` bytes of value little-endian.
+ */
+void writeLE(uint8_t* out, uint64_t value, size_t bytes);
+
+/**
+ * Load a `bytes`-byte little-endian value.
+ */
+uint64_t readLE(const uint8_t* in, size_t bytes);
+
+/**
+ * Milliseconds since the Unix epoch, the timestamp resolution the on-disk
+ * formats store.
+ */
+int64_t toUnixMillis(std::chrono::system_clock::time_point time);
+
+std::chrono::system_clock::time_point fromUnixMillis(int64_t millis);
+
+/**
+ * Write all of data at offset, retrying short and interrupted writes.
+ * @throws std::system_error with the errno on a write error
+ */
+void writeFully(int fd, const uint8_t* data, size_t length, uint64_t offset);
+
+/**
+ * Write all of data at the current position, for pipes and other streams.
+ * @throws std::system_error with the errno on a write error
+ */
+void writeFully(int fd, const uint8_t* data, size_t length);
+
+/**
+ * Read exactly length bytes at offset.
+ * @return False if the file ends first
+ * @throws std::runtime_error on a read error
+ */
+bool readFully(int fd, uint8_t* data, size_t length, uint64_t offset);
+
+/**
+ * Make a file's data durable: fdatasync on Linux, F_FULLFSYNC on Apple
+ * (whose fsync leaves data in the drive cache), fsync elsewhere.
+ * @return 0, or -1 with errno set
+ */
+int syncData(int fd);
+
+/**
+ * Start writeback of a file's dirty pages without waiting for it, so a
+ * later syncData() finds the I/O already under way. Linux only; elsewhere
+ * this does nothing.
+ */
+void startWriteback(int fd);
+
+/**
+ * fsync a directory, making renames and new entries in it durable.
+ * @throws std::runtime_error on failure
+ */
+void syncDirectory(const std::filesystem::path& directory);
+
+} // namespace brightchain
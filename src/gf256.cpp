@@ -0,0 +1,220 @@
+#include "brightchain/gf256.hpp"
+#include "brightchain/xor_blocks.hpp"
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BRIGHTCHAIN_GF_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace brightchain {
+namespace gf256 {
+
+namespace {
+
+struct Tables {
+    std::array<uint8_t, 256> log{};
+    std::array<uint8_t, 512> exp{}; // Doubled so log[a] + log[b] needs no modulo
+    std::array<std::array<uint8_t, 256>, 256> product{};
+
+    Tables() {
+        // 3 generates the multiplicative group modulo 0x11B
+        uint8_t x = 1;
+        for (int i = 0; i < 255; ++i) {
+            exp[i] = x;
+            exp[i + 255] = x;
+            log[x] = static_cast<uint8_t>(i);
+            uint8_t doubled = static_cast<uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1B : 0));
+            x = static_cast<uint8_t>(doubled ^ x);
+        }
+        for (int a = 1; a < 256; ++a) {
+            for (int b = 1; b < 256; ++b) {
+                product[a][b] = exp[log[a] + log[b]];
+            }
+        }
+    }
+};
+
+const Tables& tables() {
+    static const Tables instance;
+    return instance;
+}
+
+void mulAddScalar(uint8_t* target, const uint8_t* source, uint8_t coefficient,
+                  size_t length) {
+    const auto& row = tables().product[coefficient];
+    for (size_t i = 0; i < length; ++i) {
+        target[i] ^= row[source[i]];
+    }
+}
+
+void mulScalar(uint8_t* target, const uint8_t* source, uint8_t coefficient, size_t length) {
+    const auto& row = tables().product[coefficient];
+    for (size_t i = 0; i < length; ++i) {
+        target[i] = row[source[i]];
+    }
+}
+
+#ifdef BRIGHTCHAIN_GF_SIMD
+
+/**
+ * Products of the coefficient with every low nibble and every high nibble;
+ * a byte's product is the XOR of its two nibble products.
+ */
+struct NibbleTables {
+    alignas(16) uint8_t low[16];
+    alignas(16) uint8_t high[16];
+
+    explicit NibbleTables(uint8_t coefficient) {
+        const auto& row = tables().product[coefficient];
+        for (int i = 0; i < 16; ++i) {
+            low[i] = row[i];
+            high[i] = row[i << 4];
+        }
+    }
+};
+
+template <bool Accumulate>
+__attribute__((target("avx2"))) size_t mulAvx2(uint8_t* target, const uint8_t* source,
+                                               uint8_t coefficient, size_t length) {
+    const NibbleTables nibbles(coefficient);
+    const __m256i low = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(nibbles.low)));
+    const __m256i high = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(nibbles.high)));
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+
+    size_t offset = 0;
+    for (; offset + 32 <= length; offset += 32) {
+        const __m256i value =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + offset));
+        const __m256i lowNibbles = _mm256_and_si256(value, mask);
+        const __m256i highNibbles = _mm256_and_si256(_mm256_srli_epi64(value, 4), mask);
+        __m256i product = _mm256_xor_si256(_mm256_shuffle_epi8(low, lowNibbles),
+                                           _mm256_shuffle_epi8(high, highNibbles));
+        auto* out = reinterpret_cast<__m256i*>(target + offset);
+        if constexpr (Accumulate) {
+            product = _mm256_xor_si256(product, _mm256_loadu_si256(out));
+        }
+        _mm256_storeu_si256(out, product);
+    }
+    return offset;
+}
+
+template <bool Accumulate>
+__attribute__((target("avx512f,avx512bw,gfni"))) size_t mulGfni(uint8_t* target,
+                                                                 const uint8_t* source,
+                                                                 uint8_t coefficient,
+                                                                 size_t length) {
+    const __m512i factor = _mm512_set1_epi8(static_cast<char>(coefficient));
+    size_t offset = 0;
+    for (; offset + 64 <= length; offset += 64) {
+        __m512i product = _mm512_gf2p8mul_epi8(_mm512_loadu_si512(source + offset), factor);
+        if constexpr (Accumulate) {
+            product = _mm512_xor_si512(product, _mm512_loadu_si512(target + offset));
+        }
+        _mm512_storeu_si512(target + offset, product);
+    }
+    return offset;
+}
+
+#endif // BRIGHTCHAIN_GF_SIMD
+
+bool supported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar:
+            return true;
+#ifdef BRIGHTCHAIN_GF_SIMD
+        case Kernel::Avx2:
+            return __builtin_cpu_supports("avx2");
+        case Kernel::Avx512Gfni:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+                   __builtin_cpu_supports("gfni");
+#endif
+        default:
+            return false;
+    }
+}
+
+/**
+ * Run the vector kernel over the bulk of the buffer; returns bytes done.
+ */
+template <bool Accumulate>
+size_t mulVector(uint8_t* target, const uint8_t* source, uint8_t coefficient, size_t length,
+                 Kernel kernel) {
+    if (!supported(kernel)) {
+        throw std::invalid_argument("GF(2^8) kernel is not supported on this CPU");
+    }
+    switch (kernel) {
+#ifdef BRIGHTCHAIN_GF_SIMD
+        case Kernel::Avx2:
+            return mulAvx2<Accumulate>(target, source, coefficient, length);
+        case Kernel::Avx512Gfni:
+            return mulGfni<Accumulate>(target, source, coefficient, length);
+#endif
+        default:
+            return 0;
+    }
+}
+
+} // namespace
+
+uint8_t mul(uint8_t a, uint8_t b) {
+    return tables().product[a][b];
+}
+
+uint8_t inv(uint8_t a) {
+    if (a == 0) {
+        throw std::domain_error("Zero has no inverse in GF(2^8)");
+    }
+    const Tables& t = tables();
+    return t.exp[255 - t.log[a]];
+}
+
+Kernel bestKernel() {
+    static const Kernel best = []() {
+        if (supported(Kernel::Avx512Gfni)) {
+            return Kernel::Avx512Gfni;
+        }
+        if (supported(Kernel::Avx2)) {
+            return Kernel::Avx2;
+        }
+        return Kernel::Scalar;
+    }();
+    return best;
+}
+
+void mulAdd(uint8_t* target, const uint8_t* source, uint8_t coefficient, size_t length,
+            Kernel kernel) {
+    if (coefficient == 0 || length == 0) {
+        return;
+    }
+    if (coefficient == 1) {
+        xorInto(target, source, length);
+        return;
+    }
+    const size_t done = mulVector<true>(target, source, coefficient, length, kernel);
+    mulAddScalar(target + done, source + done, coefficient, length - done);
+}
+
+void mul(uint8_t* target, const uint8_t* source, uint8_t coefficient, size_t length,
+         Kernel kernel) {
+    if (length == 0) {
+        return;
+    }
+    if (coefficient == 0) {
+        std::memset(target, 0, length);
+        return;
+    }
+    if (coefficient == 1) {
+        std::memmove(target, source, length);
+        return;
+    }
+    const size_t done = mulVector<false>(target, source, coefficient, length, kernel);
+    mulScalar(target + done, source + done, coefficient, length - done);
+}
+
+} // namespace gf256
+} // namespace brightchain
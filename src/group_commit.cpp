@@ -0,0 +1,174 @@
+#include "brightchain/group_commit.hpp"
+#include "file_io.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace brightchain {
+
+GroupCommitter::GroupCommitter(std::chrono::milliseconds interval, size_t maxBytes,
+                               std::function<void()> batchHook)
+    : interval_(interval), maxBytes_(maxBytes), batchHook_(std::move(batchHook)) {
+    if (maxBytes == 0) {
+        throw std::invalid_argument("Group commit byte threshold must be positive");
+    }
+    committer_ = std::thread([this]() { committerLoop(); });
+}
+
+GroupCommitter::~GroupCommitter() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    committer_.join();
+}
+
+void GroupCommitter::commit(int fd, const std::filesystem::path& tempPath,
+                            const std::filesystem::path& finalPath, size_t bytes) {
+    Pending pending{fd, tempPath, finalPath, {}};
+    auto done = pending.done.get_future();
+    enqueue(std::move(pending), bytes, false);
+    done.get();
+}
+
+void GroupCommitter::await(size_t bytes) {
+    Pending pending{-1, {}, {}, {}};
+    auto done = pending.done.get_future();
+    enqueue(std::move(pending), bytes, false);
+    done.get();
+}
+
+void GroupCommitter::flush() {
+    Pending pending{-1, {}, {}, {}};
+    auto done = pending.done.get_future();
+    enqueue(std::move(pending), 0, true);
+    done.get();
+}
+
+size_t GroupCommitter::batchCount() const {
+    std::lock_guard lock(mutex_);
+    return batches_;
+}
+
+void GroupCommitter::enqueue(Pending pending, size_t bytes, bool urgent) {
+    {
+        std::lock_guard lock(mutex_);
+        if (pending_.empty()) {
+            batchStart_ = std::chrono::steady_clock::now();
+        }
+        pending_.push_back(std::move(pending));
+        pendingBytes_ += bytes;
+        urgent_ = urgent_ || urgent;
+    }
+    wake_.notify_one();
+}
+
+void GroupCommitter::committerLoop() {
+    std::unique_lock lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+        if (pending_.empty()) {
+            return;
+        }
+
+        wake_.wait_until(lock, batchStart_ + interval_, [this]() {
+            return stopping_ || urgent_ || pendingBytes_ >= maxBytes_;
+        });
+
+        std::vector<Pending> batch;
+        batch.swap(pending_);
+        pendingBytes_ = 0;
+        urgent_ = false;
+
+        lock.unlock();
+        commitBatch(batch);
+        lock.lock();
+    }
+}
+
+void GroupCommitter::commitBatch(std::vector<Pending>& batch) {
+    // Each write succeeds or fails on its own; a failed sync or rename must
+    // not report blocks already in place as lost
+    std::vector<std::exception_ptr> failures(batch.size());
+
+    // Start writeback for every file before waiting on any of them
+    for (const auto& pending : batch) {
+        if (pending.fd >= 0) {
+            startWriteback(pending.fd);
+        }
+    }
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch[i].fd >= 0 && syncData(batch[i].fd) != 0) {
+            failures[i] = std::make_exception_ptr(std::runtime_error(
+                "Failed to sync block file " + batch[i].tempPath.string() + ": " +
+                std::strerror(errno)));
+        }
+    }
+
+    // Nothing is renamed yet, so a failed hook fails the whole batch
+    std::exception_ptr hookFailure;
+    if (batchHook_) {
+        try {
+            batchHook_();
+        } catch (...) {
+            hookFailure = std::current_exception();
+        }
+    }
+    if (hookFailure) {
+        std::fill(failures.begin(), failures.end(), hookFailure);
+    }
+
+    std::map<std::filesystem::path, std::vector<size_t>> directories;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch[i].fd < 0 || failures[i]) {
+            continue;
+        }
+        try {
+            std::filesystem::rename(batch[i].tempPath, batch[i].finalPath);
+            directories[batch[i].finalPath.parent_path()].push_back(i);
+        } catch (...) {
+            failures[i] = std::current_exception();
+        }
+    }
+    for (const auto& [directory, renamed] : directories) {
+        try {
+            syncDirectory(directory);
+        } catch (...) {
+            // In place, but the rename may not survive a crash
+            for (size_t i : renamed) {
+                failures[i] = std::current_exception();
+            }
+        }
+    }
+
+    {
+        // Count before waking writers so batchCount() covers their commit
+        std::lock_guard lock(mutex_);
+        ++batches_;
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        Pending& pending = batch[i];
+        if (pending.fd >= 0) {
+            ::close(pending.fd);
+            if (failures[i]) {
+                // Already gone if the failure came after the rename
+                std::error_code ignored;
+                std::filesystem::remove(pending.tempPath, ignored);
+            }
+        }
+        if (failures[i]) {
+            pending.done.set_exception(failures[i]);
+        } else {
+            pending.done.set_value();
+        }
+    }
+}
+
+} // namespace brightchain
@@ -0,0 +1,191 @@
+#include "brightchain/ingest_pipeline.hpp"
+#include "brightchain/cbl.hpp"
+#include "brightchain/extended_cbl.hpp"
+#include "brightchain/sha3_batch.hpp"
+#include "brightchain/super_cbl_builder.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <future>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace brightchain {
+
+namespace {
+
+/**
+ * Read until the buffer is full or the input ends.
+ * @return Bytes read
+ */
+size_t readChunk(int fd, uint8_t* buffer, size_t length) {
+    size_t total = 0;
+    while (total < length) {
+        ssize_t n = ::read(fd, buffer + total, length - total);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to read input: " +
+                                     std::string(std::strerror(errno)));
+        }
+        if (n == 0) {
+            break;
+        }
+        total += static_cast<size_t>(n);
+    }
+    return total;
+}
+
+/**
+ * Largest block length whose chunks are grouped to fill the SHA3 kernel's
+ * lanes; bigger blocks hash efficiently one at a time and a group of them
+ * would hold too much of the buffer budget in one task.
+ */
+constexpr size_t MAX_GROUPED_BLOCK_LENGTH = 64 * 1024;
+
+size_t headerSize(const IngestOptions& options) {
+    if (options.fileName.empty()) {
+        return CBLHeader::SIZE;
+    }
+    return CBLHeader::SIZE + ExtendedCBLMetadata{options.fileName, options.mimeType}.size();
+}
+
+} // namespace
+
+IngestPipeline::IngestPipeline(DiskBlockStore& store, ThreadPool& pool)
+    : store_(store), pool_(pool) {}
+
+size_t IngestPipeline::cblCapacity(const IngestOptions& options) const {
+    const size_t blockLength = blockSizeToLength(store_.blockSize());
+    const size_t overhead = headerSize(options);
+    return blockLength > overhead ? (blockLength - overhead) / Checksum::HASH_SIZE : 0;
+}
+
+IngestResult IngestPipeline::ingestFile(const std::filesystem::path& path,
+                                        const IngestOptions& options) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open input file: " + path.string());
+    }
+    // Readahead hint only; macOS has no posix_fadvise but can enable
+    // readahead per descriptor
+#if defined(POSIX_FADV_SEQUENTIAL)
+    (void)::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#elif defined(F_RDAHEAD)
+    (void)::fcntl(fd, F_RDAHEAD, 1);
+#endif
+
+    try {
+        IngestResult result = ingest(fd, options);
+        ::close(fd);
+        return result;
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+IngestResult IngestPipeline::ingest(int fd, const IngestOptions& options) {
+    const BlockSize blockSize = store_.blockSize();
+    const size_t blockLength = blockSizeToLength(blockSize);
+    // Small chunks are hashed in groups that fill every lane of the batch
+    // SHA3 kernel, as long as a group fits in the buffer budget
+    const size_t budgetBlocks = std::max<size_t>(options.maxBufferedBytes / blockLength, 1);
+    const size_t group =
+        blockLength <= MAX_GROUPED_BLOCK_LENGTH
+            ? std::min(sha3KernelLanes(sha3BestKernel()), budgetBlocks)
+            : 1;
+    // The group being read counts against the window, so at most
+    // window * group blocks are buffered at once
+    const size_t window = std::clamp<size_t>(budgetBlocks / group, 1, pool_.size() * 2);
+
+    SuperCBLBuilderOptions treeOptions;
+    treeOptions.creatorId = options.creatorId;
+    if (!options.fileName.empty()) {
+        treeOptions.metadata = ExtendedCBLMetadata{options.fileName, options.mimeType};
+    }
+    SuperCBLBuilder tree(store_, treeOptions, pool_);
+
+    ChecksumStream fileHasher;
+    IngestResult result;
+    std::deque<std::future<std::vector<Checksum>>> inFlight;
+    std::vector<std::vector<uint8_t>> chunks;
+    std::vector<size_t> lengths;
+
+    auto collectOldest = [&]() {
+        auto oldest = std::move(inFlight.front());
+        inFlight.pop_front();
+        for (const auto& address : oldest.get()) {
+            tree.add(address);
+        }
+    };
+
+    auto submitChunks = [&]() {
+        inFlight.push_back(pool_.submit(
+            [this, chunks = std::move(chunks), lengths = std::move(lengths), blockSize,
+             blockLength]() {
+                std::vector<const uint8_t*> blocks;
+                for (const auto& chunk : chunks) {
+                    blocks.push_back(chunk.data());
+                }
+                auto checksums = Checksum::fromBlocks(blocks, blockLength);
+                for (size_t i = 0; i < chunks.size(); ++i) {
+                    store_.put(checksums[i], chunks[i], BlockMetadata(blockSize, lengths[i]));
+                }
+                return checksums;
+            }));
+        chunks.clear();
+        lengths.clear();
+    };
+
+    try {
+        for (;;) {
+            if (chunks.empty() && inFlight.size() >= window) {
+                collectOldest();
+            }
+            std::vector<uint8_t> chunk(blockLength);
+            const size_t length = readChunk(fd, chunk.data(), blockLength);
+            if (length == 0) {
+                break;
+            }
+
+            fileHasher.update(chunk.data(), length);
+            result.originalDataLength += length;
+            ++result.blockCount;
+
+            chunks.push_back(std::move(chunk));
+            lengths.push_back(length);
+            if (chunks.size() == group) {
+                submitChunks();
+            }
+
+            if (length < blockLength) {
+                break;
+            }
+        }
+
+        if (!chunks.empty()) {
+            submitChunks();
+        }
+        while (!inFlight.empty()) {
+            collectOldest();
+        }
+    } catch (...) {
+        // Workers reference the store and pool; never leave them running
+        for (auto& pending : inFlight) {
+            pending.wait();
+        }
+        throw;
+    }
+
+    result.originalDataChecksum = fileHasher.finish();
+    auto built = tree.finish(result.originalDataLength, result.originalDataChecksum);
+    result.cblChecksum = built.root;
+    result.depth = built.depth;
+    return result;
+}
+
+} // namespace brightchain
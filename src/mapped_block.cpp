@@ -0,0 +1,159 @@
+#include "brightchain/mapped_block.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace brightchain {
+
+namespace {
+
+int toAdvice(AccessHint hint) {
+    switch (hint) {
+        case AccessHint::Sequential: return MADV_SEQUENTIAL;
+        case AccessHint::Random: return MADV_RANDOM;
+        case AccessHint::WillNeed: return MADV_WILLNEED;
+        case AccessHint::Normal:
+        default: return MADV_NORMAL;
+    }
+}
+
+} // namespace
+
+MappedBlock::MappedBlock(void* base, size_t mappedLength, const uint8_t* data, size_t size)
+    : base_(base), mappedLength_(mappedLength), data_(data), size_(size) {}
+
+MappedBlock::~MappedBlock() {
+    release();
+}
+
+MappedBlock::MappedBlock(MappedBlock&& other) noexcept
+    : base_(other.base_), mappedLength_(other.mappedLength_),
+      data_(other.data_), size_(other.size_) {
+    other.base_ = nullptr;
+    other.mappedLength_ = 0;
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+MappedBlock& MappedBlock::operator=(MappedBlock&& other) noexcept {
+    if (this != &other) {
+        release();
+        base_ = other.base_;
+        mappedLength_ = other.mappedLength_;
+        data_ = other.data_;
+        size_ = other.size_;
+        other.base_ = nullptr;
+        other.mappedLength_ = 0;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+void MappedBlock::release() {
+    if (base_) {
+        ::munmap(base_, mappedLength_);
+        base_ = nullptr;
+    }
+}
+
+MappedBlock MappedBlock::map(const std::filesystem::path& path, AccessHint hint) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed to open block file: " + path.string());
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        const int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(),
+                                "Failed to stat block file: " + path.string());
+    }
+
+    try {
+        MappedBlock block = map(fd, 0, static_cast<size_t>(st.st_size), hint);
+        ::close(fd);
+        return block;
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+MappedBlock MappedBlock::map(int fd, uint64_t offset, size_t length, AccessHint hint) {
+    if (length == 0) {
+        return MappedBlock();
+    }
+
+    static const uint64_t pageSize = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+    const uint64_t alignedOffset = offset - (offset % pageSize);
+    const size_t delta = static_cast<size_t>(offset - alignedOffset);
+    const size_t mappedLength = length + delta;
+
+    void* base = ::mmap(nullptr, mappedLength, PROT_READ, MAP_SHARED, fd,
+                        static_cast<off_t>(alignedOffset));
+    if (base == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "Failed to map block");
+    }
+
+    MappedBlock block(base, mappedLength, static_cast<const uint8_t*>(base) + delta, length);
+    block.advise(hint);
+    return block;
+}
+
+MappedBlock MappedBlock::mapPadded(const std::filesystem::path& path, size_t storedLength,
+                                   size_t paddedLength, uint8_t fill, AccessHint hint) {
+    if (storedLength > paddedLength) {
+        throw std::invalid_argument("Stored length exceeds padded length");
+    }
+    if (paddedLength == 0) {
+        return MappedBlock();
+    }
+
+    // Reserve the whole block in anonymous memory, then overlay the stored
+    // prefix from the file. Only the page holding the prefix/padding boundary
+    // is copied when the fill is written.
+    void* base = ::mmap(nullptr, paddedLength, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "Failed to map block");
+    }
+    MappedBlock block(base, paddedLength, static_cast<const uint8_t*>(base), paddedLength);
+
+    if (storedLength > 0) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(),
+                                    "Failed to open block file: " + path.string());
+        }
+        void* prefix = ::mmap(base, storedLength, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_FIXED, fd, 0);
+        const int error = errno;
+        ::close(fd);
+        if (prefix == MAP_FAILED) {
+            throw std::system_error(error, std::generic_category(), "Failed to map block");
+        }
+    }
+
+    std::memset(static_cast<uint8_t*>(base) + storedLength, fill, paddedLength - storedLength);
+    ::mprotect(base, paddedLength, PROT_READ);
+    block.advise(hint);
+    return block;
+}
+
+void MappedBlock::advise(AccessHint hint) const {
+    if (base_) {
+        // Advice is best effort; a failure only loses the readahead tuning
+        ::madvise(base_, mappedLength_, toAdvice(hint));
+    }
+}
+
+} // namespace brightchain
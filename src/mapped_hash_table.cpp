@@ -0,0 +1,290 @@
+#include "brightchain/mapped_hash_table.hpp"
+#include "file_io.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace brightchain {
+
+namespace {
+
+constexpr double MAX_LOAD = 0.7;
+
+std::string errnoMessage() {
+    return std::string(std::strerror(errno));
+}
+
+} // namespace
+
+Checksum MappedHashTable::key(const uint8_t* record) {
+    Checksum::HashArray hash;
+    std::memcpy(hash.data(), record, Checksum::HASH_SIZE);
+    return Checksum::fromHash(hash);
+}
+
+MappedHashTable::MappedHashTable(const std::filesystem::path& path, const Layout& layout)
+    : path_(path), layout_(layout) {
+    open();
+}
+
+MappedHashTable::MappedHashTable(const std::filesystem::path& path, const Layout& layout,
+                                 uint64_t slots, Fresh)
+    : path_(path), layout_(layout) {
+    std::filesystem::remove(path_);
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error(std::string("Failed to create ") + layout_.name + ": " +
+                                 path_.string());
+    }
+    try {
+        map(slots);
+    } catch (...) {
+        ::close(fd_);
+        throw;
+    }
+}
+
+void MappedHashTable::open() {
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error(std::string("Failed to open ") + layout_.name + ": " +
+                                 path_.string());
+    }
+
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) {
+        ::close(fd_);
+        throw std::runtime_error(std::string("Failed to stat ") + layout_.name + ": " +
+                                 path_.string());
+    }
+
+    try {
+        if (st.st_size == 0) {
+            map(INITIAL_SLOTS);
+        } else {
+            uint8_t header[HEADER_SIZE];
+            if (::pread(fd_, header, HEADER_SIZE, 0) != static_cast<ssize_t>(HEADER_SIZE) ||
+                readLE(header, 4) != layout_.magic || readLE(header + 4, 4) != layout_.version) {
+                throw std::runtime_error(std::string("Invalid ") + layout_.name + ": " +
+                                         path_.string());
+            }
+            uint64_t slots = readLE(header + 8, 8);
+            if (slots == 0 || (slots & (slots - 1)) != 0 ||
+                static_cast<uint64_t>(st.st_size) != HEADER_SIZE + slots * layout_.recordSize) {
+                throw std::runtime_error(std::string("Corrupt ") + layout_.name + ": " +
+                                         path_.string());
+            }
+            map(slots);
+            live_ = readLE(header + 16, 8);
+            tombstones_ = readLE(header + 24, 8);
+        }
+    } catch (...) {
+        unmap();
+        ::close(fd_);
+        fd_ = -1;
+        throw;
+    }
+}
+
+MappedHashTable::~MappedHashTable() {
+    unmap();
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+void MappedHashTable::map(uint64_t slots) {
+    const size_t length = HEADER_SIZE + slots * layout_.recordSize;
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) {
+        throw std::runtime_error(std::string("Failed to stat ") + layout_.name + ": " +
+                                 errnoMessage());
+    }
+    const bool fresh = st.st_size == 0;
+    if (static_cast<size_t>(st.st_size) < length &&
+        ::ftruncate(fd_, static_cast<off_t>(length)) != 0) {
+        throw std::runtime_error(std::string("Failed to size ") + layout_.name + ": " +
+                                 errnoMessage());
+    }
+
+    void* base = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error(std::string("Failed to map ") + layout_.name + ": " +
+                                 errnoMessage());
+    }
+
+    base_ = static_cast<uint8_t*>(base);
+    mappedLength_ = length;
+    slots_ = slots;
+    if (fresh) {
+        writeLE(base_, layout_.magic, 4);
+        writeLE(base_ + 4, layout_.version, 4);
+        writeLE(base_ + 8, slots_, 8);
+        live_ = 0;
+        tombstones_ = 0;
+        writeCounts();
+    }
+}
+
+void MappedHashTable::unmap() {
+    if (base_) {
+        ::munmap(base_, mappedLength_);
+        base_ = nullptr;
+        mappedLength_ = 0;
+    }
+}
+
+void MappedHashTable::writeCounts() {
+    writeLE(base_ + 16, live_, 8);
+    writeLE(base_ + 24, tombstones_, 8);
+}
+
+uint8_t* MappedHashTable::slot(uint64_t index) const {
+    return base_ + HEADER_SIZE + index * layout_.recordSize;
+}
+
+uint64_t MappedHashTable::homeSlot(const Checksum& checksum) const {
+    return readLE(checksum.hash().data() + 16, 8) & (slots_ - 1);
+}
+
+uint32_t MappedHashTable::flags(const uint8_t* record) const {
+    return static_cast<uint32_t>(readLE(record + layout_.flagsOffset, 4));
+}
+
+bool MappedHashTable::isLive(const uint8_t* record) const {
+    return (flags(record) & (FLAG_OCCUPIED | FLAG_TOMBSTONE)) == FLAG_OCCUPIED;
+}
+
+void MappedHashTable::markOccupied(uint8_t* record) const {
+    writeLE(record + layout_.flagsOffset, (flags(record) & ~FLAG_TOMBSTONE) | FLAG_OCCUPIED, 4);
+}
+
+uint64_t MappedHashTable::find(const Checksum& checksum) const {
+    uint64_t index = homeSlot(checksum);
+    for (uint64_t probe = 0; probe < slots_; ++probe) {
+        const uint8_t* record = slot(index);
+        const uint32_t recordFlags = flags(record);
+        if (recordFlags == 0) {
+            return slots_;
+        }
+        if ((recordFlags & FLAG_TOMBSTONE) == 0 &&
+            std::memcmp(record, checksum.hash().data(), Checksum::HASH_SIZE) == 0) {
+            return index;
+        }
+        index = (index + 1) & (slots_ - 1);
+    }
+    return slots_;
+}
+
+uint8_t* MappedHashTable::findOrInsert(const Checksum& checksum, bool& existed) {
+    uint64_t existing = find(checksum);
+    if (existing != slots_) {
+        existed = true;
+        return slot(existing);
+    }
+    existed = false;
+
+    if (live_ + tombstones_ + 1 > static_cast<uint64_t>(slots_ * MAX_LOAD)) {
+        grow();
+    }
+
+    uint64_t index = homeSlot(checksum);
+    for (;;) {
+        uint8_t* record = slot(index);
+        const uint32_t recordFlags = flags(record);
+        if (recordFlags == 0 || (recordFlags & FLAG_TOMBSTONE) != 0) {
+            if (recordFlags & FLAG_TOMBSTONE) {
+                --tombstones_;
+            }
+            std::memset(record, 0, layout_.recordSize);
+            std::memcpy(record, checksum.hash().data(), Checksum::HASH_SIZE);
+            writeLE(record + layout_.flagsOffset, FLAG_OCCUPIED, 4);
+            ++live_;
+            writeCounts();
+            return record;
+        }
+        index = (index + 1) & (slots_ - 1);
+    }
+}
+
+void MappedHashTable::place(const uint8_t* record) {
+    uint64_t index = homeSlot(key(record));
+    while (flags(slot(index)) != 0) {
+        index = (index + 1) & (slots_ - 1);
+    }
+    std::memcpy(slot(index), record, layout_.recordSize);
+    ++live_;
+}
+
+void MappedHashTable::grow() {
+    // Double when genuinely full; rehash in place-size when tombstones dominate
+    const uint64_t newSlots =
+        live_ + 1 > static_cast<uint64_t>(slots_ * MAX_LOAD / 2) ? slots_ * 2 : slots_;
+
+    auto tmpPath = path_;
+    tmpPath += ".tmp";
+    {
+        MappedHashTable rebuilt(tmpPath, layout_, newSlots, Fresh{});
+        for (uint64_t index = 0; index < slots_; ++index) {
+            if (isLive(slot(index))) {
+                rebuilt.place(slot(index));
+            }
+        }
+        rebuilt.writeCounts();
+        rebuilt.sync();
+    }
+
+    std::filesystem::rename(tmpPath, path_);
+    syncDirectory(path_.parent_path().empty() ? "." : path_.parent_path());
+
+    unmap();
+    ::close(fd_);
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd_ < 0) {
+        throw std::runtime_error(std::string("Failed to reopen ") + layout_.name + ": " +
+                                 path_.string());
+    }
+    map(newSlots);
+    live_ = readLE(base_ + 16, 8);
+    tombstones_ = 0;
+}
+
+bool MappedHashTable::erase(const Checksum& checksum) {
+    std::unique_lock lock(mutex_);
+    const uint64_t index = find(checksum);
+    if (index == slots_) {
+        return false;
+    }
+
+    writeLE(slot(index) + layout_.flagsOffset, FLAG_OCCUPIED | FLAG_TOMBSTONE, 4);
+    --live_;
+    ++tombstones_;
+    writeCounts();
+    return true;
+}
+
+size_t MappedHashTable::size() const {
+    std::shared_lock lock(mutex_);
+    return static_cast<size_t>(live_);
+}
+
+uint64_t MappedHashTable::slotCount() const {
+    std::shared_lock lock(mutex_);
+    return slots_;
+}
+
+void MappedHashTable::sync() const {
+    // grow() replaces the mapping under the exclusive lock
+    std::shared_lock lock(mutex_);
+    if (base_ && ::msync(base_, mappedLength_, MS_SYNC) != 0) {
+        throw std::runtime_error(std::string("Failed to sync ") + layout_.name + ": " +
+                                 errnoMessage());
+    }
+}
+
+} // namespace brightchain
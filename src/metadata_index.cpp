@@ -0,0 +1,108 @@
+#include "brightchain/metadata_index.hpp"
+#include "file_io.hpp"
+#include <cstring>
+
+namespace brightchain {
+
+namespace {
+
+constexpr MappedHashTable::Layout INDEX_LAYOUT{
+    0x58494D42, // "BMIX" little-endian
+    1,
+    MetadataIndex::RECORD_SIZE,
+    84,
+    "metadata index",
+};
+
+} // namespace
+
+MetadataIndex::MetadataIndex(const std::filesystem::path& path) : table_(path, INDEX_LAYOUT) {}
+
+void MetadataIndex::writeRecord(uint8_t* record, const BlockMetadata& metadata,
+                                const std::optional<VirtualPadding>& padding) {
+    writeLE(record + 64, static_cast<uint64_t>(toUnixMillis(metadata.created_at)), 8);
+    writeLE(record + 72, metadata.length_without_padding, 8);
+    writeLE(record + 80, static_cast<uint32_t>(metadata.size), 4);
+    std::memset(record + 88, 0, 8);
+    uint32_t flags = MappedHashTable::FLAG_OCCUPIED | FLAG_CREATED_AT_MILLIS;
+    if (padding) {
+        record[88] = padding->fill;
+        writeLE(record + 92, padding->storedLength, 4);
+        flags |= FLAG_VIRTUAL_PADDING;
+    }
+    writeLE(record + 84, flags, 4);
+}
+
+std::optional<VirtualPadding> MetadataIndex::readPadding(const uint8_t* record) {
+    if ((readLE(record + 84, 4) & FLAG_VIRTUAL_PADDING) == 0) {
+        return std::nullopt;
+    }
+    return VirtualPadding{static_cast<uint32_t>(readLE(record + 92, 4)), record[88]};
+}
+
+BlockMetadata MetadataIndex::readRecord(const uint8_t* record) {
+    const auto createdAt = static_cast<int64_t>(readLE(record + 64, 8));
+    auto created = (readLE(record + 84, 4) & FLAG_CREATED_AT_MILLIS)
+                       ? fromUnixMillis(createdAt)
+                       : std::chrono::system_clock::from_time_t(static_cast<std::time_t>(createdAt));
+    return BlockMetadata(static_cast<BlockSize>(readLE(record + 80, 4)),
+                         static_cast<size_t>(readLE(record + 72, 8)), created);
+}
+
+void MetadataIndex::put(const Checksum& checksum, const BlockMetadata& metadata) {
+    table_.write(checksum, [&metadata](uint8_t* record, bool existed) {
+        writeRecord(record, metadata, existed ? readPadding(record) : std::nullopt);
+    });
+}
+
+void MetadataIndex::put(const Checksum& checksum, const BlockMetadata& metadata,
+                        const std::optional<VirtualPadding>& padding) {
+    table_.write(checksum, [&](uint8_t* record, bool) { writeRecord(record, metadata, padding); });
+}
+
+std::optional<BlockMetadata> MetadataIndex::get(const Checksum& checksum) const {
+    return table_.read(checksum, [](const uint8_t* record) -> std::optional<BlockMetadata> {
+        if (!record) {
+            return std::nullopt;
+        }
+        return readRecord(record);
+    });
+}
+
+bool MetadataIndex::has(const Checksum& checksum) const {
+    return table_.read(checksum, [](const uint8_t* record) { return record != nullptr; });
+}
+
+std::optional<VirtualPadding> MetadataIndex::padding(const Checksum& checksum) const {
+    return table_.read(checksum, [](const uint8_t* record) -> std::optional<VirtualPadding> {
+        if (!record) {
+            return std::nullopt;
+        }
+        return readPadding(record);
+    });
+}
+
+bool MetadataIndex::remove(const Checksum& checksum) {
+    return table_.erase(checksum);
+}
+
+void MetadataIndex::forEach(
+    const std::function<void(const Checksum&, const BlockMetadata&)>& callback) const {
+    table_.forEach([&callback](const uint8_t* record) {
+        callback(MappedHashTable::key(record), readRecord(record));
+    });
+}
+
+size_t MetadataIndex::size() const {
+    return table_.size();
+}
+
+uint64_t MetadataIndex::slotCount() const {
+    return table_.slotCount();
+}
+
+void MetadataIndex::sync() const {
+    table_.sync();
+}
+
+} // namespace brightchain
@@ -0,0 +1,636 @@
+#include "brightchain/packed_segment_store.hpp"
+#include "file_io.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+
+namespace brightchain {
+
+namespace {
+
+constexpr uint32_t SEGMENT_MAGIC = 0x32504342;        // "BCP2" little-endian
+constexpr size_t CRC_OFFSET = PackedSegmentStore::ENTRY_HEADER_SIZE - 4;
+constexpr uint8_t FLAG_CREATED_AT_MILLIS = 1u << 0;
+constexpr size_t RESYNC_WINDOW = 64 * 1024;
+
+/**
+ * CRC-32C (Castagnoli), bitwise-reflected table implementation.
+ */
+uint32_t crc32c(uint32_t crc, const uint8_t* data, size_t length) {
+    static const auto table = []() {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t i = 0; i < entries.size(); ++i) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) ? (value >> 1) ^ 0x82F63B78u : value >> 1;
+            }
+            entries[i] = value;
+        }
+        return entries;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * CRC of an assembled entry: the header up to the CRC field, then the data.
+ */
+uint32_t entryCrc(const uint8_t* entry, uint32_t length) {
+    uint32_t crc = crc32c(0, entry, CRC_OFFSET);
+    return crc32c(crc, entry + PackedSegmentStore::ENTRY_HEADER_SIZE, length);
+}
+
+/**
+ * Fill in the header and CRC of an entry whose data is already in place.
+ * @param createdAt Milliseconds since the epoch
+ */
+void encodeEntry(uint8_t* entry, uint8_t type, const Checksum& checksum, uint32_t length,
+                 BlockSize size, int64_t createdAt, uint64_t lengthWithoutPadding) {
+    std::memset(entry, 0, PackedSegmentStore::ENTRY_HEADER_SIZE);
+    writeLE(entry, SEGMENT_MAGIC, 4);
+    entry[4] = type;
+    entry[5] = FLAG_CREATED_AT_MILLIS;
+    writeLE(entry + 8, length, 4);
+    writeLE(entry + 12, static_cast<uint32_t>(size), 4);
+    writeLE(entry + 16, static_cast<uint64_t>(createdAt), 8);
+    writeLE(entry + 24, lengthWithoutPadding, 8);
+    std::memcpy(entry + 32, checksum.hash().data(), Checksum::HASH_SIZE);
+    writeLE(entry + CRC_OFFSET, entryCrc(entry, length), 4);
+}
+
+/**
+ * Creation time of an entry in milliseconds since the epoch.
+ */
+int64_t entryCreatedAt(const uint8_t* header) {
+    const auto value = static_cast<int64_t>(readLE(header + 16, 8));
+    return (header[5] & FLAG_CREATED_AT_MILLIS) ? value : value * 1000;
+}
+
+Checksum entryChecksum(const uint8_t* header) {
+    Checksum::HashArray hash;
+    std::memcpy(hash.data(), header + 32, Checksum::HASH_SIZE);
+    return Checksum::fromHash(hash);
+}
+
+/**
+ * Read and verify the entry at offset into entry (header followed by data).
+ * @return The data length, or nullopt if no intact entry starts there
+ */
+std::optional<uint32_t> readEntry(int fd, uint64_t offset, uint64_t fileSize,
+                                  std::vector<uint8_t>& entry) {
+    constexpr size_t headerSize = PackedSegmentStore::ENTRY_HEADER_SIZE;
+    if (offset + headerSize > fileSize || !readFully(fd, entry.data(), headerSize, offset) ||
+        readLE(entry.data(), 4) != SEGMENT_MAGIC) {
+        return std::nullopt;
+    }
+
+    const uint32_t length = static_cast<uint32_t>(readLE(entry.data() + 8, 4));
+    if (length > entry.size() - headerSize || offset + headerSize + length > fileSize ||
+        (length > 0 && !readFully(fd, entry.data() + headerSize, length, offset + headerSize))) {
+        return std::nullopt;
+    }
+    if (entryCrc(entry.data(), length) != readLE(entry.data() + CRC_OFFSET, 4)) {
+        return std::nullopt;
+    }
+    return length;
+}
+
+/**
+ * Find the next intact entry at or after from.
+ * @return Its offset, or fileSize if there is none
+ */
+uint64_t findNextEntry(int fd, uint64_t from, uint64_t fileSize, std::vector<uint8_t>& entry) {
+    uint8_t magic[4];
+    writeLE(magic, SEGMENT_MAGIC, 4);
+
+    std::vector<uint8_t> window(RESYNC_WINDOW);
+    uint64_t start = from;
+    while (start + PackedSegmentStore::ENTRY_HEADER_SIZE <= fileSize) {
+        const size_t length =
+            static_cast<size_t>(std::min<uint64_t>(window.size(), fileSize - start));
+        if (!readFully(fd, window.data(), length, start)) {
+            break;
+        }
+        for (size_t i = 0; i + sizeof(magic) <= length; ++i) {
+            if (std::memcmp(window.data() + i, magic, sizeof(magic)) == 0 &&
+                readEntry(fd, start + i, fileSize, entry)) {
+                return start + i;
+            }
+        }
+        // Overlap windows so a magic split across the boundary is not missed
+        start += length - (sizeof(magic) - 1);
+    }
+    return fileSize;
+}
+
+} // namespace
+
+PackedSegmentStore::PackedSegmentStore(const std::filesystem::path& directory,
+                                       BlockSize blockSize, uint64_t maxSegmentSize,
+                                       double compactionThreshold)
+    : directory_(directory), blockSize_(blockSize), maxSegmentSize_(maxSegmentSize),
+      compactionThreshold_(compactionThreshold) {
+    if (maxSegmentSize_ < ENTRY_HEADER_SIZE + blockSizeToLength(blockSize)) {
+        throw std::invalid_argument("Segment size too small for block size");
+    }
+    if (!(compactionThreshold_ > 0)) {
+        throw std::invalid_argument("Compaction threshold must be positive");
+    }
+
+    std::filesystem::create_directories(directory_);
+    loadSegments();
+}
+
+PackedSegmentStore::~PackedSegmentStore() {
+    for (int fd : segmentFds_) {
+        ::close(fd);
+    }
+    for (int fd : retiredFds_) {
+        ::close(fd);
+    }
+}
+
+std::filesystem::path PackedSegmentStore::segmentPath(uint32_t segment) const {
+    std::ostringstream name;
+    name << std::setw(8) << std::setfill('0') << segment << ".seg";
+    return directory_ / name.str();
+}
+
+void PackedSegmentStore::loadSegments() {
+    uint32_t segments = 0;
+    while (std::filesystem::exists(segmentPath(segments))) {
+        ++segments;
+    }
+
+    for (uint32_t segment = 0; segment < segments; ++segment) {
+        auto path = segmentPath(segment);
+        int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open segment: " + path.string());
+        }
+        segmentFds_.push_back(fd);
+        segmentStats_.emplace_back();
+        scanSegment(segment, fd, segment + 1 == segments);
+    }
+
+    if (segmentFds_.empty()) {
+        openNewSegment();
+    }
+}
+
+void PackedSegmentStore::scanSegment(uint32_t segment, int fd, bool active) {
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        throw std::runtime_error("Failed to stat segment: " + segmentPath(segment).string());
+    }
+    const uint64_t fileSize = static_cast<uint64_t>(st.st_size);
+
+    std::vector<uint8_t> entry(ENTRY_HEADER_SIZE + blockSizeToLength(blockSize_));
+    uint64_t offset = 0;
+    uint64_t validEnd = 0;
+    while (offset < fileSize) {
+        auto length = readEntry(fd, offset, fileSize, entry);
+        if (!length) {
+            // Damaged entry: resume at the next one that verifies. Nothing
+            // intact after it means a torn tail (or a damaged sealed tail).
+            const uint64_t next = findNextEntry(fd, offset + 1, fileSize, entry);
+            if (next == fileSize) {
+                break;
+            }
+            damagedBytes_ += next - offset;
+            segmentStats_[segment].keep = true;
+            offset = next;
+            length = readEntry(fd, offset, fileSize, entry);
+        }
+
+        const uint8_t* header = entry.data();
+        auto type = static_cast<EntryType>(header[4]);
+        uint64_t dataOffset = offset + ENTRY_HEADER_SIZE;
+        Checksum checksum = entryChecksum(header);
+
+        auto existing = index_.find(checksum);
+        switch (type) {
+            case EntryType::Block: {
+                if (existing != index_.end()) {
+                    deadBytes_ += ENTRY_HEADER_SIZE + existing->second.length;
+                    segmentStats_[existing->second.segment].reclaimableBytes +=
+                        ENTRY_HEADER_SIZE + existing->second.length;
+                }
+                index_[checksum] = Location{
+                    segment, dataOffset, *length,
+                    static_cast<BlockSize>(readLE(header + 12, 4)),
+                    entryCreatedAt(header),
+                    readLE(header + 24, 8)};
+                break;
+            }
+            case EntryType::Metadata:
+                if (existing != index_.end()) {
+                    existing->second.size = static_cast<BlockSize>(readLE(header + 12, 4));
+                    existing->second.createdAt = entryCreatedAt(header);
+                    existing->second.lengthWithoutPadding = readLE(header + 24, 8);
+                }
+                deadBytes_ += ENTRY_HEADER_SIZE;
+                break;
+            case EntryType::Tombstone:
+                if (existing != index_.end()) {
+                    deadBytes_ += ENTRY_HEADER_SIZE + existing->second.length;
+                    segmentStats_[existing->second.segment].reclaimableBytes +=
+                        ENTRY_HEADER_SIZE + existing->second.length;
+                    index_.erase(existing);
+                }
+                deadBytes_ += ENTRY_HEADER_SIZE;
+                break;
+            default:
+                throw std::runtime_error("Unknown segment entry type in " +
+                                         segmentPath(segment).string());
+        }
+
+        offset = dataOffset + *length;
+        validEnd = offset;
+    }
+
+    segmentStats_[segment].length = fileSize;
+    if (validEnd == fileSize) {
+        if (active) {
+            activeOffset_ = validEnd;
+        }
+        return;
+    }
+
+    if (!active) {
+        // Sealed segments are never appended to again; keep the damaged
+        // bytes for inspection rather than cutting blocks out of the file.
+        damagedBytes_ += fileSize - validEnd;
+        segmentStats_[segment].keep = true;
+        return;
+    }
+
+    // Only the active segment can have a torn tail from an interrupted append
+    if (::ftruncate(fd, static_cast<off_t>(validEnd)) != 0) {
+        throw std::runtime_error("Failed to truncate segment: " +
+                                 segmentPath(segment).string());
+    }
+    activeOffset_ = validEnd;
+}
+
+void PackedSegmentStore::openNewSegment() {
+    auto path = segmentPath(static_cast<uint32_t>(segmentFds_.size()));
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed to create segment: " + path.string());
+    }
+
+    // Make the new segment's directory entry durable; rare enough to do eagerly
+    int dirFd = ::open(directory_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+
+    std::unique_lock lock(indexMutex_);
+    if (!segmentStats_.empty()) {
+        segmentStats_.back().length = activeOffset_;
+    }
+    segmentFds_.push_back(fd);
+    segmentStats_.emplace_back();
+    activeOffset_ = 0;
+}
+
+void PackedSegmentStore::sync() {
+    std::vector<int> fds;
+    {
+        std::lock_guard writeLock(writeMutex_);
+        fds.assign(segmentFds_.begin() + static_cast<std::ptrdiff_t>(firstUnsynced_),
+                   segmentFds_.end());
+        firstUnsynced_ = segmentFds_.size() - 1;
+    }
+
+    for (int fd : fds) {
+        if (syncData(fd) != 0) {
+            throw std::runtime_error("Failed to sync segment: " +
+                                     std::string(std::strerror(errno)));
+        }
+    }
+}
+
+void PackedSegmentStore::append(EntryType type, const Checksum& checksum,
+                                std::span<const uint8_t> data,
+                                const BlockMetadata& metadata) {
+    const uint32_t length = static_cast<uint32_t>(data.size());
+    if (activeOffset_ + ENTRY_HEADER_SIZE + length > maxSegmentSize_) {
+        openNewSegment();
+        // Removals while it was active may already warrant a compaction
+        maybeCompact(static_cast<uint32_t>(segmentFds_.size() - 2));
+    }
+
+    // Entries are at most one Small block, so assemble them on the stack
+    std::array<uint8_t, ENTRY_HEADER_SIZE + blockSizeToLength(BlockSize::Small)> entry;
+    const size_t entryLength = ENTRY_HEADER_SIZE + length;
+    const int64_t createdAt = toUnixMillis(metadata.created_at);
+    if (length > 0) {
+        std::memcpy(entry.data() + ENTRY_HEADER_SIZE, data.data(), length);
+    }
+    encodeEntry(entry.data(), static_cast<uint8_t>(type), checksum, length, metadata.size,
+                createdAt, metadata.length_without_padding);
+
+    writeFully(segmentFds_.back(), entry.data(), entryLength, activeOffset_);
+
+    const uint32_t segment = static_cast<uint32_t>(segmentFds_.size() - 1);
+    const uint64_t dataOffset = activeOffset_ + ENTRY_HEADER_SIZE;
+    activeOffset_ += entryLength;
+
+    std::optional<uint32_t> reclaimed;
+    {
+        std::unique_lock lock(indexMutex_);
+        auto existing = index_.find(checksum);
+        switch (type) {
+            case EntryType::Block:
+                index_[checksum] = Location{segment, dataOffset, length, metadata.size,
+                                            createdAt, metadata.length_without_padding};
+                break;
+            case EntryType::Metadata:
+                if (existing != index_.end()) {
+                    existing->second.size = metadata.size;
+                    existing->second.createdAt = createdAt;
+                    existing->second.lengthWithoutPadding = metadata.length_without_padding;
+                }
+                deadBytes_ += ENTRY_HEADER_SIZE;
+                break;
+            case EntryType::Tombstone:
+                if (existing != index_.end()) {
+                    deadBytes_ += ENTRY_HEADER_SIZE + existing->second.length;
+                    reclaimed = existing->second.segment;
+                    segmentStats_[*reclaimed].reclaimableBytes +=
+                        ENTRY_HEADER_SIZE + existing->second.length;
+                    index_.erase(existing);
+                }
+                deadBytes_ += ENTRY_HEADER_SIZE;
+                break;
+        }
+    }
+
+    if (reclaimed) {
+        maybeCompact(*reclaimed);
+    }
+}
+
+void PackedSegmentStore::maybeCompact(uint32_t segment) {
+    const SegmentStats& stats = segmentStats_[segment];
+    if (segment + 1 >= segmentFds_.size() || stats.keep || stats.reclaimableBytes == 0 ||
+        static_cast<double>(stats.reclaimableBytes) <
+            compactionThreshold_ * static_cast<double>(stats.length)) {
+        return;
+    }
+
+    try {
+        compactSegment(segment);
+    } catch (const std::exception&) {
+        // The segment is still intact; its space is reclaimed after a reopen
+        segmentStats_[segment].keep = true;
+    }
+}
+
+void PackedSegmentStore::compactSegment(uint32_t segment) {
+    SegmentStats& stats = segmentStats_[segment];
+    const int fd = segmentFds_[segment];
+
+    // Entries are dropped because later segments supersede them, so those
+    // must be durable before the compacted segment replaces this one
+    for (size_t later = std::max<size_t>(firstUnsynced_, segment + 1);
+         later < segmentFds_.size(); ++later) {
+        if (syncData(segmentFds_[later]) != 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to sync segment");
+        }
+    }
+
+    const auto path = segmentPath(segment);
+    auto tempPath = path;
+    tempPath += ".compact";
+    int out = ::open(tempPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed to create segment: " + tempPath.string());
+    }
+
+    // Only writers change the index, and they hold writeMutex_ as we do
+    std::vector<uint8_t> entry(ENTRY_HEADER_SIZE + blockSizeToLength(blockSize_));
+    std::vector<std::pair<Checksum, uint64_t>> moved;
+    std::unordered_set<Checksum> metadataKept;
+    uint64_t offset = 0;
+    uint64_t outOffset = 0;
+    uint64_t dropped = 0;
+    try {
+        while (offset < stats.length) {
+            auto length = readEntry(fd, offset, stats.length, entry);
+            if (!length) {
+                throw std::runtime_error("Damaged segment entry in " + path.string());
+            }
+            const uint64_t entryLength = ENTRY_HEADER_SIZE + *length;
+            const Checksum checksum = entryChecksum(entry.data());
+            auto live = index_.find(checksum);
+
+            bool keep = false;
+            switch (static_cast<EntryType>(entry[4])) {
+                case EntryType::Block:
+                    keep = live != index_.end() && live->second.segment == segment &&
+                           live->second.offset == offset + ENTRY_HEADER_SIZE;
+                    break;
+                case EntryType::Metadata:
+                    // Later segments replay their own entries; this one only
+                    // matters for a block stored in an older segment
+                    keep = live != index_.end() && live->second.segment < segment &&
+                           metadataKept.insert(checksum).second;
+                    break;
+                case EntryType::Tombstone:
+                    keep = live == index_.end();
+                    break;
+            }
+
+            if (keep) {
+                if (live != index_.end()) {
+                    // Fold the current metadata into the entry that is kept
+                    const Location& location = live->second;
+                    encodeEntry(entry.data(), entry[4], checksum, *length, location.size,
+                                location.createdAt, location.lengthWithoutPadding);
+                    if (static_cast<EntryType>(entry[4]) == EntryType::Block) {
+                        moved.emplace_back(checksum, outOffset + ENTRY_HEADER_SIZE);
+                    }
+                }
+                writeFully(out, entry.data(), entryLength, outOffset);
+                outOffset += entryLength;
+            } else {
+                dropped += entryLength;
+            }
+            offset += entryLength;
+        }
+
+        if (syncData(out) != 0) {
+            throw std::system_error(errno, std::generic_category(),
+                                    "Failed to sync segment: " + tempPath.string());
+        }
+        if (::rename(tempPath.c_str(), path.c_str()) != 0) {
+            throw std::system_error(errno, std::generic_category(),
+                                    "Failed to replace segment: " + path.string());
+        }
+    } catch (...) {
+        ::close(out);
+        std::error_code ignored;
+        std::filesystem::remove(tempPath, ignored);
+        throw;
+    }
+
+    {
+        std::unique_lock lock(indexMutex_);
+        for (const auto& [checksum, dataOffset] : moved) {
+            index_[checksum].offset = dataOffset;
+        }
+        segmentFds_[segment] = out;
+        // Readers may still hold the old descriptor, so it stays open
+        retiredFds_.push_back(fd);
+        deadBytes_ -= std::min(deadBytes_, dropped);
+        ++compactions_;
+    }
+    stats.length = outOffset;
+    stats.reclaimableBytes = 0;
+
+    syncDirectory(directory_);
+}
+
+void PackedSegmentStore::put(const Checksum& checksum, std::span<const uint8_t> data,
+                             const BlockMetadata& metadata) {
+    if (data.size() > blockSizeToLength(blockSize_)) {
+        throw std::invalid_argument("Data length exceeds block size");
+    }
+
+    std::lock_guard writeLock(writeMutex_);
+    if (has(checksum)) {
+        append(EntryType::Metadata, checksum, {}, metadata);
+        return;
+    }
+    append(EntryType::Block, checksum, data, metadata);
+}
+
+std::pair<PackedSegmentStore::Location, int> PackedSegmentStore::locate(
+    const Checksum& checksum) const {
+    std::shared_lock lock(indexMutex_);
+    auto it = index_.find(checksum);
+    if (it == index_.end()) {
+        throw std::runtime_error("Block not found: " + checksum.toHex());
+    }
+    return {it->second, segmentFds_[it->second.segment]};
+}
+
+std::vector<uint8_t> PackedSegmentStore::get(const Checksum& checksum) const {
+    auto [location, fd] = locate(checksum);
+
+    std::vector<uint8_t> data(location.length);
+    if (!readFully(fd, data.data(), data.size(), location.offset)) {
+        throw std::runtime_error("Truncated segment entry: " + checksum.toHex());
+    }
+    return data;
+}
+
+size_t PackedSegmentStore::read(const Checksum& checksum, std::span<uint8_t> out) const {
+    auto [location, fd] = locate(checksum);
+    if (location.length > out.size()) {
+        throw std::runtime_error("Buffer too small for block: " + checksum.toHex());
+    }
+    if (!readFully(fd, out.data(), location.length, location.offset)) {
+        throw std::runtime_error("Truncated segment entry: " + checksum.toHex());
+    }
+    return location.length;
+}
+
+MappedBlock PackedSegmentStore::getMapped(const Checksum& checksum, AccessHint hint) const {
+    auto [location, fd] = locate(checksum);
+    return MappedBlock::map(fd, location.offset, location.length, hint);
+}
+
+bool PackedSegmentStore::has(const Checksum& checksum) const {
+    std::shared_lock lock(indexMutex_);
+    return index_.find(checksum) != index_.end();
+}
+
+bool PackedSegmentStore::remove(const Checksum& checksum) {
+    std::lock_guard writeLock(writeMutex_);
+    if (!has(checksum)) {
+        return false;
+    }
+    append(EntryType::Tombstone, checksum, {}, BlockMetadata(blockSize_, 0));
+    return true;
+}
+
+void PackedSegmentStore::putMetadata(const Checksum& checksum, const BlockMetadata& metadata) {
+    std::lock_guard writeLock(writeMutex_);
+    if (!has(checksum)) {
+        throw std::runtime_error("Block not found: " + checksum.toHex());
+    }
+    append(EntryType::Metadata, checksum, {}, metadata);
+}
+
+std::optional<BlockMetadata> PackedSegmentStore::getMetadata(const Checksum& checksum) const {
+    std::shared_lock lock(indexMutex_);
+    auto it = index_.find(checksum);
+    if (it == index_.end()) {
+        return std::nullopt;
+    }
+    const Location& location = it->second;
+    return BlockMetadata(location.size, location.lengthWithoutPadding,
+                         fromUnixMillis(location.createdAt));
+}
+
+void PackedSegmentStore::forEach(const std::function<void(const Checksum&)>& callback) const {
+    std::vector<Checksum> checksums;
+    {
+        std::shared_lock lock(indexMutex_);
+        checksums.reserve(index_.size());
+        for (const auto& entry : index_) {
+            checksums.push_back(entry.first);
+        }
+    }
+    for (const auto& checksum : checksums) {
+        callback(checksum);
+    }
+}
+
+size_t PackedSegmentStore::size() const {
+    std::shared_lock lock(indexMutex_);
+    return index_.size();
+}
+
+size_t PackedSegmentStore::segmentCount() const {
+    std::shared_lock lock(indexMutex_);
+    return segmentFds_.size();
+}
+
+uint64_t PackedSegmentStore::deadBytes() const {
+    std::shared_lock lock(indexMutex_);
+    return deadBytes_;
+}
+
+uint64_t PackedSegmentStore::compactionCount() const {
+    std::shared_lock lock(indexMutex_);
+    return compactions_;
+}
+
+uint64_t PackedSegmentStore::damagedBytes() const {
+    std::shared_lock lock(indexMutex_);
+    return damagedBytes_;
+}
+
+} // namespace brightchain
@@ -1,10 +1,9 @@
 #include "brightchain/paillier.hpp"
 #include "brightchain/hmac_drbg.hpp"
+#include "brightchain/secp256k1.hpp"
 #include <openssl/bn.h>
 #include <openssl/evp.h>
 #include <openssl/kdf.h>
-#include <openssl/ec.h>
-#include <openssl/obj_mac.h>
 #include <openssl/hmac.h>
 #include <nlohmann/json.hpp>
 #include <stdexcept>
@@ -472,25 +471,8 @@ PaillierKeyPair deriveVotingKeysFromECDH(
     int primeTestIterations) {
     
     // 1. Compute ECDH shared secret (FULL 65 bytes with 0x04 prefix)
-    EC_KEY* ec_key = EC_KEY_new_by_curve_name(NID_secp256k1);
-    BIGNUM* priv_bn = bytes_to_bn(ecdhPrivateKey);
-    EC_KEY_set_private_key(ec_key, priv_bn);
-    
-    EC_POINT* pub_point = EC_POINT_new(EC_KEY_get0_group(ec_key));
-    EC_POINT_oct2point(EC_KEY_get0_group(ec_key), pub_point, 
-                       ecdhPublicKey.data(), ecdhPublicKey.size(), nullptr);
-    
-    // Compute actual ECDH (multiply point by private key)
-    EC_POINT* result_point = EC_POINT_new(EC_KEY_get0_group(ec_key));
-    EC_POINT_mul(EC_KEY_get0_group(ec_key), result_point, nullptr, pub_point, priv_bn, nullptr);
-    
-    // Get FULL uncompressed point (65 bytes with 0x04 prefix) for maximum entropy
-    // This includes both X and Y coordinates - cryptographically superior to X alone
-    size_t shared_secret_len = 65;
-    std::vector<uint8_t> shared_secret(shared_secret_len);
-    EC_POINT_point2oct(EC_KEY_get0_group(ec_key), result_point,
-                       POINT_CONVERSION_UNCOMPRESSED,
-                       shared_secret.data(), shared_secret_len, nullptr);
+    // Includes both X and Y coordinates - cryptographically superior to X alone
+    const auto shared_secret = Secp256k1::ecdhPoint(ecdhPrivateKey, ecdhPublicKey);
     
     // Debug output
     std::cout << "\nC++ Shared Secret (65 bytes, full uncompressed point): ";
@@ -563,7 +545,6 @@ PaillierKeyPair deriveVotingKeysFromECDH(
         bn_to_bytes(p), bn_to_bytes(q));
     
     // Cleanup
-    BN_free(priv_bn);
     BN_free(p);
     BN_free(q);
     BN_free(n);
@@ -578,9 +559,6 @@ PaillierKeyPair deriveVotingKeysFromECDH(
     BN_free(gcd_val);
     BN_free(temp);
     BN_CTX_free(ctx);
-    EC_KEY_free(ec_key);
-    EC_POINT_free(pub_point);
-    EC_POINT_free(result_point);
     
     return {publicKey, privateKey};
 }
@@ -0,0 +1,191 @@
+#include "brightchain/range_reader.hpp"
+#include "brightchain/cbl_view.hpp"
+#include "brightchain/xor_blocks.hpp"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <stdexcept>
+
+namespace brightchain {
+
+RangeReader::RangeReader(DiskBlockStore& store, const Checksum& root, size_t nodeCacheSize,
+                         ThreadPool& pool)
+    : store_(store), pool_(pool), root_(root),
+      blockLength_(blockSizeToLength(store.blockSize())),
+      cacheCapacity_(std::max<size_t>(nodeCacheSize, 1)) {
+    superFanout_ = (blockLength_ - SuperCBLHeader::SIZE) / Checksum::HASH_SIZE;
+
+    auto node = loadNode(root_);
+    size_ = node->originalDataLength;
+
+    // The leftmost leaf fixes the tuple size for the whole tree
+    while (node->tupleSize == 0) {
+        if (node->children.empty()) {
+            throw std::runtime_error("SuperCBL has no children: " + root.toHex());
+        }
+        node = loadNode(node->children.front().toChecksum());
+    }
+    // ExtendedCBL leaves (with the same metadata throughout) hold fewer addresses
+    tuplesPerLeaf_ = ((blockLength_ - node->overhead) / Checksum::HASH_SIZE) / node->tupleSize;
+}
+
+size_t RangeReader::nodeLoads() const {
+    std::lock_guard lock(cacheMutex_);
+    return nodeLoads_;
+}
+
+std::shared_ptr<const RangeReader::Node> RangeReader::loadNode(const Checksum& checksum) {
+    {
+        std::lock_guard lock(cacheMutex_);
+        auto it = cache_.find(checksum);
+        if (it != cache_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second.second);
+            return it->second.first;
+        }
+    }
+
+    // Nodes are parsed in place over the mapping; the node keeps it alive
+    auto node = std::make_shared<Node>();
+    node->block = store_.getMapped(checksum, AccessHint::Random);
+    auto bytes = node->block.span();
+    if (bytes.size() < 2) {
+        throw std::runtime_error("Block is not a CBL: " + checksum.toHex());
+    }
+
+    try {
+        if (bytes[1] == static_cast<uint8_t>(StructuredBlockType::SuperCBL)) {
+            SuperCBLView super(bytes);
+            node->children = super.subCblChecksums();
+            node->depth = std::max<uint16_t>(super.depth(), 1);
+            node->originalDataLength = super.originalDataLength();
+        } else {
+            CBLView cbl(bytes);
+            node->children = cbl.addresses();
+            node->tupleSize = std::max<uint32_t>(cbl.tupleSize(), 1);
+            node->overhead = cbl.layerOverheadSize();
+            node->originalDataLength = cbl.originalDataLength();
+        }
+    } catch (const std::invalid_argument& e) {
+        throw std::runtime_error("Block is not a CBL: " + checksum.toHex() + ": " + e.what());
+    }
+
+    std::lock_guard lock(cacheMutex_);
+    ++nodeLoads_;
+    if (cache_.count(checksum) == 0) {
+        lru_.push_front(checksum);
+        cache_[checksum] = {node, lru_.begin()};
+        while (cache_.size() > cacheCapacity_) {
+            cache_.erase(lru_.back());
+            lru_.pop_back();
+        }
+    }
+    return node;
+}
+
+std::vector<Checksum> RangeReader::locateTuple(uint64_t tuple) {
+    // The arithmetic below assumes the packed layout, so every node on the
+    // path is checked against the share of the file it should cover. A node
+    // may record either that share (as SuperCBLBuilder writes) or the length
+    // of the whole file.
+    auto node = loadNode(root_);
+    uint64_t nodeLength = size_;
+    while (node->tupleSize == 0) {
+        uint64_t perChild = tuplesPerLeaf_;
+        for (uint16_t level = 1; level < node->depth; ++level) {
+            perChild *= superFanout_;
+        }
+
+        const uint64_t nodeTuples = (nodeLength + blockLength_ - 1) / blockLength_;
+        if (node->children.size() != (nodeTuples + perChild - 1) / perChild) {
+            throw std::runtime_error("CBL tree is not fully packed; cannot locate offset");
+        }
+        const uint64_t child = tuple / perChild;
+        if (child >= node->children.size()) {
+            throw std::runtime_error("Offset lies beyond the CBL tree");
+        }
+        tuple %= perChild;
+        nodeLength = std::min(nodeLength - child * perChild * blockLength_,
+                              perChild * blockLength_);
+        node = loadNode(node->children[child].toChecksum());
+        if (node->originalDataLength != nodeLength && node->originalDataLength != size_) {
+            throw std::runtime_error("CBL tree node does not match its data length");
+        }
+    }
+
+    const uint64_t leafTuples = (nodeLength + blockLength_ - 1) / blockLength_;
+    if (node->children.size() != leafTuples * node->tupleSize) {
+        throw std::runtime_error("CBL tree is not fully packed; cannot locate offset");
+    }
+    if (tuple >= leafTuples) {
+        throw std::runtime_error("Offset lies beyond the CBL tree");
+    }
+    const uint64_t first = tuple * node->tupleSize;
+    return node->children.subrange(first, node->tupleSize).toVector();
+}
+
+size_t RangeReader::read(uint64_t offset, uint8_t* out, size_t length) {
+    if (offset >= size_ || length == 0) {
+        return 0;
+    }
+    length = static_cast<size_t>(std::min<uint64_t>(length, size_ - offset));
+
+    const uint64_t firstTuple = offset / blockLength_;
+    const uint64_t lastTuple = (offset + length - 1) / blockLength_;
+
+    auto copyOut = [&](uint64_t tuple, const std::vector<uint8_t>& block) {
+        const uint64_t blockStart = tuple * blockLength_;
+        const uint64_t from = std::max(offset, blockStart);
+        const uint64_t to = std::min<uint64_t>(offset + length, blockStart + blockLength_);
+        if (blockStart + block.size() < to) {
+            throw std::runtime_error("Data block is shorter than the block size");
+        }
+        std::memcpy(out + (from - offset), block.data() + (from - blockStart), to - from);
+    };
+
+    // On one of the pool's own workers, waiting for queued tasks could
+    // deadlock, so read inline as parallelFor does
+    if (firstTuple == lastTuple || pool_.onWorker()) {
+        for (uint64_t tuple = firstTuple; tuple <= lastTuple; ++tuple) {
+            copyOut(tuple, xorTuple(store_, locateTuple(tuple)));
+        }
+        return length;
+    }
+
+    // Keep a bounded window of tuples in flight so huge ranges do not
+    // buffer the whole range
+    const size_t window = std::max<size_t>(pool_.size() * 2, 2);
+    std::deque<std::future<std::vector<uint8_t>>> pending;
+    uint64_t nextToFetch = firstTuple;
+    try {
+        for (uint64_t tuple = firstTuple; tuple <= lastTuple; ++tuple) {
+            while (nextToFetch <= lastTuple && pending.size() < window) {
+                pending.push_back(pool_.submit([this, members = locateTuple(nextToFetch)]() {
+                    return xorTuple(store_, members);
+                }));
+                ++nextToFetch;
+            }
+            auto next = std::move(pending.front());
+            pending.pop_front();
+            copyOut(tuple, next.get());
+        }
+    } catch (...) {
+        for (auto& future : pending) {
+            future.wait();
+        }
+        throw;
+    }
+    return length;
+}
+
+std::vector<uint8_t> RangeReader::read(uint64_t offset, size_t length) {
+    if (offset >= size_) {
+        return {};
+    }
+    std::vector<uint8_t> result(
+        static_cast<size_t>(std::min<uint64_t>(length, size_ - offset)));
+    read(offset, result.data(), result.size());
+    return result;
+}
+
+} // namespace brightchain
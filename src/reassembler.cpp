@@ -0,0 +1,257 @@
+#include "brightchain/reassembler.hpp"
+#include "brightchain/cbl_view.hpp"
+#include "brightchain/xor_blocks.hpp"
+#include "file_io.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace brightchain {
+
+namespace {
+
+/**
+ * Depth-first cursor over the data tuples of a CBL tree.
+ */
+class TupleCursor {
+public:
+    TupleCursor(DiskBlockStore& store, const Checksum& root) : store_(store) {
+        push(root);
+    }
+
+    uint64_t originalDataLength() const { return originalDataLength_; }
+    const Checksum::HashArray& originalDataChecksum() const { return originalDataChecksum_; }
+
+    /**
+     * Next tuple in file order, loading interior nodes as needed.
+     */
+    std::optional<std::vector<Checksum>> next() {
+        while (!stack_.empty()) {
+            Level& top = stack_.back();
+            if (top.next == top.children.size()) {
+                stack_.pop_back();
+                continue;
+            }
+
+            if (top.tupleSize > 0) {
+                auto tuple = top.children.subrange(top.next, top.tupleSize).toVector();
+                top.next += top.tupleSize;
+                return tuple;
+            }
+
+            const Checksum child = top.children[top.next++].toChecksum();
+            push(child);
+        }
+        return std::nullopt;
+    }
+
+private:
+    struct Level {
+        MappedBlock block;
+        ChecksumRange children; // Points into block
+        size_t next = 0;
+        uint32_t tupleSize = 0; // 0 for SuperCBL levels (children are CBLs)
+    };
+
+    /**
+     * Load a node and descend into it; the root also supplies the totals.
+     */
+    void push(const Checksum& checksum) {
+        // Nodes are parsed in place over the mapping; the level keeps it alive
+        Level level;
+        level.block = store_.getMapped(checksum, AccessHint::Sequential);
+        auto bytes = level.block.span();
+        if (bytes.size() < 2) {
+            throw std::runtime_error("Block is not a CBL: " + checksum.toHex());
+        }
+
+        uint64_t originalDataLength = 0;
+        ChecksumView originalDataChecksum;
+        try {
+            if (bytes[1] == static_cast<uint8_t>(StructuredBlockType::SuperCBL)) {
+                SuperCBLView node(bytes);
+                level.children = node.subCblChecksums();
+                originalDataLength = node.originalDataLength();
+                originalDataChecksum = node.originalDataChecksum();
+            } else {
+                CBLView node(bytes);
+                level.tupleSize = std::max<uint32_t>(node.tupleSize(), 1);
+                level.children = node.addresses();
+                originalDataLength = node.originalDataLength();
+                originalDataChecksum = node.originalDataChecksum();
+            }
+        } catch (const std::invalid_argument& e) {
+            throw std::runtime_error("Block is not a CBL: " + checksum.toHex() + ": " + e.what());
+        }
+        if (level.tupleSize > 0 && level.children.size() % level.tupleSize != 0) {
+            throw std::runtime_error("CBL address count is not a multiple of its tuple size: " +
+                                     checksum.toHex());
+        }
+
+        if (stack_.empty()) {
+            originalDataLength_ = originalDataLength;
+            std::memcpy(originalDataChecksum_.data(), originalDataChecksum.data(),
+                        Checksum::HASH_SIZE);
+        }
+        stack_.push_back(std::move(level));
+    }
+
+    DiskBlockStore& store_;
+    std::vector<Level> stack_;
+    uint64_t originalDataLength_ = 0;
+    Checksum::HashArray originalDataChecksum_{};
+};
+
+} // namespace
+
+Reassembler::Reassembler(DiskBlockStore& store, ThreadPool& pool)
+    : store_(store), pool_(pool) {}
+
+Reassembler::Reassembler(AsyncBlockIO& io)
+    : store_(io.store()), pool_(ThreadPool::shared()), io_(&io) {}
+
+std::future<std::vector<uint8_t>> Reassembler::readTuple(std::vector<Checksum> tuple,
+                                                         std::atomic<uint64_t>& blocksRead) {
+    if (!io_) {
+        return pool_.submit([this, tuple = std::move(tuple), &blocksRead]() {
+            auto block = xorTuple(store_, tuple);
+            blocksRead.fetch_add(tuple.size(), std::memory_order_relaxed);
+            return block;
+        });
+    }
+
+    // Members complete in any order; each is folded into the first to arrive
+    struct TupleRead {
+        std::mutex mutex;
+        std::vector<uint8_t> block;
+        size_t remaining;
+        std::exception_ptr error;
+        std::promise<std::vector<uint8_t>> done;
+    };
+    auto state = std::make_shared<TupleRead>();
+    state->remaining = tuple.size();
+    auto future = state->done.get_future();
+    io_->getBatch(tuple, [state, tuple, &blocksRead](size_t index, std::vector<uint8_t> data,
+                                                     std::exception_ptr error) {
+        std::lock_guard lock(state->mutex);
+        if (!error) {
+            blocksRead.fetch_add(1, std::memory_order_relaxed);
+            if (state->block.empty()) {
+                state->block = std::move(data);
+            } else if (data.size() == state->block.size()) {
+                xorInto(state->block.data(), data.data(), data.size());
+            } else {
+                error = std::make_exception_ptr(std::runtime_error(
+                    "Tuple members differ in size: " + tuple[index].toHex()));
+            }
+        }
+        if (error && !state->error) {
+            state->error = error;
+        }
+        if (--state->remaining == 0) {
+            if (state->error) {
+                state->done.set_exception(state->error);
+            } else {
+                state->done.set_value(std::move(state->block));
+            }
+        }
+    });
+    return future;
+}
+
+ReassemblyResult Reassembler::reassemble(const Checksum& root, int fd,
+                                         const ReassemblyOptions& options) {
+    TupleCursor cursor(store_, root);
+    const uint64_t totalLength = cursor.originalDataLength();
+    const size_t window = std::max<size_t>(options.readAhead, 1);
+
+    ChecksumStream hasher;
+    ReassemblyResult result;
+    std::atomic<uint64_t> blocksRead{0};
+    std::deque<std::future<std::vector<uint8_t>>> inFlight;
+    bool exhausted = false;
+
+    auto refill = [&]() {
+        while (!exhausted && inFlight.size() < window) {
+            auto tuple = cursor.next();
+            if (!tuple) {
+                exhausted = true;
+                break;
+            }
+            inFlight.push_back(readTuple(std::move(*tuple), blocksRead));
+        }
+    };
+
+    try {
+        refill();
+        while (result.bytesWritten < totalLength) {
+            if (inFlight.empty()) {
+                throw std::runtime_error("CBL tree holds less data than its declared length");
+            }
+
+            auto next = std::move(inFlight.front());
+            inFlight.pop_front();
+            std::vector<uint8_t> block = next.get();
+            refill();
+
+            const size_t length = static_cast<size_t>(
+                std::min<uint64_t>(block.size(), totalLength - result.bytesWritten));
+            if (options.verifyChecksum) {
+                hasher.update(block.data(), length);
+            }
+            writeFully(fd, block.data(), length);
+            result.bytesWritten += length;
+        }
+    } catch (...) {
+        for (auto& pending : inFlight) {
+            pending.wait();
+        }
+        throw;
+    }
+
+    // Trailing tuples past originalDataLength are padding; nothing to fetch
+    for (auto& pending : inFlight) {
+        pending.wait();
+    }
+    result.blocksRead = blocksRead.load(std::memory_order_relaxed);
+
+    if (options.verifyChecksum &&
+        hasher.finish() != Checksum::fromHash(cursor.originalDataChecksum())) {
+        throw std::runtime_error("Reassembled data does not match originalDataChecksum");
+    }
+    return result;
+}
+
+ReassemblyResult Reassembler::reassembleToFile(const Checksum& root,
+                                               const std::filesystem::path& path,
+                                               const ReassemblyOptions& options) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create output file: " + path.string());
+    }
+
+    try {
+        ReassemblyResult result = reassemble(root, fd, options);
+        if (::close(fd) != 0) {
+            fd = -1;
+            throw std::runtime_error("Failed to close output file: " + path.string());
+        }
+        return result;
+    } catch (...) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        std::filesystem::remove(path);
+        throw;
+    }
+}
+
+} // namespace brightchain
@@ -0,0 +1,405 @@
+#include "brightchain/reed_solomon.hpp"
+#include "brightchain/constants.hpp"
+#include "brightchain/gf256.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace brightchain {
+
+namespace {
+
+// Bytes of every shard processed together, sized to stay in L2
+constexpr size_t STRIPE = 16 * 1024;
+
+// Below this shard size the pool costs more than it saves
+constexpr size_t PARALLEL_THRESHOLD = 256 * 1024;
+
+constexpr uint8_t MANIFEST_VERSION = 1;
+constexpr size_t MANIFEST_HEADER_SIZE = 1 + 8 + 4 + 2 + 2;
+
+using Matrix = std::vector<std::vector<uint8_t>>;
+
+/**
+ * Invert a square matrix over GF(2^8) by Gauss-Jordan elimination.
+ */
+Matrix invert(Matrix matrix) {
+    const size_t n = matrix.size();
+    Matrix inverse(n, std::vector<uint8_t>(n, 0));
+    for (size_t i = 0; i < n; ++i) {
+        inverse[i][i] = 1;
+    }
+
+    for (size_t column = 0; column < n; ++column) {
+        size_t pivot = column;
+        while (pivot < n && matrix[pivot][column] == 0) {
+            ++pivot;
+        }
+        if (pivot == n) {
+            throw std::runtime_error("Reed-Solomon decode matrix is singular");
+        }
+        std::swap(matrix[pivot], matrix[column]);
+        std::swap(inverse[pivot], inverse[column]);
+
+        const uint8_t scale = gf256::inv(matrix[column][column]);
+        for (size_t j = 0; j < n; ++j) {
+            matrix[column][j] = gf256::mul(matrix[column][j], scale);
+            inverse[column][j] = gf256::mul(inverse[column][j], scale);
+        }
+
+        for (size_t row = 0; row < n; ++row) {
+            const uint8_t factor = matrix[row][column];
+            if (row == column || factor == 0) {
+                continue;
+            }
+            for (size_t j = 0; j < n; ++j) {
+                matrix[row][j] ^= gf256::mul(factor, matrix[column][j]);
+                inverse[row][j] ^= gf256::mul(factor, inverse[column][j]);
+            }
+        }
+    }
+    return inverse;
+}
+
+void writeBigEndian(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+    for (int i = bytes - 1; i >= 0; --i) {
+        out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+uint64_t readBigEndian(const uint8_t* data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+} // namespace
+
+ReedSolomon::ReedSolomon(size_t dataShards, size_t parityShards, ThreadPool& pool)
+    : dataShards_(dataShards), parityShards_(parityShards), pool_(pool) {
+    if (dataShards == 0 || parityShards == 0 || dataShards + parityShards > 256) {
+        throw std::invalid_argument("Reed-Solomon needs 1 <= data, 1 <= parity and "
+                                    "data + parity <= 256 shards");
+    }
+
+    // Cauchy rows 1 / (x_i + y_j) with x_i = k + i and y_j = j: every square
+    // submatrix of [I; C] is invertible, so any k shards decode
+    parityRows_.assign(parityShards, std::vector<uint8_t>(dataShards));
+    for (size_t i = 0; i < parityShards; ++i) {
+        for (size_t j = 0; j < dataShards; ++j) {
+            parityRows_[i][j] = gf256::inv(static_cast<uint8_t>((dataShards + i) ^ j));
+        }
+    }
+}
+
+size_t ReedSolomon::defaultParityShards(size_t dataShards) {
+    const auto wanted = static_cast<size_t>(
+        std::ceil(static_cast<double>(dataShards) * (FECConstants::REDUNDANCY_FACTOR - 1.0)));
+    return std::clamp<size_t>(wanted, FECConstants::MIN_REDUNDANCY,
+                              FECConstants::MAX_REDUNDANCY);
+}
+
+void ReedSolomon::multiply(const Matrix& rows, std::span<const uint8_t* const> inputs,
+                           std::span<uint8_t* const> outputs, size_t shardSize) const {
+    auto run = [&](size_t begin, size_t end) {
+        for (size_t offset = begin; offset < end; offset += STRIPE) {
+            const size_t length = std::min(STRIPE, end - offset);
+            for (size_t r = 0; r < rows.size(); ++r) {
+                uint8_t* out = outputs[r] + offset;
+                gf256::mul(out, inputs[0] + offset, rows[r][0], length);
+                for (size_t c = 1; c < inputs.size(); ++c) {
+                    gf256::mulAdd(out, inputs[c] + offset, rows[r][c], length);
+                }
+            }
+        }
+    };
+
+    if (shardSize < PARALLEL_THRESHOLD) {
+        run(0, shardSize);
+        return;
+    }
+
+    // Whole stripes per task, one task per worker
+    const size_t stripes = (shardSize + STRIPE - 1) / STRIPE;
+    pool_.parallelFor(0, stripes, [&run, shardSize](size_t first, size_t last) {
+        run(first * STRIPE, std::min(shardSize, last * STRIPE));
+    });
+}
+
+void ReedSolomon::encode(std::span<const uint8_t* const> data, std::span<uint8_t* const> parity,
+                         size_t shardSize) const {
+    if (data.size() != dataShards_ || parity.size() != parityShards_) {
+        throw std::invalid_argument("Shard count does not match the code");
+    }
+    multiply(parityRows_, data, parity, shardSize);
+}
+
+void ReedSolomon::reconstruct(std::span<uint8_t* const> shards, std::span<const bool> present,
+                              size_t shardSize) const {
+    if (shards.size() != totalShards() || present.size() != totalShards()) {
+        throw std::invalid_argument("Shard count does not match the code");
+    }
+
+    std::vector<size_t> available;
+    for (size_t i = 0; i < totalShards() && available.size() < dataShards_; ++i) {
+        if (present[i]) {
+            available.push_back(i);
+        }
+    }
+    if (available.size() < dataShards_) {
+        throw std::runtime_error("Need " + std::to_string(dataShards_) +
+                                 " shards to reconstruct, have " +
+                                 std::to_string(available.size()));
+    }
+
+    // Missing data shards: invert the rows of the available shards
+    std::vector<size_t> missingData;
+    for (size_t i = 0; i < dataShards_; ++i) {
+        if (!present[i]) {
+            missingData.push_back(i);
+        }
+    }
+    if (!missingData.empty()) {
+        Matrix decode;
+        std::vector<const uint8_t*> inputs;
+        for (size_t index : available) {
+            if (index < dataShards_) {
+                std::vector<uint8_t> identity(dataShards_, 0);
+                identity[index] = 1;
+                decode.push_back(std::move(identity));
+            } else {
+                decode.push_back(parityRows_[index - dataShards_]);
+            }
+            inputs.push_back(shards[index]);
+        }
+        const Matrix inverse = invert(std::move(decode));
+
+        Matrix rows;
+        std::vector<uint8_t*> outputs;
+        for (size_t index : missingData) {
+            rows.push_back(inverse[index]);
+            outputs.push_back(shards[index]);
+        }
+        multiply(rows, inputs, outputs, shardSize);
+    }
+
+    // Missing parity shards: re-encode from the now complete data
+    Matrix rows;
+    std::vector<uint8_t*> outputs;
+    for (size_t i = 0; i < parityShards_; ++i) {
+        if (!present[dataShards_ + i]) {
+            rows.push_back(parityRows_[i]);
+            outputs.push_back(shards[dataShards_ + i]);
+        }
+    }
+    if (!rows.empty()) {
+        std::vector<const uint8_t*> data(shards.begin(), shards.begin() + dataShards_);
+        multiply(rows, data, outputs, shardSize);
+    }
+}
+
+std::vector<uint8_t> FecManifest::serialize() const {
+    std::vector<uint8_t> result;
+    result.reserve(MANIFEST_HEADER_SIZE +
+                   (dataShards.size() + parityShards.size()) * Checksum::HASH_SIZE);
+    result.push_back(MANIFEST_VERSION);
+    writeBigEndian(result, originalLength, 8);
+    writeBigEndian(result, shardSize, 4);
+    writeBigEndian(result, dataShards.size(), 2);
+    writeBigEndian(result, parityShards.size(), 2);
+    for (const auto* list : {&dataShards, &parityShards}) {
+        for (const auto& checksum : *list) {
+            result.insert(result.end(), checksum.hash().begin(), checksum.hash().end());
+        }
+    }
+    return result;
+}
+
+FecManifest FecManifest::deserialize(const std::vector<uint8_t>& data) {
+    if (data.size() < MANIFEST_HEADER_SIZE) {
+        throw std::invalid_argument("Insufficient data for FEC manifest");
+    }
+    if (data[0] != MANIFEST_VERSION) {
+        throw std::invalid_argument("Unsupported FEC manifest version");
+    }
+
+    FecManifest manifest;
+    manifest.originalLength = readBigEndian(&data[1], 8);
+    manifest.shardSize = static_cast<uint32_t>(readBigEndian(&data[9], 4));
+    const size_t dataCount = readBigEndian(&data[13], 2);
+    const size_t parityCount = readBigEndian(&data[15], 2);
+    if (data.size() != MANIFEST_HEADER_SIZE + (dataCount + parityCount) * Checksum::HASH_SIZE) {
+        throw std::invalid_argument("FEC manifest length does not match its shard counts");
+    }
+
+    size_t offset = MANIFEST_HEADER_SIZE;
+    auto next = [&]() {
+        Checksum::HashArray hash;
+        std::memcpy(hash.data(), &data[offset], Checksum::HASH_SIZE);
+        offset += Checksum::HASH_SIZE;
+        return Checksum::fromHash(hash);
+    };
+    for (size_t i = 0; i < dataCount; ++i) {
+        manifest.dataShards.push_back(next());
+    }
+    for (size_t i = 0; i < parityCount; ++i) {
+        manifest.parityShards.push_back(next());
+    }
+    return manifest;
+}
+
+BlockFec::BlockFec(DiskBlockStore& store, ThreadPool& pool)
+    : store_(store), pool_(pool), shardSize_(blockSizeToLength(store.blockSize())) {
+    if (shardSize_ > FECConstants::MAX_SHARD_SIZE) {
+        throw std::invalid_argument("Shard store block size exceeds the maximum shard size");
+    }
+}
+
+FecManifest BlockFec::protect(std::span<const uint8_t> payload, size_t parityShards) {
+    const size_t dataCount = std::max<size_t>(1, (payload.size() + shardSize_ - 1) / shardSize_);
+    if (parityShards == 0) {
+        parityShards = ReedSolomon::defaultParityShards(dataCount);
+    }
+    if (parityShards >= 256 || dataCount > 256 - parityShards) {
+        throw std::invalid_argument("FEC payload needs " + std::to_string(dataCount) +
+                                    " data shards; at most " +
+                                    std::to_string(256 - std::min<size_t>(parityShards, 256)) +
+                                    " fit");
+    }
+    ReedSolomon codec(dataCount, parityShards, pool_);
+
+    std::vector<std::vector<uint8_t>> shards(dataCount + parityShards,
+                                             std::vector<uint8_t>(shardSize_, 0));
+    std::vector<size_t> lengths(shards.size(), shardSize_);
+    for (size_t i = 0; i < dataCount; ++i) {
+        const size_t offset = i * shardSize_;
+        lengths[i] = std::min(shardSize_, payload.size() - std::min(offset, payload.size()));
+        std::memcpy(shards[i].data(), payload.data() + offset, lengths[i]);
+    }
+
+    std::vector<const uint8_t*> data;
+    std::vector<uint8_t*> parity;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        if (i < dataCount) {
+            data.push_back(shards[i].data());
+        } else {
+            parity.push_back(shards[i].data());
+        }
+    }
+    codec.encode(data, parity, shardSize_);
+
+    std::vector<const uint8_t*> all(data.begin(), data.end());
+    all.insert(all.end(), parity.begin(), parity.end());
+    const auto checksums = Checksum::fromBlocks(all, shardSize_);
+
+    FecManifest manifest;
+    manifest.originalLength = payload.size();
+    manifest.shardSize = static_cast<uint32_t>(shardSize_);
+    for (size_t i = 0; i < shards.size(); ++i) {
+        store_.put(checksums[i], shards[i], BlockMetadata(store_.blockSize(), lengths[i]));
+        (i < dataCount ? manifest.dataShards : manifest.parityShards).push_back(checksums[i]);
+    }
+    return manifest;
+}
+
+std::vector<std::vector<uint8_t>> BlockFec::loadShards(const FecManifest& manifest,
+                                                       std::vector<size_t>& lost) const {
+    if (manifest.shardSize != shardSize_) {
+        throw std::invalid_argument("FEC manifest shard size does not match the store");
+    }
+
+    std::vector<Checksum> expected(manifest.dataShards);
+    expected.insert(expected.end(), manifest.parityShards.begin(), manifest.parityShards.end());
+
+    std::vector<std::vector<uint8_t>> shards(expected.size());
+    std::vector<const uint8_t*> loaded;
+    std::vector<size_t> loadedIndex;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        try {
+            shards[i] = store_.get(expected[i]);
+        } catch (const std::runtime_error&) {
+            shards[i].clear();
+        }
+        if (shards[i].size() == shardSize_) {
+            loaded.push_back(shards[i].data());
+            loadedIndex.push_back(i);
+        }
+    }
+
+    // Shards that fail their checksum are treated as lost
+    std::vector<bool> present(expected.size(), false);
+    const auto checksums = Checksum::fromBlocks(loaded, shardSize_);
+    for (size_t j = 0; j < loadedIndex.size(); ++j) {
+        present[loadedIndex[j]] = checksums[j] == expected[loadedIndex[j]];
+    }
+
+    lost.clear();
+    std::vector<uint8_t*> buffers;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        if (!present[i]) {
+            lost.push_back(i);
+            shards[i].assign(shardSize_, 0);
+        }
+        buffers.push_back(shards[i].data());
+    }
+
+    if (!lost.empty()) {
+        ReedSolomon codec(manifest.dataShards.size(), manifest.parityShards.size(), pool_);
+        std::unique_ptr<bool[]> flags(new bool[present.size()]);
+        std::copy(present.begin(), present.end(), flags.get());
+        codec.reconstruct(buffers, std::span<const bool>(flags.get(), present.size()),
+                          shardSize_);
+    }
+    return shards;
+}
+
+std::vector<uint8_t> BlockFec::recover(const FecManifest& manifest) const {
+    std::vector<size_t> lost;
+    auto shards = loadShards(manifest, lost);
+
+    std::vector<uint8_t> payload(manifest.originalLength);
+    for (size_t i = 0; i < manifest.dataShards.size(); ++i) {
+        const size_t offset = i * shardSize_;
+        if (offset >= payload.size()) {
+            break;
+        }
+        const size_t length = std::min(shardSize_, payload.size() - offset);
+        std::memcpy(payload.data() + offset, shards[i].data(), length);
+    }
+    return payload;
+}
+
+size_t BlockFec::repair(const FecManifest& manifest) {
+    std::vector<size_t> lost;
+    auto shards = loadShards(manifest, lost);
+
+    for (size_t index : lost) {
+        const bool isData = index < manifest.dataShards.size();
+        const Checksum& expected =
+            isData ? manifest.dataShards[index]
+                   : manifest.parityShards[index - manifest.dataShards.size()];
+        size_t length = shardSize_;
+        if (isData) {
+            const uint64_t offset = static_cast<uint64_t>(index) * shardSize_;
+            length = static_cast<size_t>(std::min<uint64_t>(
+                shardSize_, manifest.originalLength - std::min(offset, manifest.originalLength)));
+        }
+        // A corrupted file for this checksum must go before the rebuilt one is
+        // stored. quarantine() keeps the reference count of a damaged or
+        // already quarantined shard, and the put of the rebuilt one resumes it.
+        store_.quarantine(expected);
+        if (store_.put(shards[index], BlockMetadata(store_.blockSize(), length)) != expected) {
+            throw std::runtime_error("Rebuilt shard does not match its checksum: " +
+                                     expected.toHex());
+        }
+    }
+    return lost.size();
+}
+
+} // namespace brightchain
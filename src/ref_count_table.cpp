@@ -0,0 +1,50 @@
+#include "brightchain/ref_count_table.hpp"
+#include "file_io.hpp"
+
+namespace brightchain {
+
+namespace {
+
+constexpr MappedHashTable::Layout TABLE_LAYOUT{
+    0x54435242, // "BRCT" little-endian
+    1,
+    RefCountTable::RECORD_SIZE,
+    68,
+    "reference count table",
+};
+
+} // namespace
+
+RefCountTable::RefCountTable(const std::filesystem::path& path) : table_(path, TABLE_LAYOUT) {}
+
+std::optional<uint32_t> RefCountTable::get(const Checksum& checksum) const {
+    return table_.read(checksum, [](const uint8_t* record) -> std::optional<uint32_t> {
+        if (!record) {
+            return std::nullopt;
+        }
+        return static_cast<uint32_t>(readLE(record + 64, 4));
+    });
+}
+
+void RefCountTable::set(const Checksum& checksum, uint32_t count) {
+    table_.write(checksum,
+                 [count](uint8_t* record, bool) { writeLE(record + 64, count, 4); });
+}
+
+bool RefCountTable::remove(const Checksum& checksum) {
+    return table_.erase(checksum);
+}
+
+size_t RefCountTable::size() const {
+    return table_.size();
+}
+
+uint64_t RefCountTable::slotCount() const {
+    return table_.slotCount();
+}
+
+void RefCountTable::sync() const {
+    table_.sync();
+}
+
+} // namespace brightchain
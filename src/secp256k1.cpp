@@ -0,0 +1,553 @@
+#include "brightchain/secp256k1.hpp"
+#include <openssl/bn.h>
+#include <openssl/core_names.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
+#include <openssl/param_build.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef BRIGHTCHAIN_HAVE_LIBSECP256K1
+#include <secp256k1.h>
+#include <secp256k1_ecdh.h>
+#endif
+
+namespace brightchain {
+
+namespace {
+
+constexpr Secp256k1::Backend DEFAULT_BACKEND =
+#ifdef BRIGHTCHAIN_HAVE_LIBSECP256K1
+    Secp256k1::Backend::LibSecp256k1;
+#else
+    Secp256k1::Backend::OpenSsl;
+#endif
+
+std::atomic<Secp256k1::Backend> activeBackend{DEFAULT_BACKEND};
+
+void requirePrivateKeySize(std::span<const uint8_t> privateKey) {
+    if (privateKey.size() != Secp256k1::PRIVATE_KEY_SIZE) {
+        throw std::runtime_error("secp256k1 private key must be 32 bytes");
+    }
+}
+
+// --- OpenSSL ---------------------------------------------------------------
+
+/**
+ * The curve group, built once instead of per key.
+ */
+const EC_GROUP* curve() {
+    static const EC_GROUP* group = []() {
+        EC_GROUP* created = EC_GROUP_new_by_curve_name(NID_secp256k1);
+        if (!created) {
+            throw std::runtime_error("Failed to create secp256k1 group");
+        }
+        return created;
+    }();
+    return group;
+}
+
+/**
+ * Parse a private key, rejecting zero and values not below the group order
+ * like libsecp256k1 does. The scalar is marked secure, so parameters built
+ * from it are too and are wiped when freed.
+ */
+BIGNUM* opensslScalar(std::span<const uint8_t> privateKey) {
+    BIGNUM* scalar = BN_secure_new();
+    if (!scalar ||
+        !BN_bin2bn(privateKey.data(), static_cast<int>(privateKey.size()), scalar) ||
+        BN_is_zero(scalar) || BN_cmp(scalar, EC_GROUP_get0_order(curve())) >= 0) {
+        BN_clear_free(scalar);
+        return nullptr;
+    }
+    return scalar;
+}
+
+/**
+ * Decode a public key, or nullptr if it is not on the curve.
+ */
+EC_POINT* opensslPoint(std::span<const uint8_t> publicKey) {
+    const EC_GROUP* group = curve();
+    EC_POINT* point = EC_POINT_new(group);
+    if (point &&
+        EC_POINT_oct2point(group, point, publicKey.data(), publicKey.size(), nullptr) != 1) {
+        EC_POINT_free(point);
+        return nullptr;
+    }
+    return point;
+}
+
+Secp256k1::SharedPoint opensslEcdhPoint(std::span<const uint8_t> privateKey,
+                                        const EC_POINT* point) {
+    const EC_GROUP* group = curve();
+    BIGNUM* scalar = opensslScalar(privateKey);
+    EC_POINT* shared = EC_POINT_new(group);
+
+    Secp256k1::SharedPoint result;
+    const bool ok =
+        scalar && point && shared &&
+        EC_POINT_mul(group, shared, nullptr, point, scalar, nullptr) == 1 &&
+        EC_POINT_point2oct(group, shared, POINT_CONVERSION_UNCOMPRESSED, result.data(),
+                           result.size(), nullptr) == result.size();
+
+    BN_clear_free(scalar);
+    EC_POINT_free(shared);
+    if (!ok) {
+        throw std::runtime_error("Invalid secp256k1 key for ECDH");
+    }
+    return result;
+}
+
+Secp256k1::SharedPoint opensslEcdhPoint(std::span<const uint8_t> privateKey,
+                                        std::span<const uint8_t> publicKey) {
+    EC_POINT* point = opensslPoint(publicKey);
+    if (!point) {
+        throw std::runtime_error("Invalid secp256k1 key for ECDH");
+    }
+    try {
+        const auto result = opensslEcdhPoint(privateKey, point);
+        EC_POINT_free(point);
+        return result;
+    } catch (...) {
+        EC_POINT_free(point);
+        throw;
+    }
+}
+
+/**
+ * Build an EVP key from an encoded public key and, for signing, the private
+ * scalar. Returns nullptr if the public key is not on the curve.
+ */
+EVP_PKEY* opensslKey(std::span<const uint8_t> publicKey, const BIGNUM* scalar) {
+    OSSL_PARAM_BLD* builder = OSSL_PARAM_BLD_new();
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_from_name(nullptr, "EC", nullptr);
+    OSSL_PARAM* params = nullptr;
+    EVP_PKEY* key = nullptr;
+    char group[] = "secp256k1";
+    const bool ok =
+        builder && ctx &&
+        OSSL_PARAM_BLD_push_utf8_string(builder, OSSL_PKEY_PARAM_GROUP_NAME, group, 0) == 1 &&
+        OSSL_PARAM_BLD_push_octet_string(builder, OSSL_PKEY_PARAM_PUB_KEY, publicKey.data(),
+                                         publicKey.size()) == 1 &&
+        (!scalar || OSSL_PARAM_BLD_push_BN(builder, OSSL_PKEY_PARAM_PRIV_KEY, scalar) == 1) &&
+        (params = OSSL_PARAM_BLD_to_param(builder)) != nullptr &&
+        EVP_PKEY_fromdata_init(ctx) == 1 &&
+        EVP_PKEY_fromdata(ctx, &key, scalar ? EVP_PKEY_KEYPAIR : EVP_PKEY_PUBLIC_KEY,
+                          params) == 1;
+
+    OSSL_PARAM_free(params);
+    OSSL_PARAM_BLD_free(builder);
+    EVP_PKEY_CTX_free(ctx);
+    if (!ok) {
+        EVP_PKEY_free(key);
+        return nullptr;
+    }
+    return key;
+}
+
+std::vector<uint8_t> opensslSign(std::span<const uint8_t> privateKey,
+                                 std::span<const uint8_t> data) {
+    const EC_GROUP* group = curve();
+    BIGNUM* scalar = opensslScalar(privateKey);
+    EC_POINT* point = EC_POINT_new(group);
+    std::array<uint8_t, Secp256k1::UNCOMPRESSED_KEY_SIZE> publicKey;
+    EVP_PKEY* key =
+        scalar && point && EC_POINT_mul(group, point, scalar, nullptr, nullptr, nullptr) == 1 &&
+                EC_POINT_point2oct(group, point, POINT_CONVERSION_UNCOMPRESSED, publicKey.data(),
+                                   publicKey.size(), nullptr) == publicKey.size()
+            ? opensslKey(publicKey, scalar)
+            : nullptr;
+    BN_clear_free(scalar);
+    EC_POINT_free(point);
+    if (!key) {
+        throw std::runtime_error("Invalid secp256k1 private key");
+    }
+
+    // With no digest set, the data itself is signed as the digest
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_from_pkey(nullptr, key, nullptr);
+    std::vector<uint8_t> signature;
+    size_t length = 0;
+    bool ok = ctx && EVP_PKEY_sign_init(ctx) == 1 &&
+              EVP_PKEY_sign(ctx, nullptr, &length, data.data(), data.size()) == 1;
+    if (ok) {
+        signature.resize(length);
+        ok = EVP_PKEY_sign(ctx, signature.data(), &length, data.data(), data.size()) == 1;
+    }
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(key);
+    if (!ok) {
+        throw std::runtime_error("Failed to sign data");
+    }
+    signature.resize(length);
+    return signature;
+}
+
+bool opensslVerify(std::span<const uint8_t> data, std::span<const uint8_t> signature,
+                   std::span<const uint8_t> publicKey) {
+    EVP_PKEY* key = opensslKey(publicKey, nullptr);
+    if (!key) {
+        return false;
+    }
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_from_pkey(nullptr, key, nullptr);
+    const bool ok = ctx && EVP_PKEY_verify_init(ctx) == 1 &&
+                    EVP_PKEY_verify(ctx, signature.data(), signature.size(), data.data(),
+                                    data.size()) == 1;
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(key);
+    return ok;
+}
+
+// --- libsecp256k1 ----------------------------------------------------------
+
+#ifdef BRIGHTCHAIN_HAVE_LIBSECP256K1
+
+/**
+ * Shared context. Every operation used here takes it as const, so it is safe
+ * to use from many threads once randomized.
+ */
+const secp256k1_context* context() {
+    static const secp256k1_context* ctx = []() {
+        secp256k1_context* created = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+        if (!created) {
+            throw std::runtime_error("Failed to create secp256k1 context");
+        }
+        // Blinding for side-channel protection of signing and key generation
+        unsigned char seed[32];
+        if (RAND_bytes(seed, sizeof(seed)) == 1) {
+            (void)secp256k1_context_randomize(created, seed);
+        }
+        return created;
+    }();
+    return ctx;
+}
+
+int copyPoint(unsigned char* output, const unsigned char* x32, const unsigned char* y32,
+              void*) {
+    output[0] = 0x04;
+    std::memcpy(output + 1, x32, 32);
+    std::memcpy(output + 33, y32, 32);
+    return 1;
+}
+
+/**
+ * The 32-byte message OpenSSL signs for raw data.
+ */
+std::array<uint8_t, 32> messageDigest(std::span<const uint8_t> data) {
+    std::array<uint8_t, 32> digest{};
+    const size_t length = std::min(data.size(), digest.size());
+    std::copy_n(data.begin(), length, digest.end() - length);
+    return digest;
+}
+
+bool libParsePoint(std::span<const uint8_t> publicKey, secp256k1_pubkey& parsed) {
+    // libsecp256k1 aborts on a null input pointer, which an empty span has
+    if (publicKey.size() != Secp256k1::COMPRESSED_KEY_SIZE &&
+        publicKey.size() != Secp256k1::UNCOMPRESSED_KEY_SIZE) {
+        return false;
+    }
+    return secp256k1_ec_pubkey_parse(context(), &parsed, publicKey.data(), publicKey.size()) ==
+           1;
+}
+
+Secp256k1::SharedPoint libEcdhPoint(std::span<const uint8_t> privateKey,
+                                    const secp256k1_pubkey& point) {
+    Secp256k1::SharedPoint result;
+    if (secp256k1_ecdh(context(), result.data(), &point, privateKey.data(), copyPoint,
+                       nullptr) != 1) {
+        throw std::runtime_error("Invalid secp256k1 key for ECDH");
+    }
+    return result;
+}
+
+Secp256k1::SharedPoint libEcdhPoint(std::span<const uint8_t> privateKey,
+                                    std::span<const uint8_t> publicKey) {
+    secp256k1_pubkey point;
+    if (!libParsePoint(publicKey, point)) {
+        throw std::runtime_error("Invalid secp256k1 key for ECDH");
+    }
+    return libEcdhPoint(privateKey, point);
+}
+
+std::vector<uint8_t> libSign(std::span<const uint8_t> privateKey,
+                             std::span<const uint8_t> data) {
+    const auto digest = messageDigest(data);
+    secp256k1_ecdsa_signature signature;
+    if (secp256k1_ecdsa_sign(context(), &signature, digest.data(), privateKey.data(), nullptr,
+                             nullptr) != 1) {
+        throw std::runtime_error("Invalid secp256k1 private key");
+    }
+
+    std::vector<uint8_t> der(72);
+    size_t length = der.size();
+    if (secp256k1_ecdsa_signature_serialize_der(context(), der.data(), &length, &signature) !=
+        1) {
+        throw std::runtime_error("Failed to sign data");
+    }
+    der.resize(length);
+    return der;
+}
+
+bool libVerify(std::span<const uint8_t> data, std::span<const uint8_t> signature,
+               std::span<const uint8_t> publicKey) {
+    secp256k1_pubkey point;
+    secp256k1_ecdsa_signature parsed;
+    if (signature.empty() || !libParsePoint(publicKey, point) ||
+        secp256k1_ecdsa_signature_parse_der(context(), &parsed, signature.data(),
+                                            signature.size()) != 1) {
+        return false;
+    }
+
+    // OpenSSL signers may produce high-S signatures, which libsecp256k1 rejects
+    secp256k1_ecdsa_signature_normalize(context(), &parsed, &parsed);
+    const auto digest = messageDigest(data);
+    return secp256k1_ecdsa_verify(context(), &parsed, digest.data(), &point) == 1;
+}
+
+#endif // BRIGHTCHAIN_HAVE_LIBSECP256K1
+
+} // namespace
+
+struct Secp256k1::PublicKey::Parsed {
+    Backend backend;
+    std::vector<uint8_t> encoded;
+    EC_POINT* point = nullptr;
+#ifdef BRIGHTCHAIN_HAVE_LIBSECP256K1
+    secp256k1_pubkey pubkey{};
+#endif
+
+    ~Parsed() { EC_POINT_free(point); }
+};
+
+Secp256k1::Backend Secp256k1::PublicKey::backend() const {
+    return parsed_ ? parsed_->backend : Secp256k1::backend();
+}
+
+std::span<const uint8_t> Secp256k1::PublicKey::encoded() const {
+    if (!parsed_) {
+        return {};
+    }
+    return parsed_->encoded;
+}
+
+bool Secp256k1::available(Backend backend) {
+    switch (backend) {
+        case Backend::OpenSsl:
+            return true;
+        case Backend::LibSecp256k1:
+#ifdef BRIGHTCHAIN_HAVE_LIBSECP256K1
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+Secp256k1::Backend Secp256k1::backend() {
+    return activeBackend.load(std::memory_order_relaxed);
+}
+
+void Secp256k1::setBackend(Backend backend) {
+    if (!available(backend)) {
+        throw std::invalid_argument("secp256k1 backend not compiled in");
+    }
+    activeBackend.store(backend, std::memory_order_relaxed);
+}
+
+Secp256k1::SharedSecret Secp256k1::ecdh(std::span<const uint8_t> privateKey,
+                                        std::span<const uint8_t> publicKey) {
+    const SharedPoint point = ecdhPoint(privateKey, publicKey);
+    SharedSecret secret;
+    std::copy_n(point.begin() + 1, secret.size(), secret.begin());
+    return secret;
+}
+
+Secp256k1::SharedPoint Secp256k1::ecdhPoint(std::span<const uint8_t> privateKey,
+                                            std::span<const uint8_t> publicKey) {
+    requirePrivateKeySize(privateKey);
+#ifdef BRIGHTCHAIN_HAVE_LIBSECP256K1
+    if (backend() == Backend::LibSecp256k1) {
+        return libEcdhPoint(privateKey, publicKey);
+    }
+#endif
+    return opensslEcdhPoint(privateKey, publicKey);
+}
+
+Secp256k1::PublicKey Secp256k1::parsePublicKey(std::span<const uint8_t> publicKey) {
+    auto parsed = std::make_shared<PublicKey::Parsed>();
+    parsed->backend = backend();
+    parsed->encoded.assign(publicKey.begin(), publicKey.end());
+
+#ifdef BRIGHTCHAIN_HAVE_LIBSECP256K1
+    if (parsed->backend == Backend::LibSecp256k1) {
+        if (!libParsePoint(publicKey, parsed->pubkey)) {
+            throw std::runtime_error("Invalid secp256k1 public key");
+        }
+        PublicKey key;
+        key.parsed_ = std::move(parsed);
+        return key;
+    }
+#endif
+    parsed->point = opensslPoint(publicKey);
+    if (!parsed->point) {
+        throw std::runtime_error("Invalid secp256k1 public key");
+    }
+    PublicKey key;
+    key.parsed_ = std::move(parsed);
+    return key;
+}
+
+Secp256k1::SharedSecret Secp256k1::ecdh(std::span<const uint8_t> privateKey,
+                                        const PublicKey& publicKey) {
+    const SharedPoint point = ecdhPoint(privateKey, publicKey);
+    SharedSecret secret;
+    std::copy_n(point.begin() + 1, secret.size(), secret.begin());
+    return secret;
+}
+
+Secp256k1::SharedPoint Secp256k1::ecdhPoint(std::span<const uint8_t> privateKey,
+                                            const PublicKey& publicKey) {
+    if (publicKey.empty()) {
+        throw std::runtime_error("Invalid secp256k1 key for ECDH");
+    }
+    const PublicKey::Parsed& parsed = *publicKey.parsed_;
+    if (parsed.backend != backend()) {
+        return ecdhPoint(privateKey, parsed.encoded);
+    }
+
+    requirePrivateKeySize(privateKey);
+#ifdef BRIGHTCHAIN_HAVE_LIBSECP256K1
+    if (parsed.backend == Backend::LibSecp256k1) {
+        return libEcdhPoint(privateKey, parsed.pubkey);
+    }
+#endif
+    return opensslEcdhPoint(privateKey, parsed.point);
+}
+
+std::vector<uint8_t> Secp256k1::sign(std::span<const uint8_t> privateKey,
+                                     std::span<const uint8_t> data) {
+    requirePrivateKeySize(privateKey);
+#ifdef BRIGHTCHAIN_HAVE_LIBSECP256K1
+    if (backend() == Backend::LibSecp256k1) {
+        return libSign(privateKey, data);
+    }
+#endif
+    return opensslSign(privateKey, data);
+}
+
+bool Secp256k1::verify(std::span<const uint8_t> data, std::span<const uint8_t> signature,
+                       std::span<const uint8_t> publicKey) {
+#ifdef BRIGHTCHAIN_HAVE_LIBSECP256K1
+    if (backend() == Backend::LibSecp256k1) {
+        return libVerify(data, signature, publicKey);
+    }
+#endif
+    return opensslVerify(data, signature, publicKey);
+}
+
+PublicKeyCache::PublicKeyCache(size_t capacity, size_t shardCount) : capacity_(capacity) {
+    if (shardCount == 0) {
+        throw std::invalid_argument("Shard count must be positive");
+    }
+
+    shards_.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        auto shard = std::make_unique<Shard>();
+        // Spread the remainder so the shard capacities sum to the total
+        shard->capacity = capacity / shardCount + (i < capacity % shardCount ? 1 : 0);
+        shards_.push_back(std::move(shard));
+    }
+}
+
+size_t PublicKeyCache::EncodingHash::operator()(const Encoding& encoding) const {
+    // The x coordinate after the prefix byte is already uniformly distributed
+    uint64_t value = 0;
+    if (encoding.size() > sizeof(value)) {
+        std::memcpy(&value, encoding.data() + 1, sizeof(value));
+    } else {
+        std::memcpy(&value, encoding.data(), encoding.size());
+    }
+    return static_cast<size_t>(value);
+}
+
+PublicKeyCache::Shard& PublicKeyCache::shardFor(const Encoding& encoding) {
+    // Stripe on different bytes than EncodingHash so the per-shard hash
+    // tables stay evenly loaded.
+    uint64_t value = 0;
+    if (encoding.size() >= 1 + 2 * sizeof(value)) {
+        std::memcpy(&value, encoding.data() + 1 + sizeof(value), sizeof(value));
+    }
+    return *shards_[value % shards_.size()];
+}
+
+Secp256k1::PublicKey PublicKeyCache::get(std::span<const uint8_t> publicKey) {
+    Encoding encoding(publicKey.begin(), publicKey.end());
+    Shard& shard = shardFor(encoding);
+    const auto active = Secp256k1::backend();
+
+    {
+        std::lock_guard lock(shard.mutex);
+        auto it = shard.index.find(encoding);
+        if (it != shard.index.end() && it->second->second.backend() == active) {
+            ++shard.stats.hits;
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return it->second->second;
+        }
+        ++shard.stats.misses;
+    }
+
+    // Parse outside the lock; a concurrent miss on the same key parses twice
+    // and the later insert wins.
+    Secp256k1::PublicKey key = Secp256k1::parsePublicKey(publicKey);
+
+    std::lock_guard lock(shard.mutex);
+    if (shard.capacity == 0) {
+        return key;
+    }
+    auto it = shard.index.find(encoding);
+    if (it != shard.index.end()) {
+        it->second->second = key;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return key;
+    }
+
+    shard.lru.emplace_front(encoding, key);
+    shard.index.emplace(std::move(encoding), shard.lru.begin());
+    while (shard.lru.size() > shard.capacity) {
+        shard.index.erase(shard.lru.back().first);
+        shard.lru.pop_back();
+        ++shard.stats.evictions;
+    }
+    return key;
+}
+
+void PublicKeyCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard lock(shard->mutex);
+        shard->index.clear();
+        shard->lru.clear();
+    }
+}
+
+PublicKeyCacheStats PublicKeyCache::stats() const {
+    PublicKeyCacheStats total;
+    for (const auto& shard : shards_) {
+        std::lock_guard lock(shard->mutex);
+        total.hits += shard->stats.hits;
+        total.misses += shard->stats.misses;
+        total.evictions += shard->stats.evictions;
+        total.entries += shard->lru.size();
+    }
+    return total;
+}
+
+PublicKeyCache& PublicKeyCache::shared() {
+    static PublicKeyCache cache;
+    return cache;
+}
+
+} // namespace brightchain
@@ -0,0 +1,301 @@
+#include "brightchain/segmented_aead.hpp"
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/kdf.h>
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+
+namespace brightchain {
+
+namespace {
+
+constexpr uint8_t MAGIC[4] = {'B', 'S', 'E', 'G'};
+constexpr uint8_t FORMAT_VERSION = 1;
+constexpr size_t MAX_SEGMENT_SIZE = size_t{1} << 31;
+
+// Header bytes before the MAC: bound into every segment and the MAC
+constexpr size_t BOUND_HEADER_SIZE = 32;
+constexpr size_t IV_OFFSET = 20;
+constexpr size_t MAC_SIZE = 32;
+
+// Below this payload size the pool costs more than it saves
+constexpr size_t PARALLEL_THRESHOLD = 2 * 1024 * 1024;
+
+struct Header {
+    size_t segmentSize;
+    uint64_t payloadSize;
+    AesGcm::IV iv;
+};
+
+/**
+ * Per-message encryption and MAC keys split from the caller's key with
+ * HKDF-SHA256, wiped when they go out of scope.
+ */
+struct DerivedKeys {
+    DerivedKeys(const AesGcm::Key& key, const AesGcm::IV& iv);
+    ~DerivedKeys();
+
+    DerivedKeys(const DerivedKeys&) = delete;
+    DerivedKeys& operator=(const DerivedKeys&) = delete;
+
+    AesGcm::Key encryption;
+    std::array<uint8_t, MAC_SIZE> mac;
+};
+
+void writeUint32(uint8_t* out, uint32_t value) {
+    for (int i = 3; i >= 0; --i) {
+        out[i] = static_cast<uint8_t>(value);
+        value >>= 8;
+    }
+}
+
+void writeUint64(uint8_t* out, uint64_t value) {
+    for (int i = 7; i >= 0; --i) {
+        out[i] = static_cast<uint8_t>(value);
+        value >>= 8;
+    }
+}
+
+uint64_t readUint64(const uint8_t* in, size_t length) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < length; ++i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+size_t segmentCount(uint64_t payloadSize, size_t segmentSize) {
+    return static_cast<size_t>((payloadSize + segmentSize - 1) / segmentSize);
+}
+
+AesGcm::IV segmentNonce(size_t index) {
+    AesGcm::IV nonce{};
+    writeUint64(nonce.data() + nonce.size() - 8, index);
+    return nonce;
+}
+
+Header parseHeader(std::span<const uint8_t> sealed) {
+    if (sealed.size() < SegmentedAead::HEADER_SIZE ||
+        std::memcmp(sealed.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("Not a segmented AEAD payload");
+    }
+    if (sealed[4] != FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported segmented AEAD version");
+    }
+
+    Header header;
+    header.segmentSize = static_cast<size_t>(readUint64(sealed.data() + 8, 4));
+    header.payloadSize = readUint64(sealed.data() + 12, 8);
+    std::copy_n(sealed.data() + IV_OFFSET, header.iv.size(), header.iv.begin());
+    if (header.segmentSize == 0 || header.segmentSize > MAX_SEGMENT_SIZE) {
+        throw std::runtime_error("Invalid segmented AEAD segment size");
+    }
+    return header;
+}
+
+/**
+ * Segment count of a parsed header, checked against the sealed length.
+ */
+size_t checkedSegmentCount(const Header& header, size_t sealedSize) {
+    const size_t segments = segmentCount(header.payloadSize, header.segmentSize);
+    if ((sealedSize - SegmentedAead::HEADER_SIZE) / AesGcm::TAG_SIZE < segments ||
+        sealedSize - SegmentedAead::HEADER_SIZE - segments * AesGcm::TAG_SIZE !=
+            header.payloadSize) {
+        throw std::runtime_error("Segmented AEAD payload has the wrong length");
+    }
+    return segments;
+}
+
+DerivedKeys::DerivedKeys(const AesGcm::Key& key, const AesGcm::IV& iv) {
+    static constexpr char INFO[] = "brightchain-segmented-aead-v1";
+
+    std::array<uint8_t, AesGcm::KEY_SIZE + MAC_SIZE> okm;
+    EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
+    if (!pctx ||
+        EVP_PKEY_derive_init(pctx) <= 0 ||
+        EVP_PKEY_CTX_set_hkdf_md(pctx, EVP_sha256()) <= 0 ||
+        EVP_PKEY_CTX_set1_hkdf_key(pctx, key.data(), key.size()) <= 0 ||
+        EVP_PKEY_CTX_set1_hkdf_salt(pctx, iv.data(), iv.size()) <= 0 ||
+        EVP_PKEY_CTX_add1_hkdf_info(pctx, reinterpret_cast<const unsigned char*>(INFO),
+                                    sizeof(INFO) - 1) <= 0) {
+        EVP_PKEY_CTX_free(pctx);
+        throw std::runtime_error("Failed to setup HKDF for segmented AEAD");
+    }
+
+    size_t length = okm.size();
+    if (EVP_PKEY_derive(pctx, okm.data(), &length) <= 0 || length != okm.size()) {
+        EVP_PKEY_CTX_free(pctx);
+        OPENSSL_cleanse(okm.data(), okm.size());
+        throw std::runtime_error("Failed to derive segmented AEAD keys");
+    }
+    EVP_PKEY_CTX_free(pctx);
+
+    std::copy_n(okm.begin(), encryption.size(), encryption.begin());
+    std::copy_n(okm.begin() + encryption.size(), mac.size(), mac.begin());
+    OPENSSL_cleanse(okm.data(), okm.size());
+}
+
+DerivedKeys::~DerivedKeys() {
+    OPENSSL_cleanse(encryption.data(), encryption.size());
+    OPENSSL_cleanse(mac.data(), mac.size());
+}
+
+/**
+ * HMAC-SHA256 over the bound header, the caller's AAD and the tag table.
+ */
+std::array<uint8_t, MAC_SIZE> headerMac(const DerivedKeys& keys, const uint8_t* header,
+                                        std::span<const uint8_t> aad,
+                                        std::span<const uint8_t> tags) {
+    std::vector<uint8_t> input(BOUND_HEADER_SIZE + 8 + aad.size() + tags.size());
+    uint8_t* out = input.data();
+    std::memcpy(out, header, BOUND_HEADER_SIZE);
+    writeUint64(out + BOUND_HEADER_SIZE, aad.size());
+    std::copy(aad.begin(), aad.end(), out + BOUND_HEADER_SIZE + 8);
+    std::copy(tags.begin(), tags.end(), out + BOUND_HEADER_SIZE + 8 + aad.size());
+
+    std::array<uint8_t, MAC_SIZE> mac;
+    unsigned int length = 0;
+    if (!HMAC(EVP_sha256(), keys.mac.data(), keys.mac.size(), input.data(), input.size(),
+              mac.data(), &length) ||
+        length != mac.size()) {
+        throw std::runtime_error("Failed to compute segmented AEAD header MAC");
+    }
+    return mac;
+}
+
+} // namespace
+
+SegmentedAead::SegmentedAead(size_t segmentSize, ThreadPool& pool)
+    : segmentSize_(segmentSize), pool_(pool) {
+    if (segmentSize_ == 0 || segmentSize_ > MAX_SEGMENT_SIZE) {
+        throw std::invalid_argument("Segment size must be between 1 and 2^31 bytes");
+    }
+}
+
+size_t SegmentedAead::sealedSize(size_t plaintextSize) const {
+    return HEADER_SIZE + segmentCount(plaintextSize, segmentSize_) * AesGcm::TAG_SIZE +
+           plaintextSize;
+}
+
+template <typename Fn>
+void SegmentedAead::forSegments(size_t segments, size_t payloadSize, Fn&& fn) const {
+    if (payloadSize < PARALLEL_THRESHOLD) {
+        fn(size_t{0}, segments);
+        return;
+    }
+    pool_.parallelFor(0, segments, fn);
+}
+
+void SegmentedAead::encrypt(std::span<const uint8_t> plaintext, std::span<uint8_t> sealed,
+                            const AesGcm::Key& key, std::span<const uint8_t> aad) const {
+    if (sealed.size() < sealedSize(plaintext.size())) {
+        throw std::invalid_argument("Output buffer too small for sealed payload");
+    }
+
+    const size_t segments = segmentCount(plaintext.size(), segmentSize_);
+    uint8_t* header = sealed.data();
+    std::memset(header, 0, HEADER_SIZE);
+    std::memcpy(header, MAGIC, sizeof(MAGIC));
+    header[4] = FORMAT_VERSION;
+    writeUint32(header + 8, static_cast<uint32_t>(segmentSize_));
+    writeUint64(header + 12, plaintext.size());
+    const AesGcm::IV iv = AesGcm::generateIV();
+    std::copy(iv.begin(), iv.end(), header + IV_OFFSET);
+
+    const DerivedKeys keys(key, iv);
+    const std::span<const uint8_t> bound(header, BOUND_HEADER_SIZE);
+    uint8_t* tags = sealed.data() + HEADER_SIZE;
+    uint8_t* ciphertext = tags + segments * AesGcm::TAG_SIZE;
+
+    forSegments(segments, plaintext.size(), [&](size_t first, size_t last) {
+        AesGcmStream stream(AesGcmStream::Mode::Encrypt);
+        for (size_t i = first; i < last; ++i) {
+            const size_t offset = i * segmentSize_;
+            const size_t length = std::min(segmentSize_, plaintext.size() - offset);
+            if (i == first) {
+                stream.init(keys.encryption, segmentNonce(i), bound);
+            } else {
+                stream.init(segmentNonce(i), bound);
+            }
+            stream.update(plaintext.subspan(offset, length),
+                          std::span<uint8_t>(ciphertext + offset, length));
+            const AesGcm::Tag tag = stream.finish();
+            std::copy(tag.begin(), tag.end(), tags + i * AesGcm::TAG_SIZE);
+        }
+    });
+
+    const auto mac = headerMac(keys, header, aad,
+                               std::span<const uint8_t>(tags, segments * AesGcm::TAG_SIZE));
+    std::copy(mac.begin(), mac.end(), header + BOUND_HEADER_SIZE);
+}
+
+std::vector<uint8_t> SegmentedAead::encrypt(std::span<const uint8_t> plaintext,
+                                            const AesGcm::Key& key,
+                                            std::span<const uint8_t> aad) const {
+    std::vector<uint8_t> sealed(sealedSize(plaintext.size()));
+    encrypt(plaintext, sealed, key, aad);
+    return sealed;
+}
+
+void SegmentedAead::decrypt(std::span<const uint8_t> sealed, std::span<uint8_t> plaintext,
+                            const AesGcm::Key& key, std::span<const uint8_t> aad) const {
+    const Header header = parseHeader(sealed);
+    const size_t segments = checkedSegmentCount(header, sealed.size());
+    if (plaintext.size() < header.payloadSize) {
+        throw std::invalid_argument("Output buffer too small for payload");
+    }
+
+    const DerivedKeys keys(key, header.iv);
+    const uint8_t* tags = sealed.data() + HEADER_SIZE;
+    const auto mac = headerMac(keys, sealed.data(), aad,
+                               std::span<const uint8_t>(tags, segments * AesGcm::TAG_SIZE));
+    if (CRYPTO_memcmp(mac.data(), sealed.data() + BOUND_HEADER_SIZE, mac.size()) != 0) {
+        throw std::runtime_error("Authentication failed - data may be corrupted");
+    }
+
+    const std::span<const uint8_t> bound(sealed.data(), BOUND_HEADER_SIZE);
+    const uint8_t* ciphertext = tags + segments * AesGcm::TAG_SIZE;
+    const size_t payloadSize = static_cast<size_t>(header.payloadSize);
+    const size_t segmentSize = header.segmentSize;
+
+    forSegments(segments, payloadSize, [&](size_t first, size_t last) {
+        AesGcmStream stream(AesGcmStream::Mode::Decrypt);
+        for (size_t i = first; i < last; ++i) {
+            const size_t offset = i * segmentSize;
+            const size_t length = std::min(segmentSize, payloadSize - offset);
+            if (i == first) {
+                stream.init(keys.encryption, segmentNonce(i), bound);
+            } else {
+                stream.init(segmentNonce(i), bound);
+            }
+            stream.update(std::span<const uint8_t>(ciphertext + offset, length),
+                          plaintext.subspan(offset, length));
+            AesGcm::Tag tag;
+            std::copy_n(tags + i * AesGcm::TAG_SIZE, tag.size(), tag.begin());
+            stream.finish(tag);
+        }
+    });
+}
+
+std::vector<uint8_t> SegmentedAead::decrypt(std::span<const uint8_t> sealed,
+                                            const AesGcm::Key& key,
+                                            std::span<const uint8_t> aad) const {
+    std::vector<uint8_t> plaintext(plaintextSize(sealed));
+    decrypt(sealed, plaintext, key, aad);
+    return plaintext;
+}
+
+size_t SegmentedAead::plaintextSize(std::span<const uint8_t> sealed) {
+    const Header header = parseHeader(sealed);
+    checkedSegmentCount(header, sealed.size());
+    return static_cast<size_t>(header.payloadSize);
+}
+
+bool SegmentedAead::isSegmented(std::span<const uint8_t> data) {
+    return data.size() >= HEADER_SIZE && std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) == 0;
+}
+
+} // namespace brightchain
@@ -0,0 +1,241 @@
+#include "brightchain/sha3_batch.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BRIGHTCHAIN_SHA3_SIMD 1
+#endif
+
+namespace brightchain {
+
+namespace {
+
+#ifdef BRIGHTCHAIN_SHA3_SIMD
+
+constexpr size_t RATE = 72; // SHA3-512: 1600 - 2 * 512 bits
+constexpr size_t RATE_LANES = RATE / 8;
+constexpr size_t DIGEST_LANES = Checksum::HASH_SIZE / 8;
+
+constexpr std::array<uint64_t, 24> ROUND_CONSTANTS = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808AULL,
+    0x8000000080008000ULL, 0x000000000000808BULL, 0x0000000080000001ULL,
+    0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008AULL,
+    0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000AULL,
+    0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL,
+    0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+    0x000000000000800AULL, 0x800000008000000AULL, 0x8000000080008081ULL,
+    0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL};
+
+// Rotation offsets indexed by x + 5y
+constexpr std::array<int, 25> RHO = {0,  1,  62, 28, 27, 36, 44, 6,  55, 20, 3,  10, 43,
+                                     25, 39, 41, 45, 15, 21, 8,  18, 2,  61, 56, 14};
+
+// Lane vectors: element k is the same lane of Keccak state k
+typedef uint64_t Lanes4 __attribute__((vector_size(32)));
+typedef uint64_t Lanes8 __attribute__((vector_size(64)));
+
+// Helpers take vectors by reference: they are compiled without AVX and only
+// become vector code once inlined into a kernel
+template <typename V>
+__attribute__((always_inline)) inline void rotl(V& out, const V& x, int n) {
+    out = (x << n) | (x >> (64 - n));
+}
+
+/**
+ * Keccak-f[1600] on N interleaved states. Written with vector extensions
+ * only, so it is inlined into (and compiled for) each target-specific kernel.
+ */
+template <typename V>
+__attribute__((always_inline)) inline void keccakF1600(V* a) {
+    for (uint64_t roundConstant : ROUND_CONSTANTS) {
+        // Fully unrolled so lane indices and rotation counts are constants
+        V c[5];
+#pragma GCC unroll 5
+        for (int x = 0; x < 5; ++x) {
+            c[x] = a[x] ^ a[x + 5] ^ a[x + 10] ^ a[x + 15] ^ a[x + 20];
+        }
+#pragma GCC unroll 5
+        for (int x = 0; x < 5; ++x) {
+            V d;
+            rotl(d, c[(x + 1) % 5], 1);
+            d ^= c[(x + 4) % 5];
+#pragma GCC unroll 5
+            for (int y = 0; y < 25; y += 5) {
+                a[x + y] ^= d;
+            }
+        }
+
+        // Rho and pi: lane (x, y) moves to (y, 2x + 3y)
+        V b[25];
+        b[0] = a[0];
+#pragma GCC unroll 25
+        for (int i = 1; i < 25; ++i) {
+            const int x = i % 5;
+            const int y = i / 5;
+            rotl(b[y + 5 * ((2 * x + 3 * y) % 5)], a[i], RHO[i]);
+        }
+
+#pragma GCC unroll 5
+        for (int y = 0; y < 25; y += 5) {
+#pragma GCC unroll 5
+            for (int x = 0; x < 5; ++x) {
+                a[y + x] = b[y + x] ^ (~b[y + (x + 1) % 5] & b[y + (x + 2) % 5]);
+            }
+        }
+        a[0] ^= roundConstant;
+    }
+}
+
+template <typename V, size_t N>
+__attribute__((always_inline)) inline void absorbBlock(V* state,
+                                                       const uint8_t* const* blocks) {
+    for (size_t j = 0; j < RATE_LANES; ++j) {
+        V lane;
+        for (size_t k = 0; k < N; ++k) {
+            uint64_t word;
+            std::memcpy(&word, blocks[k] + j * 8, 8); // x86-64 is little-endian
+            lane[k] = word;
+        }
+        state[j] ^= lane;
+    }
+    keccakF1600(state);
+}
+
+/**
+ * SHA3-512 of N equal-length buffers.
+ */
+template <typename V, size_t N>
+__attribute__((always_inline)) inline void sha3Lanes(const uint8_t* const* inputs,
+                                                     size_t length, uint8_t* const* outputs) {
+    V state[25];
+    for (auto& lane : state) {
+        lane = V{};
+    }
+
+    const uint8_t* blocks[N];
+    size_t offset = 0;
+    for (; length - offset >= RATE; offset += RATE) {
+        for (size_t k = 0; k < N; ++k) {
+            blocks[k] = inputs[k] + offset;
+        }
+        absorbBlock<V, N>(state, blocks);
+    }
+
+    // Final block with SHA3 domain padding (0x06 ... 0x80)
+    uint8_t tails[N][RATE];
+    const size_t remainder = length - offset;
+    for (size_t k = 0; k < N; ++k) {
+        std::memset(tails[k], 0, RATE);
+        if (remainder) {
+            std::memcpy(tails[k], inputs[k] + offset, remainder);
+        }
+        tails[k][remainder] ^= 0x06;
+        tails[k][RATE - 1] ^= 0x80;
+        blocks[k] = tails[k];
+    }
+    absorbBlock<V, N>(state, blocks);
+
+    for (size_t k = 0; k < N; ++k) {
+        for (size_t j = 0; j < DIGEST_LANES; ++j) {
+            uint64_t word = state[j][k];
+            std::memcpy(outputs[k] + j * 8, &word, 8);
+        }
+    }
+}
+
+__attribute__((target("avx2"))) void sha3x4(const uint8_t* const* inputs, size_t length,
+                                            uint8_t* const* outputs) {
+    sha3Lanes<Lanes4, 4>(inputs, length, outputs);
+}
+
+__attribute__((target("avx512f"))) void sha3x8(const uint8_t* const* inputs, size_t length,
+                                               uint8_t* const* outputs) {
+    sha3Lanes<Lanes8, 8>(inputs, length, outputs);
+}
+
+template <size_t N, typename Kernel>
+void runGroups(std::span<const uint8_t* const> inputs, size_t length,
+               Checksum::HashArray* outputs, Kernel kernel) {
+    for (size_t first = 0; first < inputs.size(); first += N) {
+        const size_t count = std::min(N, inputs.size() - first);
+        const uint8_t* group[N];
+        uint8_t* digests[N];
+        Checksum::HashArray idle[N];
+        for (size_t k = 0; k < N; ++k) {
+            // Idle lanes rehash the first input into scratch space
+            group[k] = inputs[first + (k < count ? k : 0)];
+            digests[k] = k < count ? outputs[first + k].data() : idle[k].data();
+        }
+        kernel(group, length, digests);
+    }
+}
+
+#endif // BRIGHTCHAIN_SHA3_SIMD
+
+bool supported(Sha3Kernel kernel) {
+    switch (kernel) {
+        case Sha3Kernel::Scalar:
+            return true;
+#ifdef BRIGHTCHAIN_SHA3_SIMD
+        case Sha3Kernel::Avx2x4:
+            return __builtin_cpu_supports("avx2");
+        case Sha3Kernel::Avx512x8:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+Sha3Kernel sha3BestKernel() {
+    static const Sha3Kernel best = []() {
+        if (supported(Sha3Kernel::Avx512x8)) {
+            return Sha3Kernel::Avx512x8;
+        }
+        if (supported(Sha3Kernel::Avx2x4)) {
+            return Sha3Kernel::Avx2x4;
+        }
+        return Sha3Kernel::Scalar;
+    }();
+    return best;
+}
+
+size_t sha3KernelLanes(Sha3Kernel kernel) {
+    switch (kernel) {
+        case Sha3Kernel::Avx2x4:
+            return 4;
+        case Sha3Kernel::Avx512x8:
+            return 8;
+        default:
+            return 1;
+    }
+}
+
+void sha3_512Batch(std::span<const uint8_t* const> inputs, size_t length,
+                   Checksum::HashArray* outputs, Sha3Kernel kernel) {
+    if (!supported(kernel)) {
+        throw std::invalid_argument("SHA3 kernel is not supported on this CPU");
+    }
+
+    switch (kernel) {
+#ifdef BRIGHTCHAIN_SHA3_SIMD
+        case Sha3Kernel::Avx2x4:
+            runGroups<4>(inputs, length, outputs, sha3x4);
+            return;
+        case Sha3Kernel::Avx512x8:
+            runGroups<8>(inputs, length, outputs, sha3x8);
+            return;
+#endif
+        default:
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                outputs[i] = Checksum::fromData(inputs[i], length).hash();
+            }
+            return;
+    }
+}
+
+} // namespace brightchain
@@ -0,0 +1,216 @@
+#include "brightchain/super_cbl_builder.hpp"
+#include "brightchain/cbl.hpp"
+#include "brightchain/super_cbl.hpp"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+
+namespace brightchain {
+
+namespace {
+
+uint64_t nowMillis() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::system_clock::now().time_since_epoch())
+                                     .count());
+}
+
+void appendHashes(std::vector<uint8_t>& node, const std::vector<Checksum>& hashes) {
+    node.reserve(node.size() + hashes.size() * Checksum::HASH_SIZE);
+    for (const auto& hash : hashes) {
+        node.insert(node.end(), hash.hash().begin(), hash.hash().end());
+    }
+}
+
+} // namespace
+
+SuperCBLBuilder::SuperCBLBuilder(DiskBlockStore& store, const SuperCBLBuilderOptions& options,
+                                 ThreadPool& pool)
+    : store_(store), pool_(pool), options_(options),
+      blockLength_(blockSizeToLength(store.blockSize())),
+      window_(std::max<size_t>(pool.size() * 2, 2)) {
+    if (options_.tupleSize == 0) {
+        throw std::invalid_argument("Tuple size must be positive");
+    }
+
+    const size_t leafOverhead =
+        CBLHeader::SIZE + (options_.metadata ? options_.metadata->size() : 0);
+    const size_t leafSlots =
+        blockLength_ > leafOverhead ? (blockLength_ - leafOverhead) / Checksum::HASH_SIZE : 0;
+    leafCapacity_ = leafSlots - leafSlots % options_.tupleSize;
+    fanout_ = blockLength_ > SuperCBLHeader::SIZE
+                  ? (blockLength_ - SuperCBLHeader::SIZE) / Checksum::HASH_SIZE
+                  : 0;
+
+    if (leafCapacity_ == 0) {
+        throw std::invalid_argument("Block size " + blockSizeToString(store.blockSize()) +
+                                    " cannot hold one tuple in a CBL");
+    }
+    if (fanout_ < 2) {
+        throw std::invalid_argument("Block size " + blockSizeToString(store.blockSize()) +
+                                    " cannot hold two SuperCBL children");
+    }
+}
+
+SuperCBLBuilder::~SuperCBLBuilder() {
+    // Tasks reference the store; never leave them running
+    for (auto& pending : inFlight_) {
+        pending.wait();
+    }
+}
+
+void SuperCBLBuilder::add(const Checksum& address) {
+    if (finished_) {
+        throw std::logic_error("SuperCBLBuilder already finished");
+    }
+    // Full nodes are stored lazily, once it is certain they are not the last
+    if (leaf_.size() == leafCapacity_) {
+        flushLeaf(std::nullopt, std::nullopt);
+    }
+    leaf_.push_back(address);
+    ++result_.addressCount;
+}
+
+SuperCBLBuildResult SuperCBLBuilder::finish(uint64_t originalDataLength,
+                                            const Checksum& originalDataChecksum) {
+    if (finished_) {
+        throw std::logic_error("SuperCBLBuilder already finished");
+    }
+    finished_ = true;
+    if (result_.addressCount % options_.tupleSize != 0) {
+        throw std::runtime_error("Address count " + std::to_string(result_.addressCount) +
+                                 " is not a multiple of the tuple size");
+    }
+
+    std::shared_future<Checksum> root;
+    if (levels_.empty()) {
+        root = flushLeaf(originalDataLength, originalDataChecksum);
+    } else {
+        flushLeaf(originalDataLength, std::nullopt);
+        // Every level below the top now has at least one child
+        for (size_t level = 0; level + 1 < levels_.size(); ++level) {
+            flushLevel(level, originalDataLength, std::nullopt);
+        }
+        root = flushLevel(levels_.size() - 1, originalDataLength, originalDataChecksum);
+        result_.depth = static_cast<uint16_t>(levels_.size());
+    }
+
+    result_.root = root.get();
+    while (!inFlight_.empty()) {
+        inFlight_.front().get();
+        inFlight_.pop_front();
+    }
+    return result_;
+}
+
+uint64_t SuperCBLBuilder::nodeLength(uint64_t firstTuple, uint64_t tuples,
+                                     std::optional<uint64_t> totalLength) const {
+    const uint64_t covered = tuples * blockLength_;
+    if (!totalLength) {
+        return covered;
+    }
+    const uint64_t start = firstTuple * blockLength_;
+    return start >= *totalLength ? 0 : std::min(covered, *totalLength - start);
+}
+
+std::shared_future<Checksum> SuperCBLBuilder::submit(std::function<Checksum()> task) {
+    while (inFlight_.size() >= window_) {
+        inFlight_.front().get();
+        inFlight_.pop_front();
+    }
+    auto future = pool_.submit(std::move(task)).share();
+    inFlight_.push_back(future);
+    return future;
+}
+
+std::shared_future<Checksum> SuperCBLBuilder::flushLeaf(
+    std::optional<uint64_t> totalLength, std::optional<Checksum> rootChecksum) {
+    const uint64_t addressCount = leaf_.size();
+    const uint64_t tuples = addressCount / options_.tupleSize;
+
+    CBLHeader header;
+    header.creatorId = options_.creatorId;
+    header.dateCreated = nowMillis();
+    header.addressCount = static_cast<uint32_t>(leaf_.size());
+    header.tupleSize = options_.tupleSize;
+    header.originalDataLength = nodeLength(leafFirstTuple_, tuples, totalLength);
+    header.originalDataChecksum =
+        rootChecksum ? rootChecksum->hash() : Checksum::HashArray{};
+    header.signature.fill(0);
+
+    auto future = submit([this, header, addresses = std::move(leaf_)]() {
+        std::vector<uint8_t> node =
+            options_.metadata ? ExtendedCBL::serializeHeader(header, *options_.metadata)
+                              : header.serialize();
+        appendHashes(node, addresses);
+        const size_t length = node.size();
+        node.resize(blockLength_, 0);
+        return store_.put(node, BlockMetadata(store_.blockSize(), length));
+    });
+    ++result_.cblCount;
+
+    leaf_.clear();
+    leafFirstTuple_ += tuples;
+    if (!rootChecksum) {
+        push(0, Child{future, tuples, addressCount});
+    }
+    return future;
+}
+
+void SuperCBLBuilder::push(size_t level, Child child) {
+    if (level == levels_.size()) {
+        levels_.emplace_back();
+        levelFirstTuple_.push_back(0);
+    }
+    if (levels_[level].size() == fanout_) {
+        flushLevel(level, std::nullopt, std::nullopt);
+    }
+    levels_[level].push_back(std::move(child));
+}
+
+std::shared_future<Checksum> SuperCBLBuilder::flushLevel(
+    size_t level, std::optional<uint64_t> totalLength, std::optional<Checksum> rootChecksum) {
+    std::vector<Child> children;
+    children.swap(levels_[level]);
+
+    uint64_t tuples = 0;
+    uint64_t addresses = 0;
+    std::vector<Checksum> checksums;
+    checksums.reserve(children.size());
+    for (auto& child : children) {
+        tuples += child.tuples;
+        addresses += child.addresses;
+        // Children were submitted well before their parent and are usually done
+        checksums.push_back(child.checksum.get());
+    }
+
+    SuperCBLHeader header;
+    header.creatorId = options_.creatorId;
+    header.dateCreated = nowMillis();
+    header.subCblCount = static_cast<uint32_t>(checksums.size());
+    header.totalBlockCount = static_cast<uint32_t>(
+        std::min<uint64_t>(addresses, std::numeric_limits<uint32_t>::max()));
+    header.depth = static_cast<uint16_t>(level + 1);
+    header.originalDataLength = nodeLength(levelFirstTuple_[level], tuples, totalLength);
+    header.originalDataChecksum =
+        rootChecksum ? rootChecksum->hash() : Checksum::HashArray{};
+    header.signature.fill(0);
+
+    auto future = submit([this, header, checksums = std::move(checksums)]() {
+        std::vector<uint8_t> node = header.serialize();
+        appendHashes(node, checksums);
+        const size_t length = node.size();
+        node.resize(blockLength_, 0);
+        return store_.put(node, BlockMetadata(store_.blockSize(), length));
+    });
+    ++result_.superCblCount;
+
+    levelFirstTuple_[level] += tuples;
+    if (!rootChecksum) {
+        push(level + 1, Child{future, tuples, addresses});
+    }
+    return future;
+}
+
+} // namespace brightchain
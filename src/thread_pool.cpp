@@ -0,0 +1,87 @@
+#include "brightchain/thread_pool.hpp"
+#include <algorithm>
+
+namespace brightchain {
+
+namespace {
+
+thread_local const ThreadPool* currentPool = nullptr;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers_.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    available_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::post(std::function<void()> task) {
+    {
+        std::lock_guard lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    available_.notify_one();
+}
+
+void ThreadPool::waitIdle() {
+    std::unique_lock lock(mutex_);
+    idle_.wait(lock, [this]() { return tasks_.empty() && running_ == 0; });
+}
+
+bool ThreadPool::onWorker() const {
+    return currentPool == this;
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::workerLoop() {
+    currentPool = this;
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mutex_);
+            available_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+            ++running_;
+        }
+
+        try {
+            task();
+        } catch (...) {
+            // Posted tasks report their own errors; keep the worker alive
+        }
+
+        {
+            std::lock_guard lock(mutex_);
+            --running_;
+            if (tasks_.empty() && running_ == 0) {
+                idle_.notify_all();
+            }
+        }
+    }
+}
+
+} // namespace brightchain
@@ -0,0 +1,181 @@
+#include "brightchain/tuple_whitener.hpp"
+#include "brightchain/xor_blocks.hpp"
+#include <algorithm>
+#include <cstring>
+#include <openssl/rand.h>
+#include <stdexcept>
+
+namespace brightchain {
+
+RandomBlockPool::RandomBlockPool(size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1)), rng_(std::random_device{}()) {}
+
+void RandomBlockPool::add(const Checksum& checksum) {
+    std::lock_guard lock(mutex_);
+    if (std::find(blocks_.begin(), blocks_.end(), checksum) != blocks_.end()) {
+        return;
+    }
+    if (blocks_.size() < capacity_) {
+        blocks_.push_back(checksum);
+        return;
+    }
+    std::uniform_int_distribution<size_t> pick(0, blocks_.size() - 1);
+    blocks_[pick(rng_)] = checksum;
+}
+
+void RandomBlockPool::remove(const Checksum& checksum) {
+    std::lock_guard lock(mutex_);
+    auto it = std::find(blocks_.begin(), blocks_.end(), checksum);
+    if (it != blocks_.end()) {
+        *it = blocks_.back();
+        blocks_.pop_back();
+    }
+}
+
+std::vector<Checksum> RandomBlockPool::sample(size_t count) {
+    std::lock_guard lock(mutex_);
+    count = std::min(count, blocks_.size());
+
+    // Partial Fisher-Yates: the first `count` slots become the sample
+    std::vector<Checksum> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::uniform_int_distribution<size_t> pick(i, blocks_.size() - 1);
+        std::swap(blocks_[i], blocks_[pick(rng_)]);
+        result.push_back(blocks_[i]);
+    }
+    return result;
+}
+
+size_t RandomBlockPool::size() const {
+    std::lock_guard lock(mutex_);
+    return blocks_.size();
+}
+
+TupleWhitener::TupleWhitener(DiskBlockStore& store, RandomBlockPool& pool,
+                             const WhiteningOptions& options)
+    : store_(store), pool_(pool), options_(options),
+      blockLength_(blockSizeToLength(store.blockSize())) {
+    if (options_.randomBlocks < TupleConstants::MIN_RANDOM_BLOCKS ||
+        options_.randomBlocks > TupleConstants::MAX_RANDOM_BLOCKS) {
+        throw std::invalid_argument("Random blocks per tuple must be between " +
+                                    std::to_string(TupleConstants::MIN_RANDOM_BLOCKS) +
+                                    " and " +
+                                    std::to_string(TupleConstants::MAX_RANDOM_BLOCKS));
+    }
+    if (!(options_.reuseFraction >= 0.0 && options_.reuseFraction <= 1.0)) {
+        throw std::invalid_argument("Reuse fraction must be between 0 and 1");
+    }
+}
+
+uint32_t TupleWhitener::planReuse() {
+    std::lock_guard lock(statsMutex_);
+    uint32_t reuse = 0;
+    for (uint32_t i = 0; i < options_.randomBlocks; ++i) {
+        const uint64_t total = reused_ + fresh_ + i + 1;
+        if (static_cast<double>(reused_ + reuse + 1) <= options_.reuseFraction * total) {
+            ++reuse;
+        }
+    }
+    return reuse;
+}
+
+WhitenedTuple TupleWhitener::whiten(std::span<const uint8_t> source) {
+    if (source.size() > blockLength_) {
+        throw std::invalid_argument("Source is larger than the block size");
+    }
+
+    WhitenedTuple tuple;
+    std::vector<MappedBlock> reused;
+    for (const auto& checksum : pool_.sample(planReuse())) {
+        try {
+            MappedBlock block = store_.getMapped(checksum, AccessHint::Sequential);
+            // The tuple holds its own reference to a shared random block
+            if (block.size() == blockLength_ && store_.addRef(checksum)) {
+                tuple.members.push_back(checksum);
+                reused.push_back(std::move(block));
+                continue;
+            }
+        } catch (const std::runtime_error&) {
+            // Removed from the store since it was pooled
+        }
+        pool_.remove(checksum);
+    }
+    tuple.reusedBlocks = static_cast<uint32_t>(reused.size());
+
+    const std::vector<Checksum> referenced = tuple.members;
+    try {
+        whitenInto(tuple, source, reused);
+    } catch (...) {
+        // Give back the references taken above; nothing else holds them
+        if (store_.referenceCounting()) {
+            for (const auto& checksum : referenced) {
+                store_.remove(checksum);
+            }
+        }
+        throw;
+    }
+
+    std::lock_guard lock(statsMutex_);
+    reused_ += reused.size();
+    fresh_ += options_.randomBlocks - reused.size();
+    return tuple;
+}
+
+void TupleWhitener::whitenInto(WhitenedTuple& tuple, std::span<const uint8_t> source,
+                               const std::vector<MappedBlock>& reused) {
+    std::vector<std::vector<uint8_t>> fresh(options_.randomBlocks - reused.size());
+    for (auto& block : fresh) {
+        block.resize(blockLength_);
+        if (RAND_bytes(block.data(), static_cast<int>(blockLength_)) != 1) {
+            throw std::runtime_error("Failed to generate random block");
+        }
+    }
+
+    // The output doubles as the zero-padded copy of a short source
+    std::vector<uint8_t> whitened(blockLength_, 0);
+    std::vector<const uint8_t*> sources;
+    if (source.size() == blockLength_) {
+        sources.push_back(source.data());
+    } else {
+        std::memcpy(whitened.data(), source.data(), source.size());
+        sources.push_back(whitened.data());
+    }
+    for (const auto& block : reused) {
+        sources.push_back(block.data());
+    }
+    for (const auto& block : fresh) {
+        sources.push_back(block.data());
+    }
+    xorBlocks(whitened.data(), sources, blockLength_);
+
+    const BlockMetadata metadata(store_.blockSize(), blockLength_);
+    tuple.members.insert(tuple.members.begin(), store_.put(whitened, metadata));
+    for (const auto& block : fresh) {
+        Checksum checksum = store_.put(block, metadata);
+        tuple.members.push_back(checksum);
+        pool_.add(checksum);
+    }
+}
+
+void TupleWhitener::reconstructInto(std::span<const Checksum> members, uint8_t* out) const {
+    xorTupleInto(store_, members, out, blockLength_);
+}
+
+std::vector<uint8_t> TupleWhitener::reconstruct(std::span<const Checksum> members) const {
+    std::vector<uint8_t> result(blockLength_);
+    reconstructInto(members, result.data());
+    return result;
+}
+
+uint64_t TupleWhitener::reusedCount() const {
+    std::lock_guard lock(statsMutex_);
+    return reused_;
+}
+
+uint64_t TupleWhitener::freshCount() const {
+    std::lock_guard lock(statsMutex_);
+    return fresh_;
+}
+
+} // namespace brightchain
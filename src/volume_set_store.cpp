@@ -0,0 +1,492 @@
+#include "brightchain/volume_set_store.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+
+namespace brightchain {
+
+namespace {
+
+uint64_t mix64(uint64_t x) {
+    // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * Stable volume identity: FNV-1a of the path, so placement survives restarts
+ * and does not depend on the order volumes were listed in.
+ */
+uint64_t pathId(const std::string& path) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : path) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * Weighted rendezvous score (Schindelhauer & Schomaker): -w / ln(u) with u
+ * uniform in (0, 1) per (block, volume) pair. A volume wins a share of the
+ * blocks proportional to its weight.
+ */
+double score(uint64_t blockKey, uint64_t volumeId, double weight) {
+    uint64_t h = mix64(blockKey ^ mix64(volumeId));
+    double u = (static_cast<double>(h >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+    return -weight / std::log(u);
+}
+
+uint64_t blockKey(const Checksum& checksum) {
+    uint64_t key;
+    std::memcpy(&key, checksum.hash().data(), sizeof(key));
+    return key;
+}
+
+template <typename T>
+void waitAll(std::vector<std::future<T>>& futures) {
+    std::exception_ptr error;
+    for (auto& future : futures) {
+        try {
+            future.get();
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+bool outOfSpace(const std::system_error& error) {
+    return error.code() == std::errc::no_space_on_device ||
+           error.code() == std::error_code(EDQUOT, std::generic_category());
+}
+
+bool isEmpty(const DiskBlockStore& store) {
+    bool empty = true;
+    store.forEachChecksum([&empty](const Checksum&) { empty = false; });
+    return empty;
+}
+
+} // namespace
+
+VolumeSetStore::VolumeSetStore(const std::vector<VolumeSpec>& volumes, BlockSize blockSize,
+                               const DiskBlockStoreOptions& options, ThreadPool& pool)
+    : blockSize_(blockSize), options_(options), pool_(pool) {
+    if (volumes.empty()) {
+        throw std::invalid_argument("Volume set requires at least one volume");
+    }
+    for (const auto& spec : volumes) {
+        addVolume(spec);
+    }
+}
+
+VolumeSetStore::VolumePtr VolumeSetStore::openVolume(const VolumeSpec& spec) const {
+    std::filesystem::create_directories(spec.path);
+
+    auto volume = std::make_shared<Volume>();
+    volume->path = spec.path;
+    volume->id = pathId(spec.path);
+    volume->weight = static_cast<double>(spec.weight);
+    if (spec.weight == 0) {
+        // Capacity rather than free space: it does not change as the volume
+        // fills, so placement stays stable across reopen
+        volume->weight = static_cast<double>(std::filesystem::space(spec.path).capacity);
+    }
+    if (volume->weight <= 0) {
+        volume->weight = 1;
+    }
+    volume->store = std::make_unique<DiskBlockStore>(spec.path, blockSize_, options_);
+    return volume;
+}
+
+std::vector<VolumeSetStore::VolumePtr> VolumeSetStore::snapshot() const {
+    std::shared_lock lock(mutex_);
+    return volumes_;
+}
+
+std::vector<VolumeSetStore::VolumePtr> VolumeSetStore::ranked(const Checksum& checksum,
+                                                              std::vector<VolumePtr> volumes) {
+    const uint64_t key = blockKey(checksum);
+    std::vector<std::pair<double, VolumePtr>> scored;
+    scored.reserve(volumes.size());
+    for (auto& volume : volumes) {
+        scored.emplace_back(score(key, volume->id, volume->weight), std::move(volume));
+    }
+    std::sort(scored.begin(), scored.end(),
+              [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    std::vector<VolumePtr> result;
+    result.reserve(scored.size());
+    for (auto& entry : scored) {
+        result.push_back(std::move(entry.second));
+    }
+    return result;
+}
+
+VolumeSetStore::VolumePtr VolumeSetStore::owner(const std::vector<VolumePtr>& ranking) {
+    for (const auto& volume : ranking) {
+        if (!volume->draining.load(std::memory_order_acquire)) {
+            return volume;
+        }
+    }
+    throw std::runtime_error("No volume accepts new blocks");
+}
+
+VolumeSetStore::VolumePtr VolumeSetStore::locate(const Checksum& checksum,
+                                                 const std::vector<VolumePtr>& ranking) {
+    for (const auto& volume : ranking) {
+        if (volume->store->has(checksum)) {
+            return volume;
+        }
+    }
+    return nullptr;
+}
+
+void VolumeSetStore::putRanked(const std::vector<VolumePtr>& ranking, const Checksum& checksum,
+                               const std::vector<uint8_t>& data, const BlockMetadata& metadata) {
+    // Reads probe in the same order, so a block written further down is found
+    std::exception_ptr full;
+    for (const auto& volume : ranking) {
+        if (volume->draining.load(std::memory_order_acquire)) {
+            continue;
+        }
+        try {
+            volume->store->put(checksum, data, metadata);
+            return;
+        } catch (const std::system_error& error) {
+            if (!outOfSpace(error)) {
+                throw;
+            }
+            full = std::current_exception();
+        }
+    }
+    if (full) {
+        std::rethrow_exception(full);
+    }
+    throw std::runtime_error("No volume accepts new blocks");
+}
+
+Checksum VolumeSetStore::put(const std::vector<uint8_t>& data) {
+    return put(data, BlockMetadata(blockSize_, data.size()));
+}
+
+Checksum VolumeSetStore::put(const std::vector<uint8_t>& data, const BlockMetadata& metadata) {
+    return put(Checksum::fromData(data), data, metadata);
+}
+
+Checksum VolumeSetStore::put(const Checksum& checksum, const std::vector<uint8_t>& data,
+                             const BlockMetadata& metadata) {
+    // Held across the write so rebalance() cannot detach the owner under it
+    std::shared_lock lock(mutex_);
+    putRanked(ranked(checksum, volumes_), checksum, data, metadata);
+    return checksum;
+}
+
+std::vector<Checksum> VolumeSetStore::putMany(std::span<const std::vector<uint8_t>> blocks,
+                                              std::span<const BlockMetadata> metadata) {
+    if (!metadata.empty() && metadata.size() != blocks.size()) {
+        throw std::invalid_argument("Metadata count does not match block count");
+    }
+    if (blocks.empty()) {
+        return {};
+    }
+
+    std::vector<Checksum> checksums;
+    const bool uniform = std::all_of(blocks.begin(), blocks.end(), [&](const auto& block) {
+        return block.size() == blocks.front().size();
+    });
+    if (uniform) {
+        std::vector<const uint8_t*> pointers;
+        pointers.reserve(blocks.size());
+        for (const auto& block : blocks) {
+            pointers.push_back(block.data());
+        }
+        checksums = Checksum::fromBlocks(pointers, blocks.front().size());
+    } else {
+        checksums.reserve(blocks.size());
+        for (const auto& block : blocks) {
+            checksums.push_back(Checksum::fromData(block));
+        }
+    }
+
+    std::shared_lock lock(mutex_);
+    std::unordered_map<Volume*, std::vector<std::pair<size_t, std::vector<VolumePtr>>>> groups;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        auto ranking = ranked(checksums[i], volumes_);
+        Volume* target = owner(ranking).get();
+        groups[target].emplace_back(i, std::move(ranking));
+    }
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(groups.size());
+    for (auto& [key, group] : groups) {
+        futures.push_back(pool_.submit([&, &group = group]() {
+            for (const auto& [i, ranking] : group) {
+                putRanked(ranking, checksums[i], blocks[i],
+                          metadata.empty() ? BlockMetadata(blockSize_, blocks[i].size())
+                                           : metadata[i]);
+            }
+        }));
+    }
+    waitAll(futures);
+    return checksums;
+}
+
+std::vector<uint8_t> VolumeSetStore::get(const Checksum& checksum) const {
+    auto volume = locate(checksum, ranked(checksum, snapshot()));
+    if (!volume) {
+        throw std::runtime_error("Block not found: " + checksum.toHex());
+    }
+    return volume->store->get(checksum);
+}
+
+std::vector<std::vector<uint8_t>> VolumeSetStore::getMany(
+    std::span<const Checksum> checksums) const {
+    std::vector<std::vector<uint8_t>> results(checksums.size());
+    if (checksums.empty()) {
+        return results;
+    }
+
+    // Group by the top-ranked volume, which holds the block unless it has
+    // not been rebalanced yet; the task falls back to probing in that case.
+    const auto volumes = snapshot();
+    std::unordered_map<Volume*, std::vector<std::pair<size_t, std::vector<VolumePtr>>>> groups;
+    for (size_t i = 0; i < checksums.size(); ++i) {
+        auto ranking = ranked(checksums[i], volumes);
+        Volume* first = ranking.front().get();
+        groups[first].emplace_back(i, std::move(ranking));
+    }
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(groups.size());
+    for (auto& [key, group] : groups) {
+        futures.push_back(pool_.submit([&, &group = group]() {
+            for (const auto& [i, ranking] : group) {
+                auto volume = locate(checksums[i], ranking);
+                if (!volume) {
+                    throw std::runtime_error("Block not found: " + checksums[i].toHex());
+                }
+                results[i] = volume->store->get(checksums[i]);
+            }
+        }));
+    }
+    waitAll(futures);
+    return results;
+}
+
+MappedBlock VolumeSetStore::getMapped(const Checksum& checksum, AccessHint hint) const {
+    auto volume = locate(checksum, ranked(checksum, snapshot()));
+    if (!volume) {
+        throw std::runtime_error("Block not found: " + checksum.toHex());
+    }
+    return volume->store->getMapped(checksum, hint);
+}
+
+bool VolumeSetStore::has(const Checksum& checksum) const {
+    return locate(checksum, ranked(checksum, snapshot())) != nullptr;
+}
+
+bool VolumeSetStore::remove(const Checksum& checksum) {
+    std::lock_guard lock(stripeFor(checksum));
+    const auto volumes = snapshot();
+    if (options_.referenceCounting) {
+        // A block put again before rebalance() has a copy on its old volume
+        // too, each holding some of its references. Drop one from the copy
+        // reads find; rebalance() merges the counts when it moves the block.
+        auto volume = locate(checksum, ranked(checksum, volumes));
+        return volume && volume->store->remove(checksum);
+    }
+
+    bool removed = false;
+    for (const auto& volume : volumes) {
+        removed = volume->store->remove(checksum) || removed;
+    }
+    return removed;
+}
+
+void VolumeSetStore::forEachChecksum(
+    const std::function<void(const Checksum&)>& callback) const {
+    const auto volumes = snapshot();
+    for (const auto& volume : volumes) {
+        volume->store->forEachChecksum([&](const Checksum& checksum) {
+            // A block caught mid-move exists twice; report only the copy
+            // reads would find.
+            if (locate(checksum, ranked(checksum, volumes)) == volume) {
+                callback(checksum);
+            }
+        });
+    }
+}
+
+std::optional<BlockMetadata> VolumeSetStore::getMetadata(const Checksum& checksum) const {
+    auto volume = locate(checksum, ranked(checksum, snapshot()));
+    if (!volume) {
+        return std::nullopt;
+    }
+    return volume->store->getMetadata(checksum);
+}
+
+void VolumeSetStore::addVolume(const VolumeSpec& spec) {
+    auto volume = openVolume(spec);
+
+    std::unique_lock lock(mutex_);
+    for (const auto& existing : volumes_) {
+        if (existing->path == spec.path) {
+            throw std::invalid_argument("Volume already in set: " + spec.path);
+        }
+    }
+    volumes_.push_back(std::move(volume));
+}
+
+void VolumeSetStore::removeVolume(const std::string& path) {
+    std::unique_lock lock(mutex_);
+    auto it = std::find_if(volumes_.begin(), volumes_.end(),
+                           [&](const VolumePtr& volume) { return volume->path == path; });
+    if (it == volumes_.end()) {
+        throw std::invalid_argument("Volume not in set: " + path);
+    }
+
+    const bool otherAccepting =
+        std::any_of(volumes_.begin(), volumes_.end(), [&](const VolumePtr& volume) {
+            return volume != *it && !volume->draining.load(std::memory_order_acquire);
+        });
+    if (!otherAccepting) {
+        throw std::invalid_argument("Cannot remove the last volume accepting blocks");
+    }
+    (*it)->draining.store(true, std::memory_order_release);
+}
+
+size_t VolumeSetStore::rebalance(size_t maxBlocks) {
+    const auto volumes = snapshot();
+    std::atomic<size_t> budget{maxBlocks};
+
+    auto claim = [&budget]() {
+        size_t current = budget.load(std::memory_order_relaxed);
+        while (current > 0) {
+            if (budget.compare_exchange_weak(current, current - 1, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // One task per source volume: each reads its own disk and writes to
+    // the owners, so all spindles are busy at once.
+    std::vector<std::future<std::pair<size_t, bool>>> futures;
+    futures.reserve(volumes.size());
+    for (const auto& source : volumes) {
+        futures.push_back(pool_.submit([&, source]() {
+            std::vector<std::pair<Checksum, VolumePtr>> misplaced;
+            source->store->forEachChecksum([&](const Checksum& checksum) {
+                auto target = owner(ranked(checksum, volumes));
+                if (target != source) {
+                    misplaced.emplace_back(checksum, std::move(target));
+                }
+            });
+
+            size_t moved = 0;
+            bool stuck = false;
+            for (const auto& [checksum, target] : misplaced) {
+                if (!claim()) {
+                    return std::make_pair(moved, false);
+                }
+                std::lock_guard lock(stripeFor(checksum));
+                // Every reference moves with the block: written once on the
+                // target, then dropped from the source as a whole
+                uint32_t references = source->store->refCount(checksum);
+                if (references == 0) {
+                    continue;
+                }
+                if (!target->store->has(checksum)) {
+                    auto data = source->store->get(checksum);
+                    auto metadata = source->store->getMetadata(checksum);
+                    try {
+                        target->store->put(
+                            checksum, data,
+                            metadata.value_or(BlockMetadata(blockSize_, data.size())));
+                    } catch (const std::system_error& error) {
+                        if (!outOfSpace(error)) {
+                            throw;
+                        }
+                        // The owner is full; the block stays where reads find it
+                        stuck = true;
+                        continue;
+                    }
+                    --references;
+                }
+                if (references > 0) {
+                    target->store->addRef(checksum, references);
+                }
+                source->store->forceRemove(checksum);
+                ++moved;
+            }
+            return std::make_pair(moved, !stuck);
+        }));
+    }
+
+    std::exception_ptr error;
+    size_t moved = 0;
+    std::vector<VolumePtr> emptied;
+    for (size_t i = 0; i < futures.size(); ++i) {
+        try {
+            auto [count, complete] = futures[i].get();
+            moved += count;
+            if (complete && volumes[i]->draining.load(std::memory_order_acquire)) {
+                emptied.push_back(volumes[i]);
+            }
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    if (!emptied.empty()) {
+        // Puts hold the shared lock while they write, so none is in flight
+        // now; one that ranked volumes before the drain began may still have
+        // landed after the scan, and its volume stays for the next pass.
+        std::unique_lock lock(mutex_);
+        std::erase_if(volumes_, [&](const VolumePtr& volume) {
+            return std::find(emptied.begin(), emptied.end(), volume) != emptied.end() &&
+                   isEmpty(*volume->store);
+        });
+    }
+    return moved;
+}
+
+std::mutex& VolumeSetStore::stripeFor(const Checksum& checksum) {
+    return moveStripes_[std::hash<Checksum>{}(checksum) % MOVE_STRIPES];
+}
+
+std::string VolumeSetStore::ownerOf(const Checksum& checksum) const {
+    return owner(ranked(checksum, snapshot()))->path;
+}
+
+std::vector<VolumeInfo> VolumeSetStore::volumes() const {
+    std::vector<VolumeInfo> result;
+    for (const auto& volume : snapshot()) {
+        result.push_back({volume->path, volume->weight,
+                          volume->draining.load(std::memory_order_acquire)});
+    }
+    return result;
+}
+
+} // namespace brightchain
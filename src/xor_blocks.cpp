@@ -0,0 +1,194 @@
+#include "brightchain/xor_blocks.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BRIGHTCHAIN_XOR_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace brightchain {
+
+namespace {
+
+// Sources handled per pass; more are folded in over further passes
+constexpr size_t MAX_SOURCES_PER_PASS = 8;
+
+size_t xorScalar(uint8_t* target, const uint8_t* const* sources, size_t count,
+                 size_t length) {
+    size_t offset = 0;
+    for (; offset + 8 <= length; offset += 8) {
+        uint64_t acc;
+        std::memcpy(&acc, sources[0] + offset, 8);
+        for (size_t s = 1; s < count; ++s) {
+            uint64_t word;
+            std::memcpy(&word, sources[s] + offset, 8);
+            acc ^= word;
+        }
+        std::memcpy(target + offset, &acc, 8);
+    }
+    for (; offset < length; ++offset) {
+        uint8_t acc = sources[0][offset];
+        for (size_t s = 1; s < count; ++s) {
+            acc ^= sources[s][offset];
+        }
+        target[offset] = acc;
+    }
+    return offset;
+}
+
+#ifdef BRIGHTCHAIN_XOR_SIMD
+
+__attribute__((target("avx2"))) size_t xorAvx2(uint8_t* target, const uint8_t* const* sources,
+                                               size_t count, size_t length) {
+    size_t offset = 0;
+    for (; offset + 128 <= length; offset += 128) {
+        __m256i acc[4];
+        for (int i = 0; i < 4; ++i) {
+            acc[i] = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(sources[0] + offset + 32 * i));
+        }
+        for (size_t s = 1; s < count; ++s) {
+            for (int i = 0; i < 4; ++i) {
+                acc[i] = _mm256_xor_si256(
+                    acc[i], _mm256_loadu_si256(
+                                reinterpret_cast<const __m256i*>(sources[s] + offset + 32 * i)));
+            }
+        }
+        for (int i = 0; i < 4; ++i) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(target + offset + 32 * i), acc[i]);
+        }
+    }
+    return offset;
+}
+
+__attribute__((target("avx512f"))) size_t xorAvx512(uint8_t* target,
+                                                    const uint8_t* const* sources,
+                                                    size_t count, size_t length) {
+    size_t offset = 0;
+    for (; offset + 256 <= length; offset += 256) {
+        __m512i acc[4];
+        for (int i = 0; i < 4; ++i) {
+            acc[i] = _mm512_loadu_si512(sources[0] + offset + 64 * i);
+        }
+        for (size_t s = 1; s < count; ++s) {
+            for (int i = 0; i < 4; ++i) {
+                acc[i] = _mm512_xor_si512(acc[i],
+                                          _mm512_loadu_si512(sources[s] + offset + 64 * i));
+            }
+        }
+        for (int i = 0; i < 4; ++i) {
+            _mm512_storeu_si512(target + offset + 64 * i, acc[i]);
+        }
+    }
+    return offset;
+}
+
+#endif // BRIGHTCHAIN_XOR_SIMD
+
+using XorKernel = size_t (*)(uint8_t*, const uint8_t* const*, size_t, size_t);
+
+XorKernel bestKernel() {
+#ifdef BRIGHTCHAIN_XOR_SIMD
+    static const XorKernel best = []() -> XorKernel {
+        if (__builtin_cpu_supports("avx512f")) {
+            return xorAvx512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return xorAvx2;
+        }
+        return xorScalar;
+    }();
+    return best;
+#else
+    return xorScalar;
+#endif
+}
+
+/**
+ * XOR up to MAX_SOURCES_PER_PASS sources; the vector kernel covers the
+ * bulk and the scalar loop the tail.
+ */
+void xorPass(uint8_t* target, const uint8_t* const* sources, size_t count, size_t length) {
+    const size_t done = bestKernel()(target, sources, count, length);
+    if (done < length) {
+        const uint8_t* rest[MAX_SOURCES_PER_PASS];
+        for (size_t s = 0; s < count; ++s) {
+            rest[s] = sources[s] + done;
+        }
+        xorScalar(target + done, rest, count, length - done);
+    }
+}
+
+} // namespace
+
+void xorInto(uint8_t* target, const uint8_t* source, size_t length) {
+    const uint8_t* sources[2] = {target, source};
+    xorPass(target, sources, 2, length);
+}
+
+void xorBlocks(uint8_t* target, std::span<const uint8_t* const> sources, size_t length) {
+    if (sources.empty()) {
+        throw std::invalid_argument("xorBlocks needs at least one source");
+    }
+
+    size_t first = std::min(sources.size(), MAX_SOURCES_PER_PASS);
+    xorPass(target, sources.data(), first, length);
+
+    // Fold further sources into the target, which joins each later pass
+    while (first < sources.size()) {
+        const uint8_t* pass[MAX_SOURCES_PER_PASS];
+        pass[0] = target;
+        size_t count = 1;
+        while (count < MAX_SOURCES_PER_PASS && first < sources.size()) {
+            pass[count++] = sources[first++];
+        }
+        xorPass(target, pass, count, length);
+    }
+}
+
+namespace {
+
+std::vector<MappedBlock> mapTuple(const DiskBlockStore& store,
+                                  std::span<const Checksum> members) {
+    if (members.empty()) {
+        throw std::invalid_argument("Tuple has no members");
+    }
+    std::vector<MappedBlock> blocks;
+    blocks.reserve(members.size());
+    for (const auto& member : members) {
+        blocks.push_back(store.getMapped(member, AccessHint::Sequential));
+    }
+    return blocks;
+}
+
+void xorMapped(const std::vector<MappedBlock>& blocks, std::span<const Checksum> members,
+               uint8_t* out, size_t length) {
+    std::vector<const uint8_t*> sources;
+    sources.reserve(blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (blocks[i].size() != length) {
+            throw std::runtime_error("Tuple members differ in size: " + members[i].toHex());
+        }
+        sources.push_back(blocks[i].data());
+    }
+    xorBlocks(out, sources, length);
+}
+
+} // namespace
+
+void xorTupleInto(const DiskBlockStore& store, std::span<const Checksum> members, uint8_t* out,
+                  size_t length) {
+    xorMapped(mapTuple(store, members), members, out, length);
+}
+
+std::vector<uint8_t> xorTuple(const DiskBlockStore& store, std::span<const Checksum> members) {
+    auto blocks = mapTuple(store, members);
+    std::vector<uint8_t> block(blocks.front().size());
+    xorMapped(blocks, members, block.data(), block.size());
+    return block;
+}
+
+} // namespace brightchain
@@ -53,3 +53,128 @@ TEST(AesGcmTest, TamperedCiphertext) {
     
     EXPECT_THROW(AesGcm::decrypt(ciphertext, key, iv, tag), std::runtime_error);
 }
+
+TEST(AesGcmStreamTest, ChunkedMatchesOneShot) {
+    auto key = AesGcm::generateKey();
+    auto iv = AesGcm::generateIV();
+    std::vector<uint8_t> aad = {9, 8, 7};
+    std::vector<uint8_t> plaintext(1000);
+    for (size_t i = 0; i < plaintext.size(); ++i) {
+        plaintext[i] = static_cast<uint8_t>(i * 31);
+    }
+
+    AesGcm::Tag expectedTag;
+    auto expected = AesGcm::encrypt(plaintext, key, iv, expectedTag, aad);
+
+    AesGcmStream encryptor(AesGcmStream::Mode::Encrypt);
+    encryptor.init(key, iv, aad);
+    std::vector<uint8_t> ciphertext(plaintext.size());
+    const std::span<const uint8_t> in(plaintext);
+    const std::span<uint8_t> out(ciphertext);
+    encryptor.update(in.subspan(0, 7), out.subspan(0, 7));
+    encryptor.update(in.subspan(7, 500), out.subspan(7, 500));
+    encryptor.update(in.subspan(507), out.subspan(507));
+    EXPECT_EQ(encryptor.finish(), expectedTag);
+    EXPECT_EQ(ciphertext, expected);
+
+    AesGcmStream decryptor(AesGcmStream::Mode::Decrypt);
+    decryptor.init(key, iv, aad);
+    decryptor.update(ciphertext);
+    decryptor.finish(expectedTag);
+    EXPECT_EQ(ciphertext, plaintext);
+}
+
+TEST(AesGcmStreamTest, ReusesKeyWithNewIV) {
+    auto key = AesGcm::generateKey();
+    AesGcmStream encryptor(AesGcmStream::Mode::Encrypt);
+    AesGcmStream decryptor(AesGcmStream::Mode::Decrypt);
+    encryptor.init(key, AesGcm::generateIV());
+    encryptor.finish();
+    decryptor.init(key, AesGcm::generateIV());
+
+    for (int i = 0; i < 3; ++i) {
+        auto iv = AesGcm::generateIV();
+        std::vector<uint8_t> data(64, static_cast<uint8_t>(i));
+        const auto original = data;
+
+        encryptor.init(iv);
+        encryptor.update(data);
+        auto tag = encryptor.finish();
+
+        AesGcm::Tag oneShotTag;
+        EXPECT_EQ(AesGcm::encrypt(original, key, iv, oneShotTag), data);
+        EXPECT_EQ(oneShotTag, tag);
+
+        decryptor.init(iv);
+        decryptor.update(data);
+        decryptor.finish(tag);
+        EXPECT_EQ(data, original);
+    }
+}
+
+TEST(AesGcmStreamTest, DetectsTampering) {
+    auto key = AesGcm::generateKey();
+    auto iv = AesGcm::generateIV();
+    std::vector<uint8_t> data(100, 0x42);
+
+    AesGcmStream encryptor(AesGcmStream::Mode::Encrypt);
+    encryptor.init(key, iv);
+    encryptor.update(data);
+    auto tag = encryptor.finish();
+    data[50] ^= 1;
+
+    AesGcmStream decryptor(AesGcmStream::Mode::Decrypt);
+    decryptor.init(key, iv);
+    decryptor.update(data);
+    EXPECT_THROW(decryptor.finish(tag), std::runtime_error);
+}
+
+TEST(AesGcmStreamTest, RejectsMisuse) {
+    AesGcmStream encryptor(AesGcmStream::Mode::Encrypt);
+    std::vector<uint8_t> data(16);
+    EXPECT_THROW(encryptor.init(AesGcm::generateIV()), std::logic_error);
+    EXPECT_THROW(encryptor.update(data), std::logic_error);
+    EXPECT_THROW(encryptor.finish(), std::logic_error);
+
+    encryptor.init(AesGcm::generateKey(), AesGcm::generateIV());
+    EXPECT_THROW(encryptor.finish(AesGcm::Tag{}), std::logic_error);
+
+    std::vector<uint8_t> small(8);
+    EXPECT_THROW(encryptor.update(data, small), std::invalid_argument);
+    const std::span<uint8_t> whole(data);
+    EXPECT_THROW(encryptor.update(whole.subspan(0, 8), whole.subspan(4, 8)),
+                 std::invalid_argument);
+
+    encryptor.finish();
+    EXPECT_THROW(encryptor.update(data), std::logic_error);
+}
+
+TEST(AesGcmStreamTest, ClearKeyAndMovedFromStreams) {
+    const auto key = AesGcm::generateKey();
+    const auto iv = AesGcm::generateIV();
+    std::vector<uint8_t> data(100, 0x11);
+    AesGcm::Tag oneShotTag;
+    auto expected = AesGcm::encrypt(data, key, iv, oneShotTag);
+
+    AesGcmStream encryptor(AesGcmStream::Mode::Encrypt);
+    encryptor.init(key, iv);
+    encryptor.clearKey();
+    EXPECT_THROW(encryptor.update(data), std::logic_error);
+    EXPECT_THROW(encryptor.init(AesGcm::generateIV()), std::logic_error);
+
+    // A cleared stream takes a new key like a fresh one
+    encryptor.init(key, iv);
+    std::vector<uint8_t> out(data.size());
+    encryptor.update(data, out);
+    EXPECT_EQ(encryptor.finish(), oneShotTag);
+    EXPECT_EQ(out, expected);
+
+    AesGcmStream moved(std::move(encryptor));
+    EXPECT_THROW(encryptor.init(key, iv), std::logic_error);
+    EXPECT_THROW(encryptor.init(iv), std::logic_error);
+    EXPECT_THROW(encryptor.update(data), std::logic_error);
+    encryptor.clearKey();
+    moved.init(iv);
+    moved.update(data, out);
+    EXPECT_EQ(moved.finish(), oneShotTag);
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include "brightchain/async_block_io.hpp"
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+
+using namespace brightchain;
+
+class AsyncBlockIOTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_async_io_test";
+        std::filesystem::remove_all(testPath);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(testPath);
+    }
+
+    static std::vector<std::vector<uint8_t>> makeBlocks(size_t count) {
+        std::vector<std::vector<uint8_t>> blocks;
+        for (size_t i = 0; i < count; ++i) {
+            std::vector<uint8_t> block(256);
+            for (size_t j = 0; j < block.size(); ++j) {
+                block[j] = static_cast<uint8_t>(i * 13 + j);
+            }
+            blocks.push_back(block);
+        }
+        return blocks;
+    }
+
+    std::filesystem::path testPath;
+};
+
+TEST_F(AsyncBlockIOTest, PutThenGetBatch) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message);
+    AsyncBlockIO io(store, 16);
+    EXPECT_EQ(io.queueDepth(), 16);
+
+    auto blocks = makeBlocks(200);
+    auto putFutures = io.putBatch(blocks);
+    std::vector<Checksum> checksums;
+    for (auto& future : putFutures) {
+        checksums.push_back(future.get());
+    }
+
+    auto getFutures = io.getBatch(checksums);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        EXPECT_EQ(getFutures[i].get(), blocks[i]);
+    }
+
+    auto hasFutures = io.hasBatch(checksums);
+    for (auto& future : hasFutures) {
+        EXPECT_TRUE(future.get());
+    }
+    EXPECT_EQ(io.inFlight(), 0);
+}
+
+TEST_F(AsyncBlockIOTest, RejectsZeroQueueDepth) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message);
+    EXPECT_THROW(AsyncBlockIO(store, 0), std::invalid_argument);
+}
+
+TEST_F(AsyncBlockIOTest, CallbacksReportErrorsPerRequest) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message, StorageLayout::Packed);
+    AsyncBlockIO io(store, 8);
+
+    auto blocks = makeBlocks(10);
+    std::vector<Checksum> checksums(blocks.size());
+    io.putBatch(blocks, [&](size_t index, const Checksum& checksum, std::exception_ptr error) {
+        EXPECT_EQ(error, nullptr);
+        checksums[index] = checksum;
+    });
+    io.drain();
+
+    checksums.push_back(Checksum::fromData({9, 9, 9}));
+    std::mutex mutex;
+    std::vector<bool> failed(checksums.size(), false);
+    io.getBatch(checksums, [&](size_t index, std::vector<uint8_t> data, std::exception_ptr error) {
+        std::lock_guard lock(mutex);
+        failed[index] = error != nullptr;
+        if (!error) {
+            EXPECT_EQ(data, blocks[index]);
+        }
+    });
+    io.drain();
+
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        EXPECT_FALSE(failed[i]);
+    }
+    EXPECT_TRUE(failed.back());
+}
+
+TEST_F(AsyncBlockIOTest, FutureCarriesMissingBlockError) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message);
+    AsyncBlockIO io(store);
+    EXPECT_THROW(io.get(Checksum::fromData({1})).get(), std::runtime_error);
+}
+
+TEST_F(AsyncBlockIOTest, BackendsReadTheSameBlocks) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message);
+    AsyncBlockIO ring(store, 4);
+    AsyncBlockIO pool(store, 4, AsyncIOBackend::ThreadPool);
+    EXPECT_EQ(pool.backend(), AsyncIOBackend::ThreadPool);
+
+    // More reads than the queue depth exercises the ring's backlog
+    auto blocks = makeBlocks(64);
+    std::vector<Checksum> checksums;
+    for (const auto& block : blocks) {
+        checksums.push_back(store.put(block));
+    }
+    checksums.push_back(Checksum::fromData({7, 7, 7}));
+
+    for (AsyncBlockIO* io : {&ring, &pool}) {
+        std::mutex mutex;
+        std::vector<std::vector<uint8_t>> read(checksums.size());
+        std::vector<bool> failed(checksums.size(), false);
+        io->getBatch(checksums,
+                     [&](size_t index, std::vector<uint8_t> data, std::exception_ptr error) {
+                         std::lock_guard lock(mutex);
+                         read[index] = std::move(data);
+                         failed[index] = error != nullptr;
+                     });
+        io->drain();
+        EXPECT_EQ(io->inFlight(), 0);
+
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            EXPECT_FALSE(failed[i]);
+            EXPECT_EQ(read[i], blocks[i]);
+        }
+        EXPECT_TRUE(failed.back());
+        EXPECT_TRUE(read.back().empty());
+    }
+}
+
+TEST_F(AsyncBlockIOTest, PackedStoresReadOnThePool) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message, StorageLayout::Packed);
+    AsyncBlockIO io(store, 4);
+    EXPECT_EQ(io.backend(), AsyncIOBackend::ThreadPool);
+}
+
+TEST_F(AsyncBlockIOTest, ReadsConsultTheExistenceFilter) {
+    DiskBlockStoreOptions options;
+    options.existenceFilter = true;
+    DiskBlockStore store(testPath.string(), BlockSize::Message, options);
+    AsyncBlockIO io(store, 4);
+
+    auto blocks = makeBlocks(2);
+    auto stored = store.put(blocks[0]);
+
+    // A block file the filter does not know about is not read, on either path
+    auto unknown = Checksum::fromData(blocks[1]);
+    const std::string hex = unknown.toHex();
+    const auto dir = testPath / "Message" / std::string(1, hex[0]) / std::string(1, hex[1]);
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / hex, std::ios::binary)
+        .write(reinterpret_cast<const char*>(blocks[1].data()), blocks[1].size());
+
+    EXPECT_THROW(store.get(unknown), std::runtime_error);
+    EXPECT_THROW(io.get(unknown).get(), std::runtime_error);
+    EXPECT_EQ(io.get(stored).get(), blocks[0]);
+    EXPECT_EQ(io.inFlight(), 0);
+}
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include "brightchain/block_cache.hpp"
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+using namespace brightchain;
+
+namespace {
+
+BlockCache::Entry makeEntry(uint8_t seed, size_t size = 512) {
+    return std::make_shared<const std::vector<uint8_t>>(size, seed);
+}
+
+Checksum keyFor(uint32_t i) {
+    std::vector<uint8_t> bytes(4);
+    std::memcpy(bytes.data(), &i, 4);
+    return Checksum::fromData(bytes);
+}
+
+} // namespace
+
+TEST(BlockCacheTest, HitMissCounters) {
+    BlockCache cache(1);
+    cache.setBudget(BlockSize::Message, 4096);
+
+    auto key = keyFor(1);
+    EXPECT_EQ(cache.get(key, BlockSize::Message), nullptr);
+    cache.put(key, BlockSize::Message, makeEntry(1));
+
+    auto hit = cache.get(key, BlockSize::Message);
+    ASSERT_NE(hit, nullptr);
+    EXPECT_EQ((*hit)[0], 1);
+
+    auto stats = cache.stats(BlockSize::Message);
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(stats.insertions, 1);
+    EXPECT_EQ(stats.bytes, 512);
+    EXPECT_EQ(stats.entries, 1);
+    EXPECT_EQ(cache.stats().hits, 1);
+}
+
+TEST(BlockCacheTest, ZeroBudgetDisablesCaching) {
+    BlockCache cache(1);
+    auto key = keyFor(1);
+    cache.put(key, BlockSize::Tiny, makeEntry(1));
+    EXPECT_EQ(cache.get(key, BlockSize::Tiny), nullptr);
+    EXPECT_EQ(cache.stats().entries, 0);
+}
+
+TEST(BlockCacheTest, RespectsByteBudget) {
+    BlockCache cache(1);
+    cache.setBudget(BlockSize::Message, 8 * 512);
+
+    for (uint32_t i = 0; i < 100; ++i) {
+        cache.put(keyFor(i), BlockSize::Message, makeEntry(static_cast<uint8_t>(i)));
+    }
+
+    auto stats = cache.stats(BlockSize::Message);
+    EXPECT_LE(stats.bytes, 8 * 512);
+    EXPECT_EQ(stats.evictions, 100 - stats.entries);
+
+    cache.setBudget(BlockSize::Message, 2 * 512);
+    EXPECT_LE(cache.stats(BlockSize::Message).bytes, 2 * 512);
+}
+
+TEST(BlockCacheTest, ScanDoesNotEvictHotSet) {
+    BlockCache cache(1);
+    cache.setBudget(BlockSize::Message, 16 * 512);
+
+    // Blocks 0..3 are read once, pushed out of A1in by other traffic, then
+    // read again: the ghost list recognises them and promotes them to Am.
+    for (uint32_t i = 0; i < 4; ++i) {
+        cache.put(keyFor(i), BlockSize::Message, makeEntry(static_cast<uint8_t>(i)));
+    }
+    for (uint32_t i = 100; i < 120; ++i) {
+        cache.put(keyFor(i), BlockSize::Message, makeEntry(0));
+    }
+    for (uint32_t i = 0; i < 4; ++i) {
+        ASSERT_EQ(cache.get(keyFor(i), BlockSize::Message), nullptr);
+        cache.put(keyFor(i), BlockSize::Message, makeEntry(static_cast<uint8_t>(i)));
+    }
+
+    // A long one-pass scan
+    for (uint32_t i = 1000; i < 2000; ++i) {
+        cache.put(keyFor(i), BlockSize::Message, makeEntry(0));
+    }
+
+    for (uint32_t i = 0; i < 4; ++i) {
+        EXPECT_NE(cache.get(keyFor(i), BlockSize::Message), nullptr) << "hot block " << i;
+    }
+}
+
+TEST(BlockCacheTest, EraseAndClear) {
+    BlockCache cache(4);
+    cache.setBudget(BlockSize::Small, 1 << 20);
+
+    cache.put(keyFor(1), BlockSize::Small, makeEntry(1, 4096));
+    cache.put(keyFor(2), BlockSize::Small, makeEntry(2, 4096));
+    cache.erase(keyFor(1));
+    EXPECT_EQ(cache.get(keyFor(1), BlockSize::Small), nullptr);
+    EXPECT_NE(cache.get(keyFor(2), BlockSize::Small), nullptr);
+
+    cache.clear();
+    EXPECT_EQ(cache.stats().entries, 0);
+    EXPECT_EQ(cache.stats().bytes, 0);
+}
+
+TEST(BlockCacheTest, LoadOlderThanEraseIsNotInserted) {
+    BlockCache cache(4);
+    cache.setBudget(BlockSize::Small, 1 << 20);
+
+    // A miss loads the block, a remove erases it, then the miss tries to
+    // insert what it loaded
+    const uint64_t generation = cache.generation(keyFor(1));
+    cache.erase(keyFor(1));
+    cache.put(keyFor(1), BlockSize::Small, makeEntry(1, 4096), generation);
+    EXPECT_EQ(cache.get(keyFor(1), BlockSize::Small), nullptr);
+
+    cache.put(keyFor(1), BlockSize::Small, makeEntry(1, 4096), cache.generation(keyFor(1)));
+    EXPECT_NE(cache.get(keyFor(1), BlockSize::Small), nullptr);
+}
+
+TEST(BlockCacheTest, ConcurrentReaders) {
+    BlockCache cache(8);
+    cache.setBudget(BlockSize::Message, 1 << 20);
+    for (uint32_t i = 0; i < 64; ++i) {
+        cache.put(keyFor(i), BlockSize::Message, makeEntry(static_cast<uint8_t>(i)));
+    }
+
+    std::vector<std::thread> threads;
+    std::atomic<int> failures{0};
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&]() {
+            for (int n = 0; n < 1000; ++n) {
+                uint32_t i = n % 64;
+                auto entry = cache.get(keyFor(i), BlockSize::Message);
+                if (!entry || (*entry)[0] != static_cast<uint8_t>(i)) {
+                    failures.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(cache.stats().hits, 8000);
+}
+
+TEST(BlockCacheTest, CachingBlockStoreReadThrough) {
+    auto testPath = std::filesystem::temp_directory_path() / "brightchain_cache_test";
+    std::filesystem::remove_all(testPath);
+    {
+        DiskBlockStore store(testPath.string(), BlockSize::Small);
+        BlockCache cache;
+        cache.setBudget(BlockSize::Small, 1 << 20);
+        CachingBlockStore cached(store, cache);
+
+        std::vector<uint8_t> data = {1, 2, 3, 4};
+        auto checksum = cached.put(data);
+
+        EXPECT_EQ(cached.get(checksum), data);
+        auto first = cached.getShared(checksum);
+        auto second = cached.getShared(checksum);
+        EXPECT_EQ(first.get(), second.get());
+        EXPECT_EQ(cache.stats(BlockSize::Small).misses, 1);
+        EXPECT_EQ(cache.stats(BlockSize::Small).hits, 2);
+
+        EXPECT_TRUE(cached.remove(checksum));
+        EXPECT_FALSE(cached.has(checksum));
+        EXPECT_THROW(cached.get(checksum), std::runtime_error);
+    }
+    std::filesystem::remove_all(testPath);
+}
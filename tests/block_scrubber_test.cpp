@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include "brightchain/block_scrubber.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace brightchain;
+
+class BlockScrubberTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_scrubber_test";
+        std::filesystem::remove_all(testPath);
+        std::filesystem::create_directories(testPath);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(testPath);
+    }
+
+    std::vector<Checksum> fill(DiskBlockStore& store, size_t count) {
+        std::vector<Checksum> checksums;
+        for (size_t i = 0; i < count; ++i) {
+            std::vector<uint8_t> data(blockSizeToLength(store.blockSize()),
+                                      static_cast<uint8_t>(i));
+            data[0] = static_cast<uint8_t>(i >> 8);
+            checksums.push_back(store.put(data));
+        }
+        return checksums;
+    }
+
+    void corrupt(const DiskBlockStore& store, const Checksum& checksum) {
+        auto hex = checksum.toHex();
+        auto path = std::filesystem::path(store.storePath()) /
+                    blockSizeToString(store.blockSize()) / hex.substr(0, 1) / hex.substr(1, 1) /
+                    hex;
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(100);
+        file.put(0x7f);
+    }
+
+    ScrubberOptions unthrottled() {
+        ScrubberOptions options;
+        options.bytesPerSecond = 0;
+        return options;
+    }
+
+    std::filesystem::path testPath;
+};
+
+TEST_F(BlockScrubberTest, CleanStorePassesVerification) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message);
+    fill(store, 20);
+
+    BlockScrubber scrubber(store, unthrottled());
+    EXPECT_EQ(scrubber.scrub(), 20u);
+
+    auto stats = scrubber.stats();
+    EXPECT_EQ(stats.passesCompleted, 1u);
+    EXPECT_EQ(stats.blocksVerified, 20u);
+    EXPECT_EQ(stats.bytesVerified, 20u * 512);
+    EXPECT_EQ(stats.corruptBlocks, 0u);
+    EXPECT_EQ(stats.passBlocks, 20u);
+    EXPECT_EQ(stats.passTotal, 20u);
+}
+
+TEST_F(BlockScrubberTest, QuarantinesCorruptBlocks) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message);
+    auto checksums = fill(store, 10);
+    corrupt(store, checksums[3]);
+
+    std::vector<Checksum> reported;
+    auto options = unthrottled();
+    options.onCorrupt = [&reported](const Checksum& checksum) { reported.push_back(checksum); };
+    BlockScrubber scrubber(store, options);
+    scrubber.scrub();
+
+    ASSERT_EQ(reported.size(), 1u);
+    EXPECT_EQ(reported[0], checksums[3]);
+    EXPECT_EQ(scrubber.stats().corruptBlocks, 1u);
+    EXPECT_FALSE(store.has(checksums[3]));
+    EXPECT_FALSE(store.getMetadata(checksums[3]).has_value());
+    EXPECT_TRUE(std::filesystem::exists(store.quarantineDir() / checksums[3].toHex()));
+
+    size_t remaining = 0;
+    store.forEachChecksum([&remaining](const Checksum&) { ++remaining; });
+    EXPECT_EQ(remaining, 9u);
+}
+
+TEST_F(BlockScrubberTest, SkipsBlocksOnTransientErrors) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message);
+    auto checksums = fill(store, 3);
+    std::sort(checksums.begin(), checksums.end());
+
+    BlockScrubber scrubber(store, unthrottled());
+    EXPECT_EQ(scrubber.scrub(0), 0u); // Lists the pass while descriptors remain
+
+    // Exhaust the descriptor table so the block cannot be opened (EMFILE)
+    rlimit original{};
+    ASSERT_EQ(::getrlimit(RLIMIT_NOFILE, &original), 0);
+    rlimit lowered = original;
+    lowered.rlim_cur = 256;
+    ASSERT_EQ(::setrlimit(RLIMIT_NOFILE, &lowered), 0);
+    std::vector<int> held;
+    for (int fd; (fd = ::open("/dev/null", O_RDONLY | O_CLOEXEC)) >= 0;) {
+        held.push_back(fd);
+    }
+    // The cursor cannot be saved either
+    EXPECT_THROW(scrubber.scrub(1), std::runtime_error);
+    for (int fd : held) {
+        ::close(fd);
+    }
+    ASSERT_EQ(::setrlimit(RLIMIT_NOFILE, &original), 0);
+
+    auto stats = scrubber.stats();
+    EXPECT_EQ(stats.skippedBlocks, 1u);
+    EXPECT_EQ(stats.corruptBlocks, 0u);
+    EXPECT_TRUE(store.has(checksums[0]));
+
+    // The rest of the pass, then a new pass that verifies the skipped block
+    EXPECT_EQ(scrubber.scrub(), 2u);
+    EXPECT_EQ(scrubber.scrub(), 3u);
+    EXPECT_EQ(scrubber.stats().blocksVerified, 5u);
+    EXPECT_EQ(scrubber.stats().corruptBlocks, 0u);
+}
+
+TEST_F(BlockScrubberTest, ResumesFromPersistedCursor) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message);
+    fill(store, 30);
+
+    auto options = unthrottled();
+    options.cursorInterval = 1;
+    {
+        BlockScrubber scrubber(store, options);
+        EXPECT_EQ(scrubber.scrub(12), 12u);
+        EXPECT_EQ(scrubber.stats().passesCompleted, 0u);
+    }
+
+    BlockScrubber resumed(store, options);
+    EXPECT_EQ(resumed.scrub(), 18u);
+    EXPECT_EQ(resumed.stats().passTotal, 18u);
+    EXPECT_EQ(resumed.stats().passesCompleted, 1u);
+
+    // The next pass starts over from the beginning
+    EXPECT_EQ(resumed.scrub(), 30u);
+    EXPECT_EQ(resumed.stats().passesCompleted, 2u);
+}
+
+TEST_F(BlockScrubberTest, RejectsCorruptCursor) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message);
+    std::filesystem::path cursorPath;
+    {
+        BlockScrubber scrubber(store, unthrottled());
+        cursorPath = scrubber.cursorPath();
+    }
+    {
+        std::ofstream file(cursorPath, std::ios::trunc);
+        file << "garbage";
+    }
+    EXPECT_THROW(BlockScrubber(store, unthrottled()), std::runtime_error);
+}
+
+TEST_F(BlockScrubberTest, ThrottlesToByteBudget) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message);
+    fill(store, 20);
+
+    ScrubberOptions options;
+    options.bytesPerSecond = 512 * 100; // 20 blocks take ~200 ms
+    BlockScrubber scrubber(store, options);
+
+    auto start = std::chrono::steady_clock::now();
+    scrubber.scrub();
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(150));
+}
+
+TEST_F(BlockScrubberTest, BackgroundThreadScrubsAndStops) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message);
+    auto checksums = fill(store, 10);
+    corrupt(store, checksums[0]);
+
+    BlockScrubber scrubber(store, unthrottled());
+    scrubber.start();
+    EXPECT_TRUE(scrubber.running());
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (scrubber.stats().passesCompleted == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    scrubber.stop();
+    EXPECT_FALSE(scrubber.running());
+
+    EXPECT_EQ(scrubber.stats().passesCompleted, 1u);
+    EXPECT_EQ(scrubber.stats().corruptBlocks, 1u);
+    EXPECT_FALSE(store.has(checksums[0]));
+}
+
+TEST_F(BlockScrubberTest, QuarantineOverridesReferenceCount) {
+    DiskBlockStoreOptions storeOptions;
+    storeOptions.referenceCounting = true;
+    DiskBlockStore store(testPath.string(), BlockSize::Message, storeOptions);
+    auto checksums = fill(store, 3);
+    store.put(store.get(checksums[1]));
+    EXPECT_EQ(store.refCount(checksums[1]), 2u);
+    corrupt(store, checksums[1]);
+
+    BlockScrubber scrubber(store, unthrottled());
+    scrubber.scrub();
+    EXPECT_EQ(scrubber.stats().corruptBlocks, 1u);
+    EXPECT_EQ(store.refCount(checksums[1]), 0u);
+
+    // Putting the block back resumes the references it had
+    std::vector<uint8_t> original(512, 1);
+    original[0] = 0;
+    store.put(original);
+    EXPECT_EQ(store.refCount(checksums[1]), 2u);
+}
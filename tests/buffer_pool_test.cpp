@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+#include "brightchain/buffer_pool.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+using namespace brightchain;
+
+TEST(BufferPoolTest, BuffersAreAlignedAndSized) {
+    BufferPool pool;
+    const auto page = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+
+    auto message = pool.acquire(BlockSize::Message);
+    EXPECT_EQ(message.size(), 512u);
+    EXPECT_EQ(message.capacity(), 512u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(message.data()) % 512, 0u);
+
+    auto small = pool.acquire(BlockSize::Small);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(small.data()) % page, 0u);
+
+    auto large = pool.acquire(BlockSize::Large);
+    EXPECT_EQ(large.size(), blockSizeToLength(BlockSize::Large));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(large.data()) % page, 0u);
+    large.data()[0] = 1;
+    large.data()[large.size() - 1] = 2;
+
+    EXPECT_THROW(pool.acquire(BlockSize::Unknown), std::invalid_argument);
+    EXPECT_THROW(message.resize(513), std::length_error);
+}
+
+TEST(BufferPoolTest, ReleasedBuffersAreReused) {
+    BufferPool pool;
+    const uint8_t* first;
+    {
+        auto buffer = pool.acquire(BlockSize::Tiny);
+        first = buffer.data();
+    }
+    for (int i = 0; i < 100; ++i) {
+        auto buffer = pool.acquire(BlockSize::Tiny);
+        EXPECT_EQ(buffer.data(), first);
+    }
+
+    auto stats = pool.stats(BlockSize::Tiny);
+    EXPECT_EQ(stats.allocations, 1u);
+    EXPECT_EQ(stats.reuses, 100u);
+}
+
+TEST(BufferPoolTest, MoveTransfersOwnership) {
+    BufferPool pool;
+    auto a = pool.acquire(BlockSize::Message);
+    const uint8_t* data = a.data();
+
+    BlockBuffer b = std::move(a);
+    EXPECT_TRUE(a.empty());
+    EXPECT_EQ(b.data(), data);
+
+    b.reset();
+    EXPECT_TRUE(b.empty());
+    EXPECT_EQ(pool.acquire(BlockSize::Message).data(), data);
+}
+
+TEST(BufferPoolTest, BuffersCrossThreadsThroughDepot) {
+    BufferPool pool;
+    pool.setRetention(BlockSize::Medium, 8);
+
+    // Buffers released on a worker reach the depot when it exits
+    std::thread worker([&pool]() {
+        std::vector<BlockBuffer> buffers;
+        for (int i = 0; i < 8; ++i) {
+            buffers.push_back(pool.acquire(BlockSize::Medium));
+        }
+    });
+    worker.join();
+    EXPECT_EQ(pool.stats(BlockSize::Medium).retained, 8u);
+
+    std::vector<BlockBuffer> buffers;
+    for (int i = 0; i < 8; ++i) {
+        buffers.push_back(pool.acquire(BlockSize::Medium));
+    }
+    EXPECT_EQ(pool.stats(BlockSize::Medium).allocations, 8u);
+    EXPECT_EQ(pool.stats(BlockSize::Medium).reuses, 8u);
+}
+
+TEST(BufferPoolTest, RetentionAndTrimBoundIdleMemory) {
+    BufferPool pool;
+    pool.setRetention(BlockSize::Small, 2);
+    EXPECT_EQ(pool.retention(BlockSize::Small), 2u);
+    {
+        std::vector<BlockBuffer> buffers;
+        for (int i = 0; i < 40; ++i) {
+            buffers.push_back(pool.acquire(BlockSize::Small));
+        }
+    }
+    // Thread cache holds up to 16, depot up to 2; the rest are freed
+    EXPECT_EQ(pool.stats(BlockSize::Small).retained, 2u);
+
+    pool.trim();
+    EXPECT_EQ(pool.stats(BlockSize::Small).retained, 0u);
+}
+
+TEST(BufferPoolTest, MappedBuffersSkipTheThreadCache) {
+    BufferPool pool;
+    {
+        auto buffer = pool.acquire(BlockSize::Large);
+    }
+    // Released straight to the depot, bounded by its retention
+    EXPECT_EQ(pool.stats(BlockSize::Large).retained, 1u);
+    pool.setRetention(BlockSize::Large, 0);
+    EXPECT_EQ(pool.stats(BlockSize::Large).retained, 0u);
+}
+
+TEST(BufferPoolTest, BuffersOutliveTheirPool) {
+    BlockBuffer buffer;
+    {
+        BufferPool pool;
+        buffer = pool.acquire(BlockSize::Message);
+    }
+    std::memset(buffer.data(), 0xAB, buffer.size());
+    buffer.reset();
+}
+
+TEST(BufferPoolTest, DestroyedPoolsLeaveOtherThreadCaches) {
+    auto pool = std::make_unique<BufferPool>();
+    std::mutex mutex;
+    std::condition_variable changed;
+    int stage = 0;
+
+    std::thread worker([&]() {
+        {
+            auto a = pool->acquire(BlockSize::Small);
+            auto b = pool->acquire(BlockSize::Small);
+        }
+        std::unique_lock lock(mutex);
+        stage = 1;
+        changed.notify_all();
+        changed.wait(lock, [&stage]() { return stage == 2; });
+        lock.unlock();
+
+        // The first use of another pool drops the cache of the destroyed one
+        BufferPool other;
+        auto buffer = other.acquire(BlockSize::Small);
+        EXPECT_EQ(other.stats(BlockSize::Small).allocations, 1u);
+    });
+
+    std::unique_lock lock(mutex);
+    changed.wait(lock, [&stage]() { return stage == 1; });
+    pool.reset();
+    stage = 2;
+    changed.notify_all();
+    lock.unlock();
+    worker.join();
+}
+
+class BufferPoolStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_buffer_pool_test";
+        std::filesystem::remove_all(testPath);
+        std::filesystem::create_directories(testPath);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(testPath);
+    }
+
+    std::filesystem::path testPath;
+};
+
+TEST_F(BufferPoolStoreTest, StoreRoundTripsPooledBuffers) {
+    for (auto layout : {StorageLayout::FilePerBlock, StorageLayout::Packed}) {
+        std::filesystem::remove_all(testPath);
+        DiskBlockStore store(testPath.string(), BlockSize::Small, layout);
+        BufferPool pool;
+
+        auto buffer = pool.acquire(BlockSize::Small);
+        for (size_t i = 0; i < buffer.size(); ++i) {
+            buffer.data()[i] = static_cast<uint8_t>(i * 7);
+        }
+        auto checksum = store.put(buffer, BlockMetadata(BlockSize::Small, buffer.size()));
+        std::vector<uint8_t> expected(buffer.data(), buffer.data() + buffer.size());
+        EXPECT_EQ(checksum, Checksum::fromData(expected));
+        buffer.reset();
+
+        for (int i = 0; i < 10; ++i) {
+            auto loaded = store.getBuffer(checksum, pool);
+            ASSERT_EQ(loaded.size(), expected.size());
+            EXPECT_EQ(std::memcmp(loaded.data(), expected.data(), expected.size()), 0);
+        }
+        EXPECT_EQ(pool.stats(BlockSize::Small).allocations, 1u);
+
+        EXPECT_THROW(store.getBuffer(Checksum::fromData(std::vector<uint8_t>{1}), pool),
+                     std::runtime_error);
+    }
+}
+
+TEST_F(BufferPoolStoreTest, GetBufferRestoresVirtualPadding) {
+    DiskBlockStoreOptions options;
+    options.virtualPadding = true;
+    DiskBlockStore store(testPath.string(), BlockSize::Small, options);
+
+    std::vector<uint8_t> data(4096, 0x5C);
+    std::memset(data.data(), 1, 100);
+    auto checksum = store.put(data, BlockMetadata(BlockSize::Small, 100));
+
+    auto loaded = store.getBuffer(checksum);
+    ASSERT_EQ(loaded.size(), data.size());
+    EXPECT_EQ(std::memcmp(loaded.data(), data.data(), data.size()), 0);
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include "brightchain/cbl_view.hpp"
+#include "brightchain/extended_cbl.hpp"
+#include <algorithm>
+
+using namespace brightchain;
+
+namespace {
+
+constexpr size_t BLOCK = 4096;
+
+std::vector<Checksum> makeAddresses(size_t count) {
+    std::vector<Checksum> addresses;
+    for (size_t i = 0; i < count; ++i) {
+        addresses.push_back(Checksum::fromData(std::vector<uint8_t>{static_cast<uint8_t>(i),
+                                                                    static_cast<uint8_t>(i >> 8)}));
+    }
+    return addresses;
+}
+
+CBLHeader makeHeader(size_t addressCount) {
+    CBLHeader header;
+    header.creatorId.fill(0x11);
+    header.dateCreated = 1700000000123ULL;
+    header.addressCount = static_cast<uint32_t>(addressCount);
+    header.tupleSize = 3;
+    header.originalDataLength = 123456789;
+    header.originalDataChecksum = Checksum::fromData(std::vector<uint8_t>{42}).hash();
+    header.signature.fill(0x5A);
+    return header;
+}
+
+std::vector<uint8_t> appendAddresses(std::vector<uint8_t> data,
+                                     const std::vector<Checksum>& addresses) {
+    for (const auto& address : addresses) {
+        data.insert(data.end(), address.hash().begin(), address.hash().end());
+    }
+    data.resize(BLOCK, 0);
+    return data;
+}
+
+} // namespace
+
+TEST(CBLViewTest, MatchesConstituentBlockListBlock) {
+    auto addresses = makeAddresses(30);
+    auto data = appendAddresses(makeHeader(addresses.size()).serialize(), addresses);
+    ConstituentBlockListBlock block(BlockSize::Small, data, Checksum::fromData(data));
+
+    CBLView view(data);
+    EXPECT_FALSE(view.isExtended());
+    EXPECT_EQ(view.addressCount(), block.addressCount());
+    EXPECT_EQ(view.tupleSize(), block.tupleSize());
+    EXPECT_EQ(view.originalDataLength(), block.originalDataLength());
+    EXPECT_EQ(view.dateCreated(), block.header().dateCreated);
+    EXPECT_TRUE(std::equal(view.creatorId().begin(), view.creatorId().end(),
+                           block.header().creatorId.begin()));
+    EXPECT_TRUE(view.originalDataChecksum() ==
+                Checksum::fromHash(block.header().originalDataChecksum));
+    EXPECT_TRUE(std::equal(view.signature().begin(), view.signature().end(),
+                           block.header().signature.begin()));
+    EXPECT_EQ(view.layerOverheadSize(), block.layerOverheadSize());
+    EXPECT_EQ(view.addresses().toVector(), block.addresses());
+
+    auto payload = block.layerPayload();
+    EXPECT_TRUE(std::equal(payload.begin(), payload.end(), view.layerPayload().begin(),
+                           view.layerPayload().end()));
+}
+
+TEST(CBLViewTest, ParsesExtendedCBLMetadataInPlace) {
+    ExtendedCBLMetadata metadata{"report.pdf", "application/pdf"};
+    auto addresses = makeAddresses(5);
+    auto data = appendAddresses(ExtendedCBL::serializeHeader(makeHeader(5), metadata),
+                                addresses);
+    ExtendedCBL block(BlockSize::Small, data, Checksum::fromData(data));
+
+    CBLView view(data);
+    EXPECT_TRUE(view.isExtended());
+    EXPECT_EQ(view.fileName(), "report.pdf");
+    EXPECT_EQ(view.mimeType(), "application/pdf");
+    EXPECT_EQ(view.layerOverheadSize(), block.layerOverheadSize());
+    EXPECT_EQ(view.addresses().toVector(), block.addresses());
+    EXPECT_EQ(view.signature()[0], 0x5A);
+    EXPECT_EQ(view.signature()[63], 0x5A);
+}
+
+TEST(CBLViewTest, AddressRangeSupportsStandardAlgorithms) {
+    auto addresses = makeAddresses(40);
+    std::sort(addresses.begin(), addresses.end());
+    auto data = appendAddresses(makeHeader(addresses.size()).serialize(), addresses);
+
+    CBLView view(data);
+    auto range = view.addresses();
+    ASSERT_EQ(range.size(), 40u);
+    EXPECT_EQ(range.end() - range.begin(), 40);
+    EXPECT_TRUE(range[17] == addresses[17]);
+    EXPECT_TRUE(range.back() == addresses.back());
+
+    auto found = std::lower_bound(range.begin(), range.end(), addresses[23]);
+    ASSERT_NE(found, range.end());
+    EXPECT_EQ(found - range.begin(), 23);
+    EXPECT_TRUE(std::is_sorted(range.begin(), range.end()));
+
+    auto missing = Checksum::fromData(std::vector<uint8_t>{0xFF, 0xFF, 0xFF});
+    EXPECT_EQ(std::find(range.begin(), range.end(), ChecksumView(missing.hash().data())),
+              range.end());
+
+    auto tail = range.subrange(38, 2);
+    EXPECT_EQ(tail.toVector(), std::vector<Checksum>(addresses.end() - 2, addresses.end()));
+}
+
+TEST(CBLViewTest, RejectsMalformedBlocks) {
+    std::vector<uint8_t> tooShort(100, 0);
+    EXPECT_THROW(CBLView{tooShort}, std::invalid_argument);
+
+    auto data = makeHeader(0).serialize();
+    data[0] = 0;
+    EXPECT_THROW(CBLView{data}, std::invalid_argument);
+
+    // Address count larger than the block can hold
+    auto overflow = makeHeader(1000).serialize();
+    overflow.resize(BLOCK, 0);
+    EXPECT_THROW(CBLView{overflow}, std::invalid_argument);
+
+    SuperCBLHeader super;
+    super.creatorId.fill(0);
+    super.dateCreated = 0;
+    super.subCblCount = 0;
+    super.totalBlockCount = 0;
+    super.depth = 1;
+    super.originalDataLength = 0;
+    super.originalDataChecksum.fill(0);
+    super.signature.fill(0);
+    EXPECT_THROW(CBLView{super.serialize()}, std::invalid_argument);
+}
+
+TEST(SuperCBLViewTest, MatchesSuperCBL) {
+    auto children = makeAddresses(12);
+    SuperCBLHeader header;
+    header.creatorId.fill(7);
+    header.dateCreated = 99;
+    header.subCblCount = static_cast<uint32_t>(children.size());
+    header.totalBlockCount = 1234;
+    header.depth = 2;
+    header.originalDataLength = 1ULL << 40;
+    header.originalDataChecksum = Checksum::fromData(std::vector<uint8_t>{1}).hash();
+    header.signature.fill(3);
+    auto data = appendAddresses(header.serialize(), children);
+    SuperCBL block(BlockSize::Small, data, Checksum::fromData(data));
+
+    SuperCBLView view(data);
+    EXPECT_EQ(view.subCblCount(), block.subCblCount());
+    EXPECT_EQ(view.totalBlockCount(), block.totalBlockCount());
+    EXPECT_EQ(view.depth(), block.depth());
+    EXPECT_EQ(view.dateCreated(), 99u);
+    EXPECT_EQ(view.originalDataLength(), block.originalDataLength());
+    EXPECT_TRUE(view.originalDataChecksum() ==
+                Checksum::fromHash(block.header().originalDataChecksum));
+    EXPECT_EQ(view.signature()[0], 3);
+    EXPECT_EQ(view.subCblChecksums().toVector(), block.subCblChecksums());
+
+    auto cbl = appendAddresses(makeHeader(0).serialize(), {});
+    EXPECT_THROW(SuperCBLView{cbl}, std::invalid_argument);
+}
@@ -0,0 +1,277 @@
+#include <gtest/gtest.h>
+#include "brightchain/cuckoo_filter.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include <cstring>
+#include <filesystem>
+#include <latch>
+#include <thread>
+
+using namespace brightchain;
+
+namespace {
+
+Checksum keyFor(uint32_t i) {
+    std::vector<uint8_t> bytes(4);
+    std::memcpy(bytes.data(), &i, 4);
+    return Checksum::fromData(bytes);
+}
+
+} // namespace
+
+TEST(CuckooFilterTest, NoFalseNegatives) {
+    CuckooFilter filter(10000);
+    for (uint32_t i = 0; i < 10000; ++i) {
+        ASSERT_TRUE(filter.insert(keyFor(i)));
+    }
+    EXPECT_EQ(filter.size(), 10000);
+    for (uint32_t i = 0; i < 10000; ++i) {
+        EXPECT_TRUE(filter.contains(keyFor(i)));
+    }
+}
+
+TEST(CuckooFilterTest, LowFalsePositiveRate) {
+    CuckooFilter filter(10000);
+    for (uint32_t i = 0; i < 10000; ++i) {
+        filter.insert(keyFor(i));
+    }
+
+    size_t falsePositives = 0;
+    for (uint32_t i = 10000; i < 110000; ++i) {
+        if (filter.contains(keyFor(i))) {
+            ++falsePositives;
+        }
+    }
+    EXPECT_LT(falsePositives, 100); // < 0.1%
+}
+
+TEST(CuckooFilterTest, RemoveAndFullFilter) {
+    CuckooFilter filter;
+    auto key = keyFor(1);
+    filter.insert(key);
+    filter.insert(key);
+    EXPECT_TRUE(filter.remove(key));
+    EXPECT_TRUE(filter.contains(key));
+    EXPECT_TRUE(filter.remove(key));
+    EXPECT_FALSE(filter.contains(key));
+    EXPECT_FALSE(filter.remove(key));
+
+    // Fill beyond capacity: failed inserts must not lose existing members
+    std::vector<Checksum> inserted;
+    for (uint32_t i = 0; i < filter.capacity(); ++i) {
+        if (filter.insert(keyFor(i))) {
+            inserted.push_back(keyFor(i));
+        }
+    }
+    EXPECT_LT(inserted.size(), filter.capacity());
+    EXPECT_GT(inserted.size(), filter.capacity() * 9 / 10);
+    for (const auto& checksum : inserted) {
+        EXPECT_TRUE(filter.contains(checksum));
+    }
+}
+
+TEST(CuckooFilterTest, SaveAndLoad) {
+    auto path = std::filesystem::temp_directory_path() / "brightchain_cuckoo_test.bin";
+    CuckooFilter filter(5000);
+    for (uint32_t i = 0; i < 5000; ++i) {
+        filter.insert(keyFor(i));
+    }
+    filter.save(path);
+
+    auto loaded = CuckooFilter::load(path);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->size(), filter.size());
+    EXPECT_EQ(loaded->capacity(), filter.capacity());
+    for (uint32_t i = 0; i < 5000; ++i) {
+        EXPECT_TRUE(loaded->contains(keyFor(i)));
+    }
+
+    std::filesystem::resize_file(path, 100);
+    EXPECT_FALSE(CuckooFilter::load(path).has_value());
+    std::filesystem::remove(path);
+    EXPECT_FALSE(CuckooFilter::load(path).has_value());
+}
+
+class ExistenceFilterStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_existence_filter_test";
+        std::filesystem::remove_all(testPath);
+        options.existenceFilter = true;
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(testPath);
+    }
+
+    std::filesystem::path testPath;
+    DiskBlockStoreOptions options;
+};
+
+TEST_F(ExistenceFilterStoreTest, PutHasRemove) {
+    DiskBlockStore store(testPath.string(), BlockSize::Small, options);
+
+    std::vector<uint8_t> data = {1, 2, 3};
+    auto checksum = store.put(data);
+    EXPECT_TRUE(store.has(checksum));
+    EXPECT_EQ(store.get(checksum), data);
+
+    auto missing = Checksum::fromData({9, 9, 9});
+    EXPECT_FALSE(store.has(missing));
+    EXPECT_THROW(store.get(missing), std::runtime_error);
+
+    EXPECT_TRUE(store.remove(checksum));
+    EXPECT_FALSE(store.has(checksum));
+}
+
+TEST_F(ExistenceFilterStoreTest, PersistsAcrossCleanShutdown) {
+    Checksum checksum;
+    {
+        DiskBlockStore store(testPath.string(), BlockSize::Small, options);
+        checksum = store.put({4, 5, 6});
+    }
+    EXPECT_TRUE(std::filesystem::exists(testPath / "Small" / ".existence-filter"));
+
+    DiskBlockStore reopened(testPath.string(), BlockSize::Small, options);
+    EXPECT_FALSE(std::filesystem::exists(testPath / "Small" / ".existence-filter"));
+    EXPECT_TRUE(reopened.has(checksum));
+}
+
+TEST_F(ExistenceFilterStoreTest, OpenWithoutFilterDiscardsSavedFilter) {
+    {
+        DiskBlockStore store(testPath.string(), BlockSize::Small, options);
+        store.put({1, 2, 3});
+    }
+    EXPECT_TRUE(std::filesystem::exists(testPath / "Small" / ".existence-filter"));
+
+    Checksum checksum;
+    {
+        DiskBlockStore plain(testPath.string(), BlockSize::Small);
+        checksum = plain.put({7, 8, 9});
+    }
+    EXPECT_FALSE(std::filesystem::exists(testPath / "Small" / ".existence-filter"));
+
+    DiskBlockStore reopened(testPath.string(), BlockSize::Small, options);
+    EXPECT_TRUE(reopened.has(checksum));
+    EXPECT_EQ(reopened.get(checksum), std::vector<uint8_t>({7, 8, 9}));
+}
+
+TEST_F(ExistenceFilterStoreTest, RebuildsByScanningWithoutSavedFilter) {
+    std::vector<Checksum> checksums;
+    {
+        DiskBlockStore plain(testPath.string(), BlockSize::Tiny);
+        for (uint32_t i = 0; i < 50; ++i) {
+            std::vector<uint8_t> data(4);
+            std::memcpy(data.data(), &i, 4);
+            checksums.push_back(plain.put(data));
+        }
+    }
+
+    DiskBlockStore store(testPath.string(), BlockSize::Tiny, options);
+    for (const auto& checksum : checksums) {
+        EXPECT_TRUE(store.has(checksum));
+    }
+
+    size_t count = 0;
+    store.forEachChecksum([&count](const Checksum&) { ++count; });
+    EXPECT_EQ(count, checksums.size());
+}
+
+TEST_F(ExistenceFilterStoreTest, GrowsPastInitialCapacity) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message, options);
+    std::vector<Checksum> checksums;
+    for (uint32_t i = 0; i < 5000; ++i) {
+        std::vector<uint8_t> data(4);
+        std::memcpy(data.data(), &i, 4);
+        checksums.push_back(store.put(data));
+    }
+    for (const auto& checksum : checksums) {
+        ASSERT_TRUE(store.has(checksum));
+    }
+}
+
+TEST_F(ExistenceFilterStoreTest, RepeatedPutsAddOneFingerprint) {
+    Checksum checksum;
+    {
+        DiskBlockStore store(testPath.string(), BlockSize::Small, options);
+        for (int i = 0; i < 100; ++i) {
+            checksum = store.put({7, 8, 9});
+        }
+        EXPECT_TRUE(store.remove(checksum));
+        EXPECT_FALSE(store.has(checksum));
+        checksum = store.put({7, 8, 9});
+    }
+
+    auto saved = CuckooFilter::load(testPath / "Small" / ".existence-filter");
+    ASSERT_TRUE(saved.has_value());
+    EXPECT_EQ(saved->size(), 1u);
+    EXPECT_EQ(saved->capacity(), CuckooFilter().capacity());
+}
+
+TEST_F(ExistenceFilterStoreTest, ConcurrentPutAndRemoveKeepFilterExact) {
+    DiskBlockStore store(testPath.string(), BlockSize::Small, options);
+    const std::vector<uint8_t> data = {1, 2, 3};
+    const Checksum checksum = Checksum::fromData(data);
+    const std::string hex = checksum.toHex();
+    const auto path = testPath / "Small" / hex.substr(0, 1) / hex.substr(1, 1) / hex;
+
+    for (int round = 0; round < 200; ++round) {
+        if (round % 2 == 0) {
+            store.put(data);
+        }
+        std::latch start(2);
+        std::thread putter([&]() {
+            start.arrive_and_wait();
+            store.put(data);
+        });
+        std::thread remover([&]() {
+            start.arrive_and_wait();
+            store.remove(checksum);
+        });
+        putter.join();
+        remover.join();
+
+        // Whichever ran last, the filter must not hide a stored block
+        ASSERT_EQ(store.has(checksum), std::filesystem::exists(path)) << "round " << round;
+    }
+}
+
+TEST_F(ExistenceFilterStoreTest, RemovesDuringGrowthKeepStoredBlocks) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message, options);
+    auto dataFor = [](uint32_t i) {
+        std::vector<uint8_t> data(4);
+        std::memcpy(data.data(), &i, 4);
+        return data;
+    };
+
+    std::vector<Checksum> doomed;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        doomed.push_back(store.put(dataFor(i)));
+    }
+
+    // Enough puts to fill the initial filter while removes run alongside
+    constexpr uint32_t PUTTERS = 4;
+    constexpr uint32_t PER_PUTTER = 1500;
+    std::latch start(PUTTERS + 1);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < PUTTERS; ++t) {
+        threads.emplace_back([&, t]() {
+            start.arrive_and_wait();
+            for (uint32_t i = 0; i < PER_PUTTER; ++i) {
+                store.put(dataFor(1000 + t * PER_PUTTER + i));
+            }
+        });
+    }
+    threads.emplace_back([&]() {
+        start.arrive_and_wait();
+        for (const auto& checksum : doomed) {
+            store.remove(checksum);
+        }
+    });
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (uint32_t i = 1000; i < 1000 + PUTTERS * PER_PUTTER; ++i) {
+        ASSERT_TRUE(store.has(Checksum::fromData(dataFor(i)))) << "block " << i;
+    }
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "brightchain/ecies.hpp"
 #include "brightchain/ec_key_pair.hpp"
+#include "brightchain/thread_pool.hpp"
 
 using namespace brightchain;
 
@@ -140,3 +141,109 @@ TEST(EciesMultipleTest, SingleRecipientMultiple) {
     auto decrypted = Ecies::decrypt(encrypted, keyPair);
     EXPECT_EQ(decrypted, plaintext);
 }
+
+TEST(EciesMultipleTest, KeyIdsLocateEveryRecipient) {
+    std::vector<EcKeyPair> keyPairs;
+    std::vector<std::vector<uint8_t>> recipientKeys;
+    for (int i = 0; i < 20; ++i) {
+        keyPairs.push_back(EcKeyPair::generate());
+        recipientKeys.push_back(keyPairs.back().publicKey());
+    }
+
+    std::vector<uint8_t> plaintext = {0x10, 0x20, 0x30};
+    EciesMultipleOptions options;
+    options.recipientKeyIds = true;
+    auto encrypted = Ecies::encryptMultiple(plaintext, recipientKeys, options);
+
+    // First entry: index(4) + keyLength(2) = 56
+    const size_t table = 3 + 33 + 12 + 4;
+    EXPECT_EQ((encrypted[table + 4] << 8) | encrypted[table + 5], 56);
+    EXPECT_EQ(encrypted.size(), table + 20 * (6 + 56) + 16 + plaintext.size());
+
+    for (uint32_t i = 0; i < keyPairs.size(); ++i) {
+        EXPECT_EQ(Ecies::decrypt(encrypted, keyPairs[i]), plaintext);
+        // Entries are sorted by key id, so the index is checked after the search
+        EXPECT_EQ(Ecies::decrypt(encrypted, keyPairs[i], i), plaintext);
+    }
+    EXPECT_THROW(Ecies::decrypt(encrypted, keyPairs[2], 3), std::runtime_error);
+    EXPECT_THROW(Ecies::decrypt(encrypted, EcKeyPair::generate()), std::runtime_error);
+
+    // A payload that fails authentication is reported as such, not rescanned
+    encrypted.back() ^= 1;
+    for (auto recipientIndex : {std::optional<uint32_t>{}, std::optional<uint32_t>{3}}) {
+        try {
+            recipientIndex ? Ecies::decrypt(encrypted, keyPairs[3], *recipientIndex)
+                           : Ecies::decrypt(encrypted, keyPairs[3]);
+            FAIL() << "tampered payload decrypted";
+        } catch (const std::runtime_error& e) {
+            EXPECT_NE(std::string(e.what()).find("Authentication failed"), std::string::npos);
+        }
+    }
+}
+
+TEST(EciesMultipleTest, KnownIndexDecryptsOnlyThatEntry) {
+    std::vector<EcKeyPair> keyPairs;
+    std::vector<std::vector<uint8_t>> recipientKeys;
+    for (int i = 0; i < 8; ++i) {
+        keyPairs.push_back(EcKeyPair::generate());
+        recipientKeys.push_back(keyPairs.back().publicKey());
+    }
+
+    std::vector<uint8_t> plaintext(100, 0x77);
+    auto encrypted = Ecies::encryptMultiple(plaintext, recipientKeys);
+
+    for (uint32_t i = 0; i < keyPairs.size(); ++i) {
+        EXPECT_EQ(Ecies::decrypt(encrypted, keyPairs[i], i), plaintext);
+    }
+    EXPECT_THROW(Ecies::decrypt(encrypted, keyPairs[2], 3), std::runtime_error);
+    EXPECT_THROW(Ecies::decrypt(encrypted, keyPairs[2], 100), std::runtime_error);
+
+    auto basic = Ecies::encryptBasic(plaintext, keyPairs[0].publicKey());
+    EXPECT_THROW(Ecies::decrypt(basic, keyPairs[0], 0), std::invalid_argument);
+
+    encrypted.back() ^= 1;
+    try {
+        Ecies::decrypt(encrypted, keyPairs[5], 5);
+        FAIL() << "tampered payload decrypted";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("Authentication failed"), std::string::npos);
+    }
+}
+
+TEST(EciesMultipleTest, ParallelWrappingWithCachedKeys) {
+    std::vector<EcKeyPair> keyPairs;
+    std::vector<std::vector<uint8_t>> recipientKeys;
+    for (int i = 0; i < 100; ++i) {
+        keyPairs.push_back(EcKeyPair::generate());
+        recipientKeys.push_back(keyPairs.back().publicKey());
+    }
+
+    ThreadPool pool(4);
+    PublicKeyCache cache;
+    EciesMultipleOptions options;
+    options.pool = &pool;
+    options.keyCache = &cache;
+
+    std::vector<uint8_t> plaintext = {0x5a, 0x5b, 0x5c};
+    auto encrypted = Ecies::encryptMultiple(plaintext, recipientKeys, options);
+    EXPECT_EQ(cache.stats().misses, 100u);
+
+    // Entries stay in recipient order
+    const size_t table = 3 + 33 + 12 + 4;
+    for (uint32_t i = 0; i < keyPairs.size(); ++i) {
+        const uint8_t* entry = encrypted.data() + table + i * (6 + 48);
+        EXPECT_EQ((uint32_t{entry[2]} << 8) | entry[3], i);
+        EXPECT_EQ(Ecies::decrypt(encrypted, keyPairs[i], i), plaintext);
+    }
+
+    // The second message reuses every parsed key
+    options.recipientKeyIds = true;
+    encrypted = Ecies::encryptMultiple(plaintext, recipientKeys, options);
+    EXPECT_EQ(cache.stats().hits, 100u);
+    for (size_t i = 0; i < keyPairs.size(); i += 7) {
+        EXPECT_EQ(Ecies::decrypt(encrypted, keyPairs[i]), plaintext);
+    }
+
+    recipientKeys[50][0] = 0x05;
+    EXPECT_THROW(Ecies::encryptMultiple(plaintext, recipientKeys, options), std::runtime_error);
+}
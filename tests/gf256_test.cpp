@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include "brightchain/gf256.hpp"
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace brightchain;
+
+namespace {
+
+std::vector<uint8_t> randomBytes(size_t length, uint32_t seed) {
+    std::vector<uint8_t> data(length);
+    std::mt19937 rng(seed);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    return data;
+}
+
+// Carry-less multiply modulo 0x11B, independent of the tables
+uint8_t slowMul(uint8_t a, uint8_t b) {
+    uint8_t product = 0;
+    while (b) {
+        if (b & 1) {
+            product ^= a;
+        }
+        a = static_cast<uint8_t>((a << 1) ^ ((a & 0x80) ? 0x1B : 0));
+        b >>= 1;
+    }
+    return product;
+}
+
+std::vector<gf256::Kernel> supportedKernels() {
+    std::vector<gf256::Kernel> kernels{gf256::Kernel::Scalar};
+    if (gf256::bestKernel() != gf256::Kernel::Scalar) {
+        kernels.push_back(gf256::Kernel::Avx2);
+    }
+    if (gf256::bestKernel() == gf256::Kernel::Avx512Gfni) {
+        kernels.push_back(gf256::Kernel::Avx512Gfni);
+    }
+    return kernels;
+}
+
+} // namespace
+
+TEST(Gf256Test, FieldArithmetic) {
+    for (int a = 0; a < 256; ++a) {
+        for (int b = 0; b < 256; ++b) {
+            ASSERT_EQ(gf256::mul(a, b), slowMul(a, b)) << a << " * " << b;
+        }
+    }
+    for (int a = 1; a < 256; ++a) {
+        EXPECT_EQ(gf256::mul(a, gf256::inv(a)), 1) << a;
+    }
+    EXPECT_THROW(gf256::inv(0), std::domain_error);
+}
+
+TEST(Gf256Test, KernelsMatchScalarMultiply) {
+    for (auto kernel : supportedKernels()) {
+        for (size_t length : {0, 1, 15, 31, 32, 63, 64, 65, 1000, 4096 + 7}) {
+            for (int coefficient : {0, 1, 2, 0x53, 0xCA, 0xFF}) {
+                auto source = randomBytes(length, static_cast<uint32_t>(length + coefficient));
+                auto initial = randomBytes(length, static_cast<uint32_t>(length * 7 + 1));
+
+                std::vector<uint8_t> product(length, 0xAA);
+                gf256::mul(product.data(), source.data(), coefficient, length, kernel);
+                auto accumulated = initial;
+                gf256::mulAdd(accumulated.data(), source.data(), coefficient, length, kernel);
+
+                for (size_t i = 0; i < length; ++i) {
+                    const uint8_t expected = slowMul(source[i], coefficient);
+                    ASSERT_EQ(product[i], expected) << "length " << length << " at " << i;
+                    ASSERT_EQ(accumulated[i], initial[i] ^ expected)
+                        << "length " << length << " at " << i;
+                }
+            }
+        }
+    }
+}
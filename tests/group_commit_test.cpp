@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+#include "brightchain/group_commit.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include <atomic>
+#include <fcntl.h>
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace brightchain;
+
+class GroupCommitTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_group_commit_test";
+        std::filesystem::remove_all(testPath);
+        std::filesystem::create_directories(testPath);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(testPath);
+    }
+
+    int writeTemp(const std::filesystem::path& path, const std::string& contents) {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        EXPECT_GE(fd, 0);
+        EXPECT_EQ(::write(fd, contents.data(), contents.size()),
+                  static_cast<ssize_t>(contents.size()));
+        return fd;
+    }
+
+    size_t countTempFiles() const {
+        size_t count = 0;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(testPath)) {
+            if (entry.path().filename().string().find(".tmp") != std::string::npos) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    std::filesystem::path testPath;
+};
+
+TEST_F(GroupCommitTest, BatchesConcurrentCommits) {
+    std::atomic<int> hookCalls{0};
+    GroupCommitter committer(std::chrono::milliseconds(20), 1 << 20,
+                             [&hookCalls]() { ++hookCalls; });
+
+    const int writers = 16;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < writers; ++i) {
+        threads.emplace_back([this, &committer, i]() {
+            auto finalPath = testPath / ("block" + std::to_string(i));
+            auto tempPath = testPath / ("block" + std::to_string(i) + ".tmp");
+            int fd = writeTemp(tempPath, "data" + std::to_string(i));
+            committer.commit(fd, tempPath, finalPath, 5);
+            EXPECT_TRUE(std::filesystem::exists(finalPath));
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_LT(committer.batchCount(), static_cast<size_t>(writers));
+    EXPECT_EQ(hookCalls.load(), static_cast<int>(committer.batchCount()));
+    EXPECT_EQ(countTempFiles(), 0u);
+}
+
+TEST_F(GroupCommitTest, ByteThresholdCommitsEarly) {
+    GroupCommitter committer(std::chrono::hours(1), 4);
+    auto tempPath = testPath / "big.tmp";
+    int fd = writeTemp(tempPath, "0123456789");
+    // Would block for an hour if the byte threshold were ignored
+    committer.commit(fd, tempPath, testPath / "big", 10);
+    EXPECT_TRUE(std::filesystem::exists(testPath / "big"));
+}
+
+TEST_F(GroupCommitTest, FlushCommitsImmediately) {
+    GroupCommitter committer(std::chrono::hours(1), 1 << 20);
+    committer.flush();
+    EXPECT_EQ(committer.batchCount(), 1u);
+}
+
+TEST_F(GroupCommitTest, FailedCommitRemovesTempFile) {
+    GroupCommitter committer(std::chrono::milliseconds(1), 1 << 20);
+    auto tempPath = testPath / "orphan.tmp";
+    int fd = writeTemp(tempPath, "data");
+    EXPECT_THROW(committer.commit(fd, tempPath, testPath / "missing" / "dir" / "block", 4),
+                 std::exception);
+    EXPECT_FALSE(std::filesystem::exists(tempPath));
+}
+
+TEST_F(GroupCommitTest, FailuresAreReportedPerWrite) {
+    // Both writes only fill the byte threshold together, so they share a batch
+    GroupCommitter committer(std::chrono::hours(1), 8);
+    auto goodTemp = testPath / "good.tmp";
+    int goodFd = writeTemp(goodTemp, "good");
+    std::thread good([&]() {
+        EXPECT_NO_THROW(committer.commit(goodFd, goodTemp, testPath / "good", 4));
+    });
+
+    auto badTemp = testPath / "bad.tmp";
+    int badFd = writeTemp(badTemp, "bad!");
+    EXPECT_THROW(committer.commit(badFd, badTemp, testPath / "missing" / "block", 4),
+                 std::exception);
+    good.join();
+
+    EXPECT_EQ(committer.batchCount(), 1u);
+    EXPECT_TRUE(std::filesystem::exists(testPath / "good"));
+    EXPECT_EQ(countTempFiles(), 0u);
+}
+
+TEST_F(GroupCommitTest, FailedRenameRemovesTempFileInEveryMode) {
+    for (auto durability : {Durability::None, Durability::PerWrite}) {
+        std::filesystem::remove_all(testPath);
+        DiskBlockStoreOptions options;
+        options.durability = durability;
+        DiskBlockStore store(testPath.string(), BlockSize::Message, options);
+
+        // A non-empty directory in the block's place makes the rename fail
+        std::vector<uint8_t> data(512, 7);
+        const auto hex = Checksum::fromData(data).toHex();
+        const auto blocked = testPath / "Message" / hex.substr(0, 1) / hex.substr(1, 1) / hex;
+        std::filesystem::create_directories(blocked / "occupied");
+
+        EXPECT_THROW(store.put(data), std::exception);
+        EXPECT_EQ(countTempFiles(), 0u);
+    }
+}
+
+TEST_F(GroupCommitTest, StoreRoundTripsInEveryMode) {
+    for (auto durability : {Durability::None, Durability::PerWrite, Durability::GroupCommit}) {
+        for (auto layout : {StorageLayout::FilePerBlock, StorageLayout::Packed}) {
+            std::filesystem::remove_all(testPath);
+            DiskBlockStoreOptions options;
+            options.layout = layout;
+            options.durability = durability;
+            options.groupCommitInterval = std::chrono::milliseconds(1);
+            DiskBlockStore store(testPath.string(), BlockSize::Message, options);
+
+            std::vector<uint8_t> data(512, static_cast<uint8_t>(durability));
+            auto checksum = store.put(data);
+            EXPECT_EQ(store.get(checksum), data);
+            ASSERT_TRUE(store.getMetadata(checksum).has_value());
+            EXPECT_EQ(store.getMetadata(checksum)->length_without_padding, 512u);
+            EXPECT_EQ(countTempFiles(), 0u);
+        }
+    }
+}
+
+TEST_F(GroupCommitTest, ConcurrentGroupCommitPuts) {
+    DiskBlockStoreOptions options;
+    options.durability = Durability::GroupCommit;
+    options.groupCommitInterval = std::chrono::milliseconds(5);
+    DiskBlockStore store(testPath.string(), BlockSize::Message, options);
+
+    std::vector<std::thread> threads;
+    std::vector<Checksum> checksums(32, Checksum::fromData(std::vector<uint8_t>{}));
+    for (size_t i = 0; i < checksums.size(); ++i) {
+        threads.emplace_back([&store, &checksums, i]() {
+            std::vector<uint8_t> data(512, static_cast<uint8_t>(i));
+            checksums[i] = store.put(data);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (size_t i = 0; i < checksums.size(); ++i) {
+        EXPECT_EQ(store.get(checksums[i]), std::vector<uint8_t>(512, static_cast<uint8_t>(i)));
+    }
+}
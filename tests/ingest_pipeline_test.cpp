@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include "brightchain/ingest_pipeline.hpp"
+#include "brightchain/cbl.hpp"
+#include "brightchain/extended_cbl.hpp"
+#include "brightchain/reassembler.hpp"
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+using namespace brightchain;
+
+class IngestPipelineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_ingest_test";
+        std::filesystem::remove_all(testPath);
+        std::filesystem::create_directories(testPath);
+        store = std::make_unique<DiskBlockStore>((testPath / "store").string(), BlockSize::Small);
+    }
+
+    void TearDown() override {
+        store.reset();
+        std::filesystem::remove_all(testPath);
+    }
+
+    std::vector<uint8_t> writeInput(size_t length) {
+        std::vector<uint8_t> data(length);
+        std::mt19937 rng(7);
+        for (auto& byte : data) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        std::ofstream file(testPath / "input.bin", std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        return data;
+    }
+
+    std::vector<uint8_t> reassemble(const ConstituentBlockListBlock& cbl) {
+        std::vector<uint8_t> output;
+        for (const auto& address : cbl.addresses()) {
+            auto block = store->get(address);
+            EXPECT_EQ(block.size(), blockSizeToLength(BlockSize::Small));
+            auto metadata = store->getMetadata(address);
+            EXPECT_TRUE(metadata.has_value());
+            output.insert(output.end(), block.begin(),
+                          block.begin() + metadata->length_without_padding);
+        }
+        return output;
+    }
+
+    std::filesystem::path testPath;
+    std::unique_ptr<DiskBlockStore> store;
+};
+
+TEST_F(IngestPipelineTest, IngestsFileIntoCBL) {
+    auto input = writeInput(4096 * 10 + 123);
+    IngestPipeline pipeline(*store);
+    auto result = pipeline.ingestFile(testPath / "input.bin");
+
+    EXPECT_EQ(result.blockCount, 11u);
+    EXPECT_EQ(result.originalDataLength, input.size());
+    EXPECT_EQ(result.originalDataChecksum, Checksum::fromData(input));
+
+    auto cblData = store->get(result.cblChecksum);
+    ConstituentBlockListBlock cbl(BlockSize::Small, cblData, result.cblChecksum);
+    cbl.validateSync();
+    EXPECT_EQ(cbl.addressCount(), 11u);
+    EXPECT_EQ(cbl.tupleSize(), 1u);
+    EXPECT_EQ(cbl.originalDataLength(), input.size());
+    EXPECT_EQ(Checksum::fromHash(cbl.header().originalDataChecksum), Checksum::fromData(input));
+    EXPECT_EQ(reassemble(cbl), input);
+}
+
+TEST_F(IngestPipelineTest, IngestsIntoExtendedCBL) {
+    auto input = writeInput(4096 * 3);
+    IngestOptions options;
+    options.fileName = "input.bin";
+    options.mimeType = "application/octet-stream";
+    options.creatorId.fill(0x42);
+
+    IngestPipeline pipeline(*store);
+    auto result = pipeline.ingestFile(testPath / "input.bin", options);
+    EXPECT_EQ(result.blockCount, 3u);
+
+    auto cblData = store->get(result.cblChecksum);
+    ExtendedCBL cbl(BlockSize::Small, cblData, result.cblChecksum);
+    cbl.validateSync();
+    EXPECT_EQ(cbl.fileName(), "input.bin");
+    EXPECT_EQ(cbl.mimeType(), "application/octet-stream");
+    EXPECT_EQ(cbl.header().creatorId[0], 0x42);
+    EXPECT_EQ(reassemble(cbl), input);
+}
+
+TEST_F(IngestPipelineTest, BoundedWindowStillIngestsEverything) {
+    auto input = writeInput(4096 * 40);
+    IngestOptions options;
+    options.maxBufferedBytes = 1; // one block in flight at a time
+
+    ThreadPool pool(4);
+    IngestPipeline pipeline(*store, pool);
+    auto result = pipeline.ingestFile(testPath / "input.bin", options);
+
+    auto cblData = store->get(result.cblChecksum);
+    ConstituentBlockListBlock cbl(BlockSize::Small, cblData, result.cblChecksum);
+    EXPECT_EQ(reassemble(cbl), input);
+}
+
+TEST_F(IngestPipelineTest, EmptyInput) {
+    writeInput(0);
+    IngestPipeline pipeline(*store);
+    auto result = pipeline.ingestFile(testPath / "input.bin");
+    EXPECT_EQ(result.blockCount, 0u);
+    EXPECT_EQ(result.originalDataLength, 0u);
+    EXPECT_EQ(result.originalDataChecksum, Checksum::fromData(std::vector<uint8_t>{}));
+}
+
+TEST_F(IngestPipelineTest, InputLargerThanOneCBLBuildsSuperCBL) {
+    IngestPipeline pipeline(*store);
+    auto input = writeInput(4096 * (pipeline.cblCapacity() * 2 + 1) + 5);
+    auto result = pipeline.ingestFile(testPath / "input.bin");
+    EXPECT_EQ(result.depth, 1);
+    EXPECT_EQ(result.blockCount, pipeline.cblCapacity() * 2 + 2);
+
+    std::filesystem::path output = testPath / "output.bin";
+    Reassembler(*store).reassembleToFile(result.cblChecksum, output);
+    std::ifstream file(output, std::ios::binary);
+    std::vector<uint8_t> restored((std::istreambuf_iterator<char>(file)),
+                                  std::istreambuf_iterator<char>());
+    EXPECT_EQ(restored, input);
+}
+
+TEST_F(IngestPipelineTest, MissingFileThrows) {
+    IngestPipeline pipeline(*store);
+    EXPECT_THROW(pipeline.ingestFile(testPath / "missing.bin"), std::runtime_error);
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include "brightchain/disk_block_store.hpp"
+#include "brightchain/mapped_block.hpp"
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+using namespace brightchain;
+
+class MappedBlockTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_mapped_test";
+        std::filesystem::remove_all(testPath);
+        std::filesystem::create_directories(testPath);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(testPath);
+    }
+
+    std::filesystem::path testPath;
+};
+
+TEST_F(MappedBlockTest, MapWholeFile) {
+    std::vector<uint8_t> data(10000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 31);
+    }
+    auto path = testPath / "block";
+    std::ofstream(path, std::ios::binary)
+        .write(reinterpret_cast<const char*>(data.data()), data.size());
+
+    auto mapped = MappedBlock::map(path, AccessHint::Sequential);
+    ASSERT_EQ(mapped.size(), data.size());
+    EXPECT_TRUE(std::equal(data.begin(), data.end(), mapped.span().begin()));
+    EXPECT_EQ(Checksum::fromData(mapped.data(), mapped.size()), Checksum::fromData(data));
+}
+
+TEST_F(MappedBlockTest, MapUnalignedRange) {
+    std::vector<uint8_t> data(20000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i);
+    }
+    auto path = testPath / "segment";
+    std::ofstream(path, std::ios::binary)
+        .write(reinterpret_cast<const char*>(data.data()), data.size());
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    auto mapped = MappedBlock::map(fd, 4099, 5000, AccessHint::Random);
+    ::close(fd);
+
+    ASSERT_EQ(mapped.size(), 5000);
+    EXPECT_TRUE(std::equal(data.begin() + 4099, data.begin() + 9099, mapped.data()));
+}
+
+TEST_F(MappedBlockTest, EmptyFileAndMove) {
+    auto path = testPath / "empty";
+    std::ofstream(path, std::ios::binary).close();
+
+    auto mapped = MappedBlock::map(path);
+    EXPECT_TRUE(mapped.empty());
+
+    std::vector<uint8_t> data = {1, 2, 3};
+    auto full = testPath / "full";
+    std::ofstream(full, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), 3);
+    MappedBlock moved = MappedBlock::map(full);
+    mapped = std::move(moved);
+    EXPECT_EQ(mapped.size(), 3);
+    EXPECT_TRUE(moved.empty());
+}
+
+TEST_F(MappedBlockTest, DiskBlockStoreGetMapped) {
+    for (auto layout : {StorageLayout::FilePerBlock, StorageLayout::Packed}) {
+        DiskBlockStore store((testPath / "store").string(), BlockSize::Small, layout);
+
+        std::vector<uint8_t> first(4096, 0xAA);
+        std::vector<uint8_t> second = {5, 4, 3, 2, 1};
+        store.put(first);
+        auto checksum = store.put(second);
+
+        auto mapped = store.getMapped(checksum, AccessHint::Sequential);
+        ASSERT_EQ(mapped.size(), second.size());
+        EXPECT_TRUE(std::equal(second.begin(), second.end(), mapped.data()));
+        EXPECT_EQ(Checksum::fromData(mapped.data(), mapped.size()), checksum);
+
+        EXPECT_THROW(store.getMapped(Checksum::fromData({9, 9, 9})), std::runtime_error);
+        std::filesystem::remove_all(testPath / "store");
+    }
+}
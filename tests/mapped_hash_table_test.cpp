@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include "brightchain/mapped_hash_table.hpp"
+#include <cstring>
+#include <filesystem>
+
+using namespace brightchain;
+
+namespace {
+
+constexpr MappedHashTable::Layout LAYOUT{0x54534554, 1, 80, 72, "test table"};
+constexpr uint32_t FLAG_OWNER = 1u << 4;
+
+Checksum keyFor(uint32_t i) {
+    std::vector<uint8_t> bytes(4);
+    std::memcpy(bytes.data(), &i, 4);
+    return Checksum::fromData(bytes);
+}
+
+// Records are little-endian, like the table's own header fields
+void storeLE(uint8_t* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+}
+
+uint64_t loadLE(const uint8_t* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(in[i]) << (i * 8);
+    }
+    return value;
+}
+
+uint64_t valueOf(const MappedHashTable& table, const Checksum& checksum) {
+    return table.read(checksum, [](const uint8_t* record) -> uint64_t {
+        return record ? loadLE(record + 64, 8) : 0;
+    });
+}
+
+} // namespace
+
+class MappedHashTableTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_mapped_hash_table_test";
+        std::filesystem::remove_all(testPath);
+        std::filesystem::create_directories(testPath);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(testPath);
+    }
+
+    std::filesystem::path testPath;
+};
+
+TEST_F(MappedHashTableTest, WriteReadErase) {
+    MappedHashTable table(testPath / "table.idx", LAYOUT);
+    auto key = keyFor(1);
+
+    table.write(key, [](uint8_t* record, bool existed) {
+        EXPECT_FALSE(existed);
+        EXPECT_EQ(loadLE(record + 64, 8), 0u);
+        storeLE(record + 64, 42, 8);
+    });
+    table.write(key, [](uint8_t*, bool existed) { EXPECT_TRUE(existed); });
+
+    EXPECT_EQ(valueOf(table, key), 42u);
+    EXPECT_EQ(table.size(), 1u);
+    EXPECT_TRUE(table.erase(key));
+    EXPECT_FALSE(table.erase(key));
+    EXPECT_EQ(valueOf(table, key), 0u);
+    EXPECT_EQ(table.size(), 0u);
+}
+
+TEST_F(MappedHashTableTest, GrowthKeepsRecordsAndOwnerFlags) {
+    const uint32_t count = 3000;
+    {
+        MappedHashTable table(testPath / "table.idx", LAYOUT);
+        for (uint32_t i = 0; i < count; ++i) {
+            table.write(keyFor(i), [i](uint8_t* record, bool) {
+                storeLE(record + 64, i + 1, 8);
+                storeLE(record + 72, MappedHashTable::FLAG_OCCUPIED | FLAG_OWNER, 4);
+            });
+        }
+        EXPECT_GT(table.slotCount(), MappedHashTable::INITIAL_SLOTS);
+        EXPECT_FALSE(std::filesystem::exists(testPath / "table.idx.tmp"));
+    }
+
+    MappedHashTable reopened(testPath / "table.idx", LAYOUT);
+    EXPECT_EQ(reopened.size(), count);
+    size_t visited = 0;
+    reopened.forEach([&](const uint8_t* record) {
+        const uint64_t value = loadLE(record + 64, 8);
+        EXPECT_EQ(MappedHashTable::key(record), keyFor(static_cast<uint32_t>(value - 1)));
+        EXPECT_NE(loadLE(record + 72, 4) & FLAG_OWNER, 0u);
+        ++visited;
+    });
+    EXPECT_EQ(visited, count);
+}
+
+TEST_F(MappedHashTableTest, RejectsOtherLayouts) {
+    {
+        MappedHashTable table(testPath / "table.idx", LAYOUT);
+    }
+    auto other = LAYOUT;
+    other.magic ^= 1;
+    EXPECT_THROW(MappedHashTable(testPath / "table.idx", other), std::runtime_error);
+    other = LAYOUT;
+    other.recordSize = 96;
+    EXPECT_THROW(MappedHashTable(testPath / "table.idx", other), std::runtime_error);
+}
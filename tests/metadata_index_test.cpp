@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+#include "brightchain/metadata_index.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace brightchain;
+
+namespace {
+
+Checksum keyFor(uint32_t i) {
+    std::vector<uint8_t> bytes(4);
+    std::memcpy(bytes.data(), &i, 4);
+    return Checksum::fromData(bytes);
+}
+
+BlockMetadata metadataFor(uint32_t i) {
+    return BlockMetadata(BlockSize::Small, i,
+                         std::chrono::system_clock::from_time_t(1700000000 + i));
+}
+
+} // namespace
+
+class MetadataIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_metadata_index_test";
+        std::filesystem::remove_all(testPath);
+        std::filesystem::create_directories(testPath);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(testPath);
+    }
+
+    std::filesystem::path testPath;
+};
+
+TEST_F(MetadataIndexTest, PutGetRemove) {
+    MetadataIndex index(testPath / "metadata.idx");
+    auto key = keyFor(1);
+    EXPECT_FALSE(index.has(key));
+    EXPECT_FALSE(index.get(key).has_value());
+
+    index.put(key, metadataFor(42));
+    ASSERT_TRUE(index.has(key));
+    auto metadata = index.get(key);
+    ASSERT_TRUE(metadata.has_value());
+    EXPECT_EQ(metadata->size, BlockSize::Small);
+    EXPECT_EQ(metadata->length_without_padding, 42);
+    EXPECT_EQ(metadata->created_at, std::chrono::system_clock::from_time_t(1700000042));
+
+    index.put(key, metadataFor(7));
+    EXPECT_EQ(index.size(), 1);
+    EXPECT_EQ(index.get(key)->length_without_padding, 7);
+
+    EXPECT_TRUE(index.remove(key));
+    EXPECT_FALSE(index.remove(key));
+    EXPECT_FALSE(index.has(key));
+    EXPECT_EQ(index.size(), 0);
+}
+
+TEST_F(MetadataIndexTest, KeepsMillisecondCreationTimes) {
+    const std::chrono::system_clock::time_point created(std::chrono::milliseconds(1700000000123));
+    auto key = keyFor(2);
+    {
+        MetadataIndex index(testPath / "metadata.idx");
+        index.put(key, BlockMetadata(BlockSize::Small, 5, created));
+        EXPECT_EQ(index.get(key)->created_at, created);
+    }
+
+    MetadataIndex reopened(testPath / "metadata.idx");
+    EXPECT_EQ(reopened.get(key)->created_at, created);
+}
+
+TEST_F(MetadataIndexTest, GrowsAndPersists) {
+    const uint32_t count = 5000;
+    {
+        MetadataIndex index(testPath / "metadata.idx");
+        for (uint32_t i = 0; i < count; ++i) {
+            index.put(keyFor(i), metadataFor(i));
+        }
+        for (uint32_t i = 0; i < count; i += 2) {
+            ASSERT_TRUE(index.remove(keyFor(i)));
+        }
+        EXPECT_GT(index.slotCount(), MetadataIndex::INITIAL_SLOTS);
+    }
+
+    MetadataIndex reopened(testPath / "metadata.idx");
+    EXPECT_EQ(reopened.size(), count / 2);
+    for (uint32_t i = 0; i < count; ++i) {
+        auto metadata = reopened.get(keyFor(i));
+        if (i % 2 == 0) {
+            EXPECT_FALSE(metadata.has_value());
+        } else {
+            ASSERT_TRUE(metadata.has_value());
+            EXPECT_EQ(metadata->length_without_padding, i);
+        }
+    }
+
+    size_t visited = 0;
+    reopened.forEach([&visited](const Checksum&, const BlockMetadata& metadata) {
+        EXPECT_EQ(metadata.length_without_padding % 2, 1u);
+        ++visited;
+    });
+    EXPECT_EQ(visited, count / 2);
+}
+
+TEST_F(MetadataIndexTest, TombstonesAreReclaimed) {
+    MetadataIndex index(testPath / "metadata.idx");
+    for (uint32_t round = 0; round < 10; ++round) {
+        for (uint32_t i = 0; i < 500; ++i) {
+            index.put(keyFor(round * 500 + i), metadataFor(i));
+        }
+        for (uint32_t i = 0; i < 500; ++i) {
+            index.remove(keyFor(round * 500 + i));
+        }
+    }
+    EXPECT_EQ(index.size(), 0);
+    // Never more than 500 live records, so churn must not keep doubling the file
+    EXPECT_LE(index.slotCount(), MetadataIndex::INITIAL_SLOTS * 2);
+}
+
+TEST_F(MetadataIndexTest, SyncIsSafeDuringGrowth) {
+    MetadataIndex index(testPath / "metadata.idx");
+    std::atomic<bool> done{false};
+    std::thread syncer([&]() {
+        while (!done.load()) {
+            index.sync();
+        }
+    });
+
+    for (uint32_t i = 0; i < 5000; ++i) {
+        index.put(keyFor(i), metadataFor(i));
+    }
+    done = true;
+    syncer.join();
+
+    EXPECT_GT(index.slotCount(), MetadataIndex::INITIAL_SLOTS);
+    EXPECT_EQ(index.size(), 5000u);
+}
+
+TEST_F(MetadataIndexTest, RejectsInvalidFile) {
+    {
+        std::ofstream file(testPath / "metadata.idx", std::ios::binary);
+        file << "not an index";
+    }
+    EXPECT_THROW(MetadataIndex(testPath / "metadata.idx"), std::runtime_error);
+}
+
+TEST_F(MetadataIndexTest, StoreWritesNoSidecars) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message);
+    std::vector<uint8_t> data(100, 0x5A);
+    auto checksum = store.put(data);
+
+    ASSERT_TRUE(store.hasMetadata(checksum));
+    EXPECT_EQ(store.getMetadata(checksum)->length_without_padding, 100);
+    EXPECT_FALSE(std::filesystem::exists(
+        testPath / blockSizeToString(BlockSize::Message) / checksum.toHex().substr(0, 1) /
+        checksum.toHex().substr(1, 1) / (checksum.toHex() + ".m.json")));
+
+    EXPECT_TRUE(store.remove(checksum));
+    EXPECT_FALSE(store.hasMetadata(checksum));
+}
+
+TEST_F(MetadataIndexTest, MigratesJsonSidecars) {
+    std::vector<uint8_t> data(64, 0x11);
+    Checksum checksum = Checksum::fromData(data);
+    auto hex = checksum.toHex();
+    auto dir = testPath / blockSizeToString(BlockSize::Message) / hex.substr(0, 1) /
+               hex.substr(1, 1);
+    std::filesystem::create_directories(dir);
+    {
+        std::ofstream block(dir / hex, std::ios::binary);
+        block.write(reinterpret_cast<const char*>(data.data()), data.size());
+        std::ofstream sidecar(dir / (hex + ".m.json"));
+        sidecar << metadataFor(33).to_json().dump(2);
+    }
+
+    DiskBlockStore store(testPath.string(), BlockSize::Message);
+    // Unmigrated sidecars remain readable
+    ASSERT_TRUE(store.hasMetadata(checksum));
+    EXPECT_EQ(store.getMetadata(checksum)->length_without_padding, 33);
+
+    EXPECT_EQ(store.migrateJsonMetadata(), 1);
+    EXPECT_FALSE(std::filesystem::exists(dir / (hex + ".m.json")));
+    auto metadata = store.getMetadata(checksum);
+    ASSERT_TRUE(metadata.has_value());
+    EXPECT_EQ(metadata->length_without_padding, 33);
+    EXPECT_EQ(metadata->created_at, std::chrono::system_clock::from_time_t(1700000033));
+
+    EXPECT_EQ(store.migrateJsonMetadata(), 0);
+}
@@ -0,0 +1,307 @@
+#include <gtest/gtest.h>
+#include "brightchain/disk_block_store.hpp"
+#include "brightchain/packed_segment_store.hpp"
+#include <filesystem>
+#include <fstream>
+
+using namespace brightchain;
+
+class PackedSegmentStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_packed_test";
+        std::filesystem::remove_all(testPath);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(testPath);
+    }
+
+    static std::vector<uint8_t> makeBlock(uint8_t seed, size_t length = 512) {
+        std::vector<uint8_t> data(length);
+        for (size_t i = 0; i < length; ++i) {
+            data[i] = static_cast<uint8_t>(seed + i * 7);
+        }
+        return data;
+    }
+
+    std::filesystem::path testPath;
+};
+
+TEST_F(PackedSegmentStoreTest, PutGetHasRemove) {
+    PackedSegmentStore store(testPath, BlockSize::Message);
+
+    auto data = makeBlock(1);
+    auto checksum = Checksum::fromData(data);
+    store.put(checksum, data, BlockMetadata(BlockSize::Message, 300));
+
+    EXPECT_TRUE(store.has(checksum));
+    EXPECT_EQ(store.get(checksum), data);
+
+    auto metadata = store.getMetadata(checksum);
+    ASSERT_TRUE(metadata.has_value());
+    EXPECT_EQ(metadata->size, BlockSize::Message);
+    EXPECT_EQ(metadata->length_without_padding, 300);
+
+    EXPECT_TRUE(store.remove(checksum));
+    EXPECT_FALSE(store.has(checksum));
+    EXPECT_FALSE(store.remove(checksum));
+    EXPECT_THROW(store.get(checksum), std::runtime_error);
+}
+
+TEST_F(PackedSegmentStoreTest, DuplicatePutDoesNotAppendData) {
+    PackedSegmentStore store(testPath, BlockSize::Message);
+
+    auto data = makeBlock(2);
+    auto checksum = Checksum::fromData(data);
+    store.put(checksum, data, BlockMetadata(BlockSize::Message, 100));
+    store.put(checksum, data, BlockMetadata(BlockSize::Message, 200));
+
+    EXPECT_EQ(store.size(), 1);
+    EXPECT_EQ(store.deadBytes(), PackedSegmentStore::ENTRY_HEADER_SIZE);
+    EXPECT_EQ(store.getMetadata(checksum)->length_without_padding, 200);
+}
+
+TEST_F(PackedSegmentStoreTest, ReopenRebuildsIndex) {
+    std::vector<Checksum> kept;
+    Checksum removed;
+    {
+        PackedSegmentStore store(testPath, BlockSize::Tiny);
+        for (uint8_t i = 0; i < 20; ++i) {
+            auto data = makeBlock(i, 1024);
+            auto checksum = Checksum::fromData(data);
+            store.put(checksum, data, BlockMetadata(BlockSize::Tiny, data.size()));
+            kept.push_back(checksum);
+        }
+        removed = kept.back();
+        kept.pop_back();
+        store.remove(removed);
+    }
+
+    PackedSegmentStore reopened(testPath, BlockSize::Tiny);
+    EXPECT_EQ(reopened.size(), kept.size());
+    EXPECT_FALSE(reopened.has(removed));
+    for (uint8_t i = 0; i < kept.size(); ++i) {
+        EXPECT_EQ(reopened.get(kept[i]), makeBlock(i, 1024));
+    }
+}
+
+TEST_F(PackedSegmentStoreTest, RotatesSegments) {
+    const uint64_t segmentSize = 4 * (PackedSegmentStore::ENTRY_HEADER_SIZE + 512);
+    PackedSegmentStore store(testPath, BlockSize::Message, segmentSize);
+
+    std::vector<Checksum> checksums;
+    for (uint8_t i = 0; i < 10; ++i) {
+        auto data = makeBlock(i);
+        checksums.push_back(Checksum::fromData(data));
+        store.put(checksums.back(), data, BlockMetadata(BlockSize::Message, data.size()));
+    }
+
+    EXPECT_EQ(store.segmentCount(), 3);
+    for (uint8_t i = 0; i < checksums.size(); ++i) {
+        EXPECT_EQ(store.get(checksums[i]), makeBlock(i));
+    }
+}
+
+TEST_F(PackedSegmentStoreTest, CompactsSegmentPastDeadThreshold) {
+    const uint64_t entrySize = PackedSegmentStore::ENTRY_HEADER_SIZE + 512;
+    std::vector<Checksum> checksums;
+    {
+        PackedSegmentStore store(testPath, BlockSize::Message, 4 * entrySize);
+        for (uint8_t i = 0; i < 10; ++i) {
+            auto data = makeBlock(i);
+            checksums.push_back(Checksum::fromData(data));
+            store.put(checksums.back(), data, BlockMetadata(BlockSize::Message, data.size()));
+        }
+
+        // One removed block of four stays below the threshold
+        store.remove(checksums[0]);
+        EXPECT_EQ(store.compactionCount(), 0);
+        EXPECT_EQ(std::filesystem::file_size(testPath / "00000000.seg"), 4 * entrySize);
+
+        store.remove(checksums[1]);
+        EXPECT_EQ(store.compactionCount(), 1);
+        EXPECT_EQ(std::filesystem::file_size(testPath / "00000000.seg"), 2 * entrySize);
+        for (uint8_t i = 2; i < checksums.size(); ++i) {
+            EXPECT_EQ(store.get(checksums[i]), makeBlock(i));
+            EXPECT_EQ(store.getMapped(checksums[i]).span().size(), 512);
+        }
+    }
+
+    PackedSegmentStore reopened(testPath, BlockSize::Message, 4 * entrySize);
+    EXPECT_EQ(reopened.size(), checksums.size() - 2);
+    EXPECT_FALSE(reopened.has(checksums[0]));
+    EXPECT_FALSE(reopened.has(checksums[1]));
+    for (uint8_t i = 2; i < checksums.size(); ++i) {
+        EXPECT_EQ(reopened.get(checksums[i]), makeBlock(i));
+    }
+}
+
+TEST_F(PackedSegmentStoreTest, CompactionKeepsTombstonesForOlderSegments) {
+    const uint64_t entrySize = PackedSegmentStore::ENTRY_HEADER_SIZE + 512;
+    std::vector<Checksum> checksums;
+    auto put = [&](PackedSegmentStore& store, uint8_t seed) {
+        auto data = makeBlock(seed);
+        checksums.push_back(Checksum::fromData(data));
+        store.put(checksums.back(), data, BlockMetadata(BlockSize::Message, data.size()));
+    };
+    {
+        PackedSegmentStore store(testPath, BlockSize::Message, 4 * entrySize);
+        for (uint8_t i = 0; i < 4; ++i) {
+            put(store, i);
+        }
+        // Segment 1: the tombstone of block 0, blocks 4-6; block 7 seals it
+        store.remove(checksums[0]);
+        for (uint8_t i = 4; i < 8; ++i) {
+            put(store, i);
+        }
+        ASSERT_EQ(store.segmentCount(), 3);
+
+        for (uint8_t i = 4; i < 7; ++i) {
+            store.remove(checksums[i]);
+        }
+        EXPECT_EQ(store.compactionCount(), 2);
+        EXPECT_EQ(std::filesystem::file_size(testPath / "00000001.seg"),
+                  PackedSegmentStore::ENTRY_HEADER_SIZE);
+    }
+
+    PackedSegmentStore reopened(testPath, BlockSize::Message, 4 * entrySize);
+    EXPECT_FALSE(reopened.has(checksums[0]));
+    for (uint8_t i : {1, 2, 3, 7}) {
+        EXPECT_EQ(reopened.get(checksums[i]), makeBlock(i));
+    }
+    EXPECT_EQ(reopened.size(), 4);
+}
+
+TEST_F(PackedSegmentStoreTest, KeepsMillisecondCreationTimes) {
+    const std::chrono::system_clock::time_point created(std::chrono::milliseconds(1700000000123));
+    auto data = makeBlock(7);
+    auto checksum = Checksum::fromData(data);
+    {
+        PackedSegmentStore store(testPath, BlockSize::Message);
+        store.put(checksum, data, BlockMetadata(BlockSize::Message, data.size(), created));
+        EXPECT_EQ(store.getMetadata(checksum)->created_at, created);
+    }
+
+    PackedSegmentStore reopened(testPath, BlockSize::Message);
+    EXPECT_EQ(reopened.getMetadata(checksum)->created_at, created);
+}
+
+TEST_F(PackedSegmentStoreTest, RecoversFromTornAppend) {
+    auto data = makeBlock(3);
+    auto checksum = Checksum::fromData(data);
+    {
+        PackedSegmentStore store(testPath, BlockSize::Message);
+        store.put(checksum, data, BlockMetadata(BlockSize::Message, data.size()));
+    }
+
+    // Simulate a crash in the middle of the next append
+    {
+        std::ofstream segment(testPath / "00000000.seg", std::ios::binary | std::ios::app);
+        std::vector<char> partial(PackedSegmentStore::ENTRY_HEADER_SIZE / 2, 0x42);
+        segment.write(partial.data(), partial.size());
+    }
+
+    PackedSegmentStore reopened(testPath, BlockSize::Message);
+    EXPECT_EQ(reopened.get(checksum), data);
+
+    auto next = makeBlock(4);
+    auto nextChecksum = Checksum::fromData(next);
+    reopened.put(nextChecksum, next, BlockMetadata(BlockSize::Message, next.size()));
+    EXPECT_EQ(reopened.get(nextChecksum), next);
+}
+
+TEST_F(PackedSegmentStoreTest, TornAppendWithoutDataIsDiscarded) {
+    auto data = makeBlock(5);
+    auto checksum = Checksum::fromData(data);
+    auto lost = makeBlock(6);
+    auto lostChecksum = Checksum::fromData(lost);
+    {
+        PackedSegmentStore other(testPath / "other", BlockSize::Message);
+        other.put(lostChecksum, lost, BlockMetadata(BlockSize::Message, lost.size()));
+    }
+    {
+        PackedSegmentStore store(testPath, BlockSize::Message);
+        store.put(checksum, data, BlockMetadata(BlockSize::Message, data.size()));
+    }
+    const auto intactSize = std::filesystem::file_size(testPath / "00000000.seg");
+
+    // The file was extended and the header landed, but the data never did
+    {
+        std::ifstream source(testPath / "other" / "00000000.seg", std::ios::binary);
+        std::vector<char> entry(PackedSegmentStore::ENTRY_HEADER_SIZE + lost.size());
+        source.read(entry.data(), PackedSegmentStore::ENTRY_HEADER_SIZE);
+        std::ofstream segment(testPath / "00000000.seg", std::ios::binary | std::ios::app);
+        segment.write(entry.data(), entry.size());
+    }
+
+    PackedSegmentStore reopened(testPath, BlockSize::Message);
+    EXPECT_FALSE(reopened.has(lostChecksum));
+    EXPECT_EQ(reopened.get(checksum), data);
+    EXPECT_EQ(std::filesystem::file_size(testPath / "00000000.seg"), intactSize);
+}
+
+TEST_F(PackedSegmentStoreTest, DamagedSealedEntryKeepsLaterBlocks) {
+    const uint64_t entrySize = PackedSegmentStore::ENTRY_HEADER_SIZE + 512;
+    std::vector<Checksum> checksums;
+    {
+        PackedSegmentStore store(testPath, BlockSize::Message, 4 * entrySize);
+        for (uint8_t i = 0; i < 10; ++i) {
+            auto data = makeBlock(i);
+            checksums.push_back(Checksum::fromData(data));
+            store.put(checksums.back(), data, BlockMetadata(BlockSize::Message, data.size()));
+        }
+    }
+
+    // Flip a header byte of the second entry of the first (sealed) segment
+    const auto sealed = testPath / "00000000.seg";
+    const auto sealedSize = std::filesystem::file_size(sealed);
+    {
+        std::fstream segment(sealed, std::ios::binary | std::ios::in | std::ios::out);
+        segment.seekp(static_cast<std::streamoff>(entrySize + 2));
+        segment.put(0x7F);
+    }
+
+    PackedSegmentStore reopened(testPath, BlockSize::Message, 4 * entrySize);
+    EXPECT_FALSE(reopened.has(checksums[1]));
+    for (uint8_t i = 0; i < checksums.size(); ++i) {
+        if (i != 1) {
+            EXPECT_EQ(reopened.get(checksums[i]), makeBlock(i));
+        }
+    }
+    EXPECT_EQ(reopened.damagedBytes(), entrySize);
+    EXPECT_EQ(std::filesystem::file_size(sealed), sealedSize);
+}
+
+TEST_F(PackedSegmentStoreTest, RejectsOversizedBlock) {
+    PackedSegmentStore store(testPath, BlockSize::Message);
+    auto data = makeBlock(5, 513);
+    EXPECT_THROW(store.put(Checksum::fromData(data), data,
+                           BlockMetadata(BlockSize::Message, data.size())),
+                 std::invalid_argument);
+}
+
+TEST_F(PackedSegmentStoreTest, DiskBlockStorePackedLayout) {
+    DiskBlockStore store(testPath.string(), BlockSize::Small, StorageLayout::Packed);
+    EXPECT_EQ(store.layout(), StorageLayout::Packed);
+
+    std::vector<uint8_t> data = {1, 2, 3, 4, 5};
+    auto checksum = store.put(data);
+
+    EXPECT_TRUE(store.has(checksum));
+    EXPECT_TRUE(store.hasMetadata(checksum));
+    EXPECT_EQ(store.get(checksum), data);
+    EXPECT_TRUE(std::filesystem::exists(testPath / "Small" / "segments" / "00000000.seg"));
+
+    std::string hex = checksum.toHex();
+    EXPECT_FALSE(std::filesystem::exists(testPath / "Small" / std::string(1, hex[0])));
+
+    EXPECT_TRUE(store.remove(checksum));
+    EXPECT_FALSE(store.has(checksum));
+    EXPECT_FALSE(store.getMetadata(checksum).has_value());
+}
+
+TEST_F(PackedSegmentStoreTest, PackedLayoutRejectsLargeBlocks) {
+    EXPECT_THROW(DiskBlockStore(testPath.string(), BlockSize::Medium, StorageLayout::Packed),
+                 std::invalid_argument);
+}
@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+#include "brightchain/range_reader.hpp"
+#include "brightchain/cbl.hpp"
+#include "brightchain/ingest_pipeline.hpp"
+#include "brightchain/super_cbl.hpp"
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+using namespace brightchain;
+
+namespace {
+
+// Message blocks keep trees small: 5 addresses per CBL, 5 children per SuperCBL
+constexpr size_t BLOCK = 512;
+constexpr size_t LEAF_CAPACITY = (BLOCK - CBLHeader::SIZE) / Checksum::HASH_SIZE;
+constexpr size_t FANOUT = (BLOCK - SuperCBLHeader::SIZE) / Checksum::HASH_SIZE;
+
+} // namespace
+
+class RangeReaderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_range_reader_test";
+        std::filesystem::remove_all(testPath);
+        store = std::make_unique<DiskBlockStore>(testPath.string(), BlockSize::Message);
+    }
+
+    void TearDown() override {
+        store.reset();
+        std::filesystem::remove_all(testPath);
+    }
+
+    std::vector<uint8_t> randomBytes(size_t length, uint32_t seed) {
+        std::vector<uint8_t> data(length);
+        std::mt19937 rng(seed);
+        for (auto& byte : data) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        return data;
+    }
+
+    std::vector<Checksum> storeBlocks(const std::vector<uint8_t>& input) {
+        std::vector<Checksum> blocks;
+        for (size_t offset = 0; offset < input.size(); offset += BLOCK) {
+            std::vector<uint8_t> data(BLOCK, 0);
+            size_t length = std::min(BLOCK, input.size() - offset);
+            std::copy(input.begin() + offset, input.begin() + offset + length, data.begin());
+            blocks.push_back(store->put(data));
+        }
+        return blocks;
+    }
+
+    Checksum putCBL(const std::vector<Checksum>& addresses, uint64_t length) {
+        CBLHeader header;
+        header.creatorId.fill(0);
+        header.dateCreated = 0;
+        header.addressCount = static_cast<uint32_t>(addresses.size());
+        header.tupleSize = 1;
+        header.originalDataLength = length;
+        header.originalDataChecksum.fill(0);
+        header.signature.fill(0);
+        auto data = header.serialize();
+        for (const auto& address : addresses) {
+            data.insert(data.end(), address.hash().begin(), address.hash().end());
+        }
+        data.resize(BLOCK, 0);
+        return store->put(data);
+    }
+
+    Checksum putSuperCBL(const std::vector<Checksum>& children, uint16_t depth, uint64_t length) {
+        SuperCBLHeader header;
+        header.creatorId.fill(0);
+        header.dateCreated = 0;
+        header.subCblCount = static_cast<uint32_t>(children.size());
+        header.totalBlockCount = 0;
+        header.depth = depth;
+        header.originalDataLength = length;
+        header.originalDataChecksum.fill(0);
+        header.signature.fill(0);
+        auto data = header.serialize();
+        for (const auto& child : children) {
+            data.insert(data.end(), child.hash().begin(), child.hash().end());
+        }
+        data.resize(BLOCK, 0);
+        return store->put(data);
+    }
+
+    /**
+     * Pack blocks into full leaves and full SuperCBL levels.
+     */
+    Checksum buildTree(const std::vector<Checksum>& blocks, uint64_t length) {
+        std::vector<Checksum> level;
+        for (size_t i = 0; i < blocks.size(); i += LEAF_CAPACITY) {
+            size_t end = std::min(blocks.size(), i + LEAF_CAPACITY);
+            level.push_back(putCBL({blocks.begin() + i, blocks.begin() + end}, length));
+        }
+        uint16_t depth = 1;
+        while (level.size() > 1) {
+            std::vector<Checksum> parents;
+            for (size_t i = 0; i < level.size(); i += FANOUT) {
+                size_t end = std::min(level.size(), i + FANOUT);
+                parents.push_back(
+                    putSuperCBL({level.begin() + i, level.begin() + end}, depth, length));
+            }
+            level = std::move(parents);
+            ++depth;
+        }
+        return level.front();
+    }
+
+    void expectRandomRangesMatch(RangeReader& reader, const std::vector<uint8_t>& input) {
+        std::mt19937 rng(99);
+        for (int i = 0; i < 200; ++i) {
+            uint64_t offset = rng() % input.size();
+            size_t length = rng() % (BLOCK * 4);
+            auto bytes = reader.read(offset, length);
+            size_t expected = std::min<size_t>(length, input.size() - offset);
+            ASSERT_EQ(bytes.size(), expected);
+            ASSERT_TRUE(std::equal(bytes.begin(), bytes.end(), input.begin() + offset))
+                << "offset " << offset << " length " << length;
+        }
+    }
+
+    std::filesystem::path testPath;
+    std::unique_ptr<DiskBlockStore> store;
+};
+
+TEST_F(RangeReaderTest, ReadsRangesOfSingleCBL) {
+    auto input = randomBytes(BLOCK * 4 + 100, 1);
+    auto root = putCBL(storeBlocks(input), input.size());
+
+    RangeReader reader(*store, root);
+    EXPECT_EQ(reader.size(), input.size());
+    expectRandomRangesMatch(reader, input);
+    EXPECT_TRUE(reader.read(input.size(), 10).empty());
+}
+
+TEST_F(RangeReaderTest, ReadsRangesOfDepthOneSuperCBL) {
+    auto input = randomBytes(BLOCK * 23 + 7, 2);
+    auto root = buildTree(storeBlocks(input), input.size());
+
+    RangeReader reader(*store, root);
+    expectRandomRangesMatch(reader, input);
+}
+
+TEST_F(RangeReaderTest, ReadsRangesOfDeepSuperCBL) {
+    // 3 SuperCBL levels: more than LEAF_CAPACITY * FANOUT * FANOUT blocks
+    auto input = randomBytes(BLOCK * (LEAF_CAPACITY * FANOUT * FANOUT + 9), 3);
+    auto root = buildTree(storeBlocks(input), input.size());
+
+    RangeReader reader(*store, root);
+    expectRandomRangesMatch(reader, input);
+
+    auto whole = reader.read(0, input.size());
+    EXPECT_EQ(whole, input);
+}
+
+TEST_F(RangeReaderTest, CachedNodesAreNotReloaded) {
+    auto input = randomBytes(BLOCK * 23, 4);
+    auto root = buildTree(storeBlocks(input), input.size());
+
+    RangeReader reader(*store, root);
+    reader.read(BLOCK * 12, 10);
+    size_t loads = reader.nodeLoads();
+    for (int i = 0; i < 10; ++i) {
+        reader.read(BLOCK * 12 + i, 10);
+    }
+    EXPECT_EQ(reader.nodeLoads(), loads);
+}
+
+TEST_F(RangeReaderTest, ReadsIngestedExtendedCBL) {
+    auto input = randomBytes(BLOCK * 3 + 1, 5);
+    {
+        std::ofstream file(testPath.string() + ".input", std::ios::binary);
+        file.write(reinterpret_cast<const char*>(input.data()), input.size());
+    }
+    IngestOptions options;
+    options.fileName = "x";
+    auto result = IngestPipeline(*store).ingestFile(testPath.string() + ".input", options);
+    std::filesystem::remove(testPath.string() + ".input");
+
+    RangeReader reader(*store, result.cblChecksum);
+    expectRandomRangesMatch(reader, input);
+}
+
+TEST_F(RangeReaderTest, ReadsInlineOnPoolWorker) {
+    auto input = randomBytes(BLOCK * 23 + 7, 6);
+    auto root = buildTree(storeBlocks(input), input.size());
+
+    // Every worker blocks in a multi-tuple read; queued fetches would never run
+    ThreadPool pool(2);
+    RangeReader reader(*store, root, RangeReader::DEFAULT_NODE_CACHE, pool);
+    std::vector<std::future<std::vector<uint8_t>>> reads;
+    for (size_t i = 0; i < pool.size(); ++i) {
+        reads.push_back(pool.submit([&reader, &input]() { return reader.read(0, input.size()); }));
+    }
+    for (auto& read : reads) {
+        EXPECT_EQ(read.get(), input);
+    }
+}
+
+TEST_F(RangeReaderTest, RejectsTreesThatAreNotPacked) {
+    auto input = randomBytes(BLOCK * 12, 7);
+    auto blocks = storeBlocks(input);
+
+    // The first leaf is one tuple short, so later offsets would shift
+    std::vector<Checksum> leaves = {
+        putCBL({blocks.begin(), blocks.begin() + LEAF_CAPACITY - 1}, input.size()),
+        putCBL({blocks.begin() + LEAF_CAPACITY - 1, blocks.end()}, input.size()),
+    };
+    auto root = putSuperCBL(leaves, 1, input.size());
+
+    RangeReader reader(*store, root);
+    EXPECT_THROW(reader.read(0, 10), std::runtime_error);
+    EXPECT_THROW(reader.read(BLOCK * 8, 10), std::runtime_error);
+
+    // A length that disagrees with the tree
+    auto shortRoot = putCBL({blocks.begin(), blocks.begin() + 3}, BLOCK * 5);
+    RangeReader shortReader(*store, shortRoot);
+    EXPECT_THROW(shortReader.read(0, 10), std::runtime_error);
+}
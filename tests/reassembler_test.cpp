@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+#include "brightchain/reassembler.hpp"
+#include "brightchain/cbl.hpp"
+#include "brightchain/ingest_pipeline.hpp"
+#include "brightchain/super_cbl.hpp"
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+using namespace brightchain;
+
+class ReassemblerTest : public ::testing::Test {
+protected:
+    static constexpr size_t BLOCK = 4096;
+
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_reassembler_test";
+        std::filesystem::remove_all(testPath);
+        std::filesystem::create_directories(testPath);
+        store = std::make_unique<DiskBlockStore>((testPath / "store").string(), BlockSize::Small);
+    }
+
+    void TearDown() override {
+        store.reset();
+        std::filesystem::remove_all(testPath);
+    }
+
+    std::vector<uint8_t> randomBytes(size_t length, uint32_t seed) {
+        std::vector<uint8_t> data(length);
+        std::mt19937 rng(seed);
+        for (auto& byte : data) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        return data;
+    }
+
+    std::vector<uint8_t> readFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+    }
+
+    Checksum putCBL(const std::vector<Checksum>& addresses, uint8_t tupleSize,
+                    uint64_t originalLength, const Checksum& originalChecksum) {
+        CBLHeader header;
+        header.creatorId.fill(0);
+        header.dateCreated = 0;
+        header.addressCount = static_cast<uint32_t>(addresses.size());
+        header.tupleSize = tupleSize;
+        header.originalDataLength = originalLength;
+        header.originalDataChecksum = originalChecksum.hash();
+        header.signature.fill(0);
+        auto data = header.serialize();
+        for (const auto& address : addresses) {
+            data.insert(data.end(), address.hash().begin(), address.hash().end());
+        }
+        data.resize(BLOCK, 0);
+        return store->put(data);
+    }
+
+    Checksum putSuperCBL(const std::vector<Checksum>& children, uint64_t originalLength,
+                         const Checksum& originalChecksum) {
+        SuperCBLHeader header;
+        header.creatorId.fill(0);
+        header.dateCreated = 0;
+        header.subCblCount = static_cast<uint32_t>(children.size());
+        header.totalBlockCount = 0;
+        header.depth = 1;
+        header.originalDataLength = originalLength;
+        header.originalDataChecksum = originalChecksum.hash();
+        header.signature.fill(0);
+        auto data = header.serialize();
+        for (const auto& child : children) {
+            data.insert(data.end(), child.hash().begin(), child.hash().end());
+        }
+        data.resize(BLOCK, 0);
+        return store->put(data);
+    }
+
+    std::filesystem::path testPath;
+    std::unique_ptr<DiskBlockStore> store;
+};
+
+TEST_F(ReassemblerTest, RoundTripsIngestedFile) {
+    auto input = randomBytes(BLOCK * 50 + 17, 1);
+    {
+        std::ofstream file(testPath / "input.bin", std::ios::binary);
+        file.write(reinterpret_cast<const char*>(input.data()), input.size());
+    }
+
+    IngestPipeline ingest(*store);
+    IngestOptions ingestOptions;
+    ingestOptions.fileName = "input.bin";
+    auto ingested = ingest.ingestFile(testPath / "input.bin", ingestOptions);
+
+    ReassemblyOptions options;
+    options.readAhead = 4;
+    Reassembler reassembler(*store);
+    auto result = reassembler.reassembleToFile(ingested.cblChecksum, testPath / "output.bin",
+                                               options);
+    EXPECT_EQ(result.bytesWritten, input.size());
+    EXPECT_EQ(result.blocksRead, 51u);
+    EXPECT_EQ(readFile(testPath / "output.bin"), input);
+}
+
+TEST_F(ReassemblerTest, XorsTupleMembers) {
+    auto input = randomBytes(BLOCK * 2, 2);
+    std::vector<Checksum> addresses;
+    for (size_t b = 0; b < 2; ++b) {
+        std::vector<uint8_t> data(input.begin() + b * BLOCK, input.begin() + (b + 1) * BLOCK);
+        auto r1 = randomBytes(BLOCK, 10 + b);
+        auto r2 = randomBytes(BLOCK, 20 + b);
+        for (size_t i = 0; i < BLOCK; ++i) {
+            data[i] ^= r1[i] ^ r2[i];
+        }
+        addresses.push_back(store->put(data));
+        addresses.push_back(store->put(r1));
+        addresses.push_back(store->put(r2));
+    }
+    auto root = putCBL(addresses, 3, input.size(), Checksum::fromData(input));
+
+    Reassembler reassembler(*store);
+    auto result = reassembler.reassembleToFile(root, testPath / "output.bin");
+    EXPECT_EQ(result.blocksRead, 6u);
+    EXPECT_EQ(readFile(testPath / "output.bin"), input);
+}
+
+TEST_F(ReassemblerTest, ReadsThroughAsyncBlockIO) {
+    auto input = randomBytes(BLOCK * 20 + 5, 8);
+    std::vector<Checksum> addresses;
+    for (size_t offset = 0; offset < input.size(); offset += BLOCK) {
+        std::vector<uint8_t> data(BLOCK, 0);
+        size_t length = std::min(BLOCK, input.size() - offset);
+        std::copy(input.begin() + offset, input.begin() + offset + length, data.begin());
+        auto mask = randomBytes(BLOCK, static_cast<uint32_t>(100 + offset / BLOCK));
+        for (size_t i = 0; i < BLOCK; ++i) {
+            data[i] ^= mask[i];
+        }
+        addresses.push_back(store->put(data));
+        addresses.push_back(store->put(mask));
+    }
+    auto root = putCBL(addresses, 2, input.size(), Checksum::fromData(input));
+
+    for (auto backend : {AsyncIOBackend::IoUring, AsyncIOBackend::ThreadPool}) {
+        AsyncBlockIO io(*store, 4, backend);
+        ReassemblyOptions options;
+        options.readAhead = 8;
+        Reassembler reassembler(io);
+        auto result = reassembler.reassembleToFile(root, testPath / "output.bin", options);
+        EXPECT_EQ(result.blocksRead, addresses.size());
+        EXPECT_EQ(readFile(testPath / "output.bin"), input);
+        EXPECT_EQ(io.inFlight(), 0);
+    }
+}
+
+TEST_F(ReassemblerTest, MissingBlockThroughAsyncBlockIOThrows) {
+    auto present = store->put(randomBytes(BLOCK, 9));
+    auto root = putCBL({present, Checksum::fromData(randomBytes(BLOCK, 10))}, 2, BLOCK,
+                       Checksum());
+    AsyncBlockIO io(*store, 4);
+    Reassembler reassembler(io);
+    EXPECT_THROW(reassembler.reassembleToFile(root, testPath / "output.bin"), std::runtime_error);
+    EXPECT_FALSE(std::filesystem::exists(testPath / "output.bin"));
+}
+
+TEST_F(ReassemblerTest, WalksSuperCBL) {
+    auto input = randomBytes(BLOCK * 5 + 100, 3);
+    std::vector<Checksum> blocks;
+    for (size_t offset = 0; offset < input.size(); offset += BLOCK) {
+        std::vector<uint8_t> data(BLOCK, 0);
+        size_t length = std::min(BLOCK, input.size() - offset);
+        std::copy(input.begin() + offset, input.begin() + offset + length, data.begin());
+        blocks.push_back(store->put(data));
+    }
+
+    auto left = putCBL({blocks.begin(), blocks.begin() + 3}, 1, BLOCK * 3, Checksum());
+    auto right = putCBL({blocks.begin() + 3, blocks.end()}, 1, input.size() - BLOCK * 3,
+                        Checksum());
+    auto root = putSuperCBL({left, right}, input.size(), Checksum::fromData(input));
+
+    Reassembler reassembler(*store);
+    reassembler.reassembleToFile(root, testPath / "output.bin");
+    EXPECT_EQ(readFile(testPath / "output.bin"), input);
+}
+
+TEST_F(ReassemblerTest, DetectsChecksumMismatch) {
+    auto input = randomBytes(BLOCK, 4);
+    auto block = store->put(input);
+    auto root = putCBL({block}, 1, input.size(), Checksum::fromData(randomBytes(BLOCK, 5)));
+
+    Reassembler reassembler(*store);
+    EXPECT_THROW(reassembler.reassembleToFile(root, testPath / "output.bin"), std::runtime_error);
+    EXPECT_FALSE(std::filesystem::exists(testPath / "output.bin"));
+
+    ReassemblyOptions unchecked;
+    unchecked.verifyChecksum = false;
+    EXPECT_NO_THROW(reassembler.reassembleToFile(root, testPath / "output.bin", unchecked));
+}
+
+TEST_F(ReassemblerTest, DetectsTruncatedTree) {
+    auto input = randomBytes(BLOCK, 6);
+    auto block = store->put(input);
+    auto root = putCBL({block}, 1, BLOCK * 2, Checksum());
+
+    Reassembler reassembler(*store);
+    EXPECT_THROW(reassembler.reassembleToFile(root, testPath / "output.bin"), std::runtime_error);
+}
+
+TEST_F(ReassemblerTest, MissingBlockThrows) {
+    auto root = putCBL({Checksum::fromData(randomBytes(BLOCK, 7))}, 1, BLOCK, Checksum());
+    Reassembler reassembler(*store);
+    EXPECT_THROW(reassembler.reassembleToFile(root, testPath / "output.bin"), std::runtime_error);
+}
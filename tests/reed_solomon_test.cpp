@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include "brightchain/reed_solomon.hpp"
+#include "brightchain/constants.hpp"
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+
+using namespace brightchain;
+
+namespace {
+
+std::vector<uint8_t> randomBytes(size_t length, uint32_t seed) {
+    std::vector<uint8_t> data(length);
+    std::mt19937 rng(seed);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    return data;
+}
+
+} // namespace
+
+TEST(ReedSolomonTest, RecoversFromAnyParityCountOfErasures) {
+    constexpr size_t K = 5;
+    constexpr size_t M = 3;
+    constexpr size_t SHARD = 1000;
+    ReedSolomon codec(K, M);
+
+    std::vector<std::vector<uint8_t>> original;
+    for (size_t i = 0; i < K + M; ++i) {
+        original.push_back(i < K ? randomBytes(SHARD, static_cast<uint32_t>(i))
+                                 : std::vector<uint8_t>(SHARD));
+    }
+    std::vector<const uint8_t*> data;
+    std::vector<uint8_t*> parity;
+    for (size_t i = 0; i < K + M; ++i) {
+        if (i < K) {
+            data.push_back(original[i].data());
+        } else {
+            parity.push_back(original[i].data());
+        }
+    }
+    codec.encode(data, parity, SHARD);
+
+    // Every way of losing exactly M shards
+    for (uint32_t mask = 0; mask < (1u << (K + M)); ++mask) {
+        if (__builtin_popcount(mask) != M) {
+            continue;
+        }
+        auto shards = original;
+        std::unique_ptr<bool[]> present(new bool[K + M]);
+        std::vector<uint8_t*> buffers;
+        for (size_t i = 0; i < K + M; ++i) {
+            present[i] = !(mask & (1u << i));
+            if (!present[i]) {
+                std::fill(shards[i].begin(), shards[i].end(), 0xEE);
+            }
+            buffers.push_back(shards[i].data());
+        }
+        codec.reconstruct(buffers, std::span<const bool>(present.get(), K + M), SHARD);
+        ASSERT_EQ(shards, original) << "erasure mask " << mask;
+    }
+}
+
+TEST(ReedSolomonTest, TooManyErasuresThrows) {
+    ReedSolomon codec(3, 2);
+    std::vector<std::vector<uint8_t>> shards(5, std::vector<uint8_t>(64));
+    std::vector<uint8_t*> buffers;
+    for (auto& shard : shards) {
+        buffers.push_back(shard.data());
+    }
+    const bool present[] = {true, false, true, false, false};
+    EXPECT_THROW(codec.reconstruct(buffers, present, 64), std::runtime_error);
+
+    EXPECT_THROW(ReedSolomon(0, 2), std::invalid_argument);
+    EXPECT_THROW(ReedSolomon(250, 7), std::invalid_argument);
+}
+
+TEST(ReedSolomonTest, DefaultParityFollowsConstants) {
+    EXPECT_EQ(ReedSolomon::defaultParityShards(1), FECConstants::MIN_REDUNDANCY);
+    EXPECT_EQ(ReedSolomon::defaultParityShards(6), 3u);
+    EXPECT_EQ(ReedSolomon::defaultParityShards(64), FECConstants::MAX_REDUNDANCY);
+}
+
+class BlockFecTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_block_fec_test";
+        std::filesystem::remove_all(testPath);
+        store = std::make_unique<DiskBlockStore>(testPath.string(), BlockSize::Small);
+    }
+
+    void TearDown() override {
+        store.reset();
+        std::filesystem::remove_all(testPath);
+    }
+
+    void corrupt(const Checksum& checksum) {
+        auto hex = checksum.toHex();
+        auto path = testPath / blockSizeToString(BlockSize::Small) / hex.substr(0, 1) /
+                    hex.substr(1, 1) / hex;
+        ASSERT_TRUE(std::filesystem::exists(path));
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(10);
+        file.put('\x5A');
+    }
+
+    std::filesystem::path testPath;
+    std::unique_ptr<DiskBlockStore> store;
+};
+
+TEST_F(BlockFecTest, RecoversPayloadAfterLosingShards) {
+    BlockFec fec(*store);
+    auto payload = randomBytes(5 * 4096 + 123, 42);
+    auto manifest = fec.protect(payload);
+    ASSERT_EQ(manifest.dataShards.size(), 6u);
+    ASSERT_EQ(manifest.parityShards.size(), 3u);
+    EXPECT_EQ(fec.recover(manifest), payload);
+
+    store->remove(manifest.dataShards[0]);
+    corrupt(manifest.dataShards[5]);
+    store->remove(manifest.parityShards[1]);
+    EXPECT_EQ(fec.recover(manifest), payload);
+
+    store->remove(manifest.dataShards[2]);
+    EXPECT_THROW(fec.recover(manifest), std::runtime_error);
+}
+
+TEST_F(BlockFecTest, RepairRestoresLostShards) {
+    BlockFec fec(*store);
+    auto payload = randomBytes(3 * 4096, 7);
+    auto manifest = fec.protect(payload, 2);
+
+    store->remove(manifest.dataShards[1]);
+    corrupt(manifest.parityShards[0]);
+    EXPECT_EQ(fec.repair(manifest), 2u);
+    EXPECT_EQ(fec.repair(manifest), 0u);
+
+    // With the repaired shards back, any two may go again
+    store->remove(manifest.dataShards[0]);
+    store->remove(manifest.dataShards[2]);
+    EXPECT_EQ(fec.recover(manifest), payload);
+}
+
+TEST_F(BlockFecTest, ManifestRoundTrip) {
+    BlockFec fec(*store);
+    auto payload = randomBytes(100, 3);
+    auto manifest = fec.protect(payload);
+
+    auto bytes = manifest.serialize();
+    auto parsed = FecManifest::deserialize(bytes);
+    EXPECT_EQ(parsed.originalLength, 100u);
+    EXPECT_EQ(parsed.shardSize, 4096u);
+    EXPECT_EQ(parsed.dataShards, manifest.dataShards);
+    EXPECT_EQ(parsed.parityShards, manifest.parityShards);
+    EXPECT_EQ(fec.recover(parsed), payload);
+
+    bytes.pop_back();
+    EXPECT_THROW(FecManifest::deserialize(bytes), std::invalid_argument);
+}
+
+TEST_F(BlockFecTest, PayloadBeyondShardLimitThrows) {
+    BlockFec fec(*store);
+    // 251 data shards plus the default 5 parity shards fill the code
+    EXPECT_NO_THROW(fec.protect(randomBytes(251 * 4096, 4)));
+    EXPECT_THROW(fec.protect(randomBytes(252 * 4096, 5)), std::invalid_argument);
+    EXPECT_THROW(fec.protect(randomBytes(4096, 6), 256), std::invalid_argument);
+}
+
+TEST_F(BlockFecTest, RepairKeepsReferencesOfSharedShards) {
+    store.reset();
+    std::filesystem::remove_all(testPath);
+    DiskBlockStoreOptions options;
+    options.referenceCounting = true;
+    store = std::make_unique<DiskBlockStore>(testPath.string(), BlockSize::Small, options);
+
+    BlockFec fec(*store);
+    auto payload = randomBytes(2 * 4096, 9);
+    auto manifest = fec.protect(payload, 2);
+    fec.protect(payload, 2);
+    ASSERT_EQ(store->refCount(manifest.dataShards[0]), 2u);
+
+    corrupt(manifest.dataShards[0]);
+    EXPECT_EQ(fec.repair(manifest), 1u);
+    EXPECT_EQ(store->refCount(manifest.dataShards[0]), 2u);
+    EXPECT_EQ(fec.recover(manifest), payload);
+}
+
+TEST_F(BlockFecTest, RepairKeepsReferencesOfQuarantinedShards) {
+    store.reset();
+    std::filesystem::remove_all(testPath);
+    DiskBlockStoreOptions options;
+    options.referenceCounting = true;
+    store = std::make_unique<DiskBlockStore>(testPath.string(), BlockSize::Small, options);
+
+    BlockFec fec(*store);
+    auto payload = randomBytes(2 * 4096, 10);
+    auto manifest = fec.protect(payload, 2);
+    fec.protect(payload, 2);
+    const Checksum& shard = manifest.dataShards[1];
+
+    ASSERT_TRUE(store->quarantine(shard));
+    EXPECT_EQ(fec.repair(manifest), 1u);
+    EXPECT_EQ(store->refCount(shard), 2u);
+
+    // One of the two owners lets go; the other still reads the shard
+    store->remove(shard);
+    EXPECT_TRUE(store->has(shard));
+    EXPECT_EQ(fec.recover(manifest), payload);
+}
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include "brightchain/ref_count_table.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace brightchain;
+
+namespace {
+
+Checksum keyFor(uint32_t i) {
+    std::vector<uint8_t> bytes(4);
+    std::memcpy(bytes.data(), &i, 4);
+    return Checksum::fromData(bytes);
+}
+
+size_t countBlockFiles(const std::filesystem::path& root) {
+    size_t count = 0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(root)) {
+        if (entry.is_regular_file() && entry.path().filename().string().size() == 128) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+class RefCountTableTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_ref_count_test";
+        std::filesystem::remove_all(testPath);
+        std::filesystem::create_directories(testPath);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(testPath);
+    }
+
+    DiskBlockStoreOptions countingOptions(StorageLayout layout = StorageLayout::FilePerBlock) {
+        DiskBlockStoreOptions options;
+        options.layout = layout;
+        options.referenceCounting = true;
+        return options;
+    }
+
+    std::filesystem::path testPath;
+};
+
+TEST_F(RefCountTableTest, SetGetRemove) {
+    RefCountTable table(testPath / "refcounts.idx");
+    EXPECT_FALSE(table.get(keyFor(1)).has_value());
+
+    table.set(keyFor(1), 2);
+    table.set(keyFor(2), 7);
+    table.set(keyFor(1), 3);
+    EXPECT_EQ(table.get(keyFor(1)), 3u);
+    EXPECT_EQ(table.get(keyFor(2)), 7u);
+    EXPECT_EQ(table.size(), 2);
+
+    EXPECT_TRUE(table.remove(keyFor(1)));
+    EXPECT_FALSE(table.remove(keyFor(1)));
+    EXPECT_FALSE(table.get(keyFor(1)).has_value());
+    EXPECT_EQ(table.size(), 1);
+}
+
+TEST_F(RefCountTableTest, GrowsAndPersists) {
+    {
+        RefCountTable table(testPath / "refcounts.idx");
+        for (uint32_t i = 0; i < 3000; ++i) {
+            table.set(keyFor(i), i + 2);
+        }
+        EXPECT_GT(table.slotCount(), RefCountTable::INITIAL_SLOTS);
+    }
+
+    RefCountTable reopened(testPath / "refcounts.idx");
+    EXPECT_EQ(reopened.size(), 3000);
+    for (uint32_t i = 0; i < 3000; ++i) {
+        EXPECT_EQ(reopened.get(keyFor(i)), i + 2);
+    }
+}
+
+TEST_F(RefCountTableTest, RejectsInvalidFile) {
+    {
+        std::ofstream file(testPath / "refcounts.idx", std::ios::binary);
+        file << "not a table";
+    }
+    EXPECT_THROW(RefCountTable(testPath / "refcounts.idx"), std::runtime_error);
+}
+
+TEST_F(RefCountTableTest, DuplicatePutOnlyAddsReference) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message, countingOptions());
+    std::vector<uint8_t> data(512, 0x42);
+
+    auto checksum = store.put(data, BlockMetadata(BlockSize::Message, 100));
+    EXPECT_EQ(store.refCount(checksum), 1u);
+
+    store.put(data, BlockMetadata(BlockSize::Message, 300));
+    store.put(data);
+    EXPECT_EQ(store.refCount(checksum), 3u);
+    EXPECT_EQ(store.getMetadata(checksum)->length_without_padding, 100u);
+    EXPECT_EQ(countBlockFiles(testPath), 1u);
+
+    EXPECT_FALSE(store.remove(checksum));
+    EXPECT_FALSE(store.remove(checksum));
+    EXPECT_TRUE(store.has(checksum));
+    EXPECT_EQ(store.refCount(checksum), 1u);
+
+    EXPECT_TRUE(store.remove(checksum));
+    EXPECT_FALSE(store.has(checksum));
+    EXPECT_EQ(store.refCount(checksum), 0u);
+    EXPECT_FALSE(store.remove(checksum));
+}
+
+TEST_F(RefCountTableTest, AddRefAndForceRemove) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message, countingOptions());
+    std::vector<uint8_t> data(512, 0x24);
+
+    EXPECT_FALSE(store.addRef(Checksum::fromData(data)));
+    auto checksum = store.put(data);
+    EXPECT_TRUE(store.addRef(checksum));
+    EXPECT_TRUE(store.addRef(checksum, 3));
+    EXPECT_EQ(store.refCount(checksum), 5u);
+    EXPECT_EQ(countBlockFiles(testPath), 1u);
+
+    EXPECT_TRUE(store.forceRemove(checksum));
+    EXPECT_FALSE(store.has(checksum));
+    EXPECT_EQ(store.refCount(checksum), 0u);
+    EXPECT_FALSE(store.forceRemove(checksum));
+
+    // A re-stored block starts from one reference again
+    store.put(data);
+    EXPECT_EQ(store.refCount(checksum), 1u);
+}
+
+TEST_F(RefCountTableTest, CountsStopAtUint32Max) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message, countingOptions());
+    std::vector<uint8_t> data(512, 0x25);
+    auto checksum = store.put(data);
+    EXPECT_THROW(store.addRef(checksum, UINT32_MAX), std::overflow_error);
+    EXPECT_TRUE(store.addRef(checksum, UINT32_MAX - 1));
+
+    // A dedup put past the limit fails the same way and keeps the count
+    EXPECT_THROW(store.put(data), std::overflow_error);
+    EXPECT_EQ(store.refCount(checksum), UINT32_MAX);
+}
+
+TEST_F(RefCountTableTest, CountsPersistAcrossReopen) {
+    Checksum checksum = keyFor(0);
+    {
+        DiskBlockStore store(testPath.string(), BlockSize::Message, countingOptions());
+        std::vector<uint8_t> data(512, 7);
+        checksum = store.put(data);
+        store.put(data);
+    }
+
+    DiskBlockStore reopened(testPath.string(), BlockSize::Message, countingOptions());
+    EXPECT_EQ(reopened.refCount(checksum), 2u);
+    EXPECT_FALSE(reopened.remove(checksum));
+    EXPECT_TRUE(reopened.remove(checksum));
+}
+
+TEST_F(RefCountTableTest, PackedLayoutCountsReferences) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message,
+                         countingOptions(StorageLayout::Packed));
+    std::vector<uint8_t> data(512, 9);
+    auto checksum = store.put(data);
+    store.put(data);
+    EXPECT_EQ(store.refCount(checksum), 2u);
+    EXPECT_FALSE(store.remove(checksum));
+    EXPECT_TRUE(store.remove(checksum));
+    EXPECT_FALSE(store.has(checksum));
+}
+
+TEST_F(RefCountTableTest, ConcurrentPutsOfOneBlockCoalesce) {
+    DiskBlockStore store(testPath.string(), BlockSize::Message, countingOptions());
+    std::vector<uint8_t> data(512, 0x5A);
+    const Checksum checksum = Checksum::fromData(data);
+
+    constexpr int THREADS = 8;
+    constexpr int PUTS = 25;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < THREADS; ++t) {
+        writers.emplace_back([&]() {
+            for (int i = 0; i < PUTS; ++i) {
+                store.put(checksum, data, BlockMetadata(BlockSize::Message, data.size()));
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+
+    EXPECT_EQ(store.refCount(checksum), static_cast<uint32_t>(THREADS * PUTS));
+    EXPECT_EQ(countBlockFiles(testPath), 1u);
+    EXPECT_EQ(store.get(checksum), data);
+}
+
+TEST_F(RefCountTableTest, BlocksStoredBeforeCountingHoldOneReference) {
+    std::vector<uint8_t> data(512, 3);
+    Checksum checksum = keyFor(0);
+    {
+        DiskBlockStore store(testPath.string(), BlockSize::Message);
+        checksum = store.put(data);
+        store.put(data);
+        EXPECT_EQ(store.refCount(checksum), 1u);
+    }
+
+    DiskBlockStore store(testPath.string(), BlockSize::Message, countingOptions());
+    EXPECT_EQ(store.refCount(checksum), 1u);
+    store.put(data);
+    EXPECT_EQ(store.refCount(checksum), 2u);
+}
@@ -0,0 +1,253 @@
+#include <gtest/gtest.h>
+#include "brightchain/secp256k1.hpp"
+#include "brightchain/ec_key_pair.hpp"
+#include "brightchain/ecies.hpp"
+#include <algorithm>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+using namespace brightchain;
+using json = nlohmann::json;
+
+namespace {
+
+std::vector<uint8_t> fromHex(const std::string& hex) {
+    std::vector<uint8_t> bytes(hex.size() / 2);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<uint8_t>(std::stoi(hex.substr(i * 2, 2), nullptr, 16));
+    }
+    return bytes;
+}
+
+const auto GENERATOR = fromHex(
+    "0279be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798");
+const auto GENERATOR_UNCOMPRESSED = fromHex(
+    "0479be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798"
+    "483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8");
+const auto GROUP_ORDER = fromHex(
+    "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141");
+
+} // namespace
+
+class Secp256k1Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        original = Secp256k1::backend();
+        for (auto backend : {Secp256k1::Backend::OpenSsl, Secp256k1::Backend::LibSecp256k1}) {
+            if (Secp256k1::available(backend)) {
+                backends.push_back(backend);
+            }
+        }
+    }
+
+    void TearDown() override {
+        Secp256k1::setBackend(original);
+    }
+
+    Secp256k1::Backend original;
+    std::vector<Secp256k1::Backend> backends;
+};
+
+TEST_F(Secp256k1Test, BackendSelection) {
+    EXPECT_TRUE(Secp256k1::available(Secp256k1::Backend::OpenSsl));
+    Secp256k1::setBackend(Secp256k1::Backend::OpenSsl);
+    EXPECT_EQ(Secp256k1::backend(), Secp256k1::Backend::OpenSsl);
+
+    if (!Secp256k1::available(Secp256k1::Backend::LibSecp256k1)) {
+        EXPECT_THROW(Secp256k1::setBackend(Secp256k1::Backend::LibSecp256k1),
+                     std::invalid_argument);
+    }
+}
+
+TEST_F(Secp256k1Test, EcdhMatchesKnownPoint) {
+    std::vector<uint8_t> one(32, 0);
+    one.back() = 1;
+    for (auto backend : backends) {
+        Secp256k1::setBackend(backend);
+        auto point = Secp256k1::ecdhPoint(one, GENERATOR);
+        EXPECT_TRUE(std::equal(point.begin(), point.end(), GENERATOR_UNCOMPRESSED.begin()));
+        auto secret = Secp256k1::ecdh(one, GENERATOR_UNCOMPRESSED);
+        EXPECT_TRUE(std::equal(secret.begin(), secret.end(), GENERATOR.begin() + 1));
+    }
+}
+
+TEST_F(Secp256k1Test, EcdhAgreesAcrossBackends) {
+    for (int i = 0; i < 5; ++i) {
+        auto alice = EcKeyPair::generate();
+        auto bob = EcKeyPair::generate();
+
+        std::vector<Secp256k1::SharedSecret> secrets;
+        for (auto backend : backends) {
+            Secp256k1::setBackend(backend);
+            auto secret = Secp256k1::ecdh(alice.privateKey(), bob.publicKey());
+            EXPECT_EQ(secret, Secp256k1::ecdh(bob.privateKey(), alice.publicKey()));
+            secrets.push_back(secret);
+        }
+        for (const auto& secret : secrets) {
+            EXPECT_EQ(secret, secrets.front());
+        }
+    }
+}
+
+TEST_F(Secp256k1Test, SignaturesInteroperate) {
+    auto keyPair = EcKeyPair::generate();
+    std::vector<uint8_t> digest(32, 0xA5);
+    std::vector<uint8_t> shortData = {1, 2, 3};
+
+    for (auto signer : backends) {
+        Secp256k1::setBackend(signer);
+        auto signature = keyPair.sign(digest);
+        auto shortSignature = Secp256k1::sign(keyPair.privateKey(), shortData);
+
+        for (auto verifier : backends) {
+            Secp256k1::setBackend(verifier);
+            EXPECT_TRUE(EcKeyPair::verify(digest, signature, keyPair.publicKey()));
+            EXPECT_TRUE(Secp256k1::verify(shortData, shortSignature, keyPair.publicKey()));
+
+            auto tampered = digest;
+            tampered[0] ^= 1;
+            EXPECT_FALSE(EcKeyPair::verify(tampered, signature, keyPair.publicKey()));
+        }
+    }
+}
+
+TEST_F(Secp256k1Test, RejectsInvalidKeys) {
+    std::vector<uint8_t> zero(32, 0);
+    auto badPoint = GENERATOR;
+    badPoint[0] = 0x05;
+
+    for (auto backend : backends) {
+        Secp256k1::setBackend(backend);
+        EXPECT_THROW(Secp256k1::ecdh(zero, GENERATOR), std::runtime_error);
+        EXPECT_THROW(Secp256k1::ecdh(GROUP_ORDER, GENERATOR), std::runtime_error);
+        EXPECT_THROW(Secp256k1::ecdh(std::vector<uint8_t>(31, 1), GENERATOR),
+                     std::runtime_error);
+        EXPECT_THROW(Secp256k1::ecdh(EcKeyPair::generate().privateKey(), badPoint),
+                     std::runtime_error);
+        EXPECT_THROW(Secp256k1::sign(zero, GENERATOR), std::runtime_error);
+
+        auto keyPair = EcKeyPair::generate();
+        auto signature = keyPair.sign(GENERATOR);
+        EXPECT_FALSE(Secp256k1::verify(GENERATOR, signature, badPoint));
+        EXPECT_FALSE(Secp256k1::verify(GENERATOR, std::vector<uint8_t>(8, 0x30),
+                                       keyPair.publicKey()));
+
+        // Empty inputs have a null data pointer, which libsecp256k1 aborts on
+        const std::vector<uint8_t> empty;
+        EXPECT_THROW(Secp256k1::ecdh(keyPair.privateKey(), empty), std::runtime_error);
+        EXPECT_THROW(Secp256k1::parsePublicKey(empty), std::runtime_error);
+        EXPECT_THROW(PublicKeyCache(16).get(empty), std::runtime_error);
+        EXPECT_FALSE(Secp256k1::verify(GENERATOR, empty, keyPair.publicKey()));
+        EXPECT_FALSE(Secp256k1::verify(GENERATOR, signature, empty));
+        EXPECT_FALSE(EcKeyPair::verify(GENERATOR, empty, keyPair.publicKey()));
+        EXPECT_THROW(Ecies::encryptBasic(GENERATOR, empty), std::runtime_error);
+    }
+}
+
+TEST_F(Secp256k1Test, ParsedKeysMatchEncodedKeys) {
+    auto alice = EcKeyPair::generate();
+    auto bob = EcKeyPair::generate();
+
+    for (auto backend : backends) {
+        Secp256k1::setBackend(backend);
+        auto parsed = Secp256k1::parsePublicKey(bob.publicKey());
+        EXPECT_EQ(parsed.backend(), backend);
+        EXPECT_TRUE(std::ranges::equal(parsed.encoded(), bob.publicKey()));
+        EXPECT_EQ(Secp256k1::ecdh(alice.privateKey(), parsed),
+                  Secp256k1::ecdh(alice.privateKey(), bob.publicKey()));
+        EXPECT_EQ(Secp256k1::ecdhPoint(alice.privateKey(), parsed),
+                  Secp256k1::ecdhPoint(alice.privateKey(), bob.publicKey()));
+
+        // Keys parsed under another backend still work after a switch
+        for (auto other : backends) {
+            Secp256k1::setBackend(other);
+            EXPECT_EQ(Secp256k1::ecdh(alice.privateKey(), parsed),
+                      Secp256k1::ecdh(bob.privateKey(), alice.publicKey()));
+        }
+        Secp256k1::setBackend(backend);
+
+        auto badPoint = GENERATOR;
+        badPoint[0] = 0x05;
+        EXPECT_THROW(Secp256k1::parsePublicKey(badPoint), std::runtime_error);
+        EXPECT_THROW(Secp256k1::ecdh(alice.privateKey(), Secp256k1::PublicKey()),
+                     std::runtime_error);
+        EXPECT_THROW(Secp256k1::ecdh(std::vector<uint8_t>(32, 0), parsed), std::runtime_error);
+    }
+}
+
+TEST_F(Secp256k1Test, PublicKeyCacheEvictsLeastRecentlyUsed) {
+    PublicKeyCache cache(2, 1);
+    auto a = EcKeyPair::generate().publicKey();
+    auto b = EcKeyPair::generate().publicKey();
+    auto c = EcKeyPair::generate().publicKey();
+
+    cache.get(a);
+    cache.get(b);
+    auto cached = cache.get(a);
+    EXPECT_TRUE(std::ranges::equal(cached.encoded(), a));
+    cache.get(c); // evicts b
+
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 3u);
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.entries, 2u);
+
+    cache.get(a);
+    cache.get(b);
+    EXPECT_EQ(cache.stats().hits, 2u);
+    EXPECT_EQ(cache.stats().misses, 4u);
+
+    auto badPoint = GENERATOR;
+    badPoint[0] = 0x05;
+    EXPECT_THROW(cache.get(badPoint), std::runtime_error);
+    EXPECT_EQ(cache.stats().entries, 2u);
+
+    cache.clear();
+    EXPECT_EQ(cache.stats().entries, 0u);
+
+    PublicKeyCache disabled(0);
+    EXPECT_FALSE(disabled.get(a).empty());
+    EXPECT_EQ(disabled.stats().entries, 0u);
+    EXPECT_THROW(PublicKeyCache(16, 0), std::invalid_argument);
+}
+
+TEST_F(Secp256k1Test, PublicKeyCacheReparsesAfterBackendSwitch) {
+    PublicKeyCache cache;
+    auto key = EcKeyPair::generate().publicKey();
+    for (auto backend : backends) {
+        Secp256k1::setBackend(backend);
+        EXPECT_EQ(cache.get(key).backend(), backend);
+        EXPECT_EQ(cache.get(key).backend(), backend);
+    }
+    EXPECT_EQ(cache.stats().entries, 1u);
+    EXPECT_EQ(cache.stats().hits, backends.size());
+}
+
+TEST_F(Secp256k1Test, DecryptsCrossCompatVectorsWithEveryBackend) {
+    std::ifstream file;
+    for (const char* path : {"tests/test_vectors_ecies.json", "test_vectors_ecies.json",
+                             "../tests/test_vectors_ecies.json"}) {
+        file.open(path);
+        if (file.is_open()) {
+            break;
+        }
+        file.clear();
+    }
+    if (!file.is_open()) {
+        GTEST_SKIP() << "Test vectors file not found";
+    }
+
+    json vectors;
+    file >> vectors;
+    for (auto backend : backends) {
+        Secp256k1::setBackend(backend);
+        for (const auto& vector : vectors["ecies"]) {
+            std::vector<uint8_t> privateKey = vector["privateKey"];
+            std::vector<uint8_t> plaintext = vector["plaintext"];
+            std::vector<uint8_t> encrypted = vector["encrypted"];
+            auto keyPair = EcKeyPair::fromPrivateKey(privateKey);
+            EXPECT_EQ(Ecies::decrypt(encrypted, keyPair), plaintext);
+        }
+    }
+}
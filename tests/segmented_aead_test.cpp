@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include "brightchain/segmented_aead.hpp"
+
+using namespace brightchain;
+
+namespace {
+
+std::vector<uint8_t> pattern(size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(i * 131 + (i >> 9));
+    }
+    return data;
+}
+
+} // namespace
+
+TEST(SegmentedAeadTest, RoundTripsAcrossSegmentBoundaries) {
+    ThreadPool pool(4);
+    SegmentedAead aead(4096, pool);
+    auto key = AesGcm::generateKey();
+
+    for (size_t size : {size_t{0}, size_t{1}, size_t{4095}, size_t{4096}, size_t{4097},
+                        size_t{3 * 1024 * 1024 + 17}}) {
+        auto plaintext = pattern(size);
+        auto sealed = aead.encrypt(plaintext, key);
+        EXPECT_EQ(sealed.size(), aead.sealedSize(size));
+        EXPECT_TRUE(SegmentedAead::isSegmented(sealed));
+        EXPECT_EQ(SegmentedAead::plaintextSize(sealed), size);
+        EXPECT_EQ(aead.decrypt(sealed, key), plaintext);
+    }
+}
+
+TEST(SegmentedAeadTest, DecryptUsesSegmentSizeFromHeader) {
+    ThreadPool pool(4);
+    auto key = AesGcm::generateKey();
+    auto plaintext = pattern(5 * 1024 * 1024);
+
+    auto sealed = SegmentedAead(64 * 1024, pool).encrypt(plaintext, key);
+    EXPECT_EQ(SegmentedAead(1024 * 1024, pool).decrypt(sealed, key), plaintext);
+}
+
+TEST(SegmentedAeadTest, DetectsTamperingAnywhere) {
+    ThreadPool pool(2);
+    SegmentedAead aead(1024, pool);
+    auto key = AesGcm::generateKey();
+    std::vector<uint8_t> aad = {1, 2, 3};
+    auto sealed = aead.encrypt(pattern(10 * 1024), key, aad);
+
+    // Header field, header MAC, segment tag, ciphertext
+    for (size_t offset : {size_t{21}, size_t{40}, SegmentedAead::HEADER_SIZE + 5,
+                          sealed.size() - 1}) {
+        auto tampered = sealed;
+        tampered[offset] ^= 0x01;
+        EXPECT_THROW(aead.decrypt(tampered, key, aad), std::runtime_error) << offset;
+    }
+
+    EXPECT_THROW(aead.decrypt(sealed, key), std::runtime_error);
+    EXPECT_THROW(aead.decrypt(sealed, AesGcm::generateKey(), aad), std::runtime_error);
+}
+
+TEST(SegmentedAeadTest, RejectsReorderedAndTruncatedSegments) {
+    ThreadPool pool(2);
+    SegmentedAead aead(1024, pool);
+    auto key = AesGcm::generateKey();
+    auto sealed = aead.encrypt(pattern(4 * 1024), key);
+    const size_t body = SegmentedAead::HEADER_SIZE + 4 * AesGcm::TAG_SIZE;
+
+    auto swapped = sealed;
+    std::swap_ranges(swapped.begin() + SegmentedAead::HEADER_SIZE,
+                     swapped.begin() + SegmentedAead::HEADER_SIZE + AesGcm::TAG_SIZE,
+                     swapped.begin() + SegmentedAead::HEADER_SIZE + AesGcm::TAG_SIZE);
+    std::swap_ranges(swapped.begin() + body, swapped.begin() + body + 1024,
+                     swapped.begin() + body + 1024);
+    EXPECT_THROW(aead.decrypt(swapped, key), std::runtime_error);
+
+    auto truncated = sealed;
+    truncated.resize(sealed.size() - 1024);
+    EXPECT_THROW(aead.decrypt(truncated, key), std::runtime_error);
+    EXPECT_THROW(SegmentedAead::plaintextSize(truncated), std::runtime_error);
+}
+
+TEST(SegmentedAeadTest, SealsIntoCallerBuffers) {
+    SegmentedAead aead(512);
+    auto key = AesGcm::generateKey();
+    auto plaintext = pattern(2000);
+
+    std::vector<uint8_t> sealed(aead.sealedSize(plaintext.size()));
+    aead.encrypt(plaintext, sealed, key);
+    std::vector<uint8_t> opened(plaintext.size());
+    aead.decrypt(sealed, opened, key);
+    EXPECT_EQ(opened, plaintext);
+
+    std::vector<uint8_t> small(sealed.size() - 1);
+    EXPECT_THROW(aead.encrypt(plaintext, small, key), std::invalid_argument);
+    std::vector<uint8_t> shortOutput(plaintext.size() - 1);
+    EXPECT_THROW(aead.decrypt(sealed, shortOutput, key), std::invalid_argument);
+}
+
+TEST(SegmentedAeadTest, RejectsInvalidInput) {
+    EXPECT_THROW(SegmentedAead(0), std::invalid_argument);
+
+    std::vector<uint8_t> plain(100, 0);
+    EXPECT_FALSE(SegmentedAead::isSegmented(plain));
+    EXPECT_THROW(SegmentedAead().decrypt(plain, AesGcm::generateKey()), std::runtime_error);
+}
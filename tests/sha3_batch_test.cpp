@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "brightchain/sha3_batch.hpp"
+#include <random>
+
+using namespace brightchain;
+
+namespace {
+
+std::vector<std::vector<uint8_t>> randomBuffers(size_t count, size_t length, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<std::vector<uint8_t>> buffers(count, std::vector<uint8_t>(length));
+    for (auto& buffer : buffers) {
+        for (auto& byte : buffer) {
+            byte = static_cast<uint8_t>(rng());
+        }
+    }
+    return buffers;
+}
+
+std::vector<Sha3Kernel> supportedKernels() {
+    std::vector<Sha3Kernel> kernels{Sha3Kernel::Scalar};
+    if (sha3BestKernel() == Sha3Kernel::Avx512x8) {
+        kernels.push_back(Sha3Kernel::Avx512x8);
+        kernels.push_back(Sha3Kernel::Avx2x4); // AVX-512F implies AVX2
+    } else if (sha3BestKernel() == Sha3Kernel::Avx2x4) {
+        kernels.push_back(Sha3Kernel::Avx2x4);
+    }
+    return kernels;
+}
+
+} // namespace
+
+TEST(Sha3BatchTest, KernelsMatchOneShotHashing) {
+    // Lengths around the 72-byte rate exercise the padding edge cases
+    for (size_t length : {0, 1, 71, 72, 73, 143, 144, 512, 4096}) {
+        auto buffers = randomBuffers(11, length, static_cast<uint32_t>(length));
+        std::vector<const uint8_t*> inputs;
+        for (const auto& buffer : buffers) {
+            inputs.push_back(buffer.data());
+        }
+
+        for (Sha3Kernel kernel : supportedKernels()) {
+            std::vector<Checksum::HashArray> digests(buffers.size());
+            sha3_512Batch(inputs, length, digests.data(), kernel);
+            for (size_t i = 0; i < buffers.size(); ++i) {
+                EXPECT_EQ(Checksum::fromHash(digests[i]), Checksum::fromData(buffers[i]))
+                    << "length " << length << " kernel " << static_cast<int>(kernel)
+                    << " buffer " << i;
+            }
+        }
+    }
+}
+
+TEST(Sha3BatchTest, KnownAnswer) {
+    // SHA3-512("abc") from FIPS 202 examples
+    std::vector<uint8_t> abc{'a', 'b', 'c'};
+    const uint8_t* input = abc.data();
+    for (Sha3Kernel kernel : supportedKernels()) {
+        Checksum::HashArray digest;
+        sha3_512Batch(std::span<const uint8_t* const>(&input, 1), abc.size(), &digest, kernel);
+        EXPECT_EQ(Checksum::fromHash(digest).toHex(),
+                  "b751850b1a57168a5693cd924b6b096e08f621827444f70d884f5d0240d2712e"
+                  "10e116e9192af3c91a7ec57647e3934057340b4cf408d5a56592f8274eec53f0");
+    }
+}
+
+TEST(Sha3BatchTest, FromBlocksMatchesFromData) {
+    auto buffers = randomBuffers(20, 4096, 3);
+    std::vector<const uint8_t*> inputs;
+    for (const auto& buffer : buffers) {
+        inputs.push_back(buffer.data());
+    }
+    auto checksums = Checksum::fromBlocks(inputs, 4096);
+    ASSERT_EQ(checksums.size(), buffers.size());
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        EXPECT_EQ(checksums[i], Checksum::fromData(buffers[i]));
+    }
+    EXPECT_TRUE(Checksum::fromBlocks({}, 4096).empty());
+}
+
+TEST(Sha3BatchTest, StreamMatchesOneShotAndResets) {
+    auto data = randomBuffers(1, 10000, 9).front();
+    ChecksumStream stream;
+    stream.update(std::span<const uint8_t>(data).first(123));
+    stream.update(std::span<const uint8_t>(data).subspan(123));
+    EXPECT_EQ(stream.finish(), Checksum::fromData(data));
+
+    stream.reset();
+    stream.update(data.data(), 10);
+    EXPECT_EQ(stream.finish(), Checksum::fromData(data.data(), 10));
+}
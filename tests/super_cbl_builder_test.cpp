@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include "brightchain/super_cbl_builder.hpp"
+#include "brightchain/cbl_view.hpp"
+#include "brightchain/range_reader.hpp"
+#include "brightchain/reassembler.hpp"
+#include <filesystem>
+#include <random>
+
+using namespace brightchain;
+
+class SuperCBLBuilderTest : public ::testing::Test {
+protected:
+    // Message blocks hold 5 addresses per CBL and 5 children per SuperCBL
+    static constexpr size_t BLOCK = 512;
+
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_super_cbl_builder_test";
+        std::filesystem::remove_all(testPath);
+        store = std::make_unique<DiskBlockStore>(testPath.string(), BlockSize::Message);
+    }
+
+    void TearDown() override {
+        store.reset();
+        std::filesystem::remove_all(testPath);
+    }
+
+    /**
+     * Store `blocks` random data blocks, the last one `tail` bytes long.
+     */
+    std::vector<Checksum> storeData(size_t blocks, size_t tail, std::vector<uint8_t>& input) {
+        std::mt19937 rng(static_cast<uint32_t>(blocks));
+        std::vector<Checksum> addresses;
+        for (size_t i = 0; i < blocks; ++i) {
+            std::vector<uint8_t> block(BLOCK, 0);
+            const size_t length = i + 1 == blocks ? tail : BLOCK;
+            for (size_t j = 0; j < length; ++j) {
+                block[j] = static_cast<uint8_t>(rng());
+            }
+            input.insert(input.end(), block.begin(), block.begin() + length);
+            addresses.push_back(store->put(block));
+        }
+        return addresses;
+    }
+
+    SuperCBLBuildResult build(const std::vector<Checksum>& addresses, uint64_t length,
+                              const SuperCBLBuilderOptions& options = {}) {
+        SuperCBLBuilder builder(*store, options);
+        for (const auto& address : addresses) {
+            builder.add(address);
+        }
+        return builder.finish(length, Checksum::fromData(std::vector<uint8_t>{1, 2, 3}));
+    }
+
+    std::filesystem::path testPath;
+    std::unique_ptr<DiskBlockStore> store;
+};
+
+TEST_F(SuperCBLBuilderTest, SmallInputIsASingleCBL) {
+    std::vector<uint8_t> input;
+    auto addresses = storeData(4, 100, input);
+    auto result = build(addresses, input.size());
+
+    EXPECT_EQ(result.depth, 0);
+    EXPECT_EQ(result.cblCount, 1u);
+    EXPECT_EQ(result.superCblCount, 0u);
+
+    auto block = store->getMapped(result.root);
+    CBLView view(block.span());
+    EXPECT_EQ(view.addresses().toVector(), addresses);
+    EXPECT_EQ(view.originalDataLength(), input.size());
+    EXPECT_TRUE(view.originalDataChecksum() ==
+                Checksum::fromData(std::vector<uint8_t>{1, 2, 3}));
+}
+
+TEST_F(SuperCBLBuilderTest, ExactlyFullLevelsDoNotAddADepth) {
+    SuperCBLBuilder probe(*store);
+    ASSERT_EQ(probe.leafCapacity(), 5u);
+    ASSERT_EQ(probe.fanout(), 5u);
+
+    std::vector<uint8_t> input;
+    auto addresses = storeData(25, BLOCK, input);
+    auto result = build(addresses, input.size());
+    EXPECT_EQ(result.depth, 1);
+    EXPECT_EQ(result.cblCount, 5u);
+
+    auto block = store->getMapped(result.root);
+    SuperCBLView root(block.span());
+    EXPECT_EQ(root.subCblCount(), 5u);
+    EXPECT_EQ(root.totalBlockCount(), 25u);
+    EXPECT_EQ(root.depth(), 1);
+
+    input.clear();
+    addresses = storeData(26, 10, input);
+    result = build(addresses, input.size());
+    EXPECT_EQ(result.depth, 2);
+    EXPECT_EQ(result.cblCount, 6u);
+    EXPECT_EQ(result.superCblCount, 3u);
+}
+
+TEST_F(SuperCBLBuilderTest, DeepTreeIsFullyPackedAndReadable) {
+    std::vector<uint8_t> input;
+    auto addresses = storeData(5 * 5 * 5 + 8, 77, input);
+    auto result = build(addresses, input.size());
+    ASSERT_EQ(result.depth, 3);
+    EXPECT_EQ(result.addressCount, addresses.size());
+
+    // Every node but the last on its level is full and covers whole blocks
+    auto rootBlock = store->getMapped(result.root);
+    SuperCBLView root(rootBlock.span());
+    EXPECT_EQ(root.originalDataLength(), input.size());
+    EXPECT_EQ(root.totalBlockCount(), addresses.size());
+    ASSERT_EQ(root.subCblCount(), 2u);
+
+    auto firstBlock = store->getMapped(root.subCblChecksums()[0].toChecksum());
+    SuperCBLView first(firstBlock.span());
+    EXPECT_EQ(first.depth(), 2);
+    EXPECT_EQ(first.subCblCount(), 5u);
+    EXPECT_EQ(first.originalDataLength(), 125u * BLOCK);
+    EXPECT_TRUE(first.originalDataChecksum() == Checksum());
+
+    auto lastBlock = store->getMapped(root.subCblChecksums()[1].toChecksum());
+    SuperCBLView last(lastBlock.span());
+    EXPECT_EQ(last.originalDataLength(), input.size() - 125u * BLOCK);
+    EXPECT_EQ(last.totalBlockCount(), 8u);
+
+    std::filesystem::path output = testPath.string() + ".out";
+    ReassemblyOptions options;
+    options.verifyChecksum = false;
+    Reassembler(*store).reassembleToFile(result.root, output, options);
+    EXPECT_EQ(std::filesystem::file_size(output), input.size());
+    std::filesystem::remove(output);
+
+    RangeReader reader(*store, result.root);
+    EXPECT_EQ(reader.read(0, input.size()), input);
+    EXPECT_EQ(reader.read(BLOCK * 100 + 3, BLOCK), std::vector<uint8_t>(
+        input.begin() + BLOCK * 100 + 3, input.begin() + BLOCK * 101 + 3));
+}
+
+TEST_F(SuperCBLBuilderTest, ExtendedMetadataOnEveryLeaf) {
+    SuperCBLBuilderOptions options;
+    options.metadata = ExtendedCBLMetadata{"a.bin", "application/octet-stream"};
+    SuperCBLBuilder probe(*store, options);
+    const size_t capacity = probe.leafCapacity();
+    ASSERT_LT(capacity, 5u);
+
+    std::vector<uint8_t> input;
+    auto addresses = storeData(capacity * 3 + 1, 9, input);
+    auto result = build(addresses, input.size(), options);
+    ASSERT_EQ(result.depth, 1);
+
+    auto rootBlock = store->getMapped(result.root);
+    SuperCBLView root(rootBlock.span());
+    for (auto child : root.subCblChecksums()) {
+        auto leafBlock = store->getMapped(child.toChecksum());
+        CBLView leaf(leafBlock.span());
+        EXPECT_TRUE(leaf.isExtended());
+        EXPECT_EQ(leaf.fileName(), "a.bin");
+    }
+
+    RangeReader reader(*store, result.root);
+    EXPECT_EQ(reader.read(0, input.size()), input);
+}
+
+TEST_F(SuperCBLBuilderTest, TupleSizeMustDivideAddressCount) {
+    SuperCBLBuilderOptions options;
+    options.tupleSize = 2;
+    SuperCBLBuilder builder(*store, options);
+    EXPECT_EQ(builder.leafCapacity(), 4u);
+    builder.add(Checksum::fromData(std::vector<uint8_t>{1}));
+    EXPECT_THROW(builder.finish(BLOCK, Checksum()), std::runtime_error);
+}
+
+TEST_F(SuperCBLBuilderTest, EmptyInputIsAnEmptyCBL) {
+    auto result = build({}, 0);
+    EXPECT_EQ(result.depth, 0);
+    auto block = store->getMapped(result.root);
+    CBLView view(block.span());
+    EXPECT_EQ(view.addressCount(), 0u);
+}
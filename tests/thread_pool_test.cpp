@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include "brightchain/thread_pool.hpp"
+#include <atomic>
+#include <stdexcept>
+
+using namespace brightchain;
+
+TEST(ThreadPoolTest, SubmitReturnsResults) {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.size(), 4);
+
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 100; ++i) {
+        futures.push_back(pool.submit([i]() { return i * i; }));
+    }
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(futures[i].get(), i * i);
+    }
+}
+
+TEST(ThreadPoolTest, SubmitPropagatesExceptions) {
+    ThreadPool pool(2);
+    auto future = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+    EXPECT_THROW(future.get(), std::runtime_error);
+
+    // Pool keeps working after a failing task
+    EXPECT_EQ(pool.submit([]() { return 7; }).get(), 7);
+}
+
+TEST(ThreadPoolTest, WaitIdleRunsEverything) {
+    std::atomic<int> counter{0};
+    ThreadPool pool(3);
+    for (int i = 0; i < 1000; ++i) {
+        pool.post([&counter]() { counter.fetch_add(1); });
+    }
+    pool.waitIdle();
+    EXPECT_EQ(counter.load(), 1000);
+}
+
+TEST(ThreadPoolTest, DestructorFinishesQueuedTasks) {
+    std::atomic<int> counter{0};
+    {
+        ThreadPool pool(1);
+        for (int i = 0; i < 50; ++i) {
+            pool.post([&counter]() { counter.fetch_add(1); });
+        }
+    }
+    EXPECT_EQ(counter.load(), 50);
+}
+
+TEST(ThreadPoolTest, ParallelForCoversRangeOnce) {
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> hits(1001);
+    pool.parallelFor(1, hits.size(), [&hits](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            hits[i].fetch_add(1);
+        }
+    });
+    EXPECT_EQ(hits[0].load(), 0);
+    for (size_t i = 1; i < hits.size(); ++i) {
+        EXPECT_EQ(hits[i].load(), 1);
+    }
+
+    EXPECT_THROW(pool.parallelFor(0, 100,
+                                  [](size_t first, size_t) {
+                                      if (first > 0) {
+                                          throw std::runtime_error("range failed");
+                                      }
+                                  }),
+                 std::runtime_error);
+}
+
+TEST(ThreadPoolTest, ParallelForRunsInlineOnWorkers) {
+    ThreadPool pool(2);
+    EXPECT_FALSE(pool.onWorker());
+
+    // Every worker blocked in a nested parallelFor would deadlock if the
+    // ranges were queued behind them
+    std::vector<std::future<size_t>> outer;
+    for (int i = 0; i < 4; ++i) {
+        outer.push_back(pool.submit([&pool]() {
+            EXPECT_TRUE(pool.onWorker());
+            std::atomic<size_t> sum{0};
+            pool.parallelFor(0, 64, [&sum](size_t first, size_t last) {
+                sum.fetch_add(last - first);
+            });
+            return sum.load();
+        }));
+    }
+    for (auto& future : outer) {
+        EXPECT_EQ(future.get(), 64u);
+    }
+}
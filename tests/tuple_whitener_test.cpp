@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include "brightchain/tuple_whitener.hpp"
+#include "brightchain/reassembler.hpp"
+#include "brightchain/super_cbl_builder.hpp"
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <csignal>
+#include <sys/resource.h>
+#include <set>
+
+using namespace brightchain;
+
+class TupleWhitenerTest : public ::testing::Test {
+protected:
+    static constexpr size_t BLOCK = 4096;
+
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_tuple_whitener_test";
+        std::filesystem::remove_all(testPath);
+        store = std::make_unique<DiskBlockStore>(testPath.string(), BlockSize::Small);
+    }
+
+    void TearDown() override {
+        store.reset();
+        std::filesystem::remove_all(testPath);
+    }
+
+    std::vector<uint8_t> randomBytes(size_t length, uint32_t seed) {
+        std::vector<uint8_t> data(length);
+        std::mt19937 rng(seed);
+        for (auto& byte : data) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        return data;
+    }
+
+    std::filesystem::path testPath;
+    std::unique_ptr<DiskBlockStore> store;
+};
+
+TEST_F(TupleWhitenerTest, WhitenedTupleReconstructsSource) {
+    RandomBlockPool pool;
+    TupleWhitener whitener(*store, pool);
+
+    auto source = randomBytes(BLOCK, 1);
+    auto tuple = whitener.whiten(source);
+    ASSERT_EQ(tuple.members.size(), TupleConstants::SIZE);
+    EXPECT_EQ(std::set<Checksum>(tuple.members.begin(), tuple.members.end()).size(),
+              tuple.members.size());
+
+    // No stored member is the source itself
+    for (const auto& member : tuple.members) {
+        EXPECT_NE(store->get(member), source);
+    }
+    EXPECT_EQ(whitener.reconstruct(tuple.members), source);
+}
+
+TEST_F(TupleWhitenerTest, ShortSourceIsZeroPadded) {
+    RandomBlockPool pool;
+    TupleWhitener whitener(*store, pool);
+
+    auto source = randomBytes(100, 2);
+    auto tuple = whitener.whiten(source);
+    auto restored = whitener.reconstruct(tuple.members);
+    ASSERT_EQ(restored.size(), BLOCK);
+    EXPECT_TRUE(std::equal(source.begin(), source.end(), restored.begin()));
+    EXPECT_TRUE(std::all_of(restored.begin() + 100, restored.end(),
+                            [](uint8_t b) { return b == 0; }));
+
+    EXPECT_THROW(whitener.whiten(randomBytes(BLOCK + 1, 3)), std::invalid_argument);
+}
+
+TEST_F(TupleWhitenerTest, ReusesPooledBlocksAtConfiguredRatio) {
+    RandomBlockPool pool;
+    TupleWhitener whitener(*store, pool);
+
+    std::vector<WhitenedTuple> tuples;
+    for (uint32_t i = 0; i < 50; ++i) {
+        tuples.push_back(whitener.whiten(randomBytes(BLOCK, 100 + i)));
+    }
+
+    const double total = static_cast<double>(whitener.reusedCount() + whitener.freshCount());
+    EXPECT_EQ(total, 50.0 * TupleConstants::RANDOM_BLOCKS_PER_TUPLE);
+    EXPECT_NEAR(whitener.reusedCount() / total, OFFS_CACHE_PERCENTAGE, 0.03);
+    EXPECT_EQ(pool.size(), whitener.freshCount());
+
+    for (uint32_t i = 0; i < tuples.size(); ++i) {
+        EXPECT_EQ(whitener.reconstruct(tuples[i].members), randomBytes(BLOCK, 100 + i));
+    }
+}
+
+TEST_F(TupleWhitenerTest, RemovedPoolBlocksAreReplacedWithFreshOnes) {
+    RandomBlockPool pool;
+    TupleWhitener whitener(*store, pool);
+    whitener.whiten(randomBytes(BLOCK, 1));
+
+    // Drop every pooled block from the store; whitening must still succeed
+    for (const auto& checksum : pool.sample(pool.size())) {
+        store->remove(checksum);
+    }
+    auto source = randomBytes(BLOCK, 2);
+    auto tuple = whitener.whiten(source);
+    EXPECT_EQ(tuple.reusedBlocks, 0u);
+    EXPECT_EQ(whitener.reconstruct(tuple.members), source);
+}
+
+TEST_F(TupleWhitenerTest, ReusedBlocksHoldTheirOwnReference) {
+    store.reset();
+    std::filesystem::remove_all(testPath);
+    DiskBlockStoreOptions options;
+    options.referenceCounting = true;
+    store = std::make_unique<DiskBlockStore>(testPath.string(), BlockSize::Small, options);
+
+    RandomBlockPool pool;
+    TupleWhitener whitener(*store, pool);
+    auto first = whitener.whiten(randomBytes(BLOCK, 1));
+    auto source = randomBytes(BLOCK, 2);
+    WhitenedTuple second;
+    do {
+        second = whitener.whiten(source);
+    } while (second.reusedBlocks == 0);
+
+    // Dropping the first tuple must leave the blocks the later one shares
+    for (const auto& member : first.members) {
+        store->remove(member);
+    }
+    EXPECT_EQ(whitener.reconstruct(second.members), source);
+}
+
+TEST_F(TupleWhitenerTest, FailedStoreReleasesReusedReferences) {
+    store.reset();
+    std::filesystem::remove_all(testPath);
+    DiskBlockStoreOptions options;
+    options.referenceCounting = true;
+    store = std::make_unique<DiskBlockStore>(testPath.string(), BlockSize::Small, options);
+
+    RandomBlockPool pool;
+    TupleWhitener whitener(*store, pool);
+    whitener.whiten(randomBytes(BLOCK, 1));
+    const auto pooled = pool.sample(pool.size());
+
+    // Block files cannot be written past the size limit, so every put fails
+    rlimit original{};
+    ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &original), 0);
+    rlimit lowered = original;
+    lowered.rlim_cur = 1024;
+    auto previous = std::signal(SIGXFSZ, SIG_IGN);
+    ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &lowered), 0);
+    for (uint32_t i = 0; i < 20; ++i) {
+        EXPECT_ANY_THROW(whitener.whiten(randomBytes(BLOCK, 2 + i)));
+    }
+    ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &original), 0);
+    std::signal(SIGXFSZ, previous);
+
+    for (const auto& checksum : pooled) {
+        EXPECT_EQ(store->refCount(checksum), 1u);
+    }
+}
+
+TEST_F(TupleWhitenerTest, WhitenedTuplesReassembleThroughCBL) {
+    RandomBlockPool pool;
+    TupleWhitener whitener(*store, pool);
+    auto input = randomBytes(BLOCK * 5 + 10, 9);
+
+    SuperCBLBuilderOptions options;
+    options.tupleSize = TupleConstants::SIZE;
+    SuperCBLBuilder builder(*store, options);
+    for (size_t offset = 0; offset < input.size(); offset += BLOCK) {
+        const size_t length = std::min(BLOCK, input.size() - offset);
+        auto tuple = whitener.whiten(std::span<const uint8_t>(input).subspan(offset, length));
+        for (const auto& member : tuple.members) {
+            builder.add(member);
+        }
+    }
+    auto tree = builder.finish(input.size(), Checksum::fromData(input));
+
+    std::filesystem::path output = testPath.string() + ".out";
+    Reassembler(*store).reassembleToFile(tree.root, output);
+    std::ifstream file(output, std::ios::binary);
+    std::vector<uint8_t> restored((std::istreambuf_iterator<char>(file)),
+                                  std::istreambuf_iterator<char>());
+    std::filesystem::remove(output);
+    EXPECT_EQ(restored, input);
+}
+
+TEST(RandomBlockPoolTest, BoundedDistinctSamples) {
+    RandomBlockPool pool(8);
+    for (uint8_t i = 0; i < 20; ++i) {
+        pool.add(Checksum::fromData(std::vector<uint8_t>{i}));
+    }
+    EXPECT_EQ(pool.size(), 8u);
+
+    auto sample = pool.sample(5);
+    EXPECT_EQ(std::set<Checksum>(sample.begin(), sample.end()).size(), 5u);
+    EXPECT_EQ(pool.sample(100).size(), 8u);
+
+    pool.remove(sample.front());
+    EXPECT_EQ(pool.size(), 7u);
+}
+
+TEST(TupleWhitenerOptionsTest, RejectsOutOfRangeOptions) {
+    auto path = std::filesystem::temp_directory_path() / "brightchain_tuple_whitener_options";
+    {
+        DiskBlockStore store(path.string(), BlockSize::Small);
+        RandomBlockPool pool;
+        WhiteningOptions options;
+        options.randomBlocks = TupleConstants::MAX_RANDOM_BLOCKS + 1;
+        EXPECT_THROW(TupleWhitener(store, pool, options), std::invalid_argument);
+        options.randomBlocks = 2;
+        options.reuseFraction = 1.5;
+        EXPECT_THROW(TupleWhitener(store, pool, options), std::invalid_argument);
+    }
+    std::filesystem::remove_all(path);
+}
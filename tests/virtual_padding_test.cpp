@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include "brightchain/async_block_io.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <sys/stat.h>
+
+using namespace brightchain;
+
+class VirtualPaddingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_virtual_padding_test";
+        std::filesystem::remove_all(testPath);
+        DiskBlockStoreOptions options;
+        options.virtualPadding = true;
+        store = std::make_unique<DiskBlockStore>(testPath.string(), BlockSize::Medium, options);
+    }
+
+    void TearDown() override {
+        store.reset();
+        std::filesystem::remove_all(testPath);
+    }
+
+    std::vector<uint8_t> paddedBlock(size_t payload, uint8_t fill) {
+        std::vector<uint8_t> data(blockSizeToLength(BlockSize::Medium), fill);
+        std::mt19937 rng(42);
+        for (size_t i = 0; i < payload; ++i) {
+            data[i] = static_cast<uint8_t>(rng());
+        }
+        return data;
+    }
+
+    uint64_t allocatedBytes(const Checksum& checksum) const {
+        auto hex = checksum.toHex();
+        auto path = testPath / blockSizeToString(BlockSize::Medium) / hex.substr(0, 1) /
+                    hex.substr(1, 1) / hex;
+        struct stat st;
+        EXPECT_EQ(::stat(path.c_str(), &st), 0);
+        EXPECT_EQ(static_cast<size_t>(st.st_size), blockSizeToLength(BlockSize::Medium));
+        return static_cast<uint64_t>(st.st_blocks) * 512;
+    }
+
+    std::filesystem::path testPath;
+    std::unique_ptr<DiskBlockStore> store;
+};
+
+TEST_F(VirtualPaddingTest, ZeroPaddingIsSparse) {
+    auto data = paddedBlock(1000, 0);
+    auto checksum = store->put(data, BlockMetadata(BlockSize::Medium, 1000));
+
+    EXPECT_EQ(checksum, Checksum::fromData(data));
+    EXPECT_LT(allocatedBytes(checksum), 64 * 1024u);
+    EXPECT_EQ(store->get(checksum), data);
+
+    auto mapped = store->getMapped(checksum);
+    EXPECT_TRUE(std::equal(data.begin(), data.end(), mapped.data()));
+}
+
+TEST_F(VirtualPaddingTest, ConstantFillIsMaterialized) {
+    auto data = paddedBlock(5000, 0xA5);
+    auto checksum = store->put(data, BlockMetadata(BlockSize::Medium, 5000));
+
+    EXPECT_LT(allocatedBytes(checksum), 64 * 1024u);
+    EXPECT_EQ(store->get(checksum), data);
+
+    auto mapped = store->getMapped(checksum, AccessHint::Sequential);
+    ASSERT_EQ(mapped.size(), data.size());
+    EXPECT_TRUE(std::equal(data.begin(), data.end(), mapped.data()));
+    EXPECT_EQ(Checksum::fromData(mapped.data(), mapped.size()), checksum);
+}
+
+TEST_F(VirtualPaddingTest, AsyncReadsSynthesizeFill) {
+    auto data = paddedBlock(3000, 0x5A);
+    auto checksum = store->put(data, BlockMetadata(BlockSize::Medium, 3000));
+
+    AsyncBlockIO ring(*store, 4);
+    AsyncBlockIO pool(*store, 4, AsyncIOBackend::ThreadPool);
+    EXPECT_EQ(ring.get(checksum).get(), data);
+    EXPECT_EQ(pool.get(checksum).get(), data);
+}
+
+TEST_F(VirtualPaddingTest, NonUniformPaddingIsStoredInFull) {
+    auto data = paddedBlock(blockSizeToLength(BlockSize::Medium), 0);
+    auto checksum = store->put(data, BlockMetadata(BlockSize::Medium, 1000));
+
+    EXPECT_GE(allocatedBytes(checksum), data.size());
+    EXPECT_EQ(store->get(checksum), data);
+}
+
+TEST_F(VirtualPaddingTest, MetadataUpdateKeepsPadding) {
+    auto data = paddedBlock(100, 0x7F);
+    auto checksum = store->put(data, BlockMetadata(BlockSize::Medium, 100));
+
+    store->putMetadata(checksum, BlockMetadata(BlockSize::Medium, 50));
+    EXPECT_EQ(store->getMetadata(checksum)->length_without_padding, 50u);
+    EXPECT_EQ(store->get(checksum), data);
+}
+
+TEST_F(VirtualPaddingTest, DisabledStoresFullBlocks) {
+    store.reset();
+    std::filesystem::remove_all(testPath);
+    store = std::make_unique<DiskBlockStore>(testPath.string(), BlockSize::Medium);
+
+    auto data = paddedBlock(1000, 0x33);
+    auto checksum = store->put(data, BlockMetadata(BlockSize::Medium, 1000));
+    EXPECT_GE(allocatedBytes(checksum), data.size());
+    EXPECT_EQ(store->get(checksum), data);
+}
@@ -0,0 +1,322 @@
+#include <gtest/gtest.h>
+#include "brightchain/volume_set_store.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <set>
+#include <thread>
+
+using namespace brightchain;
+
+class VolumeSetStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        testPath = std::filesystem::temp_directory_path() / "brightchain_volume_set_test";
+        std::filesystem::remove_all(testPath);
+        std::filesystem::create_directories(testPath);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(testPath);
+    }
+
+    VolumeSpec volume(const std::string& name, uint64_t weight = 1) {
+        return {(testPath / name).string(), weight};
+    }
+
+    std::vector<std::vector<uint8_t>> makeBlocks(size_t count) {
+        std::mt19937 rng(11);
+        std::vector<std::vector<uint8_t>> blocks(count,
+            std::vector<uint8_t>(blockSizeToLength(BlockSize::Message)));
+        for (auto& block : blocks) {
+            for (auto& byte : block) {
+                byte = static_cast<uint8_t>(rng());
+            }
+        }
+        return blocks;
+    }
+
+    size_t countOn(const std::string& name) {
+        DiskBlockStore store((testPath / name).string(), BlockSize::Message);
+        size_t count = 0;
+        store.forEachChecksum([&count](const Checksum&) { ++count; });
+        return count;
+    }
+
+    std::filesystem::path testPath;
+    ThreadPool pool{4};
+};
+
+TEST_F(VolumeSetStoreTest, RejectsInvalidVolumeSets) {
+    EXPECT_THROW(VolumeSetStore({}, BlockSize::Message, {}, pool), std::invalid_argument);
+    EXPECT_THROW(VolumeSetStore({volume("a"), volume("a")}, BlockSize::Message, {}, pool),
+                 std::invalid_argument);
+}
+
+TEST_F(VolumeSetStoreTest, DefaultWeightIsFilesystemCapacity) {
+    VolumeSetStore store({{(testPath / "a").string(), 0}}, BlockSize::Message, {}, pool);
+    store.putMany(makeBlocks(20));
+    auto info = store.volumes();
+    ASSERT_EQ(info.size(), 1u);
+    EXPECT_EQ(info[0].weight,
+              static_cast<double>(std::filesystem::space(testPath / "a").capacity));
+}
+
+TEST_F(VolumeSetStoreTest, FullOwnerFallsBackToNextVolume) {
+    VolumeSetStore store({volume("a"), volume("b")}, BlockSize::Message, {}, pool);
+    auto block = makeBlocks(1).front();
+    const auto checksum = Checksum::fromData(block);
+    const auto owner = store.ownerOf(checksum);
+
+    // Point the owner's next temporary block file at /dev/full (ENOSPC)
+    const auto hex = checksum.toHex();
+    const auto blockPath = std::filesystem::path(owner) / "Message" / hex.substr(0, 1) /
+                           hex.substr(1, 1) / hex;
+    std::filesystem::create_directories(blockPath.parent_path());
+    auto fillUp = [&](int sequence) {
+        std::filesystem::create_symlink("/dev/full",
+                                        blockPath.string() + ".tmp" + std::to_string(sequence));
+    };
+    fillUp(0);
+
+    EXPECT_EQ(store.put(block), checksum);
+    EXPECT_FALSE(std::filesystem::exists(blockPath));
+    EXPECT_TRUE(store.has(checksum));
+    EXPECT_EQ(store.get(checksum), block);
+
+    // Rebalancing leaves the block in place while the owner stays full
+    fillUp(1);
+    EXPECT_EQ(store.rebalance(), 0u);
+    EXPECT_EQ(store.get(checksum), block);
+
+    // Once the owner has room again the block moves home
+    EXPECT_EQ(store.rebalance(), 1u);
+    EXPECT_TRUE(std::filesystem::exists(blockPath));
+    EXPECT_EQ(store.get(checksum), block);
+}
+
+TEST_F(VolumeSetStoreTest, SpreadsBlocksByWeight) {
+    VolumeSetStore store({volume("a", 1), volume("b", 1), volume("c", 2)}, BlockSize::Message,
+                         {}, pool);
+    auto blocks = makeBlocks(400);
+    auto checksums = store.putMany(blocks);
+    ASSERT_EQ(checksums.size(), blocks.size());
+
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        EXPECT_EQ(checksums[i], Checksum::fromData(blocks[i]));
+        EXPECT_TRUE(store.has(checksums[i]));
+        EXPECT_EQ(store.get(checksums[i]), blocks[i]);
+    }
+
+    size_t a = countOn("a");
+    size_t b = countOn("b");
+    size_t c = countOn("c");
+    EXPECT_EQ(a + b + c, blocks.size());
+    EXPECT_GT(a, 60u);
+    EXPECT_GT(b, 60u);
+    EXPECT_GT(c, a);
+    EXPECT_GT(c, b);
+}
+
+TEST_F(VolumeSetStoreTest, PlacementIsStableAcrossReopen) {
+    auto blocks = makeBlocks(50);
+    std::vector<Checksum> checksums;
+    std::map<std::string, std::string> owners;
+    {
+        VolumeSetStore store({volume("a"), volume("b")}, BlockSize::Message, {}, pool);
+        checksums = store.putMany(blocks);
+        for (const auto& checksum : checksums) {
+            owners[checksum.toHex()] = store.ownerOf(checksum);
+        }
+    }
+
+    VolumeSetStore reopened({volume("b"), volume("a")}, BlockSize::Message, {}, pool);
+    auto loaded = reopened.getMany(checksums);
+    for (size_t i = 0; i < checksums.size(); ++i) {
+        EXPECT_EQ(reopened.ownerOf(checksums[i]), owners[checksums[i].toHex()]);
+        EXPECT_EQ(loaded[i], blocks[i]);
+    }
+}
+
+TEST_F(VolumeSetStoreTest, AddVolumeMovesOnlyClaimedBlocks) {
+    VolumeSetStore store({volume("a"), volume("b")}, BlockSize::Message, {}, pool);
+    auto blocks = makeBlocks(300);
+    auto checksums = store.putMany(blocks);
+
+    std::map<std::string, std::string> before;
+    for (const auto& checksum : checksums) {
+        before[checksum.toHex()] = store.ownerOf(checksum);
+    }
+
+    store.addVolume(volume("c"));
+
+    // Readable before any block has moved.
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        EXPECT_EQ(store.get(checksums[i]), blocks[i]);
+    }
+
+    size_t claimed = 0;
+    for (const auto& checksum : checksums) {
+        auto owner = store.ownerOf(checksum);
+        if (owner == volume("c").path) {
+            ++claimed;
+        } else {
+            EXPECT_EQ(owner, before[checksum.toHex()]);
+        }
+    }
+    EXPECT_GT(claimed, 0u);
+
+    EXPECT_EQ(store.rebalance(1), 1u);
+    size_t moved = 1;
+    while (size_t step = store.rebalance(16)) {
+        moved += step;
+    }
+    EXPECT_EQ(moved, claimed);
+    EXPECT_EQ(countOn("c"), claimed);
+
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        EXPECT_EQ(store.get(checksums[i]), blocks[i]);
+    }
+}
+
+TEST_F(VolumeSetStoreTest, RebalanceMovesEveryReference) {
+    DiskBlockStoreOptions options;
+    options.referenceCounting = true;
+    VolumeSetStore store({volume("a"), volume("b")}, BlockSize::Message, options, pool);
+    auto blocks = makeBlocks(60);
+    std::vector<Checksum> checksums;
+    for (const auto& block : blocks) {
+        for (int i = 0; i < 3; ++i) {
+            checksums.push_back(store.put(block));
+        }
+    }
+    checksums.erase(std::unique(checksums.begin(), checksums.end()), checksums.end());
+
+    store.addVolume(volume("c"));
+    while (store.rebalance(16)) {
+    }
+    EXPECT_GT(countOn("c"), 0u);
+
+    // Each block is stored once and still needs three removes
+    for (const auto& checksum : checksums) {
+        EXPECT_FALSE(store.remove(checksum));
+        EXPECT_FALSE(store.remove(checksum));
+        EXPECT_TRUE(store.has(checksum));
+        EXPECT_TRUE(store.remove(checksum));
+        EXPECT_FALSE(store.has(checksum));
+    }
+}
+
+TEST_F(VolumeSetStoreTest, RemoveDropsOneReferenceFromSplitCopies) {
+    DiskBlockStoreOptions options;
+    options.referenceCounting = true;
+    VolumeSetStore store({volume("a")}, BlockSize::Message, options, pool);
+    auto blocks = makeBlocks(40);
+    for (const auto& block : blocks) {
+        store.put(block);
+    }
+
+    // Blocks the new volume claims get a second copy there when put again
+    // before a rebalance, with one reference on each volume
+    store.addVolume(volume("c"));
+    std::vector<Checksum> split;
+    for (const auto& block : blocks) {
+        auto checksum = Checksum::fromData(block);
+        if (store.ownerOf(checksum) == volume("c").path) {
+            store.put(block);
+            split.push_back(checksum);
+        }
+    }
+    ASSERT_FALSE(split.empty());
+    EXPECT_EQ(countOn("c"), split.size());
+
+    for (const auto& checksum : split) {
+        store.remove(checksum);
+        EXPECT_TRUE(store.has(checksum));
+        store.remove(checksum);
+        EXPECT_FALSE(store.has(checksum));
+    }
+}
+
+TEST_F(VolumeSetStoreTest, RemoveVolumeDrainsAndDetaches) {
+    VolumeSetStore store({volume("a"), volume("b"), volume("c")}, BlockSize::Message, {}, pool);
+    auto blocks = makeBlocks(200);
+    auto checksums = store.putMany(blocks);
+
+    store.removeVolume(volume("b").path);
+    for (const auto& checksum : checksums) {
+        EXPECT_NE(store.ownerOf(checksum), volume("b").path);
+    }
+
+    auto info = store.volumes();
+    ASSERT_EQ(info.size(), 3u);
+    EXPECT_TRUE(info[1].draining);
+
+    EXPECT_GT(store.rebalance(), 0u);
+    EXPECT_EQ(store.volumes().size(), 2u);
+    EXPECT_EQ(countOn("b"), 0u);
+    EXPECT_EQ(store.rebalance(), 0u);
+
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        EXPECT_EQ(store.get(checksums[i]), blocks[i]);
+    }
+
+    EXPECT_THROW(store.removeVolume(volume("b").path), std::invalid_argument);
+    store.removeVolume(volume("a").path);
+    EXPECT_THROW(store.removeVolume(volume("c").path), std::invalid_argument);
+}
+
+TEST_F(VolumeSetStoreTest, ForEachReportsEveryBlockOnce) {
+    VolumeSetStore store({volume("a"), volume("b")}, BlockSize::Message, {}, pool);
+    auto blocks = makeBlocks(100);
+    auto checksums = store.putMany(blocks);
+    store.addVolume(volume("c"));
+    store.rebalance(10);
+
+    std::set<std::string> seen;
+    size_t calls = 0;
+    store.forEachChecksum([&](const Checksum& checksum) {
+        seen.insert(checksum.toHex());
+        ++calls;
+    });
+    EXPECT_EQ(calls, blocks.size());
+    EXPECT_EQ(seen.size(), blocks.size());
+}
+
+TEST_F(VolumeSetStoreTest, RemoveAndMetadata) {
+    VolumeSetStore store({volume("a"), volume("b")}, BlockSize::Message, {}, pool);
+    auto blocks = makeBlocks(1);
+    auto checksum = store.put(blocks[0], BlockMetadata(BlockSize::Message, 100));
+
+    auto metadata = store.getMetadata(checksum);
+    ASSERT_TRUE(metadata.has_value());
+    EXPECT_EQ(metadata->length_without_padding, 100u);
+
+    EXPECT_TRUE(store.remove(checksum));
+    EXPECT_FALSE(store.has(checksum));
+    EXPECT_FALSE(store.remove(checksum));
+    EXPECT_THROW(store.get(checksum), std::runtime_error);
+    EXPECT_THROW(store.getMany(std::vector<Checksum>{checksum}), std::runtime_error);
+}
+
+TEST_F(VolumeSetStoreTest, RemoveDuringRebalanceIsNotUndone) {
+    VolumeSetStore store({volume("a")}, BlockSize::Message, {}, pool);
+    auto checksums = store.putMany(makeBlocks(300));
+    store.addVolume(volume("b", 1000));
+
+    // Each remove lands before or after the move of its block, never
+    // between the copy and the delete, so no copy survives it.
+    std::thread remover([&]() {
+        for (const auto& checksum : checksums) {
+            store.remove(checksum);
+        }
+    });
+    EXPECT_NO_THROW(store.rebalance());
+    remover.join();
+
+    for (const auto& checksum : checksums) {
+        EXPECT_FALSE(store.has(checksum));
+    }
+    EXPECT_EQ(countOn("a") + countOn("b"), 0u);
+}
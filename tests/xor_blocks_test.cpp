@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include "brightchain/xor_blocks.hpp"
+#include "brightchain/disk_block_store.hpp"
+#include <filesystem>
+#include <random>
+#include <vector>
+
+using namespace brightchain;
+
+namespace {
+
+std::vector<uint8_t> randomBytes(size_t length, uint32_t seed) {
+    std::vector<uint8_t> data(length);
+    std::mt19937 rng(seed);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    return data;
+}
+
+} // namespace
+
+TEST(XorBlocksTest, MatchesBytewiseXorForAnyLengthAndSourceCount) {
+    // Lengths straddle the 8-byte, 128-byte and 256-byte kernel strides
+    for (size_t length : {0, 1, 7, 8, 63, 255, 256, 257, 1000, 4096 + 3}) {
+        for (size_t count : {1, 2, 3, 8, 9, 17}) {
+            std::vector<std::vector<uint8_t>> buffers;
+            std::vector<const uint8_t*> sources;
+            for (size_t s = 0; s < count; ++s) {
+                buffers.push_back(randomBytes(length, static_cast<uint32_t>(length * 31 + s)));
+            }
+            for (const auto& buffer : buffers) {
+                sources.push_back(buffer.data());
+            }
+
+            std::vector<uint8_t> expected(length, 0);
+            for (const auto& buffer : buffers) {
+                for (size_t i = 0; i < length; ++i) {
+                    expected[i] ^= buffer[i];
+                }
+            }
+
+            std::vector<uint8_t> output(length, 0xAA);
+            xorBlocks(output.data(), sources, length);
+            EXPECT_EQ(output, expected) << "length " << length << " sources " << count;
+        }
+    }
+}
+
+TEST(XorBlocksTest, TargetMayAliasFirstSource) {
+    auto a = randomBytes(1000, 1);
+    auto b = randomBytes(1000, 2);
+    auto expected = a;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        expected[i] ^= b[i];
+    }
+
+    auto viaBlocks = a;
+    std::vector<const uint8_t*> sources{viaBlocks.data(), b.data()};
+    xorBlocks(viaBlocks.data(), sources, viaBlocks.size());
+    EXPECT_EQ(viaBlocks, expected);
+
+    xorInto(a.data(), b.data(), a.size());
+    EXPECT_EQ(a, expected);
+}
+
+TEST(XorBlocksTest, RejectsNoSources) {
+    uint8_t out[4];
+    EXPECT_THROW(xorBlocks(out, {}, sizeof(out)), std::invalid_argument);
+}
+
+TEST(XorBlocksTest, XorTupleCombinesStoredMembers) {
+    const auto path = std::filesystem::temp_directory_path() / "brightchain_xor_tuple_test";
+    std::filesystem::remove_all(path);
+    {
+        DiskBlockStore store(path.string(), BlockSize::Message);
+        std::vector<Checksum> members;
+        std::vector<uint8_t> expected(512, 0);
+        for (uint32_t i = 0; i < 3; ++i) {
+            auto block = randomBytes(512, 40 + i);
+            xorInto(expected.data(), block.data(), block.size());
+            members.push_back(store.put(block));
+        }
+
+        EXPECT_EQ(xorTuple(store, members), expected);
+        std::vector<uint8_t> out(512);
+        xorTupleInto(store, members, out.data(), out.size());
+        EXPECT_EQ(out, expected);
+
+        EXPECT_THROW(xorTupleInto(store, members, out.data(), 256), std::runtime_error);
+        EXPECT_THROW(xorTuple(store, std::vector<Checksum>{}), std::invalid_argument);
+        store.remove(members[1]);
+        EXPECT_THROW(xorTuple(store, members), std::runtime_error);
+    }
+    std::filesystem::remove_all(path);
+}